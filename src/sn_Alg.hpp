@@ -25,7 +25,9 @@ boore-morse voting
 #include "sn_AlgDS/iomanager.hpp"
 #endif
 
+#include "sn_AlgDS/modular.hpp"
 #include "sn_AlgDS/number.hpp"
+#include "sn_AlgDS/range_query.hpp"
 #include "sn_AlgDS/search.hpp"
 #include "sn_AlgDS/sort.hpp"
 
@@ -2,6 +2,7 @@
 #define SN_ALGDS_BASIC_DS_H
 
 #include <bits/stdc++.h>
+#include "bitvec.hpp"
 using namespace std;
 
 namespace point {
@@ -766,30 +767,6 @@ namespace basic {
     template <typename T>
     class table_graph : public graph<T, table_edge<T>> {};
 
-    class bitvec {
-    public:
-        bool* data;
-        const int size;
-        bitvec(int size_, bool dfl = false): size(size_) {
-            // The bool is aligned in 1 byte
-            data = new bool[size];
-            memset(data, dfl, size);
-        }
-        ~bitvec() {
-            delete[] data;
-        }
-        bool and_all() {
-            for (int i = 0; i < size; ++i) {
-                if (!data[i])
-                    return false;
-            }
-            return true;
-        }
-        bool operator[](std::size_t idx) {
-            return data[idx];
-        }
-    };
-
 
 }
 
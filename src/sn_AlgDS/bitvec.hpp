@@ -0,0 +1,550 @@
+#ifndef SN_ALGDS_BITVEC_H
+#define SN_ALGDS_BITVEC_H
+
+#include <bits/stdc++.h>
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+namespace basic {
+
+    namespace bits {
+        inline size_t popcount(uint64_t x) {
+            return static_cast<size_t>(__builtin_popcountll(x));
+        }
+
+        // x != 0
+        inline size_t ctz(uint64_t x) {
+            return static_cast<size_t>(__builtin_ctzll(x));
+        }
+
+        // position of the k-th (0-based) set bit of x, k < popcount(x)
+        inline size_t select_in_word(uint64_t x, size_t k) {
+#if defined(__BMI2__)
+            return ctz(_pdep_u64(uint64_t(1) << k, x));
+#else
+            for (; k > 0; --k)
+                x &= x - 1;
+            return ctz(x);
+#endif
+        }
+
+        // dst[i] = op(dst[i], src[i]) for n words
+        template <typename Op, typename VOp>
+        inline void bulk(uint64_t* dst, const uint64_t* src, size_t n, Op op, VOp vop) {
+            size_t i = 0;
+#if defined(__AVX2__)
+            for (; i + 4 <= n; i += 4) {
+                __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+                __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), vop(a, b));
+            }
+#else
+            (void)vop;
+#endif
+            for (; i < n; ++i)
+                dst[i] = op(dst[i], src[i]);
+        }
+
+#if defined(__AVX2__)
+#define SN_ALGDS_BITVEC_VOP(expr) [](__m256i a, __m256i b) { return expr; }
+#else
+#define SN_ALGDS_BITVEC_VOP(expr) [](int, int) { return 0; }
+#endif
+    }
+
+    // Packed bit vector, 64 bits per word, bits past size are always 0
+    class bitvec {
+    public:
+        constexpr const static size_t npos = static_cast<size_t>(-1);
+        constexpr const static size_t word_bits = 64;
+
+        class reference {
+        private:
+            uint64_t* word;
+            uint64_t mask;
+        public:
+            reference(uint64_t* word_, size_t bit) : word(word_), mask(uint64_t(1) << bit) {}
+            operator bool() const {
+                return (*word & mask) != 0;
+            }
+            reference& operator=(bool v) {
+                if (v)
+                    *word |= mask;
+                else
+                    *word &= ~mask;
+                return *this;
+            }
+            reference& operator=(const reference& rhs) {
+                return *this = static_cast<bool>(rhs);
+            }
+            bool operator~() const {
+                return !static_cast<bool>(*this);
+            }
+            reference& flip() {
+                *word ^= mask;
+                return *this;
+            }
+        };
+
+        std::vector<uint64_t> data;
+        const int size;
+
+        bitvec(int size_, bool dfl = false)
+            : data((size_ + word_bits - 1) / word_bits, dfl ? ~uint64_t(0) : 0), size(size_) {
+            trim();
+        }
+
+        bitvec(const bitvec&) = default;
+        bitvec(bitvec&&) = default;
+
+        bitvec& operator=(const bitvec& rhs) {
+            assert(size == rhs.size);
+            data = rhs.data;
+            return *this;
+        }
+
+        size_t words() const {
+            return data.size();
+        }
+
+        bool operator[](std::size_t idx) const {
+            return (data[idx / word_bits] >> (idx % word_bits)) & 1;
+        }
+        reference operator[](std::size_t idx) {
+            return reference(&data[idx / word_bits], idx % word_bits);
+        }
+        bool test(size_t idx) const {
+            return (*this)[idx];
+        }
+        bitvec& set(size_t idx, bool v = true) {
+            (*this)[idx] = v;
+            return *this;
+        }
+        bitvec& reset(size_t idx) {
+            return set(idx, false);
+        }
+        bitvec& flip(size_t idx) {
+            data[idx / word_bits] ^= uint64_t(1) << (idx % word_bits);
+            return *this;
+        }
+        bitvec& set_all(bool v = true) {
+            std::fill(data.begin(), data.end(), v ? ~uint64_t(0) : 0);
+            trim();
+            return *this;
+        }
+
+        size_t count() const {
+            size_t ret = 0;
+            for (auto w : data)
+                ret += bits::popcount(w);
+            return ret;
+        }
+        bool and_all() const {
+            return count() == static_cast<size_t>(size);
+        }
+        bool any() const {
+            return std::any_of(data.begin(), data.end(), [](uint64_t w) { return w != 0; });
+        }
+        bool none() const {
+            return !any();
+        }
+
+        size_t find_first() const {
+            return find_from_word(0, 0);
+        }
+        // first set bit after idx
+        size_t find_next(size_t idx) const {
+            ++idx;
+            if (idx >= static_cast<size_t>(size))
+                return npos;
+            return find_from_word(idx / word_bits, idx % word_bits);
+        }
+        template <typename F>
+        void for_each_set(F&& f) const {
+            for (size_t i = 0; i < data.size(); ++i) {
+                for (uint64_t w = data[i]; w; w &= w - 1)
+                    f(i * word_bits + bits::ctz(w));
+            }
+        }
+
+        bitvec& operator&=(const bitvec& rhs) {
+            assert(size == rhs.size);
+            bits::bulk(data.data(), rhs.data.data(), data.size(),
+                [](uint64_t a, uint64_t b) { return a & b; },
+                SN_ALGDS_BITVEC_VOP(_mm256_and_si256(a, b)));
+            return *this;
+        }
+        bitvec& operator|=(const bitvec& rhs) {
+            assert(size == rhs.size);
+            bits::bulk(data.data(), rhs.data.data(), data.size(),
+                [](uint64_t a, uint64_t b) { return a | b; },
+                SN_ALGDS_BITVEC_VOP(_mm256_or_si256(a, b)));
+            return *this;
+        }
+        bitvec& operator^=(const bitvec& rhs) {
+            assert(size == rhs.size);
+            bits::bulk(data.data(), rhs.data.data(), data.size(),
+                [](uint64_t a, uint64_t b) { return a ^ b; },
+                SN_ALGDS_BITVEC_VOP(_mm256_xor_si256(a, b)));
+            return *this;
+        }
+        // this & ~rhs
+        bitvec& and_not(const bitvec& rhs) {
+            assert(size == rhs.size);
+            bits::bulk(data.data(), rhs.data.data(), data.size(),
+                [](uint64_t a, uint64_t b) { return a & ~b; },
+                SN_ALGDS_BITVEC_VOP(_mm256_andnot_si256(b, a)));
+            return *this;
+        }
+        bitvec operator~() const {
+            bitvec ret(*this);
+            for (auto& w : ret.data)
+                w = ~w;
+            ret.trim();
+            return ret;
+        }
+        bool operator==(const bitvec& rhs) const {
+            return size == rhs.size && data == rhs.data;
+        }
+        bool operator!=(const bitvec& rhs) const {
+            return !(*this == rhs);
+        }
+
+    private:
+        void trim() {
+            if (size % word_bits && !data.empty())
+                data.back() &= (uint64_t(1) << (size % word_bits)) - 1;
+        }
+        size_t find_from_word(size_t i, size_t bit) const {
+            if (i >= data.size())
+                return npos;
+            uint64_t w = data[i] & (~uint64_t(0) << bit);
+            while (!w) {
+                if (++i >= data.size())
+                    return npos;
+                w = data[i];
+            }
+            return i * word_bits + bits::ctz(w);
+        }
+    };
+
+    inline bitvec operator&(bitvec lhs, const bitvec& rhs) {
+        return lhs &= rhs;
+    }
+    inline bitvec operator|(bitvec lhs, const bitvec& rhs) {
+        return lhs |= rhs;
+    }
+    inline bitvec operator^(bitvec lhs, const bitvec& rhs) {
+        return lhs ^= rhs;
+    }
+
+    // Succinct rank/select index over a bitvec, rebuild after the bitvec is modified
+    // rank: cumulative count per 512-bit block + at most 8 popcounts
+    // select: every 512-th one is sampled to bound the block search
+    // ref: Vigna, Broadword Implementation of Rank/Select Queries
+    class rank_select {
+    private:
+        constexpr const static size_t block_words = 8;
+        constexpr const static size_t block_bits = block_words * bitvec::word_bits;
+        constexpr const static size_t sample_rate = 512;
+
+        const bitvec& bv;
+        std::vector<uint64_t> block_rank;
+        std::vector<uint32_t> select_sample;
+        size_t ones;
+    public:
+        explicit rank_select(const bitvec& bv_) : bv(bv_) {
+            build();
+        }
+
+        void build() {
+            const size_t nw = bv.words();
+            const size_t nb = nw / block_words + 1;
+            block_rank.assign(nb + 1, 0);
+            select_sample.clear();
+            uint64_t acc = 0;
+            for (size_t b = 0; b < nb; ++b) {
+                block_rank[b] = acc;
+                for (size_t i = b * block_words; i < std::min(nw, (b + 1) * block_words); ++i) {
+                    const size_t c = bits::popcount(bv.data[i]);
+                    // sample the block containing each (k * sample_rate)-th one
+                    while (select_sample.size() * sample_rate < acc + c)
+                        select_sample.push_back(static_cast<uint32_t>(b));
+                    acc += c;
+                }
+            }
+            block_rank[nb] = acc;
+            ones = acc;
+            select_sample.push_back(static_cast<uint32_t>(nb - 1));
+        }
+
+        size_t count() const {
+            return ones;
+        }
+
+        // number of ones in [0, idx)
+        size_t rank(size_t idx) const {
+            const size_t w = idx / bitvec::word_bits;
+            const size_t b = w / block_words;
+            size_t ret = block_rank[b];
+            for (size_t i = b * block_words; i < w; ++i)
+                ret += bits::popcount(bv.data[i]);
+            if (idx % bitvec::word_bits)
+                ret += bits::popcount(bv.data[w] << (bitvec::word_bits - idx % bitvec::word_bits));
+            return ret;
+        }
+
+        size_t rank0(size_t idx) const {
+            return idx - rank(idx);
+        }
+
+        // position of the k-th (0-based) one, bitvec::npos if k >= count()
+        size_t select(size_t k) const {
+            if (k >= ones)
+                return bitvec::npos;
+            size_t lo = select_sample[k / sample_rate];
+            size_t hi = select_sample[k / sample_rate + 1] + 1;
+            // last block with block_rank <= k
+            while (hi - lo > 1) {
+                size_t mid = (lo + hi) / 2;
+                if (block_rank[mid] <= k)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+            k -= block_rank[lo];
+            for (size_t i = lo * block_words; ; ++i) {
+                const size_t c = bits::popcount(bv.data[i]);
+                if (k < c)
+                    return i * bitvec::word_bits + bits::select_in_word(bv.data[i], k);
+                k -= c;
+            }
+        }
+    };
+
+    // Roaring-style compressed bitmap for sparse sets of uint32_t
+    // 2^16 chunks, each an array container (sorted, <= 4096 values) or a 65536-bit bitvec container
+    // ref: https://roaringbitmap.org/
+    class roaring_bitmap {
+    private:
+        constexpr const static size_t array_limit = 4096;
+        constexpr const static int chunk_bits = 1 << 16;
+
+        struct container {
+            std::vector<uint16_t> array;
+            std::unique_ptr<bitvec> bitmap;
+            size_t card = 0;
+
+            container() = default;
+            container(const container& rhs)
+                : array(rhs.array), bitmap(rhs.bitmap ? std::make_unique<bitvec>(*rhs.bitmap) : nullptr), card(rhs.card) {}
+            container(container&&) = default;
+            container& operator=(container&&) = default;
+
+            bool contains(uint16_t v) const {
+                if (bitmap)
+                    return bitmap->test(v);
+                return std::binary_search(array.begin(), array.end(), v);
+            }
+            bool add(uint16_t v) {
+                if (bitmap) {
+                    if (bitmap->test(v))
+                        return false;
+                    bitmap->set(v);
+                } else {
+                    auto it = std::lower_bound(array.begin(), array.end(), v);
+                    if (it != array.end() && *it == v)
+                        return false;
+                    array.insert(it, v);
+                    if (array.size() > array_limit)
+                        to_bitmap();
+                }
+                ++card;
+                return true;
+            }
+            bool remove(uint16_t v) {
+                if (bitmap) {
+                    if (!bitmap->test(v))
+                        return false;
+                    bitmap->reset(v);
+                    if (--card <= array_limit)
+                        to_array();
+                    return true;
+                }
+                auto it = std::lower_bound(array.begin(), array.end(), v);
+                if (it == array.end() || *it != v)
+                    return false;
+                array.erase(it);
+                --card;
+                return true;
+            }
+            void to_bitmap() {
+                bitmap = std::make_unique<bitvec>(chunk_bits);
+                for (auto v : array)
+                    bitmap->set(v);
+                array.clear();
+                array.shrink_to_fit();
+            }
+            void to_array() {
+                array.clear();
+                array.reserve(card);
+                bitmap->for_each_set([this](size_t v) { array.push_back(static_cast<uint16_t>(v)); });
+                bitmap.reset();
+            }
+            void normalize() {
+                if (bitmap) {
+                    card = bitmap->count();
+                    if (card <= array_limit)
+                        to_array();
+                } else {
+                    card = array.size();
+                    if (card > array_limit)
+                        to_bitmap();
+                }
+            }
+            template <typename F>
+            void for_each(uint32_t high, F&& f) const {
+                if (bitmap)
+                    bitmap->for_each_set([&](size_t v) { f(high | static_cast<uint32_t>(v)); });
+                else
+                    for (auto v : array)
+                        f(high | v);
+            }
+
+            static container intersect(const container& a, const container& b) {
+                container ret;
+                if (a.bitmap && b.bitmap) {
+                    ret.bitmap = std::make_unique<bitvec>(*a.bitmap & *b.bitmap);
+                } else if (a.bitmap || b.bitmap) {
+                    const container& arr = a.bitmap ? b : a;
+                    const container& bm = a.bitmap ? a : b;
+                    for (auto v : arr.array)
+                        if (bm.bitmap->test(v))
+                            ret.array.push_back(v);
+                } else {
+                    std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(ret.array));
+                }
+                ret.normalize();
+                return ret;
+            }
+            static container unite(const container& a, const container& b) {
+                container ret;
+                if (a.bitmap || b.bitmap || a.card + b.card > array_limit) {
+                    ret.bitmap = std::make_unique<bitvec>(chunk_bits);
+                    for (const container* c : { &a, &b }) {
+                        if (c->bitmap)
+                            *ret.bitmap |= *c->bitmap;
+                        else
+                            for (auto v : c->array)
+                                ret.bitmap->set(v);
+                    }
+                } else {
+                    std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(ret.array));
+                }
+                ret.normalize();
+                return ret;
+            }
+        };
+
+        // sorted by key (high 16 bits)
+        std::vector<std::pair<uint16_t, container>> chunks;
+
+        container* find_chunk(uint16_t key) {
+            auto it = std::lower_bound(chunks.begin(), chunks.end(), key, [](const auto& c, uint16_t k) { return c.first < k; });
+            return it != chunks.end() && it->first == key ? &it->second : nullptr;
+        }
+        const container* find_chunk(uint16_t key) const {
+            return const_cast<roaring_bitmap*>(this)->find_chunk(key);
+        }
+    public:
+        roaring_bitmap() = default;
+        roaring_bitmap(std::initializer_list<uint32_t> il) {
+            for (auto v : il)
+                add(v);
+        }
+
+        bool add(uint32_t v) {
+            const uint16_t key = static_cast<uint16_t>(v >> 16);
+            auto it = std::lower_bound(chunks.begin(), chunks.end(), key, [](const auto& c, uint16_t k) { return c.first < k; });
+            if (it == chunks.end() || it->first != key)
+                it = chunks.emplace(it, key, container{});
+            return it->second.add(static_cast<uint16_t>(v));
+        }
+        bool remove(uint32_t v) {
+            const uint16_t key = static_cast<uint16_t>(v >> 16);
+            container* c = find_chunk(key);
+            if (!c || !c->remove(static_cast<uint16_t>(v)))
+                return false;
+            if (c->card == 0)
+                chunks.erase(std::find_if(chunks.begin(), chunks.end(), [key](const auto& p) { return p.first == key; }));
+            return true;
+        }
+        bool contains(uint32_t v) const {
+            const container* c = find_chunk(static_cast<uint16_t>(v >> 16));
+            return c && c->contains(static_cast<uint16_t>(v));
+        }
+        size_t cardinality() const {
+            size_t ret = 0;
+            for (const auto& c : chunks)
+                ret += c.second.card;
+            return ret;
+        }
+        bool empty() const {
+            return chunks.empty();
+        }
+
+        template <typename F>
+        void for_each(F&& f) const {
+            for (const auto& c : chunks)
+                c.second.for_each(static_cast<uint32_t>(c.first) << 16, f);
+        }
+        std::vector<uint32_t> to_vector() const {
+            std::vector<uint32_t> ret;
+            ret.reserve(cardinality());
+            for_each([&ret](uint32_t v) { ret.push_back(v); });
+            return ret;
+        }
+
+        friend roaring_bitmap operator&(const roaring_bitmap& a, const roaring_bitmap& b) {
+            roaring_bitmap ret;
+            auto i = a.chunks.begin(), j = b.chunks.begin();
+            while (i != a.chunks.end() && j != b.chunks.end()) {
+                if (i->first < j->first) {
+                    ++i;
+                } else if (j->first < i->first) {
+                    ++j;
+                } else {
+                    container c = container::intersect(i->second, j->second);
+                    if (c.card)
+                        ret.chunks.emplace_back(i->first, std::move(c));
+                    ++i, ++j;
+                }
+            }
+            return ret;
+        }
+        friend roaring_bitmap operator|(const roaring_bitmap& a, const roaring_bitmap& b) {
+            roaring_bitmap ret;
+            auto i = a.chunks.begin(), j = b.chunks.begin();
+            while (i != a.chunks.end() || j != b.chunks.end()) {
+                if (j == b.chunks.end() || (i != a.chunks.end() && i->first < j->first)) {
+                    ret.chunks.emplace_back(i->first, container(i->second));
+                    ++i;
+                } else if (i == a.chunks.end() || j->first < i->first) {
+                    ret.chunks.emplace_back(j->first, container(j->second));
+                    ++j;
+                } else {
+                    ret.chunks.emplace_back(i->first, container::unite(i->second, j->second));
+                    ++i, ++j;
+                }
+            }
+            return ret;
+        }
+    };
+
+}
+
+#undef SN_ALGDS_BITVEC_VOP
+
+#endif
@@ -2,6 +2,7 @@
 #define SN_ALGDS_MISCS_H
 
 #include <bits/stdc++.h>
+#include "range_query.hpp"
 using namespace std;
 
 
@@ -225,49 +226,22 @@ namespace misc {
         return ret;
     }
 
-    // calculate a * b mod m
+    // calculate a * b mod m, see number::modular for Montgomery/Barrett reduction
     inline int mul_mod(int a, int b, int m) {
-        int ret;
-        __asm__ __volatile__(
-            "tmull %%ebx\n" \
-            "tdivl %%ecx\n"
-            :"=d"(ret)
-            :"a"(a)
-            ,"b"(b), "c"(m)
-        );
-        return ret;
+        return static_cast<int>(static_cast<long long>(a) * b % m);
     }
 
     inline long long mul_mod_ll(long long a, long long b, long long m) {
-        long long d = static_cast<long long>(floor(a * static_cast<double>(b) / m + 0.5));
-        long long ret = a * b - d * m; // UB
-        if (ret < 0) ret += m;
-        return ret;
+        long long ret = static_cast<long long>(static_cast<__int128>(a) * b % m);
+        return ret < 0 ? ret + m : ret;
     }
 
 
+    // index of the minimum in [i, j], see range_query for sparse table/segment tree/fenwick
     auto rmq_st(std::vector<int>& arr, size_t n) {
-        size_t log2n = log2(n) + 1;
-        std::vector<std::vector<int>> m(n, std::vector<int>(log2n, 0));
-        for (size_t i = 0; i < n; ++i) {
-            m[i][0] = i;
-        }
-        for (size_t j = 1; j < log2n; ++j) {
-            for (size_t i = 0; i + (1 << j) - 1 < n; ++i) {
-                if (arr[m[i][j - 1]] < arr[m[i + (1 << (j - 1))][j - 1]]) {
-                    m[i][j] = m[i][j - 1];
-                } else {
-                    m[i][j] = m[i + (1 << (j - 1))][j - 1];
-                }
-            }
-        }
-        auto rmq_query = [=](size_t i, size_t j) {
-            size_t k = log2(j - i + 1);
-            if (arr[m[i][k]] < arr[m[j - (1 << k) + 1][k]]) {
-                return m[i][k];
-            } else {
-                return m[j - (1 << k) + 1][k];
-            }
+        auto rmq = std::make_shared<const range_query::block_rmq<int>>(arr.begin(), arr.begin() + n);
+        auto rmq_query = [rmq](size_t i, size_t j) {
+            return static_cast<int>(rmq->query_index(i, j + 1));
         };
         return rmq_query;
     }
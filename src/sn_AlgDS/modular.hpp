@@ -0,0 +1,381 @@
+#ifndef SN_ALGDS_MODULAR_H
+#define SN_ALGDS_MODULAR_H
+
+#include <bits/stdc++.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+// Modular arithmetic on 32/64-bit unsigned moduli
+// Products are formed in the double-width type (uint64_t / unsigned __int128), never in floating point.
+namespace number {
+    namespace modular {
+
+        using u128 = unsigned __int128;
+
+        template <typename UInt>
+        struct wide;
+        template <>
+        struct wide<uint32_t> {
+            using type = uint64_t;
+        };
+        template <>
+        struct wide<uint64_t> {
+            using type = u128;
+        };
+        template <typename UInt>
+        using wide_t = typename wide<UInt>::type;
+
+        inline uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t m) {
+            return static_cast<uint64_t>(static_cast<u128>(a) * b % m);
+        }
+
+        inline uint64_t add_mod(uint64_t a, uint64_t b, uint64_t m) {
+            // a, b < m
+            return a >= m - b ? a - (m - b) : a + b;
+        }
+
+        inline uint64_t pow_mod(uint64_t base, uint64_t exp, uint64_t m) {
+            uint64_t ret = 1 % m;
+            for (base %= m; exp; exp >>= 1, base = mul_mod(base, base, m))
+                if (exp & 1)
+                    ret = mul_mod(ret, base, m);
+            return ret;
+        }
+
+        // Barrett reduction: x mod m as x - floor(x * floor(2^2w / m) / 2^2w) * m, w = bits of UInt
+        // One multiply-high plus one multiply instead of a division, any m >= 1.
+        // ref: https://en.wikipedia.org/wiki/Barrett_reduction
+        template <typename UInt>
+        class barrett {
+        public:
+            using wide_type = wide_t<UInt>;
+
+            explicit barrett(UInt m_) : m(m_), im(static_cast<wide_type>(~wide_type(0)) / m_) {}
+
+            UInt modulus() const {
+                return m;
+            }
+
+            // any x representable in the wide type, the estimated quotient is at most 2 short
+            UInt reduce(wide_type x) const {
+                wide_type r = x - mulhi(x) * m;
+                while (r >= m)
+                    r -= m;
+                return static_cast<UInt>(r);
+            }
+            wide_type quotient(wide_type x) const {
+                wide_type q = mulhi(x);
+                for (wide_type r = x - q * m; r >= m; r -= m)
+                    ++q;
+                return q;
+            }
+
+            UInt mul(UInt a, UInt b) const {
+                return reduce(static_cast<wide_type>(a) * b);
+            }
+            UInt pow(UInt base, uint64_t exp) const {
+                UInt ret = reduce(1);
+                for (base = reduce(base); exp; exp >>= 1, base = mul(base, base))
+                    if (exp & 1)
+                        ret = mul(ret, base);
+                return ret;
+            }
+
+        private:
+            UInt m;
+            wide_type im;
+
+            static uint64_t mulhi(uint64_t x, uint64_t y) {
+                return static_cast<uint64_t>((static_cast<u128>(x) * y) >> 64);
+            }
+            // floor(x * im / 2^(2w))
+            uint64_t mulhi(uint64_t x) const {
+                return mulhi(x, im);
+            }
+            u128 mulhi(u128 x) const {
+                const uint64_t x0 = static_cast<uint64_t>(x), x1 = static_cast<uint64_t>(x >> 64);
+                const uint64_t i0 = static_cast<uint64_t>(im), i1 = static_cast<uint64_t>(im >> 64);
+                const u128 p01 = static_cast<u128>(x0) * i1, p10 = static_cast<u128>(x1) * i0;
+                const u128 mid = static_cast<u128>(mulhi(x0, i0)) + static_cast<uint64_t>(p01) + static_cast<uint64_t>(p10);
+                return static_cast<u128>(x1) * i1 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+            }
+        };
+
+        // Montgomery form x * R mod m, R = 2^w, m odd
+        // reduce(t) = t / R mod m by subtracting the high half of (t * m^-1 mod R) * m, no carries out of the wide type.
+        // ref: Montgomery, Modular Multiplication Without Trial Division
+        // ref: https://cp-algorithms.com/algebra/montgomery_multiplication.html
+        template <typename UInt>
+        class montgomery {
+        public:
+            using wide_type = wide_t<UInt>;
+            constexpr const static int width = std::numeric_limits<UInt>::digits;
+
+            explicit montgomery(UInt m_) : m(m_), inv(m_) {
+                // Newton: each step doubles the correct low bits (m * m == 1 mod 8 already)
+                for (int i = 3; i < width; i <<= 1)
+                    inv *= UInt(2) - m * inv;
+                r1 = static_cast<UInt>(static_cast<UInt>(-m) % m);
+                r2 = static_cast<UInt>(static_cast<wide_type>(r1) * r1 % m);
+            }
+
+            UInt modulus() const {
+                return m;
+            }
+            // m^-1 mod R
+            UInt inverse() const {
+                return inv;
+            }
+
+            // t < m * R, returns t * R^-1 mod m
+            UInt reduce(wide_type t) const {
+                const UInt q = static_cast<UInt>(t) * inv;
+                const UInt hi = static_cast<UInt>(t >> width);
+                const UInt qm = static_cast<UInt>((static_cast<wide_type>(q) * m) >> width);
+                return hi >= qm ? hi - qm : hi - qm + m;
+            }
+
+            UInt to_mont(UInt x) const {
+                return reduce(static_cast<wide_type>(x % m) * r2);
+            }
+            UInt from_mont(UInt x) const {
+                return reduce(x);
+            }
+            UInt one() const {
+                return r1;
+            }
+
+            UInt mul(UInt a, UInt b) const {
+                return reduce(static_cast<wide_type>(a) * b);
+            }
+            UInt add(UInt a, UInt b) const {
+                return a >= m - b ? a - (m - b) : a + b;
+            }
+            UInt sub(UInt a, UInt b) const {
+                return a >= b ? a - b : a - b + m;
+            }
+            // base and result in Montgomery form
+            UInt pow(UInt base, uint64_t exp) const {
+                UInt ret = r1;
+                for (; exp; exp >>= 1, base = mul(base, base))
+                    if (exp & 1)
+                        ret = mul(ret, base);
+                return ret;
+            }
+
+        private:
+            UInt m;
+            UInt inv;
+            UInt r1;
+            UInt r2;
+        };
+
+        namespace detail {
+            template <typename UInt>
+            bool miller_rabin_witness(const montgomery<UInt>& mg, UInt n, uint64_t base) {
+                const UInt a = mg.to_mont(static_cast<UInt>(base % n));
+                if (a == 0)
+                    return false;
+                const UInt one = mg.one(), minus_one = mg.sub(0, one);
+                UInt d = n - 1;
+                const int s = __builtin_ctzll(d);
+                d >>= s;
+                UInt x = mg.pow(a, d);
+                if (x == one || x == minus_one)
+                    return false;
+                for (int i = 1; i < s; ++i) {
+                    x = mg.mul(x, x);
+                    if (x == minus_one)
+                        return false;
+                }
+                return true;
+            }
+        }
+
+        // Deterministic Miller-Rabin for every 64-bit n
+        // ref: https://miller-rabin.appspot.com/
+        inline bool is_prime(uint64_t n) {
+            if (n < 64)
+                return (uint64_t(0x28208a20a08a28ac) >> n) & 1;
+            if (!(n & 1) || n % 3 == 0 || n % 5 == 0 || n % 7 == 0)
+                return false;
+            if (n < 121)
+                return true;
+            if (n < (uint64_t(1) << 32)) {
+                const montgomery<uint32_t> mg(static_cast<uint32_t>(n));
+                for (uint64_t a : {2, 7, 61})
+                    if (detail::miller_rabin_witness<uint32_t>(mg, static_cast<uint32_t>(n), a))
+                        return false;
+                return true;
+            }
+            const montgomery<uint64_t> mg(n);
+            for (uint64_t a : {2, 325, 9375, 28178, 450775, 9780504, 1795265022})
+                if (detail::miller_rabin_witness<uint64_t>(mg, n, a))
+                    return false;
+            return true;
+        }
+
+        // A non-trivial factor of odd composite n
+        // Brent's cycle detection on x^2 + c in Montgomery form, gcd taken once per 128 steps on the product of differences.
+        // ref: Brent, An Improved Monte Carlo Factorization Algorithm
+        inline uint64_t pollard_brent(uint64_t n) {
+            const montgomery<uint64_t> mg(n);
+            constexpr const uint64_t batch = 128;
+            for (uint64_t c0 = 1; ; ++c0) {
+                const uint64_t c = mg.to_mont(c0);
+                auto f = [&](uint64_t v) { return mg.add(mg.mul(v, v), c); };
+                uint64_t y = mg.to_mont(2), x = y, ys = y, q = mg.one(), g = 1;
+                for (uint64_t r = 1; g == 1; r <<= 1) {
+                    x = y;
+                    for (uint64_t i = 0; i < r; ++i)
+                        y = f(y);
+                    for (uint64_t k = 0; k < r && g == 1; k += batch) {
+                        ys = y;
+                        for (uint64_t i = 0; i < batch && i < r - k; ++i) {
+                            y = f(y);
+                            q = mg.mul(q, mg.sub(x, y));
+                        }
+                        g = std::gcd(q, n);
+                    }
+                }
+                if (g == n) {
+                    // the batch overshot, walk it again one step at a time
+                    do {
+                        ys = f(ys);
+                        g = std::gcd(mg.sub(x, ys), n);
+                    } while (g == 1);
+                }
+                if (g != n)
+                    return g;
+            }
+        }
+
+        // Prime factors of n with multiplicity, ascending
+        inline vector<uint64_t> factorize(uint64_t n) {
+            vector<uint64_t> ret;
+            if (n <= 1)
+                return ret;
+            const int twos = __builtin_ctzll(n);
+            ret.insert(ret.end(), twos, 2);
+            n >>= twos;
+            for (uint64_t p = 3; p < 64 && p * p <= n; p += 2)
+                for (; n % p == 0; n /= p)
+                    ret.push_back(p);
+            vector<uint64_t> stack;
+            if (n > 1)
+                stack.push_back(n);
+            while (!stack.empty()) {
+                const uint64_t v = stack.back();
+                stack.pop_back();
+                if (is_prime(v)) {
+                    ret.push_back(v);
+                    continue;
+                }
+                const uint64_t d = pollard_brent(v);
+                stack.push_back(d);
+                stack.push_back(v / d);
+            }
+            std::sort(ret.begin(), ret.end());
+            return ret;
+        }
+
+#if defined(__AVX2__)
+        namespace detail {
+            // 8 lanes of montgomery<uint32_t>::reduce(a * b), m < 2^31 so that r + m cannot wrap
+            inline __m256i montgomery_mul_x8(__m256i a, __m256i b, __m256i m, __m256i inv) {
+                const __m256i t_even = _mm256_mul_epu32(a, b);
+                const __m256i t_odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+                const __m256i qm_even = _mm256_mul_epu32(_mm256_mul_epu32(t_even, inv), m);
+                const __m256i qm_odd = _mm256_mul_epu32(_mm256_mul_epu32(t_odd, inv), m);
+                // high halves of the even lanes moved down, odd lanes already in place
+                const __m256i hi = _mm256_blend_epi32(_mm256_srli_epi64(t_even, 32), t_odd, 0xaa);
+                const __m256i qm = _mm256_blend_epi32(_mm256_srli_epi64(qm_even, 32), qm_odd, 0xaa);
+                const __m256i r = _mm256_sub_epi32(hi, qm);
+                return _mm256_min_epu32(r, _mm256_add_epi32(r, m));
+            }
+        }
+#endif
+
+        // out[i] = base[i] ^ exp mod m for a shared exponent
+        // Every element walks the same square-and-multiply chain, so odd m < 2^31 runs 8 lanes at a time under AVX2.
+        inline void pow_mod(const uint32_t* base, uint64_t exp, size_t n, uint32_t m, uint32_t* out) {
+            if (m == 1) {
+                std::fill(out, out + n, 0);
+                return;
+            }
+            if (!(m & 1)) {
+                const barrett<uint32_t> br(m);
+                for (size_t i = 0; i < n; ++i)
+                    out[i] = br.pow(base[i], exp);
+                return;
+            }
+            const montgomery<uint32_t> mg(m);
+            size_t i = 0;
+#if defined(__AVX2__)
+            if (m < (uint32_t(1) << 31)) {
+                const __m256i vm = _mm256_set1_epi32(static_cast<int>(m));
+                const __m256i vinv = _mm256_set1_epi32(static_cast<int>(mg.inverse()));
+                const __m256i one = _mm256_set1_epi32(1);
+                alignas(32) uint32_t buf[8];
+                for (; i + 8 <= n; i += 8) {
+                    for (size_t j = 0; j < 8; ++j)
+                        buf[j] = mg.to_mont(base[i + j]);
+                    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(buf));
+                    __m256i r = _mm256_set1_epi32(static_cast<int>(mg.one()));
+                    for (uint64_t e = exp; e; e >>= 1, b = detail::montgomery_mul_x8(b, b, vm, vinv))
+                        if (e & 1)
+                            r = detail::montgomery_mul_x8(r, b, vm, vinv);
+                    // multiplying by plain 1 leaves Montgomery form
+                    r = detail::montgomery_mul_x8(r, one, vm, vinv);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), r);
+                }
+            }
+#endif
+            for (; i < n; ++i)
+                out[i] = mg.from_mont(mg.pow(mg.to_mont(base[i]), exp));
+        }
+
+        // out[i] = base[i] ^ exp[i] mod m
+        // Four independent chains are interleaved so the multiplier latency overlaps.
+        inline void pow_mod(const uint64_t* base, const uint64_t* exp, size_t n, uint64_t m, uint64_t* out) {
+            if (!(m & 1) || m == 1) {
+                for (size_t i = 0; i < n; ++i)
+                    out[i] = pow_mod(base[i], exp[i], m);
+                return;
+            }
+            const montgomery<uint64_t> mg(m);
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                uint64_t b[4], e[4], r[4];
+                for (size_t j = 0; j < 4; ++j) {
+                    b[j] = mg.to_mont(base[i + j]);
+                    e[j] = exp[i + j];
+                    r[j] = mg.one();
+                }
+                while (e[0] | e[1] | e[2] | e[3]) {
+                    for (size_t j = 0; j < 4; ++j) {
+                        r[j] = (e[j] & 1) ? mg.mul(r[j], b[j]) : r[j];
+                        b[j] = mg.mul(b[j], b[j]);
+                        e[j] >>= 1;
+                    }
+                }
+                for (size_t j = 0; j < 4; ++j)
+                    out[i + j] = mg.from_mont(r[j]);
+            }
+            for (; i < n; ++i)
+                out[i] = mg.from_mont(mg.pow(mg.to_mont(base[i]), exp[i]));
+        }
+
+        inline vector<uint64_t> pow_mod(const vector<uint64_t>& base, const vector<uint64_t>& exp, uint64_t m) {
+            vector<uint64_t> ret(base.size());
+            pow_mod(base.data(), exp.data(), base.size(), m, ret.data());
+            return ret;
+        }
+
+    }
+}
+
+
+#endif
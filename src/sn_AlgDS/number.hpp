@@ -2,6 +2,7 @@
 #define SN_ALGDS_NUMBER_H
 
 #include <bits/stdc++.h>
+#include "modular.hpp"
 using namespace std;
 
 
@@ -56,7 +57,7 @@ namespace number {
         }
 
         vector<unsigned int> linear_prime_sieve(unsigned int n) {
-            bitset<PRIME_LIMIT> sieve_arr(0);
+            vector<bool> sieve_arr(n, false);
             vector<unsigned int> prime;
             for (size_t i = 2; i < n; ++i) {
                 if (!sieve_arr[i])
@@ -71,11 +72,11 @@ namespace number {
         }
 
         vector<uint32_t> sundaram_prime_sieve(uint32_t n) {
-            bitset<PRIME_LIMIT> sieve_arr{0};
             vector<uint32_t> prime;
             uint32_t m = (n - 2) / 2;
+            vector<bool> sieve_arr(m + 1, false);
             // sieve all 2(i + j + 2ij) + 1 odd number (that's all odd non-prime)
-            for (size_t i = 0; i < m; ++i) {
+            for (size_t i = 1; i <= m; ++i) {
                 uint32_t j = i;
                 uint64_t p = (uint64_t)i + j + 2 * i * j;
                 for (; p <= m; ++j, p = (uint64_t)i + j + 2 * i * j) {
@@ -98,8 +99,8 @@ namespace number {
         */
         unsigned int fast_prime_sum(unsigned int n) {
             unsigned int sqrt_n = floor(sqrt(n));
-            unsigned int arr_index[PRIME_LIMIT * 10];  //contain the value of n/1, n/2, ... n / sqrt(n) , 1, ..., sqrt(n)
-            unsigned int sum_prime[PRIME_LIMIT]; //contain the sum of first n primes
+            vector<unsigned int> arr_index(2 * sqrt_n + 1);  //contain the value of n/1, n/2, ... n / sqrt(n) , 1, ..., sqrt(n)
+            vector<unsigned int> sum_prime(2 * sqrt_n + 1); //contain the sum of first n primes
             for (unsigned int k = 0; k < sqrt_n + 1; ++k) {
                 arr_index[k] = k;
                 sum_prime[k] = (k * (k + 1)) / 2 - 1;
@@ -127,15 +128,16 @@ namespace number {
         }
 
         // http://www.cnblogs.com/jackiesteed/articles/2019910.html
+        // see modular::pollard_brent / modular::factorize for 64-bit n
         unsigned int pollard_rho(unsigned int n) {
             unsigned int x = 2;
             unsigned int y = 2;
             unsigned int d = 1;
-            auto f = [n](unsigned int v) { return (v ^ 2 + 1) % n; };
+            auto f = [n](unsigned int v) { return static_cast<unsigned int>(((uint64_t)v * v + 1) % n); };
             while (d == 1) {
                 x = f(x);
-                y = f(x); // f(f(y))
-                d = gcd((unsigned int)std::abs((double)x - y), n);
+                y = f(f(y));
+                d = std::gcd(x > y ? x - y : y - x, n);
             }
             if (d == n)
                 return 0;
@@ -143,6 +145,239 @@ namespace number {
                 return d;
         }
 
+        // Segmented sieve of Eratosthenes with a 2 * 3 * 5 wheel
+        // One byte holds the 8 residues coprime to 30 of a 30-number block (1/30 byte per number, odd-only is 1/16),
+        // multiples of 7, 11, 13 are copied in from a 1001-byte pattern, segments fit in L1,
+        // a sieving prime p only visits p * q with q coprime to 30.
+        // Memory is O(sqrt(hi) + segment * threads), hi up to ~10^12 and beyond.
+        // ref: https://github.com/kimwalisch/primesieve/wiki/Segmented-sieve-of-Eratosthenes
+        namespace wheel {
+            constexpr const uint32_t residue[8] = { 1, 7, 11, 13, 17, 19, 23, 29 };
+            constexpr const uint32_t gap[8] = { 6, 4, 2, 4, 2, 4, 6, 2 };
+            // bit of residue r (r coprime to 30), 8 otherwise
+            constexpr const uint8_t bit_of[30] = {
+                8, 0, 8, 8, 8, 8, 8, 1, 8, 8, 8, 2, 8, 3, 8, 8, 8, 4, 8, 5, 8, 8, 8, 6, 8, 8, 8, 8, 8, 7
+            };
+            // index of the smallest residue >= r
+            constexpr const uint8_t ceil_idx[30] = {
+                0, 0, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 4, 4, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7, 7, 7
+            };
+            constexpr const uint32_t presieve_period = 7 * 11 * 13;
+        }
+
+        class segmented_sieve {
+        public:
+            using sum_t = unsigned __int128;
+
+            // sieving primes are generated up to sqrt(limit)
+            explicit segmented_sieve(uint64_t limit_, size_t segment_bytes_ = 32 * 1024)
+                : limit(limit_), segment_bytes(segment_bytes_) {
+                const uint32_t root = static_cast<uint32_t>(std::sqrt(static_cast<long double>(limit))) + 1;
+                std::vector<bool> composite(root + 1, false);
+                for (uint32_t i = 2; i <= root; ++i) {
+                    if (composite[i])
+                        continue;
+                    if (i > 13)
+                        sieving_primes.push_back(i);
+                    for (uint64_t j = static_cast<uint64_t>(i) * i; j <= root; j += i)
+                        composite[j] = true;
+                }
+                presieve_pattern();
+            }
+
+            uint64_t max_value() const {
+                return limit;
+            }
+
+            // f(prime) for every prime in [lo, hi) in increasing order, hi <= limit + 1
+            template <typename F>
+            void for_each(uint64_t lo, uint64_t hi, F&& f) const {
+                for (uint64_t p : { 2, 3, 5 }) {
+                    if (lo <= p && p < hi)
+                        f(p);
+                }
+                sieve_segments(lo, hi, [&f](uint64_t base, const uint8_t* buf, size_t bytes) {
+                    for (size_t i = 0; i < bytes; ++i) {
+                        for (uint32_t b = buf[i]; b; b &= b - 1)
+                            f(base + i * 30 + wheel::residue[__builtin_ctz(b)]);
+                    }
+                });
+            }
+
+            std::vector<uint64_t> primes(uint64_t lo, uint64_t hi, unsigned threads = 0) const {
+                std::vector<std::vector<uint64_t>> parts = run_parallel<std::vector<uint64_t>>(lo, hi, threads,
+                    [this](uint64_t l, uint64_t h) {
+                        std::vector<uint64_t> ret;
+                        for_each(l, h, [&ret](uint64_t p) { ret.push_back(p); });
+                        return ret;
+                    });
+                std::vector<uint64_t> ret;
+                for (auto& p : parts)
+                    ret.insert(ret.end(), p.begin(), p.end());
+                return ret;
+            }
+
+            uint64_t count(uint64_t lo, uint64_t hi, unsigned threads = 0) const {
+                auto parts = run_parallel<uint64_t>(lo, hi, threads, [this](uint64_t l, uint64_t h) {
+                    uint64_t ret = 0;
+                    for (uint64_t p : { 2, 3, 5 })
+                        ret += l <= p && p < h;
+                    sieve_segments(l, h, [&ret](uint64_t, const uint8_t* buf, size_t bytes) {
+                        size_t i = 0;
+                        for (; i + 8 <= bytes; i += 8) {
+                            uint64_t w;
+                            memcpy(&w, buf + i, 8);
+                            ret += __builtin_popcountll(w);
+                        }
+                        for (; i < bytes; ++i)
+                            ret += __builtin_popcount(buf[i]);
+                    });
+                    return ret;
+                });
+                return std::accumulate(parts.begin(), parts.end(), uint64_t(0));
+            }
+
+            sum_t sum(uint64_t lo, uint64_t hi, unsigned threads = 0) const {
+                auto parts = run_parallel<sum_t>(lo, hi, threads, [this](uint64_t l, uint64_t h) {
+                    sum_t ret = 0;
+                    for_each(l, h, [&ret](uint64_t p) { ret += p; });
+                    return ret;
+                });
+                return std::accumulate(parts.begin(), parts.end(), sum_t(0));
+            }
+
+        private:
+            uint64_t limit;
+            size_t segment_bytes;
+            std::vector<uint32_t> sieving_primes;    // > 13
+            std::vector<uint8_t> pattern;            // multiples of 7, 11, 13 removed, period 1001 bytes
+
+            void presieve_pattern() {
+                pattern.assign(wheel::presieve_period, 0xFF);
+                for (uint32_t p : { 7, 11, 13 }) {
+                    for (uint64_t v = p; v < uint64_t(wheel::presieve_period) * 30; v += p) {
+                        if (wheel::bit_of[v % 30] < 8)
+                            pattern[v / 30] &= ~(1 << wheel::bit_of[v % 30]);
+                    }
+                }
+            }
+
+            // Split [lo, hi) into segment-aligned chunks, one per thread
+            template <typename R, typename F>
+            std::vector<R> run_parallel(uint64_t lo, uint64_t hi, unsigned threads, F&& f) const {
+                if (threads == 0)
+                    threads = std::max(1u, std::thread::hardware_concurrency());
+                const uint64_t span = uint64_t(segment_bytes) * 30;
+                const uint64_t segments = hi > lo ? (hi - lo + span - 1) / span : 0;
+                threads = static_cast<unsigned>(std::max<uint64_t>(1, std::min<uint64_t>(threads, segments)));
+                std::vector<R> ret(threads);
+                if (threads == 1) {
+                    ret[0] = f(lo, hi);
+                    return ret;
+                }
+                const uint64_t per = (segments + threads - 1) / threads * span;
+                std::vector<std::thread> workers;
+                for (unsigned t = 0; t < threads; ++t) {
+                    const uint64_t l = std::min(hi, lo + per * t);
+                    const uint64_t h = std::min(hi, lo + per * (t + 1));
+                    workers.emplace_back([&ret, &f, t, l, h] { ret[t] = f(l, h); });
+                }
+                for (auto& w : workers)
+                    w.join();
+                return ret;
+            }
+
+            // seg(base, buf, bytes): bit k of buf[i] set iff base + 30 * i + residue[k] is a prime in [lo, hi)
+            template <typename Seg>
+            void sieve_segments(uint64_t lo, uint64_t hi, Seg&& seg) const {
+                assert(hi <= limit + 1);
+                if (hi <= lo)
+                    return;
+                // next multiple p * q (q coprime to 30) of every sieving prime, carried across segments
+                std::vector<uint64_t> next(sieving_primes.size());
+                std::vector<uint8_t> next_idx(sieving_primes.size());
+                const uint64_t start = lo / 30 * 30;
+                for (size_t i = 0; i < sieving_primes.size(); ++i) {
+                    const uint64_t p = sieving_primes[i];
+                    uint64_t q = std::max(p, (start + p - 1) / p);
+                    const uint8_t idx = wheel::ceil_idx[q % 30];
+                    next[i] = p * (q / 30 * 30 + wheel::residue[idx]);
+                    next_idx[i] = idx;
+                }
+                std::vector<uint8_t> buf(segment_bytes);
+                for (uint64_t base = start; base < hi; base += uint64_t(segment_bytes) * 30) {
+                    const uint64_t seg_hi = std::min(hi, base + uint64_t(segment_bytes) * 30);
+                    const size_t bytes = static_cast<size_t>((seg_hi - base + 29) / 30);
+                    // presieved copy
+                    size_t off = static_cast<size_t>((base / 30) % wheel::presieve_period);
+                    for (size_t i = 0; i < bytes; ) {
+                        const size_t n = std::min<size_t>(bytes - i, wheel::presieve_period - off);
+                        memcpy(&buf[i], &pattern[off], n);
+                        i += n;
+                        off = 0;
+                    }
+                    if (base == 0)
+                        buf[0] = (buf[0] & ~uint8_t(1)) | 0x0E;   // 1 is not a prime, 7 11 13 are
+                    for (size_t i = 0; i < sieving_primes.size(); ++i) {
+                        const uint64_t p = sieving_primes[i];
+                        if (p * p >= seg_hi)
+                            break;
+                        uint64_t v = next[i];
+                        uint32_t idx = next_idx[i];
+                        for (; v < seg_hi; v += p * wheel::gap[idx], idx = (idx + 1) & 7)
+                            buf[(v - base) / 30] &= ~(1 << wheel::bit_of[v % 30]);
+                        next[i] = v;
+                        next_idx[i] = static_cast<uint8_t>(idx);
+                    }
+                    // trim to [lo, hi)
+                    for (uint32_t k = 0; k < 8; ++k) {
+                        if (base + wheel::residue[k] < lo)
+                            buf[0] &= ~(1 << k);
+                        if (base + (bytes - 1) * 30 + wheel::residue[k] >= seg_hi)
+                            buf[bytes - 1] &= ~(1 << k);
+                    }
+                    seg(base, buf.data(), bytes);
+                }
+            }
+        };
+
+        // Pull-style prime generator over [lo, hi), one segment buffered at a time
+        class prime_iterator {
+        public:
+            explicit prime_iterator(uint64_t lo = 0, uint64_t hi = uint64_t(1) << 40, size_t chunk = 1 << 20)
+                : sieve(hi - 1, 32 * 1024), cur(lo), end(hi), step(chunk) {}
+
+            // 0 when exhausted
+            uint64_t next() {
+                while (pos == buffer.size()) {
+                    if (cur >= end)
+                        return 0;
+                    const uint64_t h = cur + std::min(step, end - cur);
+                    buffer.clear();
+                    pos = 0;
+                    sieve.for_each(cur, h, [this](uint64_t p) { buffer.push_back(p); });
+                    cur = h;
+                }
+                return buffer[pos++];
+            }
+
+        private:
+            segmented_sieve sieve;
+            uint64_t cur;
+            uint64_t end;
+            uint64_t step;
+            std::vector<uint64_t> buffer;
+            size_t pos = 0;
+        };
+
+        inline uint64_t count_primes(uint64_t lo, uint64_t hi, unsigned threads = 0) {
+            return segmented_sieve(hi ? hi - 1 : 0).count(lo, hi, threads);
+        }
+
+        inline segmented_sieve::sum_t sum_primes(uint64_t lo, uint64_t hi, unsigned threads = 0) {
+            return segmented_sieve(hi ? hi - 1 : 0).sum(lo, hi, threads);
+        }
+
     }
 
     namespace gcd {
@@ -202,50 +437,55 @@ namespace number {
         }
 
 
-        //return gcd(a, b) ax + by = gcd(a, b)
-        int exgcd(int a, int b, int&x, int& y) {
-            if (!b) {
-                x = 1;
-                y = 0;
-                return a;
+        //return gcd(a, b) ax + by = gcd(a, b), iterative, any signed integer type
+        template <typename T>
+        T exgcd(T a, T b, T& x, T& y) {
+            T x1 = 0, y1 = 1;
+            x = 1;
+            y = 0;
+            while (b) {
+                const T q = a / b;
+                T t = a - q * b;
+                a = b;
+                b = t;
+                t = x - q * x1;
+                x = x1;
+                x1 = t;
+                t = y - q * y1;
+                y = y1;
+                y1 = t;
             }
-            int r = exgcd(b, a % b, x, y);
-            int t = x;
-            x = y;
-            y = t - a / b * y;
-            return r;
+            return a;
         }
 
-        //ax \\equiv b (mod n)
-        int solve_module_equation(int a, int b, int n) {
-            int x = 0, y = 0;
-            int d = exgcd(a, n, x, y);
-            if (b % d == 0) {
-                return x * b / d;
-            }
-            return -1;
+        //ax \\equiv b (mod n), a solution in [0, n / d), -1 if none
+        template <typename T>
+        T solve_module_equation(T a, T b, T n) {
+            T x = 0, y = 0;
+            const T d = exgcd(a, n, x, y);
+            if (b % d != 0)
+                return -1;
+            const T m = n / d;
+            x %= m;
+            if (x < 0)
+                x += m;
+            // x * (b / d) mod m without overflow
+            T r = static_cast<T>(static_cast<__int128>(x) * ((b / d) % m) % m);
+            return r < 0 ? r + m : r;
         }
 
         //ax \\equiv 1 (mod n)
-        int solve_reverse_element_exgcd(int a, int n) {
-            return solve_module_equation(a, 1, n);
+        template <typename T>
+        T solve_reverse_element_exgcd(T a, T n) {
+            return solve_module_equation(a, T(1), n);
         }
 
-        int modpow(int base, int exp, int modulus) {
-            base %= modulus;
-            int result = 1;
-            while (exp > 0) {
-                if (exp & 1) {
-                    result = (result * base) % modulus;
-                    base = (base * base) % modulus;
-                    exp >>= 1;
-                }
-            }
-            return result;
+        inline uint64_t modpow(uint64_t base, uint64_t exp, uint64_t modulus) {
+            return modular::pow_mod(base, exp, modulus);
         }
 
         // ax \equiv 1 (mod p), Fermat little theorem
-        int solve_reverse_element_fermat(int a, int p) {
+        inline uint64_t solve_reverse_element_fermat(uint64_t a, uint64_t p) {
             return modpow(a, p - 2, p);
         }
 
@@ -268,7 +508,7 @@ namespace number {
             // table of n! mod p
             vector<int> modtable(p + 1, 0);
             modtable[0] = 1;
-            for (int i = 1; i <= m; ++i) {
+            for (int i = 1; i < p && i <= m; ++i) {
                 modtable[i] = ((long long)modtable[i - 1] * i) % p;
             }
             long long ans = 1;
@@ -277,13 +517,13 @@ namespace number {
                 int b = n % p;
                 m /= p;
                 n /= p;
-                int dividend = modtable[a];
-                int divisor = (modtable[b] * modtable[a - b]) % p;
-                int gcd = ::gcd(dividend, divisor);
-                dividend /= gcd;
-                divisor /= gcd;
-                int rev_divisor = (solve_reverse_element_exgcd(divisor, p) + p) % p;
-                ans = (ans * dividend * rev_divisor) % p;
+                // C(a, b) = 0 for b > a
+                if (a < b)
+                    return 0;
+                long long dividend = modtable[a];
+                long long divisor = ((long long)modtable[b] * modtable[a - b]) % p;
+                long long rev_divisor = solve_reverse_element_exgcd(divisor, (long long)p);
+                ans = (ans * dividend % p) * rev_divisor % p;
             }
             return ans;
         }
@@ -0,0 +1,352 @@
+#ifndef SN_ALGDS_RANGE_QUERY_H
+#define SN_ALGDS_RANGE_QUERY_H
+
+#include <bits/stdc++.h>
+using namespace std;
+
+// All ranges are half-open [l, r)
+namespace range_query {
+
+    // Monoid: value_type, identity(), op(a, b), idempotent (op(a, a) == a, required by sparse_table)
+    template <typename T>
+    struct min_monoid {
+        using value_type = T;
+        constexpr const static bool idempotent = true;
+        static T identity() { return std::numeric_limits<T>::max(); }
+        static T op(const T& a, const T& b) { return b < a ? b : a; }
+    };
+
+    template <typename T>
+    struct max_monoid {
+        using value_type = T;
+        constexpr const static bool idempotent = true;
+        static T identity() { return std::numeric_limits<T>::lowest(); }
+        static T op(const T& a, const T& b) { return a < b ? b : a; }
+    };
+
+    template <typename T>
+    struct sum_monoid {
+        using value_type = T;
+        constexpr const static bool idempotent = false;
+        static T identity() { return T{}; }
+        static T op(const T& a, const T& b) { return a + b; }
+    };
+
+    using query_t = std::pair<size_t, size_t>;
+
+    inline size_t floor_log2(size_t x) {
+        return 63 - __builtin_clzll(static_cast<unsigned long long>(x));
+    }
+
+    // O(n log n) build, O(1) query, one flat allocation: table[k * n + i] = op[i, i + 2^k)
+    template <typename Monoid>
+    class sparse_table {
+    public:
+        using value_type = typename Monoid::value_type;
+        static_assert(Monoid::idempotent, "sparse_table overlaps two ranges, the monoid must be idempotent");
+
+        sparse_table() = default;
+        template <typename It>
+        sparse_table(It first, It last) {
+            build(first, last);
+        }
+        explicit sparse_table(const std::vector<value_type>& arr) : sparse_table(arr.begin(), arr.end()) {}
+
+        template <typename It>
+        void build(It first, It last) {
+            n = static_cast<size_t>(std::distance(first, last));
+            levels = n ? floor_log2(n) + 1 : 0;
+            table.resize(levels * n);
+            std::copy(first, last, table.begin());
+            for (size_t k = 1; k < levels; ++k) {
+                const value_type* prev = &table[(k - 1) * n];
+                value_type* cur = &table[k * n];
+                const size_t half = size_t(1) << (k - 1);
+                for (size_t i = 0; i + (half << 1) <= n; ++i)
+                    cur[i] = Monoid::op(prev[i], prev[i + half]);
+            }
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        // l < r
+        value_type query(size_t l, size_t r) const {
+            const size_t k = floor_log2(r - l);
+            return Monoid::op(table[k * n + l], table[k * n + r - (size_t(1) << k)]);
+        }
+
+        void query(const query_t* qs, size_t m, value_type* out) const {
+            for (size_t i = 0; i < m; ++i)
+                out[i] = query(qs[i].first, qs[i].second);
+        }
+        std::vector<value_type> query(const std::vector<query_t>& qs) const {
+            std::vector<value_type> ret(qs.size());
+            query(qs.data(), qs.size(), ret.data());
+            return ret;
+        }
+
+    private:
+        size_t n = 0;
+        size_t levels = 0;
+        std::vector<value_type> table;
+    };
+
+    // Linear-space RMQ returning the index of the (leftmost) extremum
+    // Blocks of 64: each position keeps a bitmask of the in-block monotone stack (O(1) in-block query by ctz),
+    // block extrema go into a sparse table of n / 64 * log n indices.
+    // ref: Fischer, Heun, Theoretical and Practical Improvements on the RMQ-Problem
+    // ref: https://codeforces.com/blog/entry/78931
+    template <typename T, typename Compare = std::less<T>>
+    class block_rmq {
+    private:
+        constexpr const static size_t block = 64;
+
+        std::vector<T> values;
+        std::vector<uint64_t> masks;
+        std::vector<uint32_t> block_table;
+        size_t levels = 0;
+        Compare comp;
+
+        uint32_t pick(uint32_t a, uint32_t b) const {
+            return comp(values[b], values[a]) ? b : a;
+        }
+        // [l, r] inside one block
+        uint32_t in_block(size_t l, size_t r) const {
+            const uint64_t m = masks[r] & (~uint64_t(0) << (l % block));
+            return static_cast<uint32_t>(l / block * block + __builtin_ctzll(m));
+        }
+        // blocks [bl, br)
+        uint32_t across_blocks(size_t bl, size_t br) const {
+            const size_t nb = (values.size() + block - 1) / block;
+            const size_t k = floor_log2(br - bl);
+            return pick(block_table[k * nb + bl], block_table[k * nb + br - (size_t(1) << k)]);
+        }
+    public:
+        block_rmq() = default;
+        template <typename It>
+        block_rmq(It first, It last, Compare comp_ = Compare{}) : values(first, last), comp(comp_) {
+            build();
+        }
+        explicit block_rmq(std::vector<T> arr, Compare comp_ = Compare{}) : values(std::move(arr)), comp(comp_) {
+            build();
+        }
+
+        void build() {
+            const size_t n = values.size();
+            const size_t nb = (n + block - 1) / block;
+            masks.assign(n, 0);
+            levels = nb ? floor_log2(nb) + 1 : 0;
+            block_table.assign(levels * nb, 0);
+            for (size_t b = 0; b < nb; ++b) {
+                const size_t s = b * block, e = std::min(n, s + block);
+                uint64_t stack = 0;
+                for (size_t i = s; i < e; ++i) {
+                    // pop everything strictly worse than i, ties keep the leftmost
+                    while (stack && comp(values[i], values[s + floor_log2(stack)]))
+                        stack &= ~(uint64_t(1) << floor_log2(stack));
+                    stack |= uint64_t(1) << (i - s);
+                    masks[i] = stack;
+                }
+                block_table[b] = in_block(s, e - 1);
+            }
+            for (size_t k = 1; k < levels; ++k) {
+                const size_t half = size_t(1) << (k - 1);
+                for (size_t b = 0; b + (half << 1) <= nb; ++b)
+                    block_table[k * nb + b] = pick(block_table[(k - 1) * nb + b], block_table[(k - 1) * nb + b + half]);
+            }
+        }
+
+        size_t size() const {
+            return values.size();
+        }
+        const T& operator[](size_t i) const {
+            return values[i];
+        }
+
+        // index of the extremum in [l, r), l < r
+        size_t query_index(size_t l, size_t r) const {
+            --r;
+            const size_t bl = l / block, br = r / block;
+            if (bl == br)
+                return in_block(l, r);
+            uint32_t ret = in_block(l, bl * block + block - 1);
+            if (bl + 1 < br)
+                ret = pick(ret, across_blocks(bl + 1, br));
+            return pick(ret, in_block(br * block, r));
+        }
+        const T& query(size_t l, size_t r) const {
+            return values[query_index(l, r)];
+        }
+
+        void query(const query_t* qs, size_t m, T* out) const {
+            for (size_t i = 0; i < m; ++i)
+                out[i] = query(qs[i].first, qs[i].second);
+        }
+        std::vector<T> query(const std::vector<query_t>& qs) const {
+            std::vector<T> ret(qs.size());
+            query(qs.data(), qs.size(), ret.data());
+            return ret;
+        }
+    };
+
+    // Binary indexed tree over a group (op = +, inverse = -)
+    template <typename T>
+    class fenwick {
+    public:
+        fenwick() = default;
+        explicit fenwick(size_t n) : tree(n + 1, T{}) {}
+        template <typename It>
+        fenwick(It first, It last) {
+            build(first, last);
+        }
+        explicit fenwick(const std::vector<T>& arr) : fenwick(arr.begin(), arr.end()) {}
+
+        // O(n): push every node into its parent once
+        template <typename It>
+        void build(It first, It last) {
+            tree.assign(1, T{});
+            tree.insert(tree.end(), first, last);
+            const size_t n = tree.size() - 1;
+            for (size_t i = 1; i <= n; ++i) {
+                const size_t j = i + (i & (~i + 1));
+                if (j <= n)
+                    tree[j] += tree[i];
+            }
+        }
+
+        size_t size() const {
+            return tree.size() - 1;
+        }
+
+        void add(size_t i, const T& delta) {
+            for (++i; i < tree.size(); i += i & (~i + 1))
+                tree[i] += delta;
+        }
+
+        // sum of [0, i)
+        T prefix(size_t i) const {
+            T ret{};
+            for (; i > 0; i -= i & (~i + 1))
+                ret += tree[i];
+            return ret;
+        }
+        T query(size_t l, size_t r) const {
+            return prefix(r) - prefix(l);
+        }
+
+        // smallest i with prefix(i + 1) >= value, size() if none (non-negative elements)
+        size_t lower_bound(T value) const {
+            size_t pos = 0;
+            for (size_t step = size_t(1) << floor_log2(tree.size()); step; step >>= 1) {
+                if (pos + step < tree.size() && tree[pos + step] < value) {
+                    pos += step;
+                    value -= tree[pos];
+                }
+            }
+            return pos;
+        }
+
+        void query(const query_t* qs, size_t m, T* out) const {
+            for (size_t i = 0; i < m; ++i)
+                out[i] = query(qs[i].first, qs[i].second);
+        }
+        std::vector<T> query(const std::vector<query_t>& qs) const {
+            std::vector<T> ret(qs.size());
+            query(qs.data(), qs.size(), ret.data());
+            return ret;
+        }
+
+    private:
+        std::vector<T> tree = std::vector<T>(1, T{});
+    };
+
+    // Bottom-up segment tree over any monoid (op may be non-commutative), 2n values
+    // ref: https://codeforces.com/blog/entry/18051
+    template <typename Monoid>
+    class segment_tree {
+    public:
+        using value_type = typename Monoid::value_type;
+
+        segment_tree() = default;
+        explicit segment_tree(size_t n_) : n(n_), tree(2 * n_, Monoid::identity()) {}
+        template <typename It>
+        segment_tree(It first, It last) {
+            build(first, last);
+        }
+        explicit segment_tree(const std::vector<value_type>& arr) : segment_tree(arr.begin(), arr.end()) {}
+
+        template <typename It>
+        void build(It first, It last) {
+            n = static_cast<size_t>(std::distance(first, last));
+            tree.assign(2 * n, Monoid::identity());
+            std::copy(first, last, tree.begin() + n);
+            for (size_t i = n; i-- > 1; )
+                tree[i] = Monoid::op(tree[i << 1], tree[i << 1 | 1]);
+        }
+
+        size_t size() const {
+            return n;
+        }
+        const value_type& operator[](size_t i) const {
+            return tree[i + n];
+        }
+
+        void update(size_t i, const value_type& v) {
+            for (tree[i += n] = v; i > 1; i >>= 1)
+                tree[i >> 1] = Monoid::op(tree[i & ~size_t(1)], tree[i | 1]);
+        }
+
+        // Apply many point updates, then recompute the touched ancestors once per level
+        void update(const std::vector<std::pair<size_t, value_type>>& ups) {
+            std::vector<size_t> nodes;
+            nodes.reserve(ups.size());
+            for (const auto& u : ups) {
+                tree[u.first + n] = u.second;
+                if (u.first + n > 1)
+                    nodes.push_back((u.first + n) >> 1);
+            }
+            while (!nodes.empty()) {
+                std::sort(nodes.begin(), nodes.end());
+                nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+                size_t m = 0;
+                for (auto p : nodes) {
+                    tree[p] = Monoid::op(tree[p << 1], tree[p << 1 | 1]);
+                    if (p > 1)
+                        nodes[m++] = p >> 1;
+                }
+                nodes.resize(m);
+            }
+        }
+
+        value_type query(size_t l, size_t r) const {
+            value_type left = Monoid::identity(), right = Monoid::identity();
+            for (l += n, r += n; l < r; l >>= 1, r >>= 1) {
+                if (l & 1)
+                    left = Monoid::op(left, tree[l++]);
+                if (r & 1)
+                    right = Monoid::op(tree[--r], right);
+            }
+            return Monoid::op(left, right);
+        }
+
+        void query(const query_t* qs, size_t m, value_type* out) const {
+            for (size_t i = 0; i < m; ++i)
+                out[i] = query(qs[i].first, qs[i].second);
+        }
+        std::vector<value_type> query(const std::vector<query_t>& qs) const {
+            std::vector<value_type> ret(qs.size());
+            query(qs.data(), qs.size(), ret.data());
+            return ret;
+        }
+
+    private:
+        size_t n = 0;
+        std::vector<value_type> tree;
+    };
+
+}
+
+
+#endif
@@ -2,6 +2,7 @@
 #define SN_ALGDS_SORT_H
 
 #include <bits/stdc++.h>
+#include "sort_network.hpp"
 using namespace std;
 
 namespace sort {
@@ -67,12 +68,21 @@ namespace sort {
         return left;
     }
 
+    // sort [left, right) with a sorting network, base case of quick_sort/merge_sort
+    template <typename T>
+    void small_sort(T a[], size_t left, size_t right) {
+        network::sort(a + left, right - left);
+    }
+
+    // [left, right)
     template <typename T>
     void quick_sort(T arr[], size_t left, size_t right) {
-        if (left >= right)
+        if (right - left <= network::max_size) {
+            small_sort(arr, left, right);
             return;
+        }
         size_t pivot = partition(arr, left, right);
-        quick_sort(arr, left, pivot - 1);
+        quick_sort(arr, left, pivot);
         quick_sort(arr, pivot + 1, right);
     }
 
@@ -99,23 +109,28 @@ namespace sort {
         std::copy(c.begin(), c.end(), &a[left]);
     }
 
-    // Top-down
+    // Top-down, [left, right]
     template <typename T>
     void merge_sort(T arr[], size_t left, size_t right) {
-        if (right <= left)
+        if (right - left < network::max_size) {
+            small_sort(arr, left, right + 1);
             return;
+        }
         size_t mid = (right + left) / 2;
         merge_sort(arr, left, mid);
         merge_sort(arr, mid + 1, right);
         merge(arr, left, mid, right);
     }
 
-    // bottom-up
+    // bottom-up, [left, right], runs of network::max_size are sorted first
     template <typename T>
     void merge_sort_bu(T arr[], size_t left, size_t right) {
-        size_t dis = right - left;
-        for (size_t sz = 1; sz < dis; sz *= 2) {
-            for (size_t i = left; i < dis; i += sz * 2) {
+        const size_t run = network::max_size;
+        for (size_t i = left; i <= right; i += run) {
+            small_sort(arr, i, std::min(i + run, right + 1));
+        }
+        for (size_t sz = run; sz <= right - left; sz *= 2) {
+            for (size_t i = left; i + sz <= right; i += sz * 2) {
                 merge(arr, i, i + sz - 1, std::min(i + sz * 2 - 1, right));
             }
         }
@@ -0,0 +1,410 @@
+#ifndef SN_ALGDS_SORT_NETWORK_H
+#define SN_ALGDS_SORT_NETWORK_H
+
+#include <bits/stdc++.h>
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+using namespace std;
+
+namespace sort {
+    // Sorting network for small arrays, generated at compile-time
+    // Batcher odd-even merge sort pruned to N wires, comparator count is optimal for N <= 8 (N = 8: 19)
+    // ref: https://en.wikipedia.org/wiki/Batcher_odd%E2%80%93even_mergesort
+    // ref: http://pages.ripco.net/~jgamble/nw.html
+    namespace network {
+        constexpr const static size_t max_size = 32;
+
+        struct comparator {
+            uint8_t lo;
+            uint8_t hi;
+        };
+
+        // f(lo, hi, layer), comparators in one layer are disjoint
+        template <typename F>
+        constexpr void batcher_visit(size_t n, F&& f) {
+            size_t layer = 0;
+            for (size_t p = 1; p < n; p += p) {
+                for (size_t k = p; k >= 1; k /= 2, ++layer) {
+                    for (size_t j = k % p; j + k < n; j += k + k) {
+                        for (size_t i = 0; i < k && i + j + k < n; ++i) {
+                            if ((i + j) / (p + p) == (i + j + k) / (p + p))
+                                f(i + j, i + j + k, layer);
+                        }
+                    }
+                }
+            }
+        }
+
+        constexpr size_t batcher_size(size_t n) {
+            size_t cnt = 0;
+            batcher_visit(n, [&cnt](size_t, size_t, size_t) { ++cnt; });
+            return cnt;
+        }
+
+        constexpr size_t batcher_depth(size_t n) {
+            size_t depth = 0;
+            batcher_visit(n, [&depth](size_t, size_t, size_t l) { depth = l + 1; });
+            return depth;
+        }
+
+        template <size_t N>
+        struct batcher {
+            static_assert(N <= max_size, "Sorting network is only generated for small N");
+            constexpr const static size_t size = batcher_size(N);
+            constexpr const static size_t depth = batcher_depth(N);
+
+            constexpr static std::array<comparator, size> make_comparators() {
+                std::array<comparator, size> ret{};
+                size_t cnt = 0;
+                batcher_visit(N, [&ret, &cnt](size_t lo, size_t hi, size_t) {
+                    ret[cnt].lo = static_cast<uint8_t>(lo);
+                    ret[cnt].hi = static_cast<uint8_t>(hi);
+                    ++cnt;
+                });
+                return ret;
+            }
+
+            constexpr const static std::array<comparator, size> comparators = make_comparators();
+        };
+
+        template <typename T, typename Compare>
+        inline void compare_exchange(T& a, T& b, Compare& comp) {
+            if constexpr (std::is_arithmetic<T>::value) {
+                // select instead of branch, becomes cmov/minss
+                const bool s = comp(b, a);
+                const T x = s ? b : a;
+                const T y = s ? a : b;
+                a = x;
+                b = y;
+            } else {
+                if (comp(b, a))
+                    std::swap(a, b);
+            }
+        }
+
+        template <size_t N, typename T, typename Compare, size_t ...I>
+        inline void apply_scalar(T* a, Compare& comp, std::index_sequence<I...>) {
+            using net = batcher<N>;
+            (compare_exchange(a[net::comparators[I].lo], a[net::comparators[I].hi], comp), ...);
+        }
+
+        template <size_t N, typename T, typename Compare>
+        inline void sort_scalar(T* a, Compare comp) {
+            apply_scalar<N>(a, comp, std::make_index_sequence<batcher<N>::size>{});
+        }
+
+
+        // Vectorized kernels use the bitonic network instead: every comparator distance is a power of 2,
+        // so a layer is either min/max between two registers or one fixed in-register permute + blend.
+        // The input is padded with the max value up to a power of 2 (NaN is not ordered by this path).
+        // ref: https://en.wikipedia.org/wiki/Bitonic_sorter (alternative representation)
+        template <typename T>
+        struct simd_traits {
+            constexpr const static bool enable = false;
+            constexpr const static bool profitable = false;
+            constexpr const static size_t lanes = 1;
+        };
+
+        // lane i of xor_perm<M>(v) is lane (i ^ M) of v, lanes with (i & P) of blend<P>(lo, hi) come from hi
+        template <size_t Lanes>
+        struct lane_mask {
+            constexpr static int perm(size_t m, size_t bits) {
+                int imm = 0;
+                for (size_t i = 0; i < Lanes; ++i)
+                    imm |= static_cast<int>(i ^ m) << (i * bits);
+                return imm;
+            }
+            constexpr static int blend(size_t p, size_t rep) {
+                int imm = 0;
+                for (size_t i = 0; i < Lanes; ++i) {
+                    if (i & p)
+                        imm |= ((1 << rep) - 1) << (i * rep);
+                }
+                return imm;
+            }
+        };
+
+#if defined(__AVX2__)
+
+#define SN_ALGDS_SORT_NETWORK_SIMD "AVX2"
+
+        template <>
+        struct simd_traits<int32_t> {
+            constexpr const static bool enable = true;
+            constexpr const static bool profitable = true;
+            constexpr const static size_t lanes = 8;
+            using reg = __m256i;
+            static reg load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+            static void store(int32_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+            static reg min(reg a, reg b) { return _mm256_min_epi32(a, b); }
+            static reg max(reg a, reg b) { return _mm256_max_epi32(a, b); }
+            template <size_t M>
+            static reg xor_perm(reg v) {
+                return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0 ^ M, 1 ^ M, 2 ^ M, 3 ^ M, 4 ^ M, 5 ^ M, 6 ^ M, 7 ^ M));
+            }
+            template <size_t P>
+            static reg blend(reg lo, reg hi) { return _mm256_blend_epi32(lo, hi, lane_mask<8>::blend(P, 1)); }
+        };
+
+        template <>
+        struct simd_traits<float> {
+            constexpr const static bool enable = true;
+            constexpr const static bool profitable = true;
+            constexpr const static size_t lanes = 8;
+            using reg = __m256;
+            static reg load(const float* p) { return _mm256_loadu_ps(p); }
+            static void store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+            static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+            static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+            template <size_t M>
+            static reg xor_perm(reg v) {
+                return _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(0 ^ M, 1 ^ M, 2 ^ M, 3 ^ M, 4 ^ M, 5 ^ M, 6 ^ M, 7 ^ M));
+            }
+            template <size_t P>
+            static reg blend(reg lo, reg hi) { return _mm256_blend_ps(lo, hi, lane_mask<8>::blend(P, 1)); }
+        };
+
+        template <>
+        struct simd_traits<int64_t> {
+            constexpr const static bool enable = true;
+            // emulated 64-bit min/max loses to cmov
+            constexpr const static bool profitable = false;
+            constexpr const static size_t lanes = 4;
+            using reg = __m256i;
+            static reg load(const int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+            static void store(int64_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+            // no vpminsq before AVX-512
+            static reg min(reg a, reg b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+            static reg max(reg a, reg b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+            template <size_t M>
+            static reg xor_perm(reg v) { return _mm256_permute4x64_epi64(v, lane_mask<4>::perm(M, 2)); }
+            template <size_t P>
+            static reg blend(reg lo, reg hi) { return _mm256_blend_epi32(lo, hi, lane_mask<4>::blend(P, 2)); }
+        };
+
+        template <>
+        struct simd_traits<double> {
+            constexpr const static bool enable = true;
+            constexpr const static bool profitable = true;
+            constexpr const static size_t lanes = 4;
+            using reg = __m256d;
+            static reg load(const double* p) { return _mm256_loadu_pd(p); }
+            static void store(double* p, reg v) { _mm256_storeu_pd(p, v); }
+            static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+            static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+            template <size_t M>
+            static reg xor_perm(reg v) { return _mm256_permute4x64_pd(v, lane_mask<4>::perm(M, 2)); }
+            template <size_t P>
+            static reg blend(reg lo, reg hi) { return _mm256_blend_pd(lo, hi, lane_mask<4>::blend(P, 1)); }
+        };
+
+#elif defined(__SSE4_2__)
+
+#define SN_ALGDS_SORT_NETWORK_SIMD "SSE4.2"
+
+        template <>
+        struct simd_traits<int32_t> {
+            constexpr const static bool enable = true;
+            constexpr const static bool profitable = true;
+            constexpr const static size_t lanes = 4;
+            using reg = __m128i;
+            static reg load(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+            static void store(int32_t* p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+            static reg min(reg a, reg b) { return _mm_min_epi32(a, b); }
+            static reg max(reg a, reg b) { return _mm_max_epi32(a, b); }
+            template <size_t M>
+            static reg xor_perm(reg v) { return _mm_shuffle_epi32(v, lane_mask<4>::perm(M, 2)); }
+            template <size_t P>
+            static reg blend(reg lo, reg hi) { return _mm_blend_epi16(lo, hi, lane_mask<4>::blend(P, 2)); }
+        };
+
+        template <>
+        struct simd_traits<float> {
+            constexpr const static bool enable = true;
+            constexpr const static bool profitable = true;
+            constexpr const static size_t lanes = 4;
+            using reg = __m128;
+            static reg load(const float* p) { return _mm_loadu_ps(p); }
+            static void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+            static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+            static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+            template <size_t M>
+            static reg xor_perm(reg v) { return _mm_shuffle_ps(v, v, lane_mask<4>::perm(M, 2)); }
+            template <size_t P>
+            static reg blend(reg lo, reg hi) { return _mm_blend_ps(lo, hi, lane_mask<4>::blend(P, 1)); }
+        };
+
+        template <>
+        struct simd_traits<int64_t> {
+            constexpr const static bool enable = true;
+            // emulated 64-bit min/max loses to cmov
+            constexpr const static bool profitable = false;
+            constexpr const static size_t lanes = 2;
+            using reg = __m128i;
+            static reg load(const int64_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+            static void store(int64_t* p, reg v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+            static reg min(reg a, reg b) { return _mm_blendv_epi8(a, b, _mm_cmpgt_epi64(a, b)); }
+            static reg max(reg a, reg b) { return _mm_blendv_epi8(b, a, _mm_cmpgt_epi64(a, b)); }
+            template <size_t M>
+            static reg xor_perm(reg v) { return _mm_shuffle_epi32(v, 0x4E); }
+            template <size_t P>
+            static reg blend(reg lo, reg hi) { return _mm_blend_epi16(lo, hi, 0xF0); }
+        };
+
+        template <>
+        struct simd_traits<double> {
+            constexpr const static bool enable = true;
+            constexpr const static bool profitable = true;
+            constexpr const static size_t lanes = 2;
+            using reg = __m128d;
+            static reg load(const double* p) { return _mm_loadu_pd(p); }
+            static void store(double* p, reg v) { _mm_storeu_pd(p, v); }
+            static reg min(reg a, reg b) { return _mm_min_pd(a, b); }
+            static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+            template <size_t M>
+            static reg xor_perm(reg v) { return _mm_shuffle_pd(v, v, 1); }
+            template <size_t P>
+            static reg blend(reg lo, reg hi) { return _mm_blend_pd(lo, hi, 2); }
+        };
+
+#endif
+
+        template <typename F, size_t ...I>
+        inline void unroll(F&& f, std::index_sequence<I...>) {
+            (f(std::integral_constant<size_t, I>{}), ...);
+        }
+
+        template <typename T>
+        struct bitonic {
+            using traits = simd_traits<T>;
+            using reg = typename traits::reg;
+            constexpr const static size_t lanes = traits::lanes;
+
+            // i <-> i ^ K, lower index keeps the min
+            template <size_t R, size_t K>
+            static void xor_layer(reg* v) {
+                unroll([v](auto r) {
+                    if constexpr (K >= lanes) {
+                        constexpr size_t s = r | (K / lanes);
+                        if constexpr (s != r) {
+                            const reg lo = traits::min(v[r], v[s]);
+                            v[s] = traits::max(v[r], v[s]);
+                            v[r] = lo;
+                        }
+                    } else {
+                        const reg g = traits::template xor_perm<K>(v[r]);
+                        v[r] = traits::template blend<K>(traits::min(v[r], g), traits::max(v[r], g));
+                    }
+                }, std::make_index_sequence<R>{});
+            }
+
+            // i <-> i ^ (B - 1) inside blocks of B
+            template <size_t R, size_t B>
+            static void mirror_layer(reg* v) {
+                unroll([v](auto r) {
+                    if constexpr (B > lanes) {
+                        constexpr size_t s = r ^ (B / lanes - 1);
+                        if constexpr (!(r & (B / lanes / 2))) {
+                            const reg g = traits::template xor_perm<lanes - 1>(v[s]);
+                            const reg hi = traits::max(v[r], g);
+                            v[r] = traits::min(v[r], g);
+                            v[s] = traits::template xor_perm<lanes - 1>(hi);
+                        }
+                    } else {
+                        const reg g = traits::template xor_perm<B - 1>(v[r]);
+                        v[r] = traits::template blend<B / 2>(traits::min(v[r], g), traits::max(v[r], g));
+                    }
+                }, std::make_index_sequence<R>{});
+            }
+
+            template <size_t R, size_t K>
+            static void xor_layers(reg* v) {
+                if constexpr (K >= 1) {
+                    xor_layer<R, K>(v);
+                    xor_layers<R, K / 2>(v);
+                }
+            }
+
+            // merge sorted blocks of P into blocks of 2P
+            template <size_t R, size_t P>
+            static void stage(reg* v) {
+                if constexpr (P < R * lanes) {
+                    mirror_layer<R, P * 2>(v);
+                    xor_layers<R, P / 2>(v);
+                    stage<R, P * 2>(v);
+                }
+            }
+        };
+
+        constexpr size_t ceil_pow2(size_t n) {
+            size_t ret = 1;
+            while (ret < n)
+                ret += ret;
+            return ret;
+        }
+
+        template <size_t N, typename T>
+        inline void sort_simd(T* a) {
+            using traits = simd_traits<T>;
+            constexpr size_t lanes = traits::lanes;
+            constexpr size_t R = (ceil_pow2(N) < lanes ? lanes : ceil_pow2(N)) / lanes;
+            const T pad = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+            typename traits::reg v[R];
+            // full registers are loaded in place, only the tail goes through a padded buffer
+            unroll([a, pad, &v](auto r) {
+                if constexpr ((r + 1) * lanes <= N) {
+                    v[r] = traits::load(a + r * lanes);
+                } else {
+                    T tail[lanes];
+                    for (size_t i = 0; i < lanes; ++i)
+                        tail[i] = r * lanes + i < N ? a[r * lanes + i] : pad;
+                    v[r] = traits::load(tail);
+                }
+            }, std::make_index_sequence<R>{});
+            bitonic<T>::template stage<R, 1>(v);
+            unroll([a, &v](auto r) {
+                if constexpr ((r + 1) * lanes <= N) {
+                    traits::store(a + r * lanes, v[r]);
+                } else if constexpr (r * lanes < N) {
+                    T tail[lanes];
+                    traits::store(tail, v[r]);
+                    std::copy(tail, tail + (N - r * lanes), a + r * lanes);
+                }
+            }, std::make_index_sequence<R>{});
+        }
+
+        template <typename T, typename Compare>
+        constexpr bool use_simd() {
+            return simd_traits<T>::profitable && std::is_same<Compare, std::less<T>>::value;
+        }
+
+        template <size_t N, typename T, typename Compare>
+        void sort_n(T* a, Compare comp) {
+            if constexpr (N < 2) {
+                return;
+            } else if constexpr (use_simd<T, Compare>() && N >= simd_traits<T>::lanes) {
+                // a handful of comparators are cheaper as cmov than a partial register
+                sort_simd<N>(a);
+            } else {
+                sort_scalar<N>(a, comp);
+            }
+        }
+
+        template <typename T, typename Compare, size_t ...I>
+        constexpr auto make_dispatch(std::index_sequence<I...>) {
+            return std::array<void(*)(T*, Compare), sizeof...(I)>{ &sort_n<I, T, Compare>... };
+        }
+
+        // Sort a[0, n) for n <= max_size with the network of size n
+        template <typename T, typename Compare = std::less<T>>
+        void sort(T* a, size_t n, Compare comp = Compare{}) {
+            constexpr static auto dispatch = make_dispatch<T, Compare>(std::make_index_sequence<max_size + 1>{});
+            assert(n <= max_size);
+            dispatch[n](a, comp);
+        }
+    }
+}
+
+
+#endif
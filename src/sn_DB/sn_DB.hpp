@@ -72,71 +72,19 @@ namespace sn_DBImpl {
 			return dest;
 		}
 
-		string wstring_to_utf8(const wstring& str) {
-			std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
-			return myconv.to_bytes(str);
-		}
-
-		wstring gbk_to_wstring(const string& gbk_str) {
-			string gbk_locale_name = ".936";
-			// avoid protected codecvt
-            typedef sn_String::convert::deletable_facet<std::codecvt_byname<wchar_t, char, std::mbstate_t>> F;
-			std::wstring_convert<std::codecvt_byname<wchar_t, char, mbstate_t>> conv(new F(gbk_locale_name));
-			return conv.from_bytes(gbk_str);
-		}
-
+		// the encoding helpers live in sn_String::convert
+		using sn_String::convert::wstring_to_utf8;
+		using sn_String::convert::gbk_to_wstring;
 		//for outputing chinese rows, we use wcout(.imbue(local("chs"))) << utf8_to_wstring(content)
-		wstring utf8_to_wstring(const string& str) {
-			std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
-			return myconv.from_bytes(str);
-		}
-
-		wstring string_to_wstring(const string& str) {
-			try {
-				std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> conv;
-				wstring wstr = conv.from_bytes(str);
-				return wstr;
-			}
-			catch (std::range_error&)
-			{
-				wstring wstr = gbk_to_wstring(str);
-				return wstr;
-			}
-		}
-
-		string wstring_to_string(const wstring& wstr) {
-			std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> conv;
-			string str = conv.to_bytes(wstr);
-			return str;
-		}
-
+		using sn_String::convert::utf8_to_wstring;
+		using sn_String::convert::string_to_wstring;
+		using sn_String::convert::wstring_to_string;
 		//for chinese fields, we use hex(field_name) = wstring_to_hex(L'example')
-		string wstring_to_hex(const wstring& str) {
-			string u8str = wstring_to_utf8(str);
-			stringstream ss;
-			ss << std::hex;
-			for (unsigned char c : u8str)
-				ss << setw(2) << setfill('0') << static_cast<int>(c);
-			string hexstr = ss.str();
-			hexstr = "\'" + hexstr + "\'";
-			return hexstr;
-		}
-
+		using sn_String::convert::wstring_to_hex;
 		//to chinese name, use wstring_to_unhex('example');
-		string wstring_to_unhex(const wstring& str) {
-			string unhexstr = "unhex(" + wstring_to_hex(str) + ")";
-			return unhexstr;
-		}
-
-		string string_to_hex(const string& str) {
-			wstring wstr = string_to_wstring(str);
-			return wstring_to_hex(wstr);
-		}
-
-		string string_to_unhex(const string& str) {
-			wstring wstr = string_to_wstring(str);
-			return wstring_to_unhex(wstr);
-		}
+		using sn_String::convert::wstring_to_unhex;
+		using sn_String::convert::string_to_hex;
+		using sn_String::convert::string_to_unhex;
 
 		struct split_option {
 			enum empty_t { empty_remain, empty_discard };
@@ -4,9 +4,10 @@
 #include "sn_CommonHeader.h"
 #include "sn_Log.hpp"
 #include "sn_Macro.hpp"
+#include "sn_Decimal/bigint.hpp"
+#include "sn_Decimal/fixed.hpp"
 
 
-// TODO: add FFT/NTT multiplication
 // TODO: add template <char...> operator
 namespace sn_Decimal {
 
@@ -265,8 +266,7 @@ namespace sn_Decimal {
 			return ret;
 		}
 
-		//TODO: FFT operator*
-		//TODO: FFT operator/
+		// operator* / operator/: see sn_big_unsigned (64-bit limbs, Karatsuba/Toom-3/NTT, Newton division)
 
 		/* no member function partial specialization
 		template <typename F, typename = std::enable_if_t<std::is_floating_point<F>::value>>
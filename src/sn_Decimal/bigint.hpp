@@ -0,0 +1,806 @@
+#ifndef SN_DECIMAL_BIGINT_H
+#define SN_DECIMAL_BIGINT_H
+
+#include "../sn_CommonHeader.h"
+
+namespace sn_Decimal {
+
+	// Kernels over little-endian base 2^64 limb arrays
+	// Multiplication picks schoolbook -> Karatsuba -> Toom-3 -> 3-prime NTT by the size of the smaller operand,
+	// division is Knuth D for short quotients/divisors and Newton reciprocal otherwise.
+	// ref: Brent, Zimmermann, Modern Computer Arithmetic
+	namespace limb {
+		using limb_t = uint64_t;
+		using dlimb_t = unsigned __int128;
+		using limbs = std::vector<limb_t>;
+
+		// in limbs of the smaller operand
+		constexpr const size_t karatsuba_threshold = 32;
+		constexpr const size_t toom3_threshold = 224;
+		constexpr const size_t ntt_threshold = 4096;
+		// quotient and divisor both longer than this go through the reciprocal
+		constexpr const size_t newton_threshold = 96;
+		// limbs converted to/from decimal by repeated 10^18 steps
+		constexpr const size_t radix_threshold = 48;
+
+		constexpr const limb_t pow10_18 = 1000000000000000000ULL;
+
+		inline void trim(limbs& a) {
+			while (!a.empty() && !a.back())
+				a.pop_back();
+		}
+
+		inline int compare(const limb_t* a, size_t n, const limb_t* b, size_t m) {
+			while (n && !a[n - 1])
+				--n;
+			while (m && !b[m - 1])
+				--m;
+			if (n != m)
+				return n < m ? -1 : 1;
+			while (n--)
+				if (a[n] != b[n])
+					return a[n] < b[n] ? -1 : 1;
+			return 0;
+		}
+		inline int compare(const limbs& a, const limbs& b) {
+			return compare(a.data(), a.size(), b.data(), b.size());
+		}
+
+		// r[0, n) = a[0, n) + b[0, m) (n >= m), returns the carry
+		inline limb_t add(limb_t* r, const limb_t* a, size_t n, const limb_t* b, size_t m) {
+			limb_t carry = 0;
+			size_t i = 0;
+			for (; i < m; ++i) {
+				const limb_t s = a[i] + carry;
+				carry = s < carry;
+				r[i] = s + b[i];
+				carry += r[i] < s;
+			}
+			for (; i < n; ++i) {
+				r[i] = a[i] + carry;
+				carry = r[i] < carry;
+			}
+			return carry;
+		}
+
+		// r[0, n) = a[0, n) - b[0, m) (n >= m), returns the borrow
+		inline limb_t sub(limb_t* r, const limb_t* a, size_t n, const limb_t* b, size_t m) {
+			limb_t borrow = 0;
+			size_t i = 0;
+			for (; i < m; ++i) {
+				const limb_t d = a[i] - b[i];
+				const limb_t nb = a[i] < b[i];
+				r[i] = d - borrow;
+				borrow = nb + (d < borrow);
+			}
+			for (; i < n; ++i) {
+				const limb_t ai = a[i];
+				r[i] = ai - borrow;
+				borrow = ai < borrow;
+			}
+			return borrow;
+		}
+
+		// r[off, ...) += a[0, n), the carry must stay inside r
+		inline void add_at(limb_t* r, size_t rn, const limb_t* a, size_t n, size_t off) {
+			while (n && !a[n - 1])
+				--n;
+			if (add(r + off, r + off, rn - off, a, n))
+				assert(false && "carry out of limb range");
+		}
+
+		// a[0, n) = a * m + c, returns the carry limb
+		inline limb_t mul_1(limb_t* a, size_t n, limb_t m, limb_t c) {
+			for (size_t i = 0; i < n; ++i) {
+				const dlimb_t p = static_cast<dlimb_t>(a[i]) * m + c;
+				a[i] = static_cast<limb_t>(p);
+				c = static_cast<limb_t>(p >> 64);
+			}
+			return c;
+		}
+
+		// q[0, n) = a / d, returns a % d
+		inline limb_t divmod_1(limb_t* q, const limb_t* a, size_t n, limb_t d) {
+			dlimb_t r = 0;
+			for (size_t i = n; i-- > 0; ) {
+				r = (r << 64) | a[i];
+				q[i] = static_cast<limb_t>(r / d);
+				r %= d;
+			}
+			return static_cast<limb_t>(r);
+		}
+
+		// r[0, n + m) = a[0, n) * b[0, m)
+		inline void mul_basecase(limb_t* r, const limb_t* a, size_t n, const limb_t* b, size_t m) {
+			std::fill(r, r + n + m, 0);
+			for (size_t j = 0; j < m; ++j) {
+				limb_t carry = 0;
+				const limb_t bj = b[j];
+				for (size_t i = 0; i < n; ++i) {
+					const dlimb_t p = static_cast<dlimb_t>(a[i]) * bj + r[i + j] + carry;
+					r[i + j] = static_cast<limb_t>(p);
+					carry = static_cast<limb_t>(p >> 64);
+				}
+				r[j + n] = carry;
+			}
+		}
+
+		inline void mul(limb_t* r, const limb_t* a, size_t n, const limb_t* b, size_t m);
+
+		inline limbs mul(const limbs& a, const limbs& b) {
+			if (a.empty() || b.empty())
+				return {};
+			limbs r(a.size() + b.size());
+			if (a.size() >= b.size())
+				mul(r.data(), a.data(), a.size(), b.data(), b.size());
+			else
+				mul(r.data(), b.data(), b.size(), a.data(), a.size());
+			trim(r);
+			return r;
+		}
+
+		inline limbs add(const limbs& a, const limbs& b) {
+			const limbs& x = a.size() >= b.size() ? a : b;
+			const limbs& y = a.size() >= b.size() ? b : a;
+			limbs r(x.size() + 1);
+			r[x.size()] = add(r.data(), x.data(), x.size(), y.data(), y.size());
+			trim(r);
+			return r;
+		}
+
+		// a >= b
+		inline limbs sub(const limbs& a, const limbs& b) {
+			limbs r(a.size());
+			sub(r.data(), a.data(), a.size(), b.data(), b.size());
+			trim(r);
+			return r;
+		}
+
+		// Karatsuba, n >= m > ceil(n / 2): three half-size products
+		inline void mul_karatsuba(limb_t* r, const limb_t* a, size_t n, const limb_t* b, size_t m) {
+			const size_t k = (n + 1) / 2;
+			const size_t na1 = n - k, nb1 = m - k;
+			mul(r, a, k, b, k);
+			mul(r + 2 * k, a + k, na1, b + k, nb1);
+			limbs t1(k + 1), t2(k + 1), z1(2 * k + 2);
+			t1[k] = add(t1.data(), a, k, a + k, na1);
+			t2[k] = add(t2.data(), b, k, b + k, nb1);
+			mul(z1.data(), t1.data(), k + 1, t2.data(), k + 1);
+			sub(z1.data(), z1.data(), z1.size(), r, 2 * k);
+			sub(z1.data(), z1.data(), z1.size(), r + 2 * k, na1 + nb1);
+			add_at(r, n + m, z1.data(), z1.size(), k);
+		}
+
+		// sign-magnitude value for the Toom-3 interpolation
+		struct signed_limbs {
+			bool neg = false;
+			limbs mag;
+
+			signed_limbs() = default;
+			signed_limbs(const limb_t* p, size_t n) : mag(p, p + n) {
+				trim(mag);
+			}
+			signed_limbs(bool neg_, limbs mag_) : neg(neg_), mag(std::move(mag_)) {
+				trim(mag);
+				if (mag.empty())
+					neg = false;
+			}
+
+			friend signed_limbs operator+(const signed_limbs& x, const signed_limbs& y) {
+				if (x.neg == y.neg)
+					return signed_limbs(x.neg, add(x.mag, y.mag));
+				if (compare(x.mag, y.mag) >= 0)
+					return signed_limbs(x.neg, sub(x.mag, y.mag));
+				return signed_limbs(y.neg, sub(y.mag, x.mag));
+			}
+			friend signed_limbs operator-(const signed_limbs& x, const signed_limbs& y) {
+				return x + signed_limbs(!y.neg, y.mag);
+			}
+			friend signed_limbs operator*(const signed_limbs& x, const signed_limbs& y) {
+				return signed_limbs(x.neg != y.neg, mul(x.mag, y.mag));
+			}
+			signed_limbs shl1() const {
+				limbs r(mag);
+				r.push_back(0);
+				for (size_t i = r.size(); i-- > 1; )
+					r[i] = (r[i] << 1) | (r[i - 1] >> 63);
+				r[0] <<= 1;
+				return signed_limbs(neg, std::move(r));
+			}
+			// exact division by a small constant
+			signed_limbs div(limb_t d) const {
+				limbs r(mag.size());
+				divmod_1(r.data(), mag.data(), mag.size(), d);
+				return signed_limbs(neg, std::move(r));
+			}
+		};
+
+		// Toom-3 with points 0, 1, -1, -2, inf: five third-size products
+		// ref: Bodrato, Zanoni, Integer and Polynomial Multiplication: Towards Optimal Toom-Cook Matrices
+		inline void mul_toom3(limb_t* r, const limb_t* a, size_t n, const limb_t* b, size_t m) {
+			const size_t k = (n + 2) / 3;
+			const signed_limbs a0(a, k), a1(a + k, k), a2(a + 2 * k, n - 2 * k);
+			const signed_limbs b0(b, k), b1(b + k, k), b2(b + 2 * k, m - 2 * k);
+
+			const signed_limbs pa = a0 + a2, pb = b0 + b2;
+			const signed_limbs am1 = pa - a1, bm1 = pb - b1;
+			const signed_limbs am2 = (am1 + a2).shl1() - a0, bm2 = (bm1 + b2).shl1() - b0;
+
+			const signed_limbs r0 = a0 * b0;
+			signed_limbs r1 = (pa + a1) * (pb + b1);
+			const signed_limbs rm1 = am1 * bm1;
+			const signed_limbs rm2 = am2 * bm2;
+			const signed_limbs rinf = a2 * b2;
+
+			signed_limbs r3 = (rm2 - r1).div(3);
+			r1 = (r1 - rm1).div(2);
+			signed_limbs r2 = rm1 - r0;
+			r3 = (r2 - r3).div(2) + rinf.shl1();
+			r2 = r2 + r1 - rinf;
+			r1 = r1 - r3;
+
+			// the middle coefficients are non-negative once interpolated
+			assert(!r1.neg && !r2.neg && !r3.neg);
+			std::fill(r, r + n + m, 0);
+			std::copy(r0.mag.begin(), r0.mag.end(), r);
+			std::copy(rinf.mag.begin(), rinf.mag.end(), r + 4 * k);
+			add_at(r, n + m, r1.mag.data(), r1.mag.size(), k);
+			add_at(r, n + m, r2.mag.data(), r2.mag.size(), 2 * k);
+			add_at(r, n + m, r3.mag.data(), r3.mag.size(), 3 * k);
+		}
+
+		// NTT over a 32-bit prime, Montgomery butterflies
+		// Forward is decimation in frequency and inverse decimation in time, so no bit reversal pass is needed
+		// (the spectrum stays in bit-reversed order, fine for a pointwise product).
+		template <uint32_t P, uint32_t G>
+		struct ntt_prime {
+			constexpr const static uint32_t mod = P;
+
+			static constexpr uint32_t inverse_mod_r() {
+				uint32_t inv = P;
+				for (int i = 0; i < 4; ++i)
+					inv *= 2 - P * inv;
+				return inv;
+			}
+			constexpr const static uint32_t inv = inverse_mod_r();
+			constexpr const static uint32_t r2 = static_cast<uint32_t>((static_cast<dlimb_t>(1) << 64) % P);
+
+			// t < P * 2^32, returns t / 2^32 mod P
+			static uint32_t reduce(uint64_t t) {
+				const uint32_t q = static_cast<uint32_t>(t) * inv;
+				const uint32_t hi = static_cast<uint32_t>(t >> 32);
+				const uint32_t qm = static_cast<uint32_t>((static_cast<uint64_t>(q) * P) >> 32);
+				return hi - qm + (P & (0u - (hi < qm)));
+			}
+			// branch-free, the butterfly operands are random
+			static uint32_t add(uint32_t a, uint32_t b) {
+				const uint32_t s = a + b - P;
+				return s + (P & (0u - (s >> 31)));
+			}
+			static uint32_t sub(uint32_t a, uint32_t b) {
+				return a - b + (P & (0u - (a < b)));
+			}
+			static uint32_t mul(uint32_t a, uint32_t b) {
+				return reduce(static_cast<uint64_t>(a) * b);
+			}
+			static uint32_t to_mont(uint32_t x) {
+				return mul(x, r2);
+			}
+
+			static uint32_t pow(uint32_t b, uint64_t e) {
+				uint64_t r = 1, x = b % P;
+				for (; e; e >>= 1, x = x * x % P)
+					if (e & 1)
+						r = r * x % P;
+				return static_cast<uint32_t>(r);
+			}
+
+			// roots of the stage with half-length h: w^j, j < h, in Montgomery form
+			static void stage_roots(std::vector<uint32_t>& w, size_t h, bool invert) {
+				const uint32_t g = pow(G, (P - 1) / (2 * h));
+				const uint32_t wl = to_mont(invert ? pow(g, P - 2) : g);
+				w[0] = to_mont(1);
+				for (size_t j = 1; j < h; ++j)
+					w[j] = mul(w[j - 1], wl);
+			}
+
+			static void forward(std::vector<uint32_t>& a) {
+				const size_t n = a.size();
+				std::vector<uint32_t> w(n / 2 + 1);
+				for (size_t len = n; len >= 2; len >>= 1) {
+					const size_t half = len / 2;
+					stage_roots(w, half, false);
+					for (size_t i = 0; i < n; i += len) {
+						uint32_t* x = &a[i];
+						uint32_t* y = &a[i + half];
+						for (size_t j = 0; j < half; ++j) {
+							const uint32_t u = x[j], v = y[j];
+							x[j] = add(u, v);
+							y[j] = mul(sub(u, v), w[j]);
+						}
+					}
+				}
+			}
+
+			// also multiplies by scale
+			static void inverse(std::vector<uint32_t>& a, uint32_t scale) {
+				const size_t n = a.size();
+				std::vector<uint32_t> w(n / 2 + 1);
+				for (size_t len = 2; len <= n; len <<= 1) {
+					const size_t half = len / 2;
+					stage_roots(w, half, true);
+					for (size_t i = 0; i < n; i += len) {
+						uint32_t* x = &a[i];
+						uint32_t* y = &a[i + half];
+						for (size_t j = 0; j < half; ++j) {
+							const uint32_t u = x[j], v = mul(y[j], w[j]);
+							x[j] = add(u, v);
+							y[j] = sub(u, v);
+						}
+					}
+				}
+				const uint32_t s = to_mont(scale);
+				for (auto& v : a)
+					v = mul(v, s);
+			}
+
+			static std::vector<uint32_t> load(const std::vector<uint32_t>& x, size_t len) {
+				std::vector<uint32_t> f(len, 0);
+				for (size_t i = 0; i < x.size(); ++i)
+					f[i] = x[i] % P;
+				return f;
+			}
+
+			static std::vector<uint32_t> convolve(const std::vector<uint32_t>& x, const std::vector<uint32_t>& y, size_t len, bool square) {
+				std::vector<uint32_t> fx = load(x, len);
+				forward(fx);
+				if (square) {
+					for (auto& v : fx)
+						v = mul(v, v);
+				} else {
+					std::vector<uint32_t> fy = load(y, len);
+					forward(fy);
+					for (size_t i = 0; i < len; ++i)
+						fx[i] = mul(fx[i], fy[i]);
+				}
+				// the pointwise Montgomery product left a factor 2^-32, undo it together with 1 / len
+				const uint64_t r = (static_cast<uint64_t>(1) << 32) % P;
+				inverse(fx, static_cast<uint32_t>(r * pow(static_cast<uint32_t>(len % P), P - 2) % P));
+				return fx;
+			}
+		};
+
+		using ntt_p1 = ntt_prime<998244353, 3>;
+		using ntt_p2 = ntt_prime<167772161, 3>;
+		using ntt_p3 = ntt_prime<469762049, 3>;
+		// transform length limit shared by the three primes
+		constexpr const size_t ntt_max_length = size_t(1) << 23;
+
+		// 32-bit digits: every convolution term is below min(n, m) * 2 * 2^64 <= 2^86 < p1 * p2 * p3, recovered exactly by CRT
+		inline void mul_ntt(limb_t* r, const limb_t* a, size_t n, const limb_t* b, size_t m) {
+			auto split = [](const limb_t* p, size_t cnt) {
+				std::vector<uint32_t> d(cnt * 2);
+				for (size_t i = 0; i < cnt; ++i) {
+					d[2 * i] = static_cast<uint32_t>(p[i]);
+					d[2 * i + 1] = static_cast<uint32_t>(p[i] >> 32);
+				}
+				return d;
+			};
+			const bool square = a == b && n == m;
+			const std::vector<uint32_t> x = split(a, n), y = square ? std::vector<uint32_t>() : split(b, m);
+			size_t len = 1;
+			while (len < 2 * (n + m) - 1)
+				len <<= 1;
+			const std::vector<uint32_t> c1 = ntt_p1::convolve(x, y, len, square);
+			const std::vector<uint32_t> c2 = ntt_p2::convolve(x, y, len, square);
+			const std::vector<uint32_t> c3 = ntt_p3::convolve(x, y, len, square);
+
+			constexpr const uint64_t p1 = ntt_p1::mod, p2 = ntt_p2::mod, p3 = ntt_p3::mod;
+			const uint64_t inv_p1_p2 = ntt_p2::pow(static_cast<uint32_t>(p1 % p2), p2 - 2);
+			const uint64_t inv_p1_p3 = ntt_p3::pow(static_cast<uint32_t>(p1 % p3), p3 - 2);
+			const uint64_t inv_p2_p3 = ntt_p3::pow(static_cast<uint32_t>(p2 % p3), p3 - 2);
+
+			dlimb_t carry = 0;
+			const size_t digits = (n + m) * 2;
+			for (size_t i = 0; i < digits; ++i) {
+				if (i < len) {
+					// Garner: v = x1 + x2 * p1 + x3 * p1 * p2
+					const uint64_t x1 = c1[i];
+					const uint64_t x2 = (c2[i] + p2 - x1 % p2) % p2 * inv_p1_p2 % p2;
+					const uint64_t t = (c3[i] + p3 - x1 % p3) % p3 * inv_p1_p3 % p3;
+					const uint64_t x3 = (t + p3 - x2 % p3) % p3 * inv_p2_p3 % p3;
+					carry += x1 + static_cast<dlimb_t>(x2) * p1 + static_cast<dlimb_t>(x3) * (p1 * p2);
+				}
+				const limb_t piece = static_cast<limb_t>(carry & 0xffffffffu);
+				carry >>= 32;
+				if (i & 1)
+					r[i / 2] |= piece << 32;
+				else
+					r[i / 2] = piece;
+			}
+		}
+
+		// r[0, n + m) = a * b, n >= m >= 1, r must not alias a or b
+		inline void mul(limb_t* r, const limb_t* a, size_t n, const limb_t* b, size_t m) {
+			if (m < karatsuba_threshold) {
+				mul_basecase(r, a, n, b, m);
+			} else if (m >= ntt_threshold && (n + m) * 2 <= ntt_max_length) {
+				mul_ntt(r, a, n, b, m);
+			} else if (2 * m <= n + 1) {
+				// unbalanced: m-sized slices of a, each a balanced product
+				std::fill(r, r + n + m, 0);
+				limbs t(2 * m);
+				for (size_t off = 0; off < n; off += m) {
+					const size_t len = std::min(m, n - off);
+					if (len >= m)
+						mul(t.data(), a + off, len, b, m);
+					else
+						mul(t.data(), b, m, a + off, len);
+					add_at(r, n + m, t.data(), len + m, off);
+				}
+			} else if (m >= toom3_threshold && m > 2 * ((n + 2) / 3)) {
+				mul_toom3(r, a, n, b, m);
+			} else {
+				mul_karatsuba(r, a, n, b, m);
+			}
+		}
+
+		inline limbs shift_left(const limbs& a, unsigned s, size_t extra) {
+			limbs r(a.size() + extra, 0);
+			for (size_t i = 0; i < a.size(); ++i) {
+				r[i] |= a[i] << s;
+				if (s && i + 1 < r.size())
+					r[i + 1] = a[i] >> (64 - s);
+			}
+			return r;
+		}
+
+		// Knuth algorithm D, a = q * b + r, |b| >= 2
+		// ref: Knuth, TAOCP Vol. 2, 4.3.1
+		inline void divmod_basecase(const limbs& a, const limbs& b, limbs& q, limbs& r) {
+			const size_t n = b.size(), m = a.size() - n;
+			const unsigned s = __builtin_clzll(b.back());
+			const limbs v = shift_left(b, s, 0);
+			limbs u = shift_left(a, s, 1);
+			q.assign(m + 1, 0);
+			const limb_t vt = v[n - 1], vs = v[n - 2];
+			for (size_t j = m + 1; j-- > 0; ) {
+				const dlimb_t num = (static_cast<dlimb_t>(u[j + n]) << 64) | u[j + n - 1];
+				dlimb_t qhat = num / vt;
+				if (qhat >> 64)
+					qhat = ~limb_t(0);
+				dlimb_t rhat = num - qhat * vt;
+				while (!(rhat >> 64) && qhat * vs > ((rhat << 64) | u[j + n - 2])) {
+					--qhat;
+					rhat += vt;
+				}
+				// u[j, j + n] -= qhat * v
+				limb_t carry = 0, borrow = 0;
+				for (size_t i = 0; i < n; ++i) {
+					const dlimb_t p = qhat * v[i] + carry;
+					carry = static_cast<limb_t>(p >> 64);
+					const limb_t pl = static_cast<limb_t>(p);
+					const limb_t t = u[i + j] - pl;
+					const limb_t b1 = u[i + j] < pl;
+					u[i + j] = t - borrow;
+					borrow = b1 + (t < borrow);
+				}
+				const limb_t t = u[j + n] - carry;
+				const limb_t b1 = u[j + n] < carry;
+				u[j + n] = t - borrow;
+				if (b1 + (t < borrow)) {
+					// qhat was one too large
+					--qhat;
+					u[j + n] += add(u.data() + j, u.data() + j, n, v.data(), n);
+				}
+				q[j] = static_cast<limb_t>(qhat);
+			}
+			r.assign(n, 0);
+			for (size_t i = 0; i < n; ++i)
+				r[i] = (u[i] >> s) | (s ? u[i + 1] << (64 - s) : 0);
+			trim(q);
+			trim(r);
+		}
+
+		// approximately floor(B^p / b) (within a couple of units), p >= |b|, Newton iteration y += y * (B^p - b * y) / B^p
+		// with the working precision doubling from the top limbs of b
+		inline limbs reciprocal(const limbs& b, size_t p) {
+			const size_t m = b.size(), t = p - m + 1;
+			if (t <= newton_threshold || m <= newton_threshold) {
+				limbs num(p + 1, 0), q, r;
+				num[p] = 1;
+				if (m == 1) {
+					q.resize(p + 1);
+					divmod_1(q.data(), num.data(), num.size(), b[0]);
+					trim(q);
+				} else {
+					divmod_basecase(num, b, q, r);
+				}
+				return q;
+			}
+			const size_t k = t / 2 + 2;
+			const size_t s = m > k + 1 ? m - (k + 1) : 0;
+			const limbs bh(b.begin() + s, b.end());
+			const limbs z = reciprocal(bh, p - s - (t - k));
+			limbs y(t - k, 0);
+			y.insert(y.end(), z.begin(), z.end());
+
+			limbs pw(p + 1, 0);
+			pw[p] = 1;
+			const limbs by = mul(b, y);
+			const bool under = compare(by, pw) <= 0;
+			const limbs e = under ? sub(pw, by) : sub(by, pw);
+			limbs ye = mul(y, e);
+			limbs delta(ye.size() > p ? ye.begin() + p : ye.end(), ye.end());
+			return under ? add(y, delta) : sub(y, add(delta, limbs{1}));
+		}
+
+		// a = q * b + r with y = reciprocal(b, p) and |a| <= p
+		// a * y / B^p is at most a couple of units off the true quotient, fixed up with a few subtractions
+		inline void divmod_reciprocal(const limbs& a, const limbs& b, const limbs& y, size_t p, limbs& q, limbs& r) {
+			const limbs ay = mul(a, y);
+			q.assign(ay.size() > p ? ay.begin() + p : ay.end(), ay.end());
+			limbs qb = mul(q, b);
+			while (compare(qb, a) > 0) {
+				q = sub(q, limbs{1});
+				qb = sub(qb, b);
+			}
+			r = sub(a, qb);
+			while (compare(r, b) >= 0) {
+				q = add(q, limbs{1});
+				r = sub(r, b);
+			}
+		}
+
+		// a = q * b + r, b != 0
+		inline void divmod(const limbs& a, const limbs& b, limbs& q, limbs& r) {
+			if (compare(a, b) < 0) {
+				q.clear();
+				r = a;
+				return;
+			}
+			if (b.size() == 1) {
+				q.assign(a.size(), 0);
+				const limb_t rem = divmod_1(q.data(), a.data(), a.size(), b[0]);
+				trim(q);
+				r.assign(rem ? 1 : 0, rem);
+				return;
+			}
+			const size_t n = a.size(), m = b.size();
+			if (m <= newton_threshold || n - m <= newton_threshold)
+				divmod_basecase(a, b, q, r);
+			else
+				divmod_reciprocal(a, b, reciprocal(b, n), n, q, r);
+		}
+
+		// 10^(18 * 2^i), grown by squaring until the square of the last one exceeds x;
+		// reciprocals are computed once per level on first use
+		struct decimal_powers {
+			std::vector<limbs> pw;
+			std::vector<limbs> inv;
+
+			explicit decimal_powers(size_t limb_count) : pw{limbs{pow10_18}} {
+				while (pw.back().size() * 2 < limb_count + 2)
+					pw.push_back(mul(pw.back(), pw.back()));
+				inv.resize(pw.size());
+			}
+
+			const limbs& power(size_t level) {
+				while (pw.size() <= level) {
+					pw.push_back(mul(pw.back(), pw.back()));
+					inv.emplace_back();
+				}
+				return pw[level];
+			}
+
+			// x < pw[level]^2
+			void divmod(const limbs& x, size_t level, limbs& q, limbs& r) {
+				const limbs& b = pw[level];
+				if (b.size() <= newton_threshold) {
+					limb::divmod(x, b, q, r);
+					return;
+				}
+				const size_t p = 2 * b.size();
+				if (inv[level].empty())
+					inv[level] = reciprocal(b, p);
+				divmod_reciprocal(x, b, inv[level], p, q, r);
+			}
+		};
+
+		// Divide and conquer: split by 10^(18 * 2^level), the low half is zero-padded to its width, x < pw[level]^2
+		inline void to_decimal(const limbs& x, size_t width, decimal_powers& pw, size_t level, std::string& out) {
+			if (x.size() <= radix_threshold) {
+				std::vector<limb_t> chunks;
+				limbs t(x);
+				while (!t.empty()) {
+					chunks.push_back(divmod_1(t.data(), t.data(), t.size(), pow10_18));
+					trim(t);
+				}
+				std::string s;
+				char buf[24];
+				for (size_t i = chunks.size(); i-- > 0; ) {
+					const int len = snprintf(buf, sizeof(buf), i + 1 == chunks.size() ? "%" PRIu64 : "%018" PRIu64, chunks[i]);
+					s.append(buf, len);
+				}
+				if (width > s.size())
+					out.append(width - s.size(), '0');
+				out += s;
+				return;
+			}
+			if (x.size() < pw.pw[level].size()) {
+				to_decimal(x, width, pw, level - 1, out);
+				return;
+			}
+			limbs q, r;
+			pw.divmod(x, level, q, r);
+			if (q.empty()) {
+				to_decimal(r, width, pw, level - 1, out);
+				return;
+			}
+			const size_t low_width = size_t(18) << level;
+			to_decimal(q, width > low_width ? width - low_width : 0, pw, level - 1, out);
+			to_decimal(r, low_width, pw, level - 1, out);
+		}
+
+		inline std::string to_decimal(const limbs& x) {
+			if (x.empty())
+				return "0";
+			decimal_powers pw(x.size());
+			std::string out;
+			out.reserve(x.size() * 20);
+			to_decimal(x, 0, pw, pw.pw.size() - 1, out);
+			return out;
+		}
+
+		// s[0, len) all decimal digits
+		inline limbs from_decimal(const char* s, size_t len, decimal_powers& pw) {
+			if (len <= 18 * radix_threshold) {
+				limbs r;
+				for (size_t i = 0; i < len; ) {
+					const size_t step = i == 0 && len % 18 ? len % 18 : 18;
+					limb_t chunk = 0, scale = 1;
+					for (size_t j = 0; j < step; ++j, ++i) {
+						chunk = chunk * 10 + static_cast<limb_t>(s[i] - '0');
+						scale *= 10;
+					}
+					const limb_t c = mul_1(r.data(), r.size(), scale, chunk);
+					if (c)
+						r.push_back(c);
+				}
+				trim(r);
+				return r;
+			}
+			size_t level = 0;
+			while ((size_t(18) << (level + 1)) < len)
+				++level;
+			const size_t low_width = size_t(18) << level;
+			const limbs hi = from_decimal(s, len - low_width, pw);
+			const limbs lo = from_decimal(s + len - low_width, low_width, pw);
+			return add(mul(hi, pw.power(level)), lo);
+		}
+
+		inline limbs from_decimal(const char* s, size_t len) {
+			decimal_powers pw(len / 20 + 1);
+			return from_decimal(s, len, pw);
+		}
+	}
+
+	// Arbitrary-precision unsigned integer over 64-bit limbs
+	class sn_big_unsigned {
+	public:
+		using limb_t = limb::limb_t;
+
+		sn_big_unsigned() = default;
+		template <typename I, typename = std::enable_if_t<std::is_integral<I>::value>>
+		sn_big_unsigned(I x) {
+			if (x)
+				data_.push_back(static_cast<limb_t>(x));
+		}
+		// decimal digits, leading '+' and zeros allowed
+		explicit sn_big_unsigned(const std::string& str) {
+			size_t i = 0;
+			if (i < str.size() && str[i] == '+')
+				++i;
+			for (size_t j = i; j < str.size(); ++j)
+				if (!isdigit(static_cast<unsigned char>(str[j])))
+					throw std::invalid_argument("sn_big_unsigned: not a decimal number");
+			while (i < str.size() && str[i] == '0')
+				++i;
+			data_ = limb::from_decimal(str.data() + i, str.size() - i);
+		}
+		explicit sn_big_unsigned(std::vector<limb_t> digits) : data_(std::move(digits)) {
+			limb::trim(data_);
+		}
+
+		const std::vector<limb_t>& limbs() const {
+			return data_;
+		}
+		bool is_zero() const {
+			return data_.empty();
+		}
+		size_t bit_length() const {
+			return data_.empty() ? 0 : data_.size() * 64 - __builtin_clzll(data_.back());
+		}
+		std::string to_string() const {
+			return limb::to_decimal(data_);
+		}
+
+		friend sn_big_unsigned operator+(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return sn_big_unsigned(limb::add(lhs.data_, rhs.data_));
+		}
+		// lhs >= rhs
+		friend sn_big_unsigned operator-(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			if (lhs < rhs)
+				throw std::underflow_error("sn_big_unsigned: negative difference");
+			return sn_big_unsigned(limb::sub(lhs.data_, rhs.data_));
+		}
+		friend sn_big_unsigned operator*(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return sn_big_unsigned(limb::mul(lhs.data_, rhs.data_));
+		}
+		friend sn_big_unsigned operator/(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return divmod(lhs, rhs).first;
+		}
+		friend sn_big_unsigned operator%(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return divmod(lhs, rhs).second;
+		}
+		static std::pair<sn_big_unsigned, sn_big_unsigned> divmod(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			if (rhs.is_zero())
+				throw std::domain_error("sn_big_unsigned: division by zero");
+			std::vector<limb_t> q, r;
+			limb::divmod(lhs.data_, rhs.data_, q, r);
+			return {sn_big_unsigned(std::move(q)), sn_big_unsigned(std::move(r))};
+		}
+
+		sn_big_unsigned& operator+=(const sn_big_unsigned& rhs) {
+			return *this = *this + rhs;
+		}
+		sn_big_unsigned& operator-=(const sn_big_unsigned& rhs) {
+			return *this = *this - rhs;
+		}
+		sn_big_unsigned& operator*=(const sn_big_unsigned& rhs) {
+			return *this = *this * rhs;
+		}
+		sn_big_unsigned& operator/=(const sn_big_unsigned& rhs) {
+			return *this = *this / rhs;
+		}
+		sn_big_unsigned& operator%=(const sn_big_unsigned& rhs) {
+			return *this = *this % rhs;
+		}
+
+		friend bool operator==(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return lhs.data_ == rhs.data_;
+		}
+		friend bool operator!=(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return lhs.data_ != rhs.data_;
+		}
+		friend bool operator<(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return limb::compare(lhs.data_, rhs.data_) < 0;
+		}
+		friend bool operator>(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return rhs < lhs;
+		}
+		friend bool operator<=(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return !(rhs < lhs);
+		}
+		friend bool operator>=(const sn_big_unsigned& lhs, const sn_big_unsigned& rhs) {
+			return !(lhs < rhs);
+		}
+
+		friend std::ostream& operator<<(std::ostream& out, const sn_big_unsigned& x) {
+			return out << x.to_string();
+		}
+		friend std::istream& operator>>(std::istream& in, sn_big_unsigned& x) {
+			std::string s;
+			if (in >> s)
+				x = sn_big_unsigned(s);
+			return in;
+		}
+
+	private:
+		std::vector<limb_t> data_;
+	};
+
+}
+
+
+#endif
@@ -0,0 +1,490 @@
+#ifndef SN_DECIMAL_FIXED_H
+#define SN_DECIMAL_FIXED_H
+
+#include "../sn_CommonHeader.h"
+#include "bigint.hpp"
+#include <cstring>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace sn_Decimal {
+
+	namespace fixed_detail {
+		using u128 = unsigned __int128;
+		using i128 = __int128;
+
+		template <typename T>
+		constexpr T pow10(unsigned n) {
+			T r = 1;
+			for (unsigned i = 0; i < n; ++i)
+				r *= 10;
+			return r;
+		}
+
+		template <typename Rep>
+		struct rep_traits;
+		template <>
+		struct rep_traits<int64_t> {
+			using unsigned_type = uint64_t;
+			using wide_type = u128;
+			constexpr const static unsigned max_scale = 18;
+		};
+		template <>
+		struct rep_traits<i128> {
+			using unsigned_type = u128;
+			constexpr const static unsigned max_scale = 38;
+		};
+
+		template <typename U>
+		constexpr U magnitude_max(bool negative) {
+			// |min| = max + 1 for two's complement
+			return (~U(0) >> 1) + (negative ? 1 : 0);
+		}
+
+		// round half to even, q = floor(x / d), r = x - q * d
+		template <typename U>
+		U round_half_even(U q, U r, U d) {
+			const U half = d - r;
+			return (r > half || (r == half && (q & 1))) ? q + 1 : q;
+		}
+
+		struct u256 {
+			u128 hi, lo;
+		};
+
+		inline u256 mul_wide(u128 a, u128 b) {
+			const uint64_t a0 = static_cast<uint64_t>(a), a1 = static_cast<uint64_t>(a >> 64);
+			const uint64_t b0 = static_cast<uint64_t>(b), b1 = static_cast<uint64_t>(b >> 64);
+			const u128 p00 = static_cast<u128>(a0) * b0, p01 = static_cast<u128>(a0) * b1;
+			const u128 p10 = static_cast<u128>(a1) * b0, p11 = static_cast<u128>(a1) * b1;
+			const u128 mid = (p00 >> 64) + static_cast<uint64_t>(p01) + static_cast<uint64_t>(p10);
+			return {p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64), (mid << 64) | static_cast<uint64_t>(p00)};
+		}
+
+		// x / d for a 64-bit d, four 128/64 steps
+		inline u256 div_small(u256 x, uint64_t d) {
+			uint64_t w[4] = {static_cast<uint64_t>(x.lo), static_cast<uint64_t>(x.lo >> 64), static_cast<uint64_t>(x.hi), static_cast<uint64_t>(x.hi >> 64)};
+			limb::divmod_1(w, w, 4, d);
+			return {(static_cast<u128>(w[3]) << 64) | w[2], (static_cast<u128>(w[1]) << 64) | w[0]};
+		}
+
+		// round_half_even(x / 10^s), s <= 38; false if the quotient does not fit 128 bits
+		inline bool div_pow10(u256 x, unsigned s, u128& q) {
+			u256 t = x;
+			for (unsigned left = s; left > 0; ) {
+				const unsigned step = left > 19 ? 19 : left;
+				t = div_small(t, pow10<uint64_t>(step));
+				left -= step;
+			}
+			if (t.hi)
+				return false;
+			const u128 d = pow10<u128>(s);
+			// r < d < 2^127, the low 128 bits are exact
+			q = round_half_even<u128>(t.lo, x.lo - t.lo * d, d);
+			return q >= t.lo;
+		}
+
+		// round_half_even(x / d) for any d != 0; false if the quotient does not fit 128 bits
+		inline bool div_wide(u256 x, u128 d, u128& q) {
+			if (!(d >> 64)) {
+				const u256 t = div_small(x, static_cast<uint64_t>(d));
+				if (t.hi)
+					return false;
+				q = round_half_even<u128>(t.lo, x.lo - t.lo * d, d);
+				return q >= t.lo;
+			}
+			limb::limbs a{static_cast<uint64_t>(x.lo), static_cast<uint64_t>(x.lo >> 64), static_cast<uint64_t>(x.hi), static_cast<uint64_t>(x.hi >> 64)};
+			limb::limbs b{static_cast<uint64_t>(d), static_cast<uint64_t>(d >> 64)}, lq, lr;
+			limb::trim(a);
+			limb::divmod(a, b, lq, lr);
+			if (lq.size() > 2)
+				return false;
+			lq.resize(2);
+			lr.resize(2);
+			const u128 fq = (static_cast<u128>(lq[1]) << 64) | lq[0];
+			q = round_half_even<u128>(fq, (static_cast<u128>(lr[1]) << 64) | lr[0], d);
+			return q >= fq;
+		}
+
+		// 00 .. 99
+		constexpr const char digit_pairs[201] =
+			"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+			"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+			"8081828384858687888990919293949596979899";
+
+		// writes exactly `width` digits of v (zero-padded) ending at last, returns the new end
+		inline char* write_digits(char* last, uint64_t v, unsigned width) {
+			for (; width >= 2; width -= 2, v /= 100) {
+				last -= 2;
+				std::memcpy(last, digit_pairs + 2 * (v % 100), 2);
+			}
+			if (width)
+				*--last = static_cast<char>('0' + v % 10);
+			return last;
+		}
+
+		inline unsigned count_digits(uint64_t v) {
+			unsigned n = 1;
+			for (; v >= 10; v /= 10)
+				++n;
+			return n;
+		}
+
+		// 8 ASCII digits at p to their value
+		// ref: https://lemire.me/blog/2022/01/21/swar-explained-parsing-eight-digits/
+		inline uint32_t parse_eight(const char* p) {
+			uint64_t v;
+			std::memcpy(&v, p, 8);
+			v -= 0x3030303030303030ULL;
+			v = (v * 10) + (v >> 8);
+			v = (((v & 0x000000FF000000FFULL) * 0x000F424000000064ULL) + (((v >> 16) & 0x000000FF000000FFULL) * 0x0000271000000001ULL)) >> 32;
+			return static_cast<uint32_t>(v);
+		}
+		inline bool is_eight_digits(const char* p) {
+			uint64_t v;
+			std::memcpy(&v, p, 8);
+			return !(((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ^ 0x3333333333333333ULL);
+		}
+	}
+
+	// Signed fixed-point decimal: value = raw / 10^Scale
+	// Every operation is exact or rounds half to even, and throws std::overflow_error instead of wrapping.
+	template <typename Rep, unsigned Scale>
+	class sn_fixed_decimal {
+	private:
+		using traits = fixed_detail::rep_traits<Rep>;
+		using unsigned_type = typename traits::unsigned_type;
+		static_assert(Scale <= traits::max_scale, "scale exceeds the digits of the representation");
+
+		Rep value;
+
+		static unsigned_type magnitude(Rep v) {
+			return v < 0 ? unsigned_type(0) - static_cast<unsigned_type>(v) : static_cast<unsigned_type>(v);
+		}
+		static Rep signed_from(unsigned_type mag, bool negative) {
+			if (mag > fixed_detail::magnitude_max<unsigned_type>(negative))
+				throw std::overflow_error("sn_fixed_decimal: overflow");
+			return negative ? static_cast<Rep>(unsigned_type(0) - mag) : static_cast<Rep>(mag);
+		}
+		static unsigned_type mul_div(unsigned_type a, unsigned_type b, unsigned_type d, bool pow10_d) {
+			if constexpr (std::is_same<Rep, int64_t>::value) {
+				const fixed_detail::u128 p = static_cast<fixed_detail::u128>(a) * b;
+				// the common small case stays in 64-bit arithmetic, dividing by a constant for operator*
+				if (!(p >> 64) && pow10_d) {
+					const uint64_t pl = static_cast<uint64_t>(p);
+					constexpr const uint64_t c = static_cast<uint64_t>(one);
+					return fixed_detail::round_half_even<uint64_t>(pl / c, pl % c, c);
+				}
+				const fixed_detail::u128 q = p / d;
+				const fixed_detail::u128 rq = fixed_detail::round_half_even<fixed_detail::u128>(q, p - q * d, d);
+				if (rq >> 64)
+					throw std::overflow_error("sn_fixed_decimal: overflow");
+				return static_cast<uint64_t>(rq);
+			} else {
+				const fixed_detail::u256 p = fixed_detail::mul_wide(a, b);
+				fixed_detail::u128 q;
+				if (!(pow10_d ? fixed_detail::div_pow10(p, Scale, q) : fixed_detail::div_wide(p, d, q)))
+					throw std::overflow_error("sn_fixed_decimal: overflow");
+				return q;
+			}
+		}
+
+	public:
+		using rep_type = Rep;
+		constexpr const static unsigned scale = Scale;
+		constexpr const static Rep one = fixed_detail::pow10<Rep>(Scale);
+
+		constexpr sn_fixed_decimal() : value(0) {}
+		template <typename I, typename = std::enable_if_t<std::is_integral<I>::value>>
+		sn_fixed_decimal(I x) {
+			Rep r;
+			if (__builtin_mul_overflow(static_cast<Rep>(x), one, &r) || (std::is_unsigned<I>::value && static_cast<Rep>(x) < 0))
+				throw std::overflow_error("sn_fixed_decimal: overflow");
+			value = r;
+		}
+		explicit sn_fixed_decimal(const std::string& str) : sn_fixed_decimal(parse(str.data(), str.size())) {}
+
+		static constexpr sn_fixed_decimal from_raw(Rep raw) {
+			sn_fixed_decimal ret;
+			ret.value = raw;
+			return ret;
+		}
+		constexpr Rep raw() const {
+			return value;
+		}
+
+		// [+-]digits[.digits], extra fraction digits are rounded half to even
+		static sn_fixed_decimal parse(const char* s, size_t len) {
+			using namespace fixed_detail;
+			size_t i = 0;
+			bool negative = false;
+			if (i < len && (s[i] == '-' || s[i] == '+'))
+				negative = s[i++] == '-';
+			unsigned_type mag = 0;
+			const unsigned_type limit = magnitude_max<unsigned_type>(negative);
+			bool any = false, overflow = false;
+			auto push = [&](unsigned_type mult, unsigned_type add) {
+				overflow |= __builtin_mul_overflow(mag, mult, &mag) || __builtin_add_overflow(mag, add, &mag);
+			};
+			for (; i + 8 <= len && is_eight_digits(s + i); i += 8, any = true)
+				push(100000000, parse_eight(s + i));
+			for (; i < len && isdigit(static_cast<unsigned char>(s[i])); ++i, any = true)
+				push(10, static_cast<unsigned_type>(s[i] - '0'));
+			unsigned frac = 0;
+			if (i < len && s[i] == '.') {
+				++i;
+				for (; i < len && frac < Scale && isdigit(static_cast<unsigned char>(s[i])); ++i, ++frac, any = true)
+					push(10, static_cast<unsigned_type>(s[i] - '0'));
+				if (i < len && isdigit(static_cast<unsigned char>(s[i]))) {
+					// first dropped digit decides, later ones only break a tie
+					const int first = s[i++] - '0';
+					bool sticky = false;
+					for (; i < len && isdigit(static_cast<unsigned char>(s[i])); ++i)
+						sticky |= s[i] != '0';
+					if (first > 5 || (first == 5 && (sticky || (mag & 1))))
+						push(1, 1);
+				}
+			}
+			if (!any || i != len)
+				throw std::invalid_argument("sn_fixed_decimal: not a decimal number");
+			for (; frac < Scale; ++frac)
+				push(10, 0);
+			if (overflow || mag > limit)
+				throw std::overflow_error("sn_fixed_decimal: overflow");
+			return from_raw(negative ? static_cast<Rep>(unsigned_type(0) - mag) : static_cast<Rep>(mag));
+		}
+
+		// writes at most max_chars() characters, returns the end
+		constexpr static size_t max_chars() {
+			return std::numeric_limits<unsigned_type>::digits10 + 4;
+		}
+		char* to_chars(char* first) const {
+			using namespace fixed_detail;
+			char buf[max_chars()];
+			char* const end = buf + sizeof(buf);
+			char* p = end;
+			unsigned_type mag = magnitude(value);
+			unsigned_type int_part = mag / static_cast<unsigned_type>(one);
+			unsigned_type frac_part = mag % static_cast<unsigned_type>(one);
+			// 19-digit chunks so that every write is 64-bit
+			for (unsigned left = Scale; left > 0; ) {
+				const unsigned step = left > 19 ? 19 : left;
+				p = write_digits(p, static_cast<uint64_t>(frac_part % pow10<unsigned_type>(step)), step);
+				frac_part /= pow10<unsigned_type>(step);
+				left -= step;
+			}
+			if (Scale)
+				*--p = '.';
+			do {
+				const uint64_t chunk = static_cast<uint64_t>(int_part % pow10<unsigned_type>(19));
+				int_part /= pow10<unsigned_type>(19);
+				p = write_digits(p, chunk, int_part ? 19 : count_digits(chunk));
+			} while (int_part);
+			if (value < 0)
+				*--p = '-';
+			std::memcpy(first, p, end - p);
+			return first + (end - p);
+		}
+		std::string to_string() const {
+			char buf[max_chars()];
+			return std::string(buf, to_chars(buf));
+		}
+		double to_double() const {
+			return static_cast<double>(value) / static_cast<double>(one);
+		}
+
+		// round half to even when the scale drops
+		template <unsigned S2>
+		sn_fixed_decimal<Rep, S2> rescale() const {
+			if constexpr (S2 >= Scale) {
+				Rep r;
+				if (__builtin_mul_overflow(value, fixed_detail::pow10<Rep>(S2 - Scale), &r))
+					throw std::overflow_error("sn_fixed_decimal: overflow");
+				return sn_fixed_decimal<Rep, S2>::from_raw(r);
+			} else {
+				constexpr const unsigned_type d = fixed_detail::pow10<unsigned_type>(Scale - S2);
+				const unsigned_type mag = magnitude(value);
+				const unsigned_type q = fixed_detail::round_half_even<unsigned_type>(mag / d, mag % d, d);
+				return sn_fixed_decimal<Rep, S2>::from_raw(value < 0 ? static_cast<Rep>(unsigned_type(0) - q) : static_cast<Rep>(q));
+			}
+		}
+
+		sn_fixed_decimal operator-() const {
+			return from_raw(signed_from(magnitude(value), value > 0));
+		}
+		sn_fixed_decimal operator+() const {
+			return *this;
+		}
+
+		friend sn_fixed_decimal operator+(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			Rep r;
+			if (__builtin_add_overflow(lhs.value, rhs.value, &r))
+				throw std::overflow_error("sn_fixed_decimal: overflow");
+			return from_raw(r);
+		}
+		friend sn_fixed_decimal operator-(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			Rep r;
+			if (__builtin_sub_overflow(lhs.value, rhs.value, &r))
+				throw std::overflow_error("sn_fixed_decimal: overflow");
+			return from_raw(r);
+		}
+		friend sn_fixed_decimal operator*(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			const bool negative = (lhs.value < 0) != (rhs.value < 0);
+			const unsigned_type mag = mul_div(magnitude(lhs.value), magnitude(rhs.value), static_cast<unsigned_type>(one), true);
+			return from_raw(signed_from(mag, negative));
+		}
+		friend sn_fixed_decimal operator/(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			if (rhs.value == 0)
+				throw std::domain_error("sn_fixed_decimal: division by zero");
+			const bool negative = (lhs.value < 0) != (rhs.value < 0);
+			const unsigned_type mag = mul_div(magnitude(lhs.value), static_cast<unsigned_type>(one), magnitude(rhs.value), false);
+			return from_raw(signed_from(mag, negative));
+		}
+
+		sn_fixed_decimal& operator+=(sn_fixed_decimal rhs) {
+			return *this = *this + rhs;
+		}
+		sn_fixed_decimal& operator-=(sn_fixed_decimal rhs) {
+			return *this = *this - rhs;
+		}
+		sn_fixed_decimal& operator*=(sn_fixed_decimal rhs) {
+			return *this = *this * rhs;
+		}
+		sn_fixed_decimal& operator/=(sn_fixed_decimal rhs) {
+			return *this = *this / rhs;
+		}
+
+		friend constexpr bool operator==(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			return lhs.value == rhs.value;
+		}
+		friend constexpr bool operator!=(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			return lhs.value != rhs.value;
+		}
+		friend constexpr bool operator<(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			return lhs.value < rhs.value;
+		}
+		friend constexpr bool operator>(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			return lhs.value > rhs.value;
+		}
+		friend constexpr bool operator<=(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			return lhs.value <= rhs.value;
+		}
+		friend constexpr bool operator>=(sn_fixed_decimal lhs, sn_fixed_decimal rhs) {
+			return lhs.value >= rhs.value;
+		}
+
+		friend std::ostream& operator<<(std::ostream& out, sn_fixed_decimal x) {
+			char buf[max_chars()];
+			return out.write(buf, x.to_chars(buf) - buf);
+		}
+	};
+
+	template <unsigned Scale>
+	using decimal64 = sn_fixed_decimal<int64_t, Scale>;
+	template <unsigned Scale>
+	using decimal128 = sn_fixed_decimal<__int128, Scale>;
+
+	// Batch kernels over contiguous arrays (sn_fixed_decimal is a single Rep, arrays are reinterpreted as raw values)
+	namespace fixed_batch {
+
+		// Exact sum: each value is split into its unsigned low and high 32 bits, both summed in 64-bit lanes
+		// (no overflow below 2^32 elements), the sign is restored by counting negatives.
+		template <unsigned Scale>
+		decimal128<Scale> sum(const decimal64<Scale>* a, size_t n) {
+			static_assert(sizeof(decimal64<Scale>) == sizeof(int64_t), "decimal64 must be a bare int64_t");
+			const int64_t* x = reinterpret_cast<const int64_t*>(a);
+			uint64_t lo = 0, hi = 0, neg = 0;
+			size_t i = 0;
+#if defined(__AVX2__)
+			const __m256i mask = _mm256_set1_epi64x(0xffffffff);
+			__m256i vlo = _mm256_setzero_si256(), vhi = _mm256_setzero_si256(), vneg = _mm256_setzero_si256();
+			for (; i + 4 <= n; i += 4) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+				vlo = _mm256_add_epi64(vlo, _mm256_and_si256(v, mask));
+				vhi = _mm256_add_epi64(vhi, _mm256_srli_epi64(v, 32));
+				vneg = _mm256_add_epi64(vneg, _mm256_srli_epi64(v, 63));
+			}
+			alignas(32) uint64_t buf[3][4];
+			_mm256_store_si256(reinterpret_cast<__m256i*>(buf[0]), vlo);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(buf[1]), vhi);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(buf[2]), vneg);
+			for (size_t j = 0; j < 4; ++j) {
+				lo += buf[0][j];
+				hi += buf[1][j];
+				neg += buf[2][j];
+			}
+#endif
+			for (; i < n; ++i) {
+				const uint64_t v = static_cast<uint64_t>(x[i]);
+				lo += v & 0xffffffff;
+				hi += v >> 32;
+				neg += v >> 63;
+			}
+			// each negative value contributed 2^64 too much through its high half
+			const __int128 total = (static_cast<__int128>(hi) << 32) + lo - (static_cast<__int128>(neg) << 64);
+			return decimal128<Scale>::from_raw(total);
+		}
+
+		// Exact dot product at scale 2 * Scale in 128-bit, one rounding back to Scale at the end
+		// (AVX2 has no 64x64->128 multiply, four scalar accumulators keep the multipliers busy).
+		template <unsigned Scale>
+		decimal128<Scale> dot(const decimal64<Scale>* a, const decimal64<Scale>* b, size_t n) {
+			static_assert(2 * Scale <= 38, "dot product needs 2 * Scale digits of fraction");
+			__int128 acc[4] = {0, 0, 0, 0};
+			bool overflow = false;
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+				for (size_t j = 0; j < 4; ++j)
+					overflow |= __builtin_add_overflow(acc[j], static_cast<__int128>(a[i + j].raw()) * b[i + j].raw(), &acc[j]);
+			for (; i < n; ++i)
+				overflow |= __builtin_add_overflow(acc[0], static_cast<__int128>(a[i].raw()) * b[i].raw(), &acc[0]);
+			__int128 total;
+			if (overflow || __builtin_add_overflow(acc[0], acc[1], &total) || __builtin_add_overflow(total, acc[2], &total) || __builtin_add_overflow(total, acc[3], &total))
+				throw std::overflow_error("sn_fixed_decimal: overflow");
+			return sn_fixed_decimal<__int128, 2 * Scale>::from_raw(total).template rescale<Scale>();
+		}
+
+		// out[i] = a[i] at scale S2, rounding half to even when the scale drops
+		template <unsigned S2, unsigned S1>
+		void rescale(const decimal64<S1>* a, size_t n, decimal64<S2>* out) {
+			if constexpr (S2 >= S1) {
+				constexpr const int64_t f = fixed_detail::pow10<int64_t>(S2 - S1);
+				constexpr const int64_t bound = std::numeric_limits<int64_t>::max() / f;
+				// range check first, the multiply loop then has no early exit and vectorizes
+				bool ok = true;
+				for (size_t i = 0; i < n; ++i)
+					ok &= a[i].raw() <= bound && a[i].raw() >= -bound;
+				if (!ok)
+					throw std::overflow_error("sn_fixed_decimal: overflow");
+				for (size_t i = 0; i < n; ++i)
+					out[i] = decimal64<S2>::from_raw(a[i].raw() * f);
+			} else {
+				// division by a compile-time constant compiles to a multiply-high,
+				// sign and rounding are masks since mixed-sign data would mispredict every branch
+				constexpr const uint64_t d = fixed_detail::pow10<uint64_t>(S1 - S2);
+				for (size_t i = 0; i < n; ++i) {
+					const uint64_t v = static_cast<uint64_t>(a[i].raw());
+					const uint64_t sign = 0 - (v >> 63);
+					const uint64_t mag = (v ^ sign) - sign;
+					const uint64_t q = mag / d, r2 = 2 * (mag - q * d);
+					const uint64_t rq = q + ((r2 > d) | ((r2 == d) & q & 1));
+					out[i] = decimal64<S2>::from_raw(static_cast<int64_t>((rq ^ sign) - sign));
+				}
+			}
+		}
+
+		template <unsigned Scale>
+		decimal128<Scale> sum(const std::vector<decimal64<Scale>>& a) {
+			return sum(a.data(), a.size());
+		}
+		template <unsigned Scale>
+		decimal128<Scale> dot(const std::vector<decimal64<Scale>>& a, const std::vector<decimal64<Scale>>& b) {
+			return dot(a.data(), b.data(), std::min(a.size(), b.size()));
+		}
+	}
+
+}
+
+
+#endif
@@ -2,6 +2,11 @@
 #define SN_JSON_H
 
 #include "sn_CommonHeader.h"
+#include "sn_JSON/parser.hpp"
+#include "sn_JSON/tape.hpp"
+#include "sn_JSON/writer.hpp"
+#include "sn_JSON/ondemand.hpp"
+#include "sn_JSON/reflect.hpp"
 
 namespace sn_JSON {
 
@@ -10,8 +15,6 @@ namespace sn_JSON {
 		class json_serializer {};
 	}
 
-	// TODO: add output formatting
-	// TODO: add parser/serializer
 	namespace container {
 		// ref: https://github.com/nlohmann/json/blob/develop/src/json.hpp
 
@@ -375,6 +378,76 @@ namespace sn_JSON {
 					return m_type;
 				}
 
+				object_t& get_object() {
+					if (!is_object())
+						throw std::runtime_error("Cannot use get_object with non-object json type.");
+					return *m_value.object;
+				}
+				const object_t& get_object() const {
+					if (!is_object())
+						throw std::runtime_error("Cannot use get_object with non-object json type.");
+					return *m_value.object;
+				}
+				array_t& get_array() {
+					if (!is_array())
+						throw std::runtime_error("Cannot use get_array with non-array json type.");
+					return *m_value.array;
+				}
+				const array_t& get_array() const {
+					if (!is_array())
+						throw std::runtime_error("Cannot use get_array with non-array json type.");
+					return *m_value.array;
+				}
+				string_t& get_string() {
+					if (!is_string())
+						throw std::runtime_error("Cannot use get_string with non-string json type.");
+					return *m_value.string;
+				}
+				const string_t& get_string() const {
+					if (!is_string())
+						throw std::runtime_error("Cannot use get_string with non-string json type.");
+					return *m_value.string;
+				}
+				boolean_t& get_boolean() {
+					if (!is_boolean())
+						throw std::runtime_error("Cannot use get_boolean with non-boolean json type.");
+					return m_value.boolean;
+				}
+				boolean_t get_boolean() const {
+					if (!is_boolean())
+						throw std::runtime_error("Cannot use get_boolean with non-boolean json type.");
+					return m_value.boolean;
+				}
+				integer_t get_integer() const {
+					if (!is_number_integer())
+						throw std::runtime_error("Cannot use get_integer with non-integer json type.");
+					return m_value.num_integer;
+				}
+				double_t get_double() const {
+					if (is_number_integer())
+						return static_cast<double_t>(m_value.num_integer);
+					if (!is_number_double())
+						throw std::runtime_error("Cannot use get_double with non-number json type.");
+					return m_value.num_double;
+				}
+
+				// Compact when indent == 0, see sn_JSON/writer.hpp for streaming output
+				std::string dump(unsigned indent = 0) const {
+					return writer::dump(*this, indent);
+				}
+
+				// SIMD two-stage parser, see sn_JSON/parser.hpp
+				static basic_json parse(const char* data, std::size_t len, std::size_t max_depth = parser::default_max_depth) {
+					return parser::parse<basic_json>(data, len, max_depth);
+				}
+				static basic_json parse(const char* str) {
+					return parser::parse<basic_json>(str);
+				}
+				template <typename Buffer, typename = parser::detail::buffer_t<Buffer>>
+				static basic_json parse(Buffer&& buf, std::size_t max_depth = parser::default_max_depth) {
+					return parser::parse<basic_json>(buf.data(), buf.size(), max_depth);
+				}
+
 				basic_json get() const {
 					return *this;
 				}
@@ -483,10 +556,6 @@ namespace sn_JSON {
 		};
 	}
 	using json = container::basic_json<>;
-	
-	namespace parser {
-
-	}
 }
 
 
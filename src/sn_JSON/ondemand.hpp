@@ -0,0 +1,705 @@
+#ifndef SN_JSON_ONDEMAND_H
+#define SN_JSON_ONDEMAND_H
+
+#include "../sn_CommonHeader.h"
+#include <cstring>
+#include <string_view>
+#include <thread>
+#include "parser.hpp"
+
+namespace sn_JSON {
+	// Pull parser over the stage 1 structural index: nothing is materialized, values are
+	// decoded when asked for and everything the caller does not touch is skipped by walking
+	// the structural positions only (bracket counting, string bodies are never read).
+	// Forward-only: a value can be read once, in document order; skipped subtrees are only
+	// checked for balanced brackets.
+	// ref: John Keiser, Daniel Lemire, On-Demand JSON: A Better Way to Parse Documents?
+	namespace ondemand {
+
+		enum class json_type : uint8_t {
+			object,
+			array,
+			string,
+			number,
+			boolean,
+			null
+		};
+
+		namespace detail {
+			using parser::parse_error;
+
+			struct cursor {
+				const char* buf = nullptr;
+				const char* end = nullptr;
+				const uint32_t* idx = nullptr;
+				std::size_t n = 0;
+				std::size_t pos = 0;
+				std::size_t depth = 0;
+				// unescaped strings, valid until the document is reloaded; a string is written at its own
+				// source offset (never longer than its source), so re-reading it after a rewind rewrites the same bytes
+				char* arena = nullptr;
+
+				std::size_t offset(std::size_t i) const {
+					return i < n ? idx[i] : static_cast<std::size_t>(end - buf);
+				}
+				char peek() const {
+					return pos < n ? buf[idx[pos]] : '\0';
+				}
+				std::size_t advance() {
+					if (pos == n)
+						throw parse_error("Unexpected end of input.", static_cast<std::size_t>(end - buf));
+					return idx[pos++];
+				}
+				// consume structurals until the cursor is back at depth d
+				void skip_to(std::size_t d) {
+					while (depth > d) {
+						switch (buf[advance()]) {
+						case '{':
+						case '[':
+							++depth;
+							break;
+						case '}':
+						case ']':
+							--depth;
+							break;
+						default:
+							break;
+						}
+					}
+				}
+				// the whole value starting at pos
+				void skip_value() {
+					const char c = buf[advance()];
+					if (c == '{' || c == '[') {
+						++depth;
+						skip_to(depth - 1);
+					}
+				}
+			};
+
+			struct arena_writer {
+				char* p;
+				void append(const char* s, std::size_t n) {
+					std::memcpy(p, s, n);
+					p += n;
+				}
+				void push_back(char c) {
+					*p++ = c;
+				}
+			};
+		}
+
+		class object;
+		class array;
+
+		class value {
+		public:
+			value() = default;
+			value(detail::cursor* c, std::size_t at) : m_cursor(c), m_at(at) {}
+
+			bool valid() const noexcept {
+				return m_cursor != nullptr;
+			}
+			explicit operator bool() const noexcept {
+				return valid();
+			}
+
+			json_type type() const {
+				switch (m_cursor->buf[m_cursor->idx[m_at]]) {
+				case '{': return json_type::object;
+				case '[': return json_type::array;
+				case '"': return json_type::string;
+				case 't': case 'f': return json_type::boolean;
+				case 'n': return json_type::null;
+				default: return json_type::number;
+				}
+			}
+
+			object get_object();
+			array get_array();
+
+			// Zero-copy view of the source when the string has no escapes, otherwise unescaped into the document arena
+			std::string_view get_string() {
+				const std::size_t at = consume();
+				const char* const body = m_cursor->buf + at + 1;
+				if (m_cursor->buf[at] != '"')
+					throw parser::parse_error("Expected a string.", at);
+				const char* q = structural::find_string_special(body, m_cursor->end);
+				if (q != m_cursor->end && *q == '"')
+					return std::string_view(body, static_cast<std::size_t>(q - body));
+				char* const out = m_cursor->arena + (at + 1);
+				detail::arena_writer w{out};
+				if (!parser::detail::parse_string(body, m_cursor->end, w))
+					throw parser::parse_error("Invalid string.", at);
+				return std::string_view(out, static_cast<std::size_t>(w.p - out));
+			}
+			// Whatever representation fits: int64, uint64 or double
+			number::value get_number() {
+				const std::size_t at = consume();
+				number::value v;
+				const char* p = number::parse(m_cursor->buf + at, m_cursor->end, v);
+				if (!p || !parser::detail::is_scalar_end(p, m_cursor->end))
+					throw parser::parse_error("Invalid number.", at);
+				return v;
+			}
+			int64_t get_int64() {
+				const number::value v = get_number();
+				if (v.kind != number::kind_t::signed_integer)
+					throw std::runtime_error("Cannot use get_int64 with non-int64 json type.");
+				return v.i;
+			}
+			uint64_t get_uint64() {
+				const number::value v = get_number();
+				if (v.kind == number::kind_t::unsigned_integer || (v.kind == number::kind_t::signed_integer && v.i >= 0))
+					return v.u;
+				throw std::runtime_error("Cannot use get_uint64 with non-uint64 json type.");
+			}
+			double get_double() {
+				const number::value v = get_number();
+				switch (v.kind) {
+				case number::kind_t::signed_integer:
+					return static_cast<double>(v.i);
+				case number::kind_t::unsigned_integer:
+					return static_cast<double>(v.u);
+				default:
+					return v.d;
+				}
+			}
+			bool get_bool() {
+				const std::size_t at = consume();
+				if (literal(at, "true", 4))
+					return true;
+				if (literal(at, "false", 5))
+					return false;
+				throw parser::parse_error("Expected a boolean.", at);
+			}
+			// Consumes the value only when it is null
+			bool is_null() {
+				check();
+				if (!literal(m_cursor->idx[m_at], "null", 4))
+					return false;
+				consume();
+				return true;
+			}
+
+			// Source text of the value, skipping it
+			std::string_view raw_json() {
+				check();
+				const std::size_t start = m_cursor->idx[m_at];
+				m_cursor->skip_value();
+				// up to the next structural byte, minus the whitespace before it
+				std::size_t stop = m_cursor->offset(m_cursor->pos);
+				while (stop > start) {
+					const char c = m_cursor->buf[stop - 1];
+					if (c != ' ' && c != '\t' && c != '\n' && c != '\r')
+						break;
+					--stop;
+				}
+				return std::string_view(m_cursor->buf + start, stop - start);
+			}
+			void skip() {
+				if (m_cursor->pos == m_at)
+					m_cursor->skip_value();
+			}
+
+		private:
+			friend class object;
+			friend class array;
+
+			void check() const {
+				if (m_cursor->pos != m_at)
+					throw std::runtime_error("On-demand value read out of order.");
+			}
+			std::size_t consume() {
+				check();
+				return m_cursor->advance();
+			}
+			bool literal(std::size_t at, const char* word, std::size_t len) const {
+				return static_cast<std::size_t>(m_cursor->end - m_cursor->buf) - at >= len &&
+					std::memcmp(m_cursor->buf + at, word, len) == 0 &&
+					parser::detail::is_scalar_end(m_cursor->buf + at + len, m_cursor->end);
+			}
+			detail::cursor* m_cursor = nullptr;
+			std::size_t m_at = 0;
+		};
+
+		class field {
+		public:
+			field() = default;
+			field(detail::cursor* c, std::size_t key_at, std::size_t colon_at, std::size_t value_at)
+				: m_cursor(c), m_key_at(key_at), m_colon_at(colon_at), m_value(c, value_at) {}
+
+			// Key as it appears in the source, escapes not decoded
+			std::string_view raw_key() const {
+				const char* const begin = m_cursor->buf + m_cursor->idx[m_key_at] + 1;
+				const char* stop = m_cursor->buf + m_cursor->idx[m_colon_at];
+				while (*--stop != '"') {}
+				return std::string_view(begin, static_cast<std::size_t>(stop - begin));
+			}
+			std::string key() const {
+				const std::string_view raw = raw_key();
+				std::string ret;
+				if (!parser::detail::parse_string(raw.data(), raw.data() + raw.size() + 1, ret))
+					throw parser::parse_error("Invalid string.", m_cursor->idx[m_key_at]);
+				return ret;
+			}
+			bool key_equals(std::string_view k) const {
+				const std::string_view raw = raw_key();
+				if (raw.find('\\') == std::string_view::npos)
+					return raw == k;
+				return key() == k;
+			}
+			value& get_value() {
+				return m_value;
+			}
+
+		private:
+			detail::cursor* m_cursor = nullptr;
+			std::size_t m_key_at = 0, m_colon_at = 0;
+			value m_value;
+		};
+
+		class object {
+		public:
+			object(detail::cursor* c, std::size_t depth) : m_cursor(c), m_depth(depth), m_start(c->pos) {}
+
+			// Next member, false once the closing brace is consumed; skips whatever is left of the previous value
+			bool next(field& f) {
+				if (m_done)
+					return false;
+				if (m_started) {
+					finish_value();
+					const std::size_t sep = m_cursor->advance();
+					if (m_cursor->buf[sep] == '}') {
+						close();
+						return false;
+					}
+					if (m_cursor->buf[sep] != ',')
+						throw parser::parse_error("Expected ',' or '}'.", sep);
+				}
+				else {
+					m_started = true;
+					if (m_cursor->peek() == '}') {
+						m_cursor->advance();
+						close();
+						return false;
+					}
+				}
+				const std::size_t key_at = m_cursor->pos;
+				if (m_cursor->buf[m_cursor->advance()] != '"')
+					throw parser::parse_error("Expected a string key.", m_cursor->idx[key_at]);
+				const std::size_t colon_at = m_cursor->pos;
+				if (m_cursor->buf[m_cursor->advance()] != ':')
+					throw parser::parse_error("Expected ':'.", m_cursor->idx[colon_at]);
+				m_value_at = m_cursor->pos;
+				f = field(m_cursor, key_at, colon_at, m_value_at);
+				return true;
+			}
+
+			// Scans forward from the current member, members passed over are skipped for good
+			value find_field(std::string_view key) {
+				field f;
+				while (next(f)) {
+					if (f.key_equals(key))
+						return f.get_value();
+				}
+				return value();
+			}
+			// As find_field, then once more from the first member if the key was not ahead
+			// (the index keeps every position, so an object can be rewound while its parent has not moved on)
+			value find_field_unordered(std::string_view key) {
+				if (value v = find_field(key))
+					return v;
+				rewind();
+				return find_field(key);
+			}
+			value operator[](std::string_view key) {
+				return find_field_unordered(key);
+			}
+			void rewind() {
+				m_cursor->pos = m_start;
+				m_cursor->depth = m_depth;
+				m_started = m_done = false;
+			}
+
+			// Consume the rest of the object
+			void skip() {
+				if (!m_done)
+					m_cursor->skip_to(m_depth - 1);
+				m_done = true;
+			}
+
+			class iterator {
+			public:
+				using iterator_category = std::input_iterator_tag;
+				using value_type = field;
+				using difference_type = std::ptrdiff_t;
+				using pointer = field*;
+				using reference = field&;
+
+				explicit iterator(object* obj) : m_obj(obj) {
+					if (m_obj && !m_obj->next(m_field))
+						m_obj = nullptr;
+				}
+				field& operator*() {
+					return m_field;
+				}
+				iterator& operator++() {
+					if (!m_obj->next(m_field))
+						m_obj = nullptr;
+					return *this;
+				}
+				bool operator==(const iterator& rhs) const {
+					return m_obj == rhs.m_obj;
+				}
+				bool operator!=(const iterator& rhs) const {
+					return m_obj != rhs.m_obj;
+				}
+			private:
+				object* m_obj;
+				field m_field;
+			};
+			iterator begin() {
+				return iterator(this);
+			}
+			iterator end() {
+				return iterator(nullptr);
+			}
+
+		private:
+			void finish_value() {
+				if (m_cursor->pos == m_value_at)
+					m_cursor->skip_value();
+				else
+					m_cursor->skip_to(m_depth);
+			}
+			void close() {
+				--m_cursor->depth;
+				m_done = true;
+			}
+
+			detail::cursor* m_cursor;
+			std::size_t m_depth;
+			std::size_t m_start;
+			std::size_t m_value_at = 0;
+			bool m_started = false;
+			bool m_done = false;
+		};
+
+		class array {
+		public:
+			array(detail::cursor* c, std::size_t depth) : m_cursor(c), m_depth(depth) {}
+
+			bool next(value& v) {
+				if (m_done)
+					return false;
+				if (m_started) {
+					if (m_cursor->pos == m_value_at)
+						m_cursor->skip_value();
+					else
+						m_cursor->skip_to(m_depth);
+					const std::size_t sep = m_cursor->advance();
+					if (m_cursor->buf[sep] == ']') {
+						close();
+						return false;
+					}
+					if (m_cursor->buf[sep] != ',')
+						throw parser::parse_error("Expected ',' or ']'.", sep);
+				}
+				else {
+					m_started = true;
+					if (m_cursor->peek() == ']') {
+						m_cursor->advance();
+						close();
+						return false;
+					}
+				}
+				m_value_at = m_cursor->pos;
+				v = value(m_cursor, m_value_at);
+				return true;
+			}
+
+			void skip() {
+				if (!m_done)
+					m_cursor->skip_to(m_depth - 1);
+				m_done = true;
+			}
+
+			class iterator {
+			public:
+				using iterator_category = std::input_iterator_tag;
+				using value_type = ondemand::value;
+				using difference_type = std::ptrdiff_t;
+				using pointer = ondemand::value*;
+				using reference = ondemand::value&;
+
+				explicit iterator(array* arr) : m_arr(arr) {
+					if (m_arr && !m_arr->next(m_value))
+						m_arr = nullptr;
+				}
+				ondemand::value& operator*() {
+					return m_value;
+				}
+				iterator& operator++() {
+					if (!m_arr->next(m_value))
+						m_arr = nullptr;
+					return *this;
+				}
+				bool operator==(const iterator& rhs) const {
+					return m_arr == rhs.m_arr;
+				}
+				bool operator!=(const iterator& rhs) const {
+					return m_arr != rhs.m_arr;
+				}
+			private:
+				array* m_arr;
+				ondemand::value m_value;
+			};
+			iterator begin() {
+				return iterator(this);
+			}
+			iterator end() {
+				return iterator(nullptr);
+			}
+
+		private:
+			void close() {
+				--m_cursor->depth;
+				m_done = true;
+			}
+
+			detail::cursor* m_cursor;
+			std::size_t m_depth;
+			std::size_t m_value_at = 0;
+			bool m_started = false;
+			bool m_done = false;
+		};
+
+		inline object value::get_object() {
+			const std::size_t at = consume();
+			if (m_cursor->buf[at] != '{')
+				throw parser::parse_error("Expected an object.", at);
+			return object(m_cursor, ++m_cursor->depth);
+		}
+		inline array value::get_array() {
+			const std::size_t at = consume();
+			if (m_cursor->buf[at] != '[')
+				throw parser::parse_error("Expected an array.", at);
+			return array(m_cursor, ++m_cursor->depth);
+		}
+
+		// One buffer holding any number of whitespace-separated documents (a single one included),
+		// indexed once; the index and string arena are reused across load() calls
+		class document_stream {
+		public:
+			document_stream() = default;
+			document_stream(const char* data, std::size_t len) {
+				load(data, len);
+			}
+			template <typename Buffer, typename = parser::detail::buffer_t<Buffer>>
+			explicit document_stream(Buffer&& buf) {
+				load(buf.data(), buf.size());
+			}
+			document_stream(const document_stream&) = delete;
+			document_stream& operator=(const document_stream&) = delete;
+
+			void load(const char* data, std::size_t len) {
+				parser::index(data, len, m_structural);
+				if (m_arena_capacity < len) {
+					m_arena_capacity = len;
+					m_arena.reset(new char[m_arena_capacity]);
+				}
+				m_cursor = detail::cursor();
+				m_cursor.buf = data;
+				m_cursor.end = data + len;
+				m_cursor.idx = m_structural.data();
+				m_cursor.n = m_structural.size();
+				m_cursor.arena = m_arena.get();
+				m_doc_at = npos;
+			}
+
+			// Root of the next document, invalid value at the end; the previous one is skipped past
+			value next() {
+				if (m_doc_at != npos) {
+					if (m_cursor.pos == m_doc_at)
+						m_cursor.skip_value();
+					else
+						m_cursor.skip_to(0);
+				}
+				if (m_cursor.pos == m_cursor.n)
+					return value();
+				m_doc_at = m_cursor.pos;
+				return value(&m_cursor, m_doc_at);
+			}
+
+			// Start offset of the document last returned by next()
+			std::size_t offset() const {
+				return m_cursor.offset(m_doc_at);
+			}
+
+			class iterator {
+			public:
+				using iterator_category = std::input_iterator_tag;
+				using value_type = ondemand::value;
+				using difference_type = std::ptrdiff_t;
+				using pointer = ondemand::value*;
+				using reference = ondemand::value&;
+
+				explicit iterator(document_stream* s) : m_stream(s) {
+					if (m_stream && !(m_value = m_stream->next()))
+						m_stream = nullptr;
+				}
+				ondemand::value& operator*() {
+					return m_value;
+				}
+				iterator& operator++() {
+					if (!(m_value = m_stream->next()))
+						m_stream = nullptr;
+					return *this;
+				}
+				bool operator==(const iterator& rhs) const {
+					return m_stream == rhs.m_stream;
+				}
+				bool operator!=(const iterator& rhs) const {
+					return m_stream != rhs.m_stream;
+				}
+			private:
+				document_stream* m_stream;
+				ondemand::value m_value;
+			};
+			iterator begin() {
+				return iterator(this);
+			}
+			iterator end() {
+				return iterator(nullptr);
+			}
+
+		private:
+			constexpr const static std::size_t npos = static_cast<std::size_t>(-1);
+
+			std::vector<uint32_t> m_structural;
+			std::unique_ptr<char[]> m_arena;
+			std::size_t m_arena_capacity = 0;
+			detail::cursor m_cursor;
+			std::size_t m_doc_at = npos;
+		};
+
+		// Exactly one document
+		class document {
+		public:
+			document() = default;
+			document(const char* data, std::size_t len) {
+				load(data, len);
+			}
+			template <typename Buffer, typename = parser::detail::buffer_t<Buffer>>
+			explicit document(Buffer&& buf) {
+				load(buf.data(), buf.size());
+			}
+
+			void load(const char* data, std::size_t len) {
+				m_stream.load(data, len);
+				m_root = m_stream.next();
+				if (!m_root)
+					throw parser::parse_error("Empty document.", 0);
+			}
+			value& root() {
+				return m_root;
+			}
+
+		private:
+			document_stream m_stream;
+			value m_root;
+		};
+	}
+
+	// Newline-delimited JSON: one document per line, a raw '\n' can never occur inside a JSON value
+	namespace ndjson {
+
+		// Cut [0, len) into at most parts ranges, each ending just after a '\n' (or at len)
+		inline std::vector<std::pair<std::size_t, std::size_t>> split(const char* buf, std::size_t len, std::size_t parts) {
+			std::vector<std::pair<std::size_t, std::size_t>> ret;
+			std::size_t begin = 0;
+			for (std::size_t i = 1; i <= parts && begin < len; ++i) {
+				std::size_t stop = i == parts ? len : std::max(begin, len / parts * i);
+				if (stop < len) {
+					const void* nl = std::memchr(buf + stop, '\n', len - stop);
+					stop = nl ? static_cast<std::size_t>(static_cast<const char*>(nl) - buf) + 1 : len;
+				}
+				ret.emplace_back(begin, stop);
+				begin = stop;
+			}
+			return ret;
+		}
+
+		// fn(ondemand::value root) for every document
+		template <typename F>
+		void for_each(const char* buf, std::size_t len, F&& fn) {
+			ondemand::document_stream docs(buf, len);
+			for (ondemand::value& root : docs)
+				fn(root);
+		}
+
+		// fn(ondemand::value root, unsigned worker) for every document, threads == 0 uses every core
+		// Each worker owns one contiguous slice of lines; the first exception is rethrown after all joined
+		template <typename F>
+		void parallel_for_each(const char* buf, std::size_t len, F&& fn, unsigned threads = 0) {
+			if (threads == 0)
+				threads = std::max(1u, std::thread::hardware_concurrency());
+			const auto slices = split(buf, len, threads);
+			std::vector<std::exception_ptr> errors(slices.size());
+			auto work = [&](unsigned t) {
+				try {
+					ondemand::document_stream docs(buf + slices[t].first, slices[t].second - slices[t].first);
+					for (ondemand::value& root : docs)
+						fn(root, t);
+				}
+				catch (...) {
+					errors[t] = std::current_exception();
+				}
+			};
+			std::vector<std::thread> workers;
+			for (unsigned t = 1; t < slices.size(); ++t)
+				workers.emplace_back(work, t);
+			if (!slices.empty())
+				work(0);
+			for (auto& w : workers)
+				w.join();
+			for (auto& e : errors) {
+				if (e)
+					std::rethrow_exception(e);
+			}
+		}
+
+		// Documents read chunk by chunk from a Source with read_bytes(uint8_t*, len) -> len
+		// (sn_Stream::stream::IStream and friends); memory stays at about one chunk plus the longest line
+		template <typename Source, typename F>
+		void stream_for_each(Source& src, F&& fn, std::size_t chunk_size = std::size_t(1) << 24) {
+			std::vector<char> buf(chunk_size);
+			std::size_t filled = 0;
+			ondemand::document_stream docs;
+			for (;;) {
+				if (filled == buf.size())
+					buf.resize(buf.size() * 2);
+				const std::size_t got = static_cast<std::size_t>(src.read_bytes(reinterpret_cast<uint8_t*>(buf.data() + filled), buf.size() - filled));
+				filled += got;
+				std::size_t complete = filled;
+				if (got != 0) {
+					// hand over whole lines only
+					while (complete > 0 && buf[complete - 1] != '\n')
+						--complete;
+					if (complete == 0)
+						continue;
+				}
+				docs.load(buf.data(), complete);
+				for (ondemand::value& root : docs)
+					fn(root);
+				if (got == 0)
+					return;
+				std::memmove(buf.data(), buf.data() + complete, filled - complete);
+				filled -= complete;
+			}
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,309 @@
+#ifndef SN_JSON_PARSER_H
+#define SN_JSON_PARSER_H
+
+#include "../sn_CommonHeader.h"
+#include <cstring>
+#include "structural.hpp"
+#include "number.hpp"
+
+namespace sn_JSON {
+	namespace parser {
+
+		class parse_error : public std::runtime_error {
+		public:
+			parse_error(const std::string& what, std::size_t offset)
+				: std::runtime_error(what + " At byte " + std::to_string(offset) + "."), m_offset(offset) {}
+			std::size_t offset() const noexcept {
+				return m_offset;
+			}
+		private:
+			std::size_t m_offset;
+		};
+
+		constexpr const static std::size_t default_max_depth = 1024;
+
+		namespace detail {
+			inline bool is_scalar_end(const char* p, const char* end) {
+				if (p == end)
+					return true;
+				switch (*p) {
+				case ' ': case '\t': case '\n': case '\r':
+				case ',': case ':': case '[': case ']': case '{': case '}':
+					return true;
+				default:
+					return false;
+				}
+			}
+
+			inline int hex_value(char c) {
+				if (c >= '0' && c <= '9')
+					return c - '0';
+				c |= 0x20;
+				if (c >= 'a' && c <= 'f')
+					return c - 'a' + 10;
+				return -1;
+			}
+
+			// \uXXXX, p at the 'u'
+			inline bool parse_hex4(const char* p, const char* end, uint32_t& cp) {
+				if (end - p < 5)
+					return false;
+				cp = 0;
+				for (int i = 1; i <= 4; ++i) {
+					const int h = hex_value(p[i]);
+					if (h < 0)
+						return false;
+					cp = (cp << 4) | static_cast<uint32_t>(h);
+				}
+				return true;
+			}
+
+			template <typename String>
+			void append_utf8(String& out, uint32_t cp) {
+				if (cp < 0x80) {
+					out.push_back(static_cast<char>(cp));
+				}
+				else if (cp < 0x800) {
+					out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+					out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+				}
+				else if (cp < 0x10000) {
+					out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+					out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+					out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+				}
+				else {
+					out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+					out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+					out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+					out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+				}
+			}
+
+			// p just after the opening quote; appends the unescaped body to out
+			// Returns one past the closing quote, nullptr on a bad escape or raw control character
+			template <typename String>
+			const char* parse_string(const char* p, const char* end, String& out) {
+				for (;;) {
+					const char* q = structural::find_string_special(p, end);
+					out.append(p, static_cast<std::size_t>(q - p));
+					if (q == end)
+						return nullptr;
+					if (*q == '"')
+						return q + 1;
+					if (*q != '\\' || q + 1 == end)
+						return nullptr;
+					switch (q[1]) {
+					case '"': out.push_back('"'); break;
+					case '\\': out.push_back('\\'); break;
+					case '/': out.push_back('/'); break;
+					case 'b': out.push_back('\b'); break;
+					case 'f': out.push_back('\f'); break;
+					case 'n': out.push_back('\n'); break;
+					case 'r': out.push_back('\r'); break;
+					case 't': out.push_back('\t'); break;
+					case 'u': {
+						uint32_t cp;
+						if (!parse_hex4(q + 1, end, cp))
+							return nullptr;
+						q += 4;
+						if (cp >= 0xD800 && cp <= 0xDBFF) {
+							// high surrogate, a low one must follow
+							uint32_t low;
+							if (end - q < 4 || q[2] != '\\' || q[3] != 'u' || !parse_hex4(q + 3, end, low) || low < 0xDC00 || low > 0xDFFF)
+								return nullptr;
+							cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+							q += 6;
+						}
+						else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+							return nullptr;
+						}
+						append_utf8(out, cp);
+						break;
+					}
+					default:
+						return nullptr;
+					}
+					p = q + 2;
+				}
+			}
+
+			// Stage 2: walk the structural index and build the document
+			template <typename Json>
+			class dom_builder {
+			public:
+				using value_t = typename Json::value_t;
+				using string_t = typename Json::string_t;
+				using integer_t = typename Json::integer_t;
+				using double_t = typename Json::double_t;
+
+				dom_builder(const char* buf, std::size_t len, const uint32_t* idx, std::size_t n, std::size_t max_depth)
+					: m_buf(buf), m_end(buf + len), m_idx(idx), m_n(n), m_max_depth(max_depth) {}
+
+				Json build() {
+					if (m_n == 0)
+						throw parse_error("Empty document.", 0);
+					Json ret = value(0);
+					if (m_pos != m_n)
+						throw parse_error("Unexpected content after the document.", m_idx[m_pos]);
+					return ret;
+				}
+
+			private:
+				std::size_t next() {
+					if (m_pos == m_n)
+						throw parse_error("Unexpected end of input.", static_cast<std::size_t>(m_end - m_buf));
+					return m_idx[m_pos++];
+				}
+				char peek() const {
+					return m_pos == m_n ? '\0' : m_buf[m_idx[m_pos]];
+				}
+
+				void string(std::size_t at, string_t& out) {
+					if (!parse_string(m_buf + at + 1, m_end, out))
+						throw parse_error("Invalid string.", at);
+				}
+
+				void literal(std::size_t at, const char* word, std::size_t len) {
+					if (static_cast<std::size_t>(m_end - m_buf) - at < len || std::memcmp(m_buf + at, word, len) != 0 ||
+						!is_scalar_end(m_buf + at + len, m_end))
+						throw parse_error("Invalid literal.", at);
+				}
+
+				Json value(std::size_t depth) {
+					const std::size_t at = next();
+					switch (m_buf[at]) {
+					case '{':
+						return object(at, depth + 1);
+					case '[':
+						return array(at, depth + 1);
+					case '"': {
+						Json ret(value_t::string);
+						string(at, ret.get_string());
+						return ret;
+					}
+					case 't': {
+						literal(at, "true", 4);
+						Json ret(value_t::boolean);
+						ret.get_boolean() = true;
+						return ret;
+					}
+					case 'f':
+						literal(at, "false", 5);
+						return Json(value_t::boolean);
+					case 'n':
+						literal(at, "null", 4);
+						return Json();
+					default:
+						return parse_number(at);
+					}
+				}
+
+				Json parse_number(std::size_t at) {
+					number::value v;
+					const char* p = number::parse(m_buf + at, m_end, v);
+					if (!p || !is_scalar_end(p, m_end))
+						throw parse_error("Invalid number.", at);
+					switch (v.kind) {
+					case number::kind_t::signed_integer:
+						return Json(static_cast<integer_t>(v.i));
+					case number::kind_t::unsigned_integer:
+						return Json(static_cast<double_t>(v.u));
+					default:
+						return Json(static_cast<double_t>(v.d));
+					}
+				}
+
+				Json object(std::size_t at, std::size_t depth) {
+					if (depth > m_max_depth)
+						throw parse_error("Exceeded maximum nesting depth.", at);
+					Json ret(value_t::object);
+					auto& obj = ret.get_object();
+					if (peek() == '}') {
+						++m_pos;
+						return ret;
+					}
+					for (;;) {
+						const std::size_t key_at = next();
+						if (m_buf[key_at] != '"')
+							throw parse_error("Expected a string key.", key_at);
+						string_t key;
+						string(key_at, key);
+						const std::size_t colon = next();
+						if (m_buf[colon] != ':')
+							throw parse_error("Expected ':'.", colon);
+						obj[std::move(key)] = value(depth);
+						const std::size_t sep = next();
+						if (m_buf[sep] == '}')
+							return ret;
+						if (m_buf[sep] != ',')
+							throw parse_error("Expected ',' or '}'.", sep);
+					}
+				}
+
+				Json array(std::size_t at, std::size_t depth) {
+					if (depth > m_max_depth)
+						throw parse_error("Exceeded maximum nesting depth.", at);
+					Json ret(value_t::array);
+					auto& arr = ret.get_array();
+					if (peek() == ']') {
+						++m_pos;
+						return ret;
+					}
+					for (;;) {
+						arr.push_back(value(depth));
+						const std::size_t sep = next();
+						if (m_buf[sep] == ']')
+							return ret;
+						if (m_buf[sep] != ',')
+							throw parse_error("Expected ',' or ']'.", sep);
+					}
+				}
+
+				const char* m_buf;
+				const char* m_end;
+				const uint32_t* m_idx;
+				std::size_t m_n;
+				std::size_t m_pos = 0;
+				std::size_t m_max_depth;
+			};
+
+			template <typename Buffer>
+			using buffer_t = decltype(std::declval<Buffer&>().data(), std::declval<Buffer&>().size(), void());
+		}
+
+		// Stage 1 only, shared by every consumer of the structural index
+		inline void index(const char* data, std::size_t len, std::vector<uint32_t>& out) {
+			switch (structural::index(data, len, out)) {
+			case structural::error_t::unclosed_string:
+				throw parse_error("Unclosed string.", len);
+			case structural::error_t::invalid_utf8:
+				throw parse_error("Invalid UTF-8.", 0);
+			case structural::error_t::too_large:
+				throw parse_error("Document larger than 4GiB.", 0);
+			default:
+				break;
+			}
+		}
+
+		template <typename Json>
+		Json parse(const char* data, std::size_t len, std::size_t max_depth = default_max_depth) {
+			std::vector<uint32_t> idx;
+			index(data, len, idx);
+			return detail::dom_builder<Json>(data, len, idx.data(), idx.size(), max_depth).build();
+		}
+
+		template <typename Json>
+		Json parse(const char* str) {
+			return parse<Json>(str, std::strlen(str));
+		}
+
+		// Anything exposing data() / size(): std::string, sn_String::basic_string_view, file_map::InputMemoryFile, ...
+		template <typename Json, typename Buffer, typename = detail::buffer_t<Buffer>>
+		Json parse(Buffer&& buf, std::size_t max_depth = default_max_depth) {
+			return parse<Json>(buf.data(), buf.size(), max_depth);
+		}
+	}
+}
+
+#endif
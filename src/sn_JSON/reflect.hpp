@@ -0,0 +1,516 @@
+#ifndef SN_JSON_REFLECT_H
+#define SN_JSON_REFLECT_H
+
+#include "../sn_CommonHeader.h"
+#include "../sn_Reflection.hpp"
+#include <cstring>
+#include <string_view>
+#include <optional>
+#include "writer.hpp"
+#include "ondemand.hpp"
+
+namespace sn_JSON {
+	// Struct <-> JSON without a DOM in between: encoders are unrolled over the reflected members
+	// straight into writer::basic_writer, decoders pull from ondemand::value straight into the fields.
+	// Named structs are registered with SN_REFLECTION inside sn_Reflection::named_pod_reflect and map
+	// to objects, member names are found with a perfect hash built at compile time.
+	// Other trivial structs whose fields are all types unamed_pod_reflect registers (the integers, char,
+	// wchar_t and double) go through it and map to arrays.
+	//
+	//     struct point { int x; int y; };
+	//     namespace sn_Reflection { namespace named_pod_reflect { SN_REFLECTION(point, x, y) } }
+	//     std::string s = sn_JSON::reflect::to_json(point{1, 2});   // {"x":1,"y":2}
+	//     point p; sn_JSON::reflect::from_json(s, p);
+	//
+	// Types holding a std::string_view decode only through from_json(doc, ...): escaped strings are
+	// unescaped into the arena of that document, which has to outlive the result.
+	namespace reflect {
+		using sn_Reflection::named_pod_reflect::sn_reflection_member;
+
+		template <typename T, typename = void>
+		struct is_named : std::false_type {};
+		template <typename T>
+		struct is_named<T, std::void_t<typename sn_reflection_member<T>::type>> : std::true_type {};
+
+		namespace detail {
+			template <typename T>
+			struct is_std_array : std::false_type {};
+			template <typename T, std::size_t N>
+			struct is_std_array<std::array<T, N>> : std::true_type {};
+
+			template <typename T>
+			struct is_optional : std::false_type {};
+			template <typename T>
+			struct is_optional<std::optional<T>> : std::true_type {};
+
+			template <typename T, typename = void>
+			struct is_sequence : std::false_type {};
+			template <typename T>
+			struct is_sequence<T, std::void_t<typename T::value_type, decltype(std::declval<T&>().emplace_back())>> : std::true_type {};
+
+			// std::map / std::unordered_map keyed by std::string
+			template <typename T, typename = void>
+			struct is_string_map : std::false_type {};
+			template <typename T>
+			struct is_string_map<T, std::void_t<typename T::mapped_type>> : std::is_same<typename T::key_type, std::string> {};
+
+			// The field types unamed_pod_reflect::type_to_id knows
+			template <typename T>
+			struct is_pod_field : std::integral_constant<bool,
+				std::is_same<T, unsigned char>::value || std::is_same<T, unsigned short>::value ||
+				std::is_same<T, unsigned int>::value || std::is_same<T, unsigned long>::value ||
+				std::is_same<T, unsigned long long>::value || std::is_same<T, signed char>::value ||
+				std::is_same<T, short>::value || std::is_same<T, int>::value || std::is_same<T, long>::value ||
+				std::is_same<T, long long>::value || std::is_same<T, char>::value ||
+				std::is_same<T, wchar_t>::value || std::is_same<T, double>::value> {};
+
+			// Aggregate-initializer stand-ins: one converting to anything, one only to a registered field type
+			template <std::size_t>
+			struct any_field {
+				template <typename U>
+				constexpr operator U() const noexcept;
+			};
+			template <std::size_t>
+			struct pod_field {
+				template <typename U, typename = std::enable_if_t<is_pod_field<U>::value>>
+				constexpr operator U() const noexcept;
+			};
+
+			template <typename T, template <std::size_t> class F, typename Seq, typename = void>
+			struct is_brace_constructible : std::false_type {};
+			template <typename T, template <std::size_t> class F, std::size_t ...I>
+			struct is_brace_constructible<T, F, std::index_sequence<I...>, std::void_t<decltype(T{ F<I>{}... })>> : std::true_type {};
+
+			// Number of fields: the most initializers T{...} takes
+			template <typename T, std::size_t N = 0, bool = is_brace_constructible<T, any_field, std::make_index_sequence<N + 1>>::value>
+			struct field_count : std::integral_constant<std::size_t, N> {};
+			template <typename T, std::size_t N>
+			struct field_count<T, N, true> : field_count<T, N + 1> {};
+
+			template <typename T>
+			constexpr bool is_unnamed() {
+#if defined(__GNUC__) || defined(__clang__)
+				if constexpr (std::is_class<T>::value && std::is_trivial<T>::value && !is_named<T>::value && !is_std_array<T>::value) {
+					constexpr std::size_t N = field_count<T>::value;
+					return N != 0 && is_brace_constructible<T, pod_field, std::make_index_sequence<N>>::value;
+				}
+				else {
+					return false;
+				}
+#else
+				return false;
+#endif
+			}
+
+			template <typename T>
+			struct dependent_false : std::false_type {};
+
+			template <typename P>
+			struct member_type;
+			template <typename C, typename M>
+			struct member_type<M C::*> {
+				using type = M;
+			};
+
+			// Whether decoding T can leave a std::string_view pointing into the document arena
+			template <typename T, typename = void>
+			struct holds_view;
+
+			template <typename T, typename Seq>
+			struct named_holds_view;
+			template <typename T, std::size_t ...I>
+			struct named_holds_view<T, std::index_sequence<I...>> : std::disjunction<
+				holds_view<typename member_type<std::tuple_element_t<I, decltype(sn_reflection_member<T>::apply())>>::type>...> {};
+
+			template <typename T, typename>
+			struct holds_view : std::false_type {};
+			template <>
+			struct holds_view<std::string_view> : std::true_type {};
+			template <typename T, std::size_t N>
+			struct holds_view<T[N]> : holds_view<T> {};
+			template <typename T, std::size_t N>
+			struct holds_view<std::array<T, N>> : holds_view<T> {};
+			template <typename T>
+			struct holds_view<std::optional<T>> : holds_view<T> {};
+			template <typename T>
+			struct holds_view<T, std::enable_if_t<is_named<T>::value>>
+				: named_holds_view<T, std::make_index_sequence<sn_reflection_member<T>::value>> {};
+			template <typename T>
+			struct holds_view<T, std::enable_if_t<!is_named<T>::value && is_string_map<T>::value>> : holds_view<typename T::mapped_type> {};
+			template <typename T>
+			struct holds_view<T, std::enable_if_t<!is_named<T>::value && !is_string_map<T>::value && is_sequence<T>::value>>
+				: holds_view<typename T::value_type> {};
+
+			//-----------compile-time perfect hash over member names-----------
+
+			constexpr std::size_t length(const char* s) {
+				std::size_t n = 0;
+				while (s[n])
+					++n;
+				return n;
+			}
+
+			// FNV-1a
+			constexpr uint32_t hash(const char* s, std::size_t n) {
+				uint32_t h = 2166136261u;
+				for (std::size_t i = 0; i < n; ++i) {
+					h ^= static_cast<unsigned char>(s[i]);
+					h *= 16777619u;
+				}
+				return h;
+			}
+
+			constexpr unsigned table_bits(std::size_t n) {
+				unsigned bits = 1;
+				while ((std::size_t(1) << bits) < n * 2)
+					++bits;
+				return bits;
+			}
+
+			// Fibonacci hashing of the seeded hash, the top bits pick the slot
+			constexpr std::size_t slot_of(uint32_t h, uint32_t seed, unsigned bits) {
+				return static_cast<uint32_t>((h ^ seed) * 2654435769u) >> (32 - bits);
+			}
+
+			template <std::size_t N>
+			struct perfect_hash {
+				constexpr static const unsigned bits = table_bits(N);
+				constexpr static const std::size_t size = std::size_t(1) << bits;
+				constexpr static const uint8_t empty = 0xFF;
+				uint32_t seed = 0;
+				uint8_t slot[size] = {};
+				const char* names[N == 0 ? 1 : N] = {};
+				std::size_t lengths[N == 0 ? 1 : N] = {};
+
+				// Member index of key, or N
+				std::size_t find(std::string_view key) const noexcept {
+					const uint8_t i = slot[slot_of(hash(key.data(), key.size()), seed, bits)];
+					if (i != empty && lengths[i] == key.size() && std::memcmp(names[i], key.data(), key.size()) == 0)
+						return i;
+					return N;
+				}
+			};
+
+			// Smallest seed under which every name lands in its own slot (a 2N table, so a few tries at most)
+			template <typename T>
+			constexpr auto make_perfect_hash() {
+				using M = sn_reflection_member<T>;
+				constexpr std::size_t N = M::value;
+				static_assert(N < perfect_hash<N>::empty, "Too many members.");
+				perfect_hash<N> ret{};
+				for (std::size_t i = 0; i < N; ++i) {
+					ret.names[i] = M::arr[i];
+					ret.lengths[i] = length(M::arr[i]);
+				}
+				for (uint32_t seed = 0; seed < 10000; ++seed) {
+					for (std::size_t s = 0; s < perfect_hash<N>::size; ++s)
+						ret.slot[s] = perfect_hash<N>::empty;
+					bool ok = true;
+					for (std::size_t i = 0; i < N && ok; ++i) {
+						const std::size_t s = slot_of(hash(ret.names[i], ret.lengths[i]), seed, perfect_hash<N>::bits);
+						if (ret.slot[s] != perfect_hash<N>::empty)
+							ok = false;
+						else
+							ret.slot[s] = static_cast<uint8_t>(i);
+					}
+					if (ok) {
+						ret.seed = seed;
+						return ret;
+					}
+				}
+				throw std::logic_error("No perfect hash for the member names.");
+			}
+
+			template <typename T>
+			struct field_table {
+				constexpr static const auto value = make_perfect_hash<T>();
+			};
+		}
+
+		//-----------encode-----------
+
+		template <typename Sink, typename T>
+		void write(writer::basic_writer<Sink>& w, const T& v);
+
+		namespace detail {
+			template <typename Sink, typename T, std::size_t ...I>
+			void write_named(writer::basic_writer<Sink>& w, const T& v, std::index_sequence<I...>) {
+				using M = sn_reflection_member<T>;
+				constexpr auto members = M::apply();
+				w.begin_object();
+				(void)std::initializer_list<int>{ (w.plain_key(M::arr[I]), write(w, v.*std::get<I>(members)), 0)... };
+				w.end_object();
+			}
+
+#if defined(__GNUC__) || defined(__clang__)
+			template <typename Sink, typename T, std::size_t ...I>
+			void write_unnamed(writer::basic_writer<Sink>& w, const T& v, std::index_sequence<I...>) {
+				w.begin_array();
+				(void)std::initializer_list<int>{ (write(w, sn_Reflection::unamed_pod_reflect::get<I>(v)), 0)... };
+				w.end_array();
+			}
+#endif
+		}
+
+		template <typename Sink, typename T>
+		void write(writer::basic_writer<Sink>& w, const T& v) {
+			if constexpr (std::is_same<T, bool>::value || std::is_arithmetic<T>::value) {
+				w.value(v);
+			}
+			else if constexpr (std::is_enum<T>::value) {
+				w.value(static_cast<std::underlying_type_t<T>>(v));
+			}
+			else if constexpr (std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value) {
+				w.value(std::string_view(v));
+			}
+			else if constexpr (std::is_array<T>::value) {
+				if constexpr (std::is_same<std::remove_extent_t<T>, char>::value) {
+					// fixed char buffer, up to the first NUL
+					const char* const end = static_cast<const char*>(std::memchr(v, '\0', sizeof(T)));
+					w.value(std::string_view(v, end ? static_cast<std::size_t>(end - v) : sizeof(T)));
+				}
+				else {
+					w.begin_array();
+					for (const auto& e : v)
+						write(w, e);
+					w.end_array();
+				}
+			}
+			else if constexpr (detail::is_optional<T>::value) {
+				if (v)
+					write(w, *v);
+				else
+					w.value(nullptr);
+			}
+			else if constexpr (is_named<T>::value) {
+				detail::write_named(w, v, std::make_index_sequence<sn_reflection_member<T>::value>());
+			}
+			else if constexpr (detail::is_string_map<T>::value) {
+				w.begin_object();
+				for (const auto& kv : v) {
+					w.key(kv.first);
+					write(w, kv.second);
+				}
+				w.end_object();
+			}
+			else if constexpr (detail::is_sequence<T>::value || detail::is_std_array<T>::value) {
+				w.begin_array();
+				for (const auto& e : v)
+					write(w, e);
+				w.end_array();
+			}
+#if defined(__GNUC__) || defined(__clang__)
+			else if constexpr (detail::is_unnamed<T>()) {
+				detail::write_unnamed(w, v, std::make_index_sequence<sn_Reflection::unamed_pod_reflect::fields_count<T>()>());
+			}
+#endif
+			else {
+				static_assert(detail::dependent_false<T>::value, "Type has no JSON mapping.");
+			}
+		}
+
+		template <typename T>
+		std::string to_json(const T& v, unsigned indent = 0) {
+			std::string ret;
+			writer::string_sink sink(ret);
+			writer::basic_writer<writer::string_sink> w(sink, indent);
+			write(w, v);
+			w.flush();
+			return ret;
+		}
+
+		//-----------decode-----------
+
+		// std::string_view members (and views inside other members) point into the input or the
+		// document arena, they live as long as those do (the document until it is reloaded)
+		template <typename T>
+		void read(ondemand::value& v, T& out);
+
+		namespace detail {
+			template <typename T, std::size_t I>
+			void read_member(ondemand::value& v, T& out) {
+				constexpr auto members = sn_reflection_member<T>::apply();
+				read(v, out.*std::get<I>(members));
+			}
+
+			template <typename T, std::size_t ...I>
+			void read_named(ondemand::value& v, T& out, std::index_sequence<I...>) {
+				using read_fn = void(*)(ondemand::value&, T&);
+				constexpr std::size_t N = sizeof...(I);
+				constexpr static const read_fn dispatch[N == 0 ? 1 : N] = { &read_member<T, I>... };
+				const auto& table = field_table<T>::value;
+
+				ondemand::object obj = v.get_object();
+				ondemand::field f;
+				// unknown members are skipped, missing ones keep their value
+				while (obj.next(f)) {
+					const std::string_view raw = f.raw_key();
+					std::size_t i = table.find(raw);
+					if (i == N && raw.find('\\') != std::string_view::npos)
+						i = table.find(f.key());
+					if (i != N)
+						dispatch[i](f.get_value(), out);
+				}
+			}
+
+#if defined(__GNUC__) || defined(__clang__)
+			template <typename T, std::size_t ...I>
+			void read_unnamed(ondemand::value& v, T& out, std::index_sequence<I...>) {
+				ondemand::array arr = v.get_array();
+				ondemand::value e;
+				auto one = [&](auto& field) {
+					if (!arr.next(e))
+						throw std::runtime_error("Too few elements.");
+					read(e, field);
+				};
+				(void)std::initializer_list<int>{ (one(sn_Reflection::unamed_pod_reflect::get<I>(out)), 0)... };
+				if (arr.next(e))
+					throw std::runtime_error("Too many elements.");
+			}
+#endif
+
+			template <typename T>
+			void read_integer(ondemand::value& v, T& out) {
+				if constexpr (std::is_signed<T>::value) {
+					const int64_t i = v.get_int64();
+					if (i < static_cast<int64_t>(std::numeric_limits<T>::min()) || i > static_cast<int64_t>(std::numeric_limits<T>::max()))
+						throw std::runtime_error("Integer out of range.");
+					out = static_cast<T>(i);
+				}
+				else {
+					const uint64_t u = v.get_uint64();
+					if (u > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+						throw std::runtime_error("Integer out of range.");
+					out = static_cast<T>(u);
+				}
+			}
+
+			template <typename T, typename Insert>
+			void read_elements(ondemand::value& v, Insert&& insert) {
+				ondemand::array arr = v.get_array();
+				ondemand::value e;
+				while (arr.next(e))
+					insert(e);
+			}
+		}
+
+		template <typename T>
+		void read(ondemand::value& v, T& out) {
+			if constexpr (std::is_same<T, bool>::value) {
+				out = v.get_bool();
+			}
+			else if constexpr (std::is_integral<T>::value) {
+				detail::read_integer(v, out);
+			}
+			else if constexpr (std::is_floating_point<T>::value) {
+				out = static_cast<T>(v.get_double());
+			}
+			else if constexpr (std::is_enum<T>::value) {
+				std::underlying_type_t<T> u;
+				detail::read_integer(v, u);
+				out = static_cast<T>(u);
+			}
+			else if constexpr (std::is_same<T, std::string>::value) {
+				const std::string_view s = v.get_string();
+				out.assign(s.data(), s.size());
+			}
+			else if constexpr (std::is_same<T, std::string_view>::value) {
+				out = v.get_string();
+			}
+			else if constexpr (std::is_array<T>::value) {
+				using E = std::remove_extent_t<T>;
+				constexpr std::size_t N = std::extent<T>::value;
+				if constexpr (std::is_same<E, char>::value) {
+					const std::string_view s = v.get_string();
+					if (s.size() > N)
+						throw std::runtime_error("String too long.");
+					std::memcpy(out, s.data(), s.size());
+					std::memset(out + s.size(), 0, N - s.size());
+				}
+				else {
+					std::size_t i = 0;
+					detail::read_elements<T>(v, [&](ondemand::value& e) {
+						if (i == N)
+							throw std::runtime_error("Too many elements.");
+						read(e, out[i++]);
+					});
+				}
+			}
+			else if constexpr (detail::is_optional<T>::value) {
+				if (v.is_null()) {
+					out.reset();
+				}
+				else {
+					if (!out)
+						out.emplace();
+					read(v, *out);
+				}
+			}
+			else if constexpr (is_named<T>::value) {
+				detail::read_named(v, out, std::make_index_sequence<sn_reflection_member<T>::value>());
+			}
+			else if constexpr (detail::is_string_map<T>::value) {
+				out.clear();
+				ondemand::object obj = v.get_object();
+				for (auto& f : obj)
+					read(f.get_value(), out[f.key()]);
+			}
+			else if constexpr (detail::is_std_array<T>::value) {
+				std::size_t i = 0;
+				detail::read_elements<T>(v, [&](ondemand::value& e) {
+					if (i == out.size())
+						throw std::runtime_error("Too many elements.");
+					read(e, out[i++]);
+				});
+			}
+			else if constexpr (detail::is_sequence<T>::value) {
+				out.clear();
+				detail::read_elements<T>(v, [&](ondemand::value& e) {
+					read(e, out.emplace_back());
+				});
+			}
+#if defined(__GNUC__) || defined(__clang__)
+			else if constexpr (detail::is_unnamed<T>()) {
+				detail::read_unnamed(v, out, std::make_index_sequence<sn_Reflection::unamed_pod_reflect::fields_count<T>()>());
+			}
+#endif
+			else {
+				static_assert(detail::dependent_false<T>::value, "Type has no JSON mapping.");
+			}
+		}
+
+		// Decodes through the caller's document, views in out stay valid until doc is reloaded or destroyed
+		template <typename T>
+		void from_json(ondemand::document& doc, const char* data, std::size_t len, T& out) {
+			doc.load(data, len);
+			read(doc.root(), out);
+		}
+
+		template <typename T, typename Buffer, typename = parser::detail::buffer_t<Buffer>>
+		void from_json(ondemand::document& doc, Buffer&& buf, T& out) {
+			from_json(doc, buf.data(), buf.size(), out);
+		}
+
+		template <typename T>
+		void from_json(const char* data, std::size_t len, T& out) {
+			static_assert(!detail::holds_view<T>::value,
+				"std::string_view members would outlive the document, use from_json(doc, ...).");
+			ondemand::document doc;
+			from_json(doc, data, len, out);
+		}
+
+		template <typename T, typename Buffer, typename = parser::detail::buffer_t<Buffer>>
+		void from_json(Buffer&& buf, T& out) {
+			from_json(buf.data(), buf.size(), out);
+		}
+
+		template <typename T>
+		T from_json(const char* data, std::size_t len) {
+			T ret{};
+			from_json(data, len, ret);
+			return ret;
+		}
+	}
+}
+
+#endif
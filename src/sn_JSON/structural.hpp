@@ -0,0 +1,259 @@
+#ifndef SN_JSON_STRUCTURAL_H
+#define SN_JSON_STRUCTURAL_H
+
+#include "../sn_CommonHeader.h"
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace sn_JSON {
+	// Stage 1: classify 64-byte blocks into bitmasks, then extract the position of every
+	// structural character ({}[]:,), every opening quote and the first byte of every other scalar.
+	// Quote / escape / in-string tracking is carried across blocks with bit tricks, no per-byte branches.
+	// ref: Geoff Langdale, Daniel Lemire, Parsing Gigabytes of JSON per Second
+	// ref: https://github.com/simdjson/simdjson
+	namespace structural {
+
+		struct block_masks {
+			uint64_t quote;
+			uint64_t backslash;
+			uint64_t op;
+			uint64_t whitespace;
+			uint64_t non_ascii;
+		};
+
+		namespace detail {
+#if defined(__AVX2__)
+			inline void classify_32(__m256i v, uint32_t& quote, uint32_t& backslash, uint32_t& op, uint32_t& whitespace, uint32_t& non_ascii) {
+				// '[' | 0x20 == '{', ']' | 0x20 == '}'
+				const __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+				const __m256i ops = _mm256_or_si256(
+					_mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+					_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))));
+				// whitespace by low nibble lookup: ' ' -> 0, '\t' -> 9, '\n' -> 10, '\r' -> 13, 0x80 never matches its own slot
+				const __m256i ws_table = _mm256_setr_epi8(
+					' ', -128, -128, -128, -128, -128, -128, -128, -128, '\t', '\n', -128, -128, '\r', -128, -128,
+					' ', -128, -128, -128, -128, -128, -128, -128, -128, '\t', '\n', -128, -128, '\r', -128, -128);
+				const __m256i ws = _mm256_cmpeq_epi8(_mm256_shuffle_epi8(ws_table, v), v);
+				quote = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'))));
+				backslash = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+				op = static_cast<uint32_t>(_mm256_movemask_epi8(ops));
+				whitespace = static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+				non_ascii = static_cast<uint32_t>(_mm256_movemask_epi8(v));
+			}
+#elif defined(__SSE2__)
+			inline void classify_16(__m128i v, uint64_t& quote, uint64_t& backslash, uint64_t& op, uint64_t& whitespace, uint64_t& non_ascii, int shift) {
+				const __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+				const __m128i ops = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+					_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+				const __m128i ws = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+					_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+				quote |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')))) << shift;
+				backslash |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')))) << shift;
+				op |= static_cast<uint64_t>(_mm_movemask_epi8(ops)) << shift;
+				whitespace |= static_cast<uint64_t>(_mm_movemask_epi8(ws)) << shift;
+				non_ascii |= static_cast<uint64_t>(_mm_movemask_epi8(v)) << shift;
+			}
+#endif
+
+			// bit i = xor of bits [0, i]
+			inline uint64_t prefix_xor(uint64_t x) {
+#if defined(__PCLMUL__)
+				return static_cast<uint64_t>(_mm_cvtsi128_si64(
+					_mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<int64_t>(x)), _mm_set1_epi8(static_cast<char>(0xFF)), 0)));
+#else
+				x ^= x << 1;
+				x ^= x << 2;
+				x ^= x << 4;
+				x ^= x << 8;
+				x ^= x << 16;
+				x ^= x << 32;
+				return x;
+#endif
+			}
+
+			// Characters preceded by an odd-length run of backslashes
+			inline uint64_t find_escaped(uint64_t backslash, uint64_t& prev_escaped) {
+				constexpr const uint64_t even_bits = 0x5555555555555555;
+				backslash &= ~prev_escaped;
+				const uint64_t follows_escape = (backslash << 1) | prev_escaped;
+				const uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+				uint64_t even_start_runs;
+				prev_escaped = __builtin_add_overflow(odd_starts, backslash, &even_start_runs);
+				return (even_bits ^ (even_start_runs << 1)) & follows_escape;
+			}
+
+			// Structurally valid UTF-8 (no overlongs, surrogates or code points above U+10FFFF)
+			inline bool validate_utf8(const unsigned char* p, size_t len) {
+				const unsigned char* const end = p + len;
+				while (p != end) {
+					if (*p < 0x80) {
+						// skip ASCII runs a word at a time
+						uint64_t v;
+						while (end - p >= 8 && (std::memcpy(&v, p, 8), (v & 0x8080808080808080) == 0))
+							p += 8;
+						while (p != end && *p < 0x80)
+							++p;
+						continue;
+					}
+					size_t n;
+					uint32_t cp;
+					if ((*p & 0xE0) == 0xC0) {
+						n = 1;
+						cp = *p & 0x1F;
+					}
+					else if ((*p & 0xF0) == 0xE0) {
+						n = 2;
+						cp = *p & 0x0F;
+					}
+					else if ((*p & 0xF8) == 0xF0) {
+						n = 3;
+						cp = *p & 0x07;
+					}
+					else {
+						return false;
+					}
+					if (static_cast<size_t>(end - p) <= n)
+						return false;
+					for (size_t i = 1; i <= n; ++i) {
+						if ((p[i] & 0xC0) != 0x80)
+							return false;
+						cp = (cp << 6) | (p[i] & 0x3F);
+					}
+					constexpr const static uint32_t min_code_point[] = {0, 0x80, 0x800, 0x10000};
+					if (cp < min_code_point[n] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+						return false;
+					p += n + 1;
+				}
+				return true;
+			}
+		}
+
+		// 64 bytes at p
+		inline block_masks classify(const char* p) {
+			block_masks m;
+#if defined(__AVX2__)
+			uint32_t q[2], b[2], o[2], w[2], a[2];
+			for (int h = 0; h < 2; ++h)
+				detail::classify_32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32 * h)), q[h], b[h], o[h], w[h], a[h]);
+			m.quote = q[0] | (static_cast<uint64_t>(q[1]) << 32);
+			m.backslash = b[0] | (static_cast<uint64_t>(b[1]) << 32);
+			m.op = o[0] | (static_cast<uint64_t>(o[1]) << 32);
+			m.whitespace = w[0] | (static_cast<uint64_t>(w[1]) << 32);
+			m.non_ascii = a[0] | (static_cast<uint64_t>(a[1]) << 32);
+#elif defined(__SSE2__)
+			m = block_masks{0, 0, 0, 0, 0};
+			for (int h = 0; h < 4; ++h)
+				detail::classify_16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * h)),
+					m.quote, m.backslash, m.op, m.whitespace, m.non_ascii, 16 * h);
+#else
+			m = block_masks{0, 0, 0, 0, 0};
+			for (int i = 0; i < 64; ++i) {
+				const unsigned char c = static_cast<unsigned char>(p[i]);
+				const uint64_t bit = uint64_t(1) << i;
+				m.quote |= (c == '"') ? bit : 0;
+				m.backslash |= (c == '\\') ? bit : 0;
+				m.op |= (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') ? bit : 0;
+				m.whitespace |= (c == ' ' || c == '\t' || c == '\n' || c == '\r') ? bit : 0;
+				m.non_ascii |= (c >= 0x80) ? bit : 0;
+			}
+#endif
+			return m;
+		}
+
+		enum class error_t : uint8_t {
+			success,
+			unclosed_string,
+			invalid_utf8,
+			too_large
+		};
+
+		// Fill out with the positions of all structural bytes of [buf, buf + len)
+		inline error_t index(const char* buf, size_t len, std::vector<uint32_t>& out) {
+			if (len > std::numeric_limits<uint32_t>::max())
+				return error_t::too_large;
+			uint64_t prev_escaped = 0, prev_in_string = 0, prev_scalar = 0;
+			size_t n = 0, first_non_ascii = len;
+			out.clear();
+			char tail[64];
+			for (size_t base = 0; base < len; base += 64) {
+				const char* block = buf + base;
+				if (len - base < 64) {
+					std::memset(tail, ' ', sizeof(tail));
+					std::memcpy(tail, block, len - base);
+					block = tail;
+				}
+				const block_masks m = classify(block);
+				if (m.non_ascii && first_non_ascii == len)
+					first_non_ascii = base + __builtin_ctzll(m.non_ascii);
+
+				const uint64_t escaped = detail::find_escaped(m.backslash, prev_escaped);
+				const uint64_t quote = m.quote & ~escaped;
+				// opening quote and string body set, closing quote clear
+				const uint64_t in_string = detail::prefix_xor(quote) ^ prev_in_string;
+				prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+				const uint64_t scalar = ~(m.op | m.whitespace);
+				const uint64_t nonquote_scalar = scalar & ~quote;
+				const uint64_t follows_scalar = (nonquote_scalar << 1) | prev_scalar;
+				prev_scalar = nonquote_scalar >> 63;
+				const uint64_t string_tail = in_string ^ quote;
+				uint64_t bits = (m.op | (scalar & ~follows_scalar)) & ~string_tail;
+
+				if (out.size() < n + 64)
+					out.resize(std::max(out.size() * 2, n + 64));
+				uint32_t* dst = out.data() + n;
+				n += static_cast<size_t>(__builtin_popcountll(bits));
+				while (bits) {
+					*dst++ = static_cast<uint32_t>(base + __builtin_ctzll(bits));
+					bits &= bits - 1;
+				}
+			}
+			out.resize(n);
+			if (prev_in_string)
+				return error_t::unclosed_string;
+			if (first_non_ascii != len &&
+				!detail::validate_utf8(reinterpret_cast<const unsigned char*>(buf) + first_non_ascii, len - first_non_ascii))
+				return error_t::invalid_utf8;
+			return error_t::success;
+		}
+
+		// First '"', '\\' or control character in [p, end), end if none
+		inline const char* find_string_special(const char* p, const char* end) {
+#if defined(__AVX2__)
+			for (; end - p >= 32; p += 32) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+				const __m256i special = _mm256_or_si256(
+					_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+					_mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F)));
+				const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(special));
+				if (mask)
+					return p + __builtin_ctz(mask);
+			}
+#endif
+#if defined(__SSE2__)
+			for (; end - p >= 16; p += 16) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+				const __m128i special = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+					_mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F)));
+				const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(special));
+				if (mask)
+					return p + __builtin_ctz(mask);
+			}
+#endif
+			for (; p != end; ++p) {
+				const unsigned char c = static_cast<unsigned char>(*p);
+				if (c == '"' || c == '\\' || c < 0x20)
+					break;
+			}
+			return p;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,559 @@
+#ifndef SN_JSON_TAPE_H
+#define SN_JSON_TAPE_H
+
+#include "../sn_CommonHeader.h"
+#include <cstring>
+#include <string_view>
+#include "parser.hpp"
+
+namespace sn_JSON {
+	// Read-only DOM on one flat tape of 64-bit words plus one string arena
+	// A document is three buffers (structural index, tape, arena) whatever its size,
+	// reused across load() calls and released in O(1).
+	// ref: https://github.com/simdjson/simdjson/blob/master/doc/tape.md
+	namespace tape {
+
+		// Tape word: type character in the top 8 bits, payload in the low 56
+		//   '{' / '[' : index one past the matching close (low 32), element count (bits 32..55, saturated)
+		//   '}' / ']' : index of the matching open
+		//   '"'       : arena offset of [uint32 length][bytes]['\0']
+		//   'l' / 'u' / 'd' : int64 / uint64 / double bits in the next word
+		//   't' / 'f' / 'n' : no payload
+		//   'r'       : root, index one past the last word
+		enum class type_t : char {
+			object = '{',
+			array = '[',
+			string = '"',
+			integer = 'l',
+			unsigned_integer = 'u',
+			floating = 'd',
+			true_value = 't',
+			false_value = 'f',
+			null = 'n'
+		};
+
+		class document;
+
+		class element {
+		public:
+			element() = default;
+			element(const document* doc, uint32_t idx) : m_doc(doc), m_idx(idx) {}
+
+			// false for the result of a failed lookup
+			bool valid() const noexcept {
+				return m_doc != nullptr;
+			}
+			explicit operator bool() const noexcept {
+				return valid();
+			}
+			uint32_t index() const noexcept {
+				return m_idx;
+			}
+
+			type_t type() const;
+			bool is_object() const { return type() == type_t::object; }
+			bool is_array() const { return type() == type_t::array; }
+			bool is_string() const { return type() == type_t::string; }
+			bool is_number() const {
+				const type_t t = type();
+				return t == type_t::integer || t == type_t::unsigned_integer || t == type_t::floating;
+			}
+			bool is_boolean() const {
+				const type_t t = type();
+				return t == type_t::true_value || t == type_t::false_value;
+			}
+			bool is_null() const { return type() == type_t::null; }
+
+			// Zero-copy, points into the document arena
+			std::string_view get_string() const;
+			int64_t get_int64() const;
+			uint64_t get_uint64() const;
+			double get_double() const;
+			bool get_bool() const;
+
+			// Elements of an array / members of an object
+			std::size_t size() const;
+
+			// Object member, invalid element if absent (first one wins on duplicate keys)
+			element find(std::string_view key) const;
+			element operator[](std::string_view key) const {
+				return find(key);
+			}
+			element at(std::string_view key) const {
+				const element e = find(key);
+				if (!e)
+					throw std::runtime_error("Out of range.");
+				return e;
+			}
+			// Array element, O(i)
+			element at(std::size_t i) const;
+
+			class iterator;
+			class member_iterator;
+			template <typename It>
+			struct range {
+				It first, last;
+				It begin() const { return first; }
+				It end() const { return last; }
+			};
+			range<iterator> elements() const;
+			range<member_iterator> members() const;
+
+			// Tape index of the next sibling
+			uint32_t next() const;
+
+		private:
+			const document* m_doc = nullptr;
+			uint32_t m_idx = 0;
+		};
+
+		class document {
+		public:
+			using tape_word = uint64_t;
+
+			constexpr const static std::size_t linear_lookup_limit = 16;
+
+			document() = default;
+			document(const char* data, std::size_t len, std::size_t max_depth = parser::default_max_depth) {
+				load(data, len, max_depth);
+			}
+			template <typename Buffer, typename = parser::detail::buffer_t<Buffer>>
+			explicit document(Buffer&& buf, std::size_t max_depth = parser::default_max_depth) {
+				load(buf.data(), buf.size(), max_depth);
+			}
+
+			document(document&&) = default;
+			document& operator=(document&&) = default;
+			document(const document&) = delete;
+			document& operator=(const document&) = delete;
+
+			// Parse into this document, reusing the buffers of the previous load when large enough
+			void load(const char* data, std::size_t len, std::size_t max_depth = parser::default_max_depth);
+
+			element root() const {
+				if (m_tape_size == 0)
+					throw std::runtime_error("Empty document.");
+				return element(this, 1);
+			}
+
+			std::size_t tape_size() const noexcept {
+				return m_tape_size;
+			}
+			std::size_t arena_size() const noexcept {
+				return m_arena_size;
+			}
+
+		private:
+			friend class element;
+
+			static tape_word word(char type, uint64_t payload) {
+				return (static_cast<uint64_t>(static_cast<unsigned char>(type)) << 56) | payload;
+			}
+			static char type_of(tape_word w) {
+				return static_cast<char>(w >> 56);
+			}
+			static uint64_t payload_of(tape_word w) {
+				return w & ((uint64_t(1) << 56) - 1);
+			}
+
+			std::string_view string_at(uint64_t offset) const {
+				uint32_t len;
+				std::memcpy(&len, m_arena.get() + offset, sizeof(len));
+				return std::string_view(m_arena.get() + offset + sizeof(len), len);
+			}
+
+			// Appends into the arena, no bounds checks: capacity covers the worst case up front
+			struct arena_writer {
+				char* p;
+				void append(const char* s, std::size_t n) {
+					std::memcpy(p, s, n);
+					p += n;
+				}
+				void push_back(char c) {
+					*p++ = c;
+				}
+			};
+
+			void build(const char* buf, std::size_t len, std::size_t max_depth);
+			element find_hashed(uint32_t obj, std::string_view key) const;
+
+			static uint64_t hash(std::string_view s) {
+				// FNV-1a
+				uint64_t h = 0xcbf29ce484222325;
+				for (unsigned char c : s)
+					h = (h ^ c) * 0x100000001b3;
+				return h;
+			}
+
+			std::vector<uint32_t> m_structural;
+			std::unique_ptr<tape_word[]> m_tape;
+			std::size_t m_tape_capacity = 0, m_tape_size = 0;
+			std::unique_ptr<char[]> m_arena;
+			std::size_t m_arena_capacity = 0, m_arena_size = 0;
+			// Open-addressed key tables of large objects, built on first lookup (not thread-safe)
+			mutable std::unordered_map<uint32_t, std::vector<uint32_t>> m_key_index;
+		};
+
+		inline void document::load(const char* data, std::size_t len, std::size_t max_depth) {
+			m_tape_size = m_arena_size = 0;
+			m_key_index.clear();
+			parser::index(data, len, m_structural);
+			const std::size_t n = m_structural.size();
+			// every structural byte becomes at most 2 words, plus the root pair
+			if (m_tape_capacity < 2 * n + 2) {
+				m_tape_capacity = 2 * n + 2;
+				m_tape.reset(new tape_word[m_tape_capacity]);
+			}
+			// unescaped strings never grow, each one adds a length and a terminator
+			const std::size_t arena_needed = len + 5 * n;
+			if (m_arena_capacity < arena_needed) {
+				m_arena_capacity = arena_needed;
+				m_arena.reset(new char[m_arena_capacity]);
+			}
+			build(data, len, max_depth);
+		}
+
+		inline void document::build(const char* buf, std::size_t len, std::size_t max_depth) {
+			using parser::parse_error;
+			const char* const end = buf + len;
+			const uint32_t* const idx = m_structural.data();
+			const std::size_t n = m_structural.size();
+			tape_word* const tape = m_tape.get();
+			std::size_t pos = 0, t = 1;
+			arena_writer arena{m_arena.get()};
+
+			struct frame {
+				uint32_t open;
+				uint32_t count;
+			};
+			std::vector<frame> stack;
+
+			auto next = [&]() -> std::size_t {
+				if (pos == n)
+					throw parse_error("Unexpected end of input.", len);
+				return idx[pos++];
+			};
+			auto peek = [&]() -> char {
+				return pos == n ? '\0' : buf[idx[pos]];
+			};
+			auto string = [&](std::size_t at) {
+				char* const start = arena.p;
+				arena.p += sizeof(uint32_t);
+				if (!parser::detail::parse_string(buf + at + 1, end, arena))
+					throw parse_error("Invalid string.", at);
+				const uint32_t slen = static_cast<uint32_t>(arena.p - start - sizeof(uint32_t));
+				std::memcpy(start, &slen, sizeof(slen));
+				*arena.p++ = '\0';
+				tape[t++] = word('"', static_cast<uint64_t>(start - m_arena.get()));
+			};
+			auto literal = [&](std::size_t at, const char* w, std::size_t wlen) {
+				if (len - at < wlen || std::memcmp(buf + at, w, wlen) != 0 || !parser::detail::is_scalar_end(buf + at + wlen, end))
+					throw parse_error("Invalid literal.", at);
+				tape[t++] = word(w[0], 0);
+			};
+			auto open = [&](char c, std::size_t at) {
+				if (stack.size() >= max_depth)
+					throw parse_error("Exceeded maximum nesting depth.", at);
+				stack.push_back(frame{static_cast<uint32_t>(t), 0});
+				tape[t++] = word(c, 0);
+			};
+			auto close = [&](char c) {
+				const frame f = stack.back();
+				stack.pop_back();
+				tape[t] = word(c, f.open);
+				++t;
+				const uint64_t count = std::min<uint64_t>(f.count, 0xFFFFFF);
+				tape[f.open] = word(type_of(tape[f.open]), (count << 32) | t);
+			};
+
+			if (n == 0)
+				throw parse_error("Empty document.", 0);
+
+			enum class state_t { value, key, after_value };
+			state_t state = state_t::value;
+			for (;;) {
+				if (state == state_t::value) {
+					const std::size_t at = next();
+					switch (buf[at]) {
+					case '{':
+						open('{', at);
+						if (peek() == '}') {
+							++pos;
+							close('}');
+							state = state_t::after_value;
+						}
+						else {
+							state = state_t::key;
+						}
+						continue;
+					case '[':
+						open('[', at);
+						if (peek() == ']') {
+							++pos;
+							close(']');
+							state = state_t::after_value;
+						}
+						continue;
+					case '"':
+						string(at);
+						break;
+					case 't':
+						literal(at, "true", 4);
+						break;
+					case 'f':
+						literal(at, "false", 5);
+						break;
+					case 'n':
+						literal(at, "null", 4);
+						break;
+					default: {
+						number::value v;
+						const char* p = number::parse(buf + at, end, v);
+						if (!p || !parser::detail::is_scalar_end(p, end))
+							throw parse_error("Invalid number.", at);
+						static const char tags[] = {'l', 'u', 'd'};
+						tape[t] = word(tags[static_cast<int>(v.kind)], 0);
+						std::memcpy(&tape[t + 1], &v.u, sizeof(uint64_t));
+						t += 2;
+						break;
+					}
+					}
+					state = state_t::after_value;
+				}
+				else if (state == state_t::key) {
+					const std::size_t at = next();
+					if (buf[at] != '"')
+						throw parse_error("Expected a string key.", at);
+					string(at);
+					const std::size_t colon = next();
+					if (buf[colon] != ':')
+						throw parse_error("Expected ':'.", colon);
+					state = state_t::value;
+				}
+				else {
+					if (stack.empty())
+						break;
+					++stack.back().count;
+					const std::size_t sep = next();
+					const bool in_object = type_of(tape[stack.back().open]) == '{';
+					if (buf[sep] == ',')
+						state = in_object ? state_t::key : state_t::value;
+					else if (buf[sep] == (in_object ? '}' : ']'))
+						close(in_object ? '}' : ']');
+					else
+						throw parse_error(in_object ? "Expected ',' or '}'." : "Expected ',' or ']'.", sep);
+				}
+			}
+			if (pos != n)
+				throw parse_error("Unexpected content after the document.", idx[pos]);
+			tape[0] = word('r', t);
+			m_tape_size = t;
+			m_arena_size = static_cast<std::size_t>(arena.p - m_arena.get());
+		}
+
+		inline type_t element::type() const {
+			return static_cast<type_t>(document::type_of(m_doc->m_tape[m_idx]));
+		}
+
+		inline uint32_t element::next() const {
+			const document::tape_word w = m_doc->m_tape[m_idx];
+			switch (document::type_of(w)) {
+			case '{':
+			case '[':
+				return static_cast<uint32_t>(w);
+			case 'l':
+			case 'u':
+			case 'd':
+				return m_idx + 2;
+			default:
+				return m_idx + 1;
+			}
+		}
+
+		inline std::string_view element::get_string() const {
+			if (!is_string())
+				throw std::runtime_error("Cannot use get_string with non-string json type.");
+			return m_doc->string_at(document::payload_of(m_doc->m_tape[m_idx]));
+		}
+		inline int64_t element::get_int64() const {
+			const type_t t = type();
+			const uint64_t raw = m_doc->m_tape[m_idx + 1];
+			if (t == type_t::integer || (t == type_t::unsigned_integer && raw <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())))
+				return static_cast<int64_t>(raw);
+			throw std::runtime_error("Cannot use get_int64 with non-int64 json type.");
+		}
+		inline uint64_t element::get_uint64() const {
+			const type_t t = type();
+			const uint64_t raw = m_doc->m_tape[m_idx + 1];
+			if (t == type_t::unsigned_integer || (t == type_t::integer && static_cast<int64_t>(raw) >= 0))
+				return raw;
+			throw std::runtime_error("Cannot use get_uint64 with non-uint64 json type.");
+		}
+		inline double element::get_double() const {
+			const uint64_t raw = m_doc->m_tape[m_idx + 1];
+			switch (type()) {
+			case type_t::integer:
+				return static_cast<double>(static_cast<int64_t>(raw));
+			case type_t::unsigned_integer:
+				return static_cast<double>(raw);
+			case type_t::floating: {
+				double d;
+				std::memcpy(&d, &raw, sizeof(d));
+				return d;
+			}
+			default:
+				throw std::runtime_error("Cannot use get_double with non-number json type.");
+			}
+		}
+		inline bool element::get_bool() const {
+			const type_t t = type();
+			if (t != type_t::true_value && t != type_t::false_value)
+				throw std::runtime_error("Cannot use get_bool with non-boolean json type.");
+			return t == type_t::true_value;
+		}
+
+		inline std::size_t element::size() const {
+			if (!is_object() && !is_array())
+				throw std::runtime_error("Cannot use size with non-structured json type.");
+			const std::size_t count = static_cast<std::size_t>(document::payload_of(m_doc->m_tape[m_idx]) >> 32);
+			if (count < 0xFFFFFF)
+				return count;
+			// saturated, count by walking
+			std::size_t ret = 0;
+			for (uint32_t i = m_idx + 1, last = next() - 1; i < last; i = element(m_doc, i).next())
+				ret += 1;
+			return is_object() ? ret / 2 : ret;
+		}
+
+		inline element element::find(std::string_view key) const {
+			if (!is_object())
+				throw std::runtime_error("Cannot use find(key) with non-object json type.");
+			if (size() > document::linear_lookup_limit)
+				return m_doc->find_hashed(m_idx, key);
+			const uint32_t last = next() - 1;
+			for (uint32_t i = m_idx + 1; i < last; ) {
+				const uint32_t v = i + 1;
+				if (m_doc->string_at(document::payload_of(m_doc->m_tape[i])) == key)
+					return element(m_doc, v);
+				i = element(m_doc, v).next();
+			}
+			return element();
+		}
+
+		inline element document::find_hashed(uint32_t obj, std::string_view key) const {
+			auto it = m_key_index.find(obj);
+			if (it == m_key_index.end()) {
+				const element o(this, obj);
+				std::size_t cap = 1;
+				while (cap < 2 * o.size())
+					cap <<= 1;
+				std::vector<uint32_t> table(cap, 0);
+				const uint32_t last = o.next() - 1;
+				for (uint32_t i = obj + 1; i < last; i = element(this, i + 1).next()) {
+					const std::string_view k = string_at(payload_of(m_tape[i]));
+					for (std::size_t s = hash(k) & (cap - 1); ; s = (s + 1) & (cap - 1)) {
+						if (table[s] == 0) {
+							table[s] = i;
+							break;
+						}
+						if (string_at(payload_of(m_tape[table[s]])) == k)
+							break;
+					}
+				}
+				it = m_key_index.emplace(obj, std::move(table)).first;
+			}
+			const std::vector<uint32_t>& table = it->second;
+			const std::size_t mask = table.size() - 1;
+			for (std::size_t s = hash(key) & mask; table[s] != 0; s = (s + 1) & mask) {
+				if (string_at(payload_of(m_tape[table[s]])) == key)
+					return element(this, table[s] + 1);
+			}
+			return element();
+		}
+
+		class element::iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = element;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const element*;
+			using reference = element;
+
+			iterator(const document* doc, uint32_t idx) : m_doc(doc), m_idx(idx) {}
+			element operator*() const {
+				return element(m_doc, m_idx);
+			}
+			iterator& operator++() {
+				m_idx = element(m_doc, m_idx).next();
+				return *this;
+			}
+			iterator operator++(int) {
+				iterator ret = *this;
+				++*this;
+				return ret;
+			}
+			bool operator==(const iterator& rhs) const {
+				return m_idx == rhs.m_idx;
+			}
+			bool operator!=(const iterator& rhs) const {
+				return m_idx != rhs.m_idx;
+			}
+		private:
+			const document* m_doc;
+			uint32_t m_idx;
+		};
+
+		class element::member_iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<std::string_view, element>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const value_type*;
+			using reference = value_type;
+
+			member_iterator(const document* doc, uint32_t idx) : m_doc(doc), m_idx(idx) {}
+			value_type operator*() const {
+				return value_type(element(m_doc, m_idx).get_string(), element(m_doc, m_idx + 1));
+			}
+			member_iterator& operator++() {
+				m_idx = element(m_doc, m_idx + 1).next();
+				return *this;
+			}
+			member_iterator operator++(int) {
+				member_iterator ret = *this;
+				++*this;
+				return ret;
+			}
+			bool operator==(const member_iterator& rhs) const {
+				return m_idx == rhs.m_idx;
+			}
+			bool operator!=(const member_iterator& rhs) const {
+				return m_idx != rhs.m_idx;
+			}
+		private:
+			const document* m_doc;
+			uint32_t m_idx;
+		};
+
+		inline element::range<element::iterator> element::elements() const {
+			if (!is_array())
+				throw std::runtime_error("Cannot use elements with non-array json type.");
+			return range<iterator>{iterator(m_doc, m_idx + 1), iterator(m_doc, next() - 1)};
+		}
+		inline element::range<element::member_iterator> element::members() const {
+			if (!is_object())
+				throw std::runtime_error("Cannot use members with non-object json type.");
+			return range<member_iterator>{member_iterator(m_doc, m_idx + 1), member_iterator(m_doc, next() - 1)};
+		}
+
+		inline element element::at(std::size_t i) const {
+			for (const element e : elements()) {
+				if (i-- == 0)
+					return e;
+			}
+			throw std::runtime_error("Out of range.");
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,403 @@
+#ifndef SN_JSON_WRITER_H
+#define SN_JSON_WRITER_H
+
+#include "../sn_CommonHeader.h"
+#include <cstring>
+#include <string_view>
+#include <charconv>
+#include "structural.hpp"
+#include "tape.hpp"
+
+namespace sn_JSON {
+	// Streaming writer: SAX-style begin_object / key / value calls go through a fixed
+	// 4KiB buffer straight into a sink, no DOM and no allocation of its own.
+	// A sink is anything with write(const char*, std::size_t).
+	namespace writer {
+
+		class string_sink {
+		public:
+			explicit string_sink(std::string& out) : m_out(out) {}
+			void write(const char* p, std::size_t n) {
+				m_out.append(p, n);
+			}
+		private:
+			std::string& m_out;
+		};
+
+		// Caller-owned fixed buffer, throws once it is full
+		class buffer_sink {
+		public:
+			buffer_sink(char* data, std::size_t capacity) : m_data(data), m_capacity(capacity) {}
+			void write(const char* p, std::size_t n) {
+				if (n > m_capacity - m_size)
+					throw std::runtime_error("Buffer too small.");
+				std::memcpy(m_data + m_size, p, n);
+				m_size += n;
+			}
+			std::size_t size() const noexcept {
+				return m_size;
+			}
+		private:
+			char* m_data;
+			std::size_t m_capacity;
+			std::size_t m_size = 0;
+		};
+
+		// sn_Stream::stream::IStream, MemoryStream or anything with force_write_bytes(uint8_t*, len)
+		template <typename Stream>
+		class stream_sink {
+		public:
+			explicit stream_sink(Stream& stream) : m_stream(stream) {}
+			void write(const char* p, std::size_t n) {
+				m_stream.force_write_bytes(reinterpret_cast<uint8_t*>(const_cast<char*>(p)), n);
+			}
+		private:
+			Stream& m_stream;
+		};
+
+		namespace detail {
+			constexpr const static char digit_pairs[] =
+				"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+				"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+				"8081828384858687888990919293949596979899";
+
+			// digits of u ending at end, returns the first one
+			inline char* write_unsigned(char* end, uint64_t u) {
+				while (u >= 100) {
+					end -= 2;
+					std::memcpy(end, digit_pairs + (u % 100) * 2, 2);
+					u /= 100;
+				}
+				if (u >= 10) {
+					end -= 2;
+					std::memcpy(end, digit_pairs + u * 2, 2);
+				}
+				else {
+					*--end = static_cast<char>('0' + u);
+				}
+				return end;
+			}
+		}
+
+		template <typename Sink>
+		class basic_writer {
+		public:
+			constexpr const static std::size_t buffer_size = 4096;
+			constexpr const static std::size_t max_depth = 1024;
+
+			// indent == 0 writes compact JSON, otherwise one member per line indented by that many spaces
+			explicit basic_writer(Sink& sink, unsigned indent = 0) : m_sink(sink), m_indent(indent) {}
+			~basic_writer() {
+				try {
+					flush();
+				}
+				catch (...) {}
+			}
+			basic_writer(const basic_writer&) = delete;
+			basic_writer& operator=(const basic_writer&) = delete;
+
+			basic_writer& begin_object() {
+				return open('{');
+			}
+			basic_writer& end_object() {
+				return close('}');
+			}
+			basic_writer& begin_array() {
+				return open('[');
+			}
+			basic_writer& end_array() {
+				return close(']');
+			}
+
+			basic_writer& key(std::string_view k) {
+				assert(m_depth > 0 && !m_after_key && "key() outside of an object.");
+				separate();
+				string(k);
+				put(':');
+				if (m_indent)
+					put(' ');
+				m_after_key = true;
+				return *this;
+			}
+			// Key known to need no escaping (e.g. field names fixed at compile time), copied as is
+			basic_writer& plain_key(std::string_view k) {
+				assert(m_depth > 0 && !m_after_key && "key() outside of an object.");
+				separate();
+				put('"');
+				write_raw(k.data(), k.size());
+				put('"');
+				put(':');
+				if (m_indent)
+					put(' ');
+				m_after_key = true;
+				return *this;
+			}
+
+			basic_writer& value(std::nullptr_t) {
+				separate();
+				write_raw("null", 4);
+				return *this;
+			}
+			basic_writer& value(bool b) {
+				separate();
+				if (b)
+					write_raw("true", 4);
+				else
+					write_raw("false", 5);
+				return *this;
+			}
+			template <typename T, typename = std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>>
+			basic_writer& value(T v) {
+				separate();
+				char tmp[24];
+				char* const end = tmp + sizeof(tmp);
+				char* p;
+				if constexpr (std::is_signed<T>::value) {
+					if (v < 0) {
+						p = detail::write_unsigned(end, ~static_cast<uint64_t>(static_cast<int64_t>(v)) + 1);
+						*--p = '-';
+					}
+					else {
+						p = detail::write_unsigned(end, static_cast<uint64_t>(v));
+					}
+				}
+				else {
+					p = detail::write_unsigned(end, static_cast<uint64_t>(v));
+				}
+				write_raw(p, static_cast<std::size_t>(end - p));
+				return *this;
+			}
+			// Shortest representation that round-trips, NaN / infinity become null
+			basic_writer& value(double d) {
+				separate();
+				if (!std::isfinite(d)) {
+					write_raw("null", 4);
+					return *this;
+				}
+				char tmp[32];
+#if defined(__cpp_lib_to_chars)
+				std::size_t n = static_cast<std::size_t>(std::to_chars(tmp, tmp + sizeof(tmp), d).ptr - tmp);
+#else
+				std::size_t n = static_cast<std::size_t>(std::snprintf(tmp, sizeof(tmp), "%.17g", d));
+#endif
+				// keep it a double when read back
+				if (!std::memchr(tmp, '.', n) && !std::memchr(tmp, 'e', n)) {
+					tmp[n++] = '.';
+					tmp[n++] = '0';
+				}
+				write_raw(tmp, n);
+				return *this;
+			}
+			basic_writer& value(float f) {
+				return value(static_cast<double>(f));
+			}
+			basic_writer& value(std::string_view s) {
+				separate();
+				string(s);
+				return *this;
+			}
+			basic_writer& value(const char* s) {
+				return value(std::string_view(s));
+			}
+			basic_writer& value(const std::string& s) {
+				return value(std::string_view(s));
+			}
+
+			// Whole basic_json tree
+			template <typename Json, typename = decltype(std::declval<const Json&>().get_object())>
+			basic_writer& value(const Json& j) {
+				using value_t = typename Json::value_t;
+				switch (j.type()) {
+				case value_t::object:
+					begin_object();
+					for (const auto& kv : j.get_object()) {
+						key(std::string_view(kv.first.data(), kv.first.size()));
+						value(kv.second);
+					}
+					return end_object();
+				case value_t::array:
+					begin_array();
+					for (const auto& e : j.get_array())
+						value(e);
+					return end_array();
+				case value_t::string:
+					return value(std::string_view(j.get_string().data(), j.get_string().size()));
+				case value_t::boolean:
+					return value(static_cast<bool>(j.get_boolean()));
+				case value_t::number_integer:
+					return value(static_cast<int64_t>(j.get_integer()));
+				case value_t::number_double:
+					return value(static_cast<double>(j.get_double()));
+				default:
+					return value(nullptr);
+				}
+			}
+
+			// Tape element subtree
+			basic_writer& value(const tape::element& e) {
+				switch (e.type()) {
+				case tape::type_t::object:
+					begin_object();
+					for (const auto& kv : e.members()) {
+						key(kv.first);
+						value(kv.second);
+					}
+					return end_object();
+				case tape::type_t::array:
+					begin_array();
+					for (const auto& x : e.elements())
+						value(x);
+					return end_array();
+				case tape::type_t::string:
+					return value(e.get_string());
+				case tape::type_t::integer:
+					return value(e.get_int64());
+				case tape::type_t::unsigned_integer:
+					return value(e.get_uint64());
+				case tape::type_t::floating:
+					return value(e.get_double());
+				case tape::type_t::true_value:
+				case tape::type_t::false_value:
+					return value(e.get_bool());
+				default:
+					return value(nullptr);
+				}
+			}
+
+			// Pre-serialized JSON, written as is
+			basic_writer& raw(std::string_view json) {
+				separate();
+				write_raw(json.data(), json.size());
+				return *this;
+			}
+
+			void flush() {
+				if (m_pos) {
+					m_sink.write(m_buf, m_pos);
+					m_pos = 0;
+				}
+			}
+
+			std::size_t depth() const noexcept {
+				return m_depth;
+			}
+
+		private:
+			void put(char c) {
+				if (m_pos == buffer_size)
+					flush();
+				m_buf[m_pos++] = c;
+			}
+			void write_raw(const char* p, std::size_t n) {
+				if (n > buffer_size - m_pos) {
+					flush();
+					if (n >= buffer_size) {
+						m_sink.write(p, n);
+						return;
+					}
+				}
+				std::memcpy(m_buf + m_pos, p, n);
+				m_pos += n;
+			}
+
+			void newline() {
+				put('\n');
+				for (std::size_t n = m_indent * m_depth; n; ) {
+					if (m_pos == buffer_size)
+						flush();
+					const std::size_t k = std::min(n, buffer_size - m_pos);
+					std::memset(m_buf + m_pos, ' ', k);
+					m_pos += k;
+					n -= k;
+				}
+			}
+
+			// comma / newline before a value or key
+			void separate() {
+				if (m_after_key) {
+					m_after_key = false;
+					return;
+				}
+				if (m_depth == 0)
+					return;
+				if (!m_first[m_depth])
+					put(',');
+				m_first[m_depth] = false;
+				if (m_indent)
+					newline();
+			}
+
+			basic_writer& open(char c) {
+				separate();
+				if (m_depth == max_depth)
+					throw std::runtime_error("Exceeded maximum nesting depth.");
+				put(c);
+				m_first[++m_depth] = true;
+				return *this;
+			}
+			basic_writer& close(char c) {
+				assert(m_depth > 0 && !m_after_key && "Unbalanced end_object() / end_array().");
+				const bool empty = m_first[m_depth];
+				--m_depth;
+				if (m_indent && !empty)
+					newline();
+				put(c);
+				return *this;
+			}
+
+			// Runs without '"', '\\' or control characters are found with SIMD and copied in bulk
+			void string(std::string_view s) {
+				put('"');
+				const char* p = s.data();
+				const char* const end = p + s.size();
+				for (;;) {
+					const char* q = structural::find_string_special(p, end);
+					write_raw(p, static_cast<std::size_t>(q - p));
+					if (q == end)
+						break;
+					escape(static_cast<unsigned char>(*q));
+					p = q + 1;
+				}
+				put('"');
+			}
+			void escape(unsigned char c) {
+				char tmp[6] = {'\\', 'u', '0', '0', 0, 0};
+				switch (c) {
+				case '"': tmp[1] = '"'; break;
+				case '\\': tmp[1] = '\\'; break;
+				case '\b': tmp[1] = 'b'; break;
+				case '\f': tmp[1] = 'f'; break;
+				case '\n': tmp[1] = 'n'; break;
+				case '\r': tmp[1] = 'r'; break;
+				case '\t': tmp[1] = 't'; break;
+				default:
+					tmp[4] = "0123456789abcdef"[c >> 4];
+					tmp[5] = "0123456789abcdef"[c & 0xF];
+					write_raw(tmp, 6);
+					return;
+				}
+				write_raw(tmp, 2);
+			}
+
+			Sink& m_sink;
+			unsigned m_indent;
+			std::size_t m_depth = 0;
+			bool m_after_key = false;
+			std::size_t m_pos = 0;
+			bool m_first[max_depth + 1];
+			char m_buf[buffer_size];
+		};
+
+		template <typename Json>
+		std::string dump(const Json& j, unsigned indent = 0) {
+			std::string ret;
+			string_sink sink(ret);
+			basic_writer<string_sink> w(sink, indent);
+			w.value(j);
+			w.flush();
+			return ret;
+		}
+	}
+}
+
+#endif
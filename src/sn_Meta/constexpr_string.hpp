@@ -2,6 +2,7 @@
 #define SN_META_CONSTEXPR_STRING_H
 
 #include "../sn_CommonHeader.h"
+#include <string_view>
 
 namespace sn_Meta {
 
@@ -81,38 +82,42 @@ namespace sn_Meta {
 
 		};
 
-		// TODO: write a formatter
-		template<std::size_t ...str>
+		// The characters live in the type, so they can drive code generation (see sn_String/format.hpp)
+		template <char ...str>
 		struct string {
 			static constexpr const char chars[sizeof...(str)+1] = { str..., '\0' };
+			static constexpr const std::size_t size = sizeof...(str);
+			static constexpr std::string_view view() {
+				return std::string_view(chars, sizeof...(str));
+			}
 		};
 
-		template <std::size_t ...I1, std::size_t ...I2>
-		string<I1..., I2...> operator+(string<I1...>, string<I2...>) {
+		template <char ...I1, char ...I2>
+		constexpr string<I1..., I2...> operator+(string<I1...>, string<I2...>) {
 			return {};
 		}
 
-		template <std::size_t ...I>
-		constexpr string<I...> make_string_impl(const char* str, std::index_sequence<I...>) {
-			return string<str[I]...>{};
-		}
-
-		template <std::size_t N>
-		constexpr auto make_string(const char(&str)[N]) {
-			return make_string_impl(str, std::make_index_sequence<N - 1>{});
-		}
-
-		// wtf, this only works for number literals or GNUC (floating points)
-		/*
-			template <typename T, T ...str>
-			constexpr string<str...> operator "" _sn() {
-				return string<str...>{};
+		namespace detail {
+			template <typename Holder, std::size_t ...I>
+			constexpr string<Holder::value()[I]...> make_string_impl(std::index_sequence<I...>) {
+				return {};
 			}
-		*/
+		}
 
-		inline constexpr auto operator "" _sn(const char* str, std::size_t N) {
-			return make_string_impl(str, std::make_index_sequence<N - 1>{});
+		// A function parameter is never a constant expression, so the literal rides in a local class
+		// SN_CONSTEXPR_STRING("abc") -> string<'a', 'b', 'c'>{}
+#define SN_CONSTEXPR_STRING(str) ([] { \
+			struct holder { static constexpr std::string_view value() { return str; } }; \
+			return ::sn_Meta::constexpr_string::detail::make_string_impl<holder>(std::make_index_sequence<sizeof(str) - 1>{}); \
+		}())
+
+		// wtf, this only works for number literals or GNUC (string literal operator template)
+#if defined(__GNUC__)
+		template <typename T, T ...str>
+		constexpr string<str...> operator "" _sn() {
+			return {};
 		}
+#endif
 
 		inline constexpr string_view operator "" _snsv(const char* str, std::size_t len) {
 			return string_view(str, len);
@@ -3,6 +3,8 @@
 
 #include "sn_CommonHeader.h"
 #include "sn_Assist.hpp"
+#include <cstring>
+#include <string_view>
 
 // ref: https://github.com/keean/Parser-Combinators
 // TODO: add examples and get hang of this techniques
@@ -24,9 +26,71 @@ namespace sn_PC {
 			stream_range(const char* name) : m_str(name), first(m_str.cbegin()), last(m_str.cend()) {}
 			stream_range(string name) : m_str(name), first(m_str.cbegin()), last(m_str.cend()) {}
 		};
+
+		// Borrows the input (a string_view, an mmap'd InputMemoryFile, ...) instead of copying it,
+		// the input has to outlive the parse
+		class view_range {
+		public:
+			using iterator = const char*;
+			const iterator first;
+			const iterator last;
+			view_range(std::string_view s) : first(s.data()), last(s.data() + s.size()) {}
+			view_range(const char* data, size_t size) : first(data), last(data + size) {}
+			template <typename File, typename = decltype(std::declval<const File&>().data() + std::declval<const File&>().size())>
+			view_range(const File& f) : first(f.data()), last(f.data() + f.size()) {}
+		};
 	}
 
 	using srange::stream_range;
+	using srange::view_range;
+
+	// Where a recogniser puts what it matched: a string gets a copy, a string_view grows to cover it
+	// (zero-copy, the input has to be contiguous; it spans from the first byte matched into it to the
+	// last, discarded input in between included), void drops it
+	namespace result_assist {
+		template <typename It>
+		void append(string* r, It first, It last) {
+			if (last - first == 1)
+				r->push_back(*first);
+			else
+				r->append(first, last);
+		}
+		template <typename It>
+		void append(std::string_view* r, It first, It last) {
+			if (first == last)
+				return;
+			const char* const b = std::addressof(*first);
+			const char* const e = b + (last - first);
+			*r = r->empty() ? std::string_view(b, static_cast<size_t>(e - b)) : std::string_view(r->data(), static_cast<size_t>(e - r->data()));
+		}
+		template <typename It>
+		void append(void*, It, It) {}
+
+		// Snapshot to undo what a failed parser left in a result
+		template <typename T>
+		struct mark {
+			T saved;
+			explicit mark(const T* r) : saved(r != nullptr ? *r : T()) {}
+			void restore(T* r) const {
+				if (r != nullptr)
+					*r = saved;
+			}
+		};
+		template <>
+		struct mark<string> {
+			size_t n;
+			explicit mark(const string* r) : n(r != nullptr ? r->size() : 0) {}
+			void restore(string* r) const {
+				if (r != nullptr)
+					r->resize(n);
+			}
+		};
+		template <>
+		struct mark<void> {
+			explicit mark(const void*) {}
+			void restore(void*) const {}
+		};
+	}
 
 	namespace is_assist {
 
@@ -266,6 +330,12 @@ namespace sn_PC {
 			static constexpr bool value = std::is_convertible<PA, PB>::value;
 		};
 
+		// Recognisers fill a string_view as well as a string, so a slice stands in for a copy
+		template <>
+		struct is_compat<std::string_view, string> {
+			static constexpr bool value = true;
+		};
+
 		template <typename A, typename B>
 		struct is_compatible {
 			static constexpr bool value = is_compat<A, B>::value || is_compat<B, A>::value;
@@ -299,6 +369,40 @@ namespace sn_PC {
 	constexpr is_assist::is_punct is_punct;
 	constexpr is_assist::is_space is_space;
 	constexpr is_assist::is_char is_eof(EOF);
+
+	// FIRST sets: the bytes a parser can start with (256 stands for the end of input) and whether it can
+	// match nothing. A parser without first() (handle, reference, fmap, ...) may start anywhere.
+	namespace first_assist {
+		struct first_set {
+			std::bitset<257> bytes;
+			bool nullable = false;
+
+			static first_set any() {
+				first_set f;
+				f.bytes.set();
+				f.nullable = true;
+				return f;
+			}
+		};
+
+		template <typename P, typename = void>
+		struct has_first : std::false_type {};
+		template <typename P>
+		struct has_first<P, std::void_t<decltype(std::declval<const P&>().first())>> : std::true_type {};
+
+		template <typename P>
+		first_set first_of(const P& p) {
+			if constexpr (has_first<P>::value)
+				return p.first();
+			else
+				return first_set::any();
+		}
+
+		template <typename It, typename R>
+		size_t index(const It& i, const R& r) {
+			return i == r.last ? 256 : static_cast<unsigned char>(*i);
+		}
+	}
 	
 	struct default_base {};
 
@@ -323,7 +427,7 @@ namespace sn_PC {
 
 			bool in = true;
 			for (It i(line_start); (i != r.last) && (in || *i != '\n'); ++i) {
-				if (i == 1) {
+				if (i == f) {
 					in = false;
 				}
 				is_assist::is_space s;
@@ -432,7 +536,7 @@ namespace sn_PC {
 	// stream advance if matched and result += symbol
 	template <typename P>
 	class recogniser_accept {
-		const P& m_p;
+		const P m_p;
 	public:
         using is_parser_type = std::true_type;
         using is_handle_type = std::false_type;
@@ -442,8 +546,8 @@ namespace sn_PC {
 
         constexpr explicit recogniser_accept(const P& p)
             : m_p(p), rank(p.rank) {}
-        template <typename It, typename R, typename Base = default_base>
-        bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+        template <typename It, typename R, typename Result = string, typename Base = default_base>
+        bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
             int sym;
             if (i == r.last)
                 sym = EOF;
@@ -451,12 +555,20 @@ namespace sn_PC {
                 sym = *i;
             if (!m_p(sym))
                 return false;
+            const It first = i;
             ++i;
             if (result != nullptr)
-                result->push_back(sym);
+                result_assist::append(result, first, i);
             return true;
         }
-        string enbf(unique_defs& defs = nullptr) const {
+        first_assist::first_set first() const {
+            first_assist::first_set f;
+            for (int b = 0; b < 256; ++b)
+                f.bytes[b] = m_p(static_cast<char>(b));
+            f.bytes[256] = m_p(EOF);
+            return f;
+        }
+        string ebnf(unique_defs* defs = nullptr) const {
             return m_p.name();
         }
 	};
@@ -478,17 +590,26 @@ namespace sn_PC {
 
 		constexpr explicit accept_str(const char* s)
 			: m_s(s) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
+			const It first = i;
 			for (auto j = m_s; *j != '\0'; ++j) {
 				if (i == r.last || *i != *j)
 					return false;
 				++i;
 			}
 			if (result != nullptr)
-				result->append(m_s);
+				result_assist::append(result, first, i);
 			return true;
 		}
+		first_assist::first_set first() const {
+			first_assist::first_set f;
+			if (*m_s == '\0')
+				f.nullable = true;
+			else
+				f.bytes[static_cast<unsigned char>(*m_s)] = true;
+			return f;
+		}
 		string ebnf(unique_defs* defs = nullptr) const {
 			return "\"" + string(m_s) + "\"";
 		}
@@ -503,10 +624,15 @@ namespace sn_PC {
 		const std::size_t rank = 0;
 
 		constexpr explicit parser_succ() {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			return true;
 		}
+		first_assist::first_set first() const {
+			first_assist::first_set f;
+			f.nullable = true;
+			return f;
+		}
 		string ebnf(unique_defs* defs = nullptr) const {
 			return "succ";
 		}
@@ -521,10 +647,13 @@ namespace sn_PC {
 		const std::size_t rank = 0;
 
 		constexpr explicit parser_fail() {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			return false;
 		}
+		first_assist::first_set first() const {
+			return first_assist::first_set();
+		}
 		string ebnf(unique_defs* defs = nullptr) const {
 			return "fail";
 		}
@@ -740,10 +869,14 @@ namespace sn_PC {
 		return fmap_sequence<F, Ps...>(f, ps...);
 	}
 
+	// The next byte picks the alternatives worth trying from a table built out of their FIRST sets,
+	// one that cannot start with it is skipped without being called
 	template <typename P1, typename P2>
 	class combinator_choice {
 		const P1 p1;
 		const P2 p2;
+		first_assist::first_set m_first;
+		uint8_t m_dispatch[257];  // bit 0: try p1, bit 1: try p2
 	public:
 		using is_parser_type = std::true_type;
 		using is_handle_type = std::false_type;
@@ -751,23 +884,37 @@ namespace sn_PC {
 		using result_type = typename least_general<P1, P2>::result_type;
 		const size_t rank = 1;
 		
-		constexpr combinator_choice(const P1& p1, const P2& p2)
-			: p1(p1), p2(p2) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
-			const It first = i;
-			if (p1(i, r, result, st)) {
-				return true;
-			}
-			if (first != i) {
-				throw parse_error("Failed parser consumed input", p1, first, i, r);
+		combinator_choice(const P1& p1, const P2& p2)
+			: p1(p1), p2(p2) {
+			const first_assist::first_set f1 = first_assist::first_of(p1);
+			const first_assist::first_set f2 = first_assist::first_of(p2);
+			for (size_t k = 0; k < 257; ++k)
+				m_dispatch[k] = static_cast<uint8_t>((f1.nullable || f1.bytes[k] ? 1 : 0) | (f2.nullable || f2.bytes[k] ? 2 : 0));
+			m_first.bytes = f1.bytes | f2.bytes;
+			m_first.nullable = f1.nullable || f2.nullable;
+		}
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
+			const uint8_t d = m_dispatch[first_assist::index(i, r)];
+			if (d & 1) {
+				const It first = i;
+				if (p1(i, r, result, st)) {
+					return true;
+				}
+				if (first != i) {
+					throw parse_error("Failed parser consumed input", p1, first, i, r);
+				}
 			}
-			if (p2(i, r, result, st)) {
+			if ((d & 2) && p2(i, r, result, st)) {
 				return true;
 			}
 			return false;
 		}
 
+		first_assist::first_set first() const {
+			return m_first;
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return format_name(p1, rank, defs) + " | " + format_name(p2, rank, defs);
 		}
@@ -780,7 +927,7 @@ namespace sn_PC {
 			|| std::is_same<typename P2::is_handle_type, std::true_type>::value>,
 		typename = std::enable_if_t<is_assist::is_compatible<typename P1::result_type, typename P2::result_type>::value,
 			std::pair<typename P1::result_type, typename P2::result_type>>>
-	constexpr const combinator_choice<P1, P2> operator||(const P1& p1, const P2& p2) {
+	const combinator_choice<P1, P2> operator||(const P1& p1, const P2& p2) {
 		return combinator_choice<P1, P2>(p1, p2);
 	}
 
@@ -797,11 +944,21 @@ namespace sn_PC {
 
 		constexpr combinator_sequence(const P1& p1, const P2& p2)
 			: p1(p1), p2(p2) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			return (p1(i, r, result, st)) && (p2(i, r, result, st));
 		}
 
+		first_assist::first_set first() const {
+			first_assist::first_set f = first_assist::first_of(p1);
+			if (f.nullable) {
+				const first_assist::first_set f2 = first_assist::first_of(p2);
+				f.bytes |= f2.bytes;
+				f.nullable = f2.nullable;
+			}
+			return f;
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return format_name(p1, rank, defs) + " , " + format_name(p2, rank, defs);
 		}
@@ -830,8 +987,8 @@ namespace sn_PC {
 
 		constexpr combinator_many(const P& p)
 			: p(p) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			It first = i;
 			while (p(i, r, result, st))
 				first = i;
@@ -841,6 +998,12 @@ namespace sn_PC {
 			return true;
 		}
 
+		first_assist::first_set first() const {
+			first_assist::first_set f = first_assist::first_of(p);
+			f.nullable = true;
+			return f;
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return "{" + p.ebnf(defs) + "}";
 		}
@@ -878,6 +1041,10 @@ namespace sn_PC {
 			return false;
 		}
 
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return p.ebnf(defs) + " - \"" + x + "\"";
 		}
@@ -900,12 +1067,16 @@ namespace sn_PC {
 
 		constexpr combinator_discard(const P& p_)
 			: p(p_), rank(p_.rank) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			typename P::result_type* const discard_result = nullptr;
 			return p(i, r, discard_result, st);
 		}
 
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return p.ebnf(defs);
 		}
@@ -916,6 +1087,45 @@ namespace sn_PC {
 		return combinator_discard<P>(p);
 	}
 
+	// Result is the slice of input p matched, a string_view into a contiguous range (view_range)
+	// instead of a string assembled character by character
+	template <typename P>
+	class parser_span {
+		const P p;
+	public:
+		using is_parser_type = std::true_type;
+		using is_handle_type = std::false_type;
+		using has_side_effects = typename P::has_side_effects;
+		using result_type = std::string_view;
+		const size_t rank;
+
+		constexpr parser_span(const P& p_)
+			: p(p_), rank(p_.rank) {}
+		template <typename It, typename R, typename Result = result_type, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
+			const It first = i;
+			typename P::result_type* const inner = nullptr;
+			if (!p(i, r, inner, st))
+				return false;
+			if (result != nullptr)
+				result_assist::append(result, first, i);
+			return true;
+		}
+
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
+		string ebnf(unique_defs* defs = nullptr) const {
+			return p.ebnf(defs);
+		}
+	};
+
+	template <typename P, typename = std::enable_if_t<std::is_same<typename P::is_parser_type, std::true_type>::value || std::is_same<typename P::is_handle_type, std::true_type>::value>>
+	constexpr const parser_span<P> span(const P& p) {
+		return parser_span<P>(p);
+	}
+
 	template <typename It, typename R, typename Syn = void, typename Base = default_base>
 	class parser_handle {
 		struct holder_base {
@@ -970,7 +1180,7 @@ namespace sn_PC {
 			return *this;
 		}
 		
-		bool operator()(It& i, const R& r, Syn* result = nullptr, Base* st = nullptr) const override {
+		bool operator()(It& i, const R& r, Syn* result = nullptr, Base* st = nullptr) const {
 			assert(p != nullptr);
 			return p->parse(i, r, result, st);
 		}
@@ -991,8 +1201,8 @@ namespace sn_PC {
 		const char* name;
 		constexpr parser_ref(const char* name_, const P* q)
 			: p(q), name(name_) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			return (*p)(i, r, result, st);
 		}
 		string ebnf(unique_defs* defs = nullptr) const {
@@ -1027,8 +1237,8 @@ namespace sn_PC {
 
 		constexpr explicit parser_fix(const char* n, F f)
 			: p(f(reference(n, &p))), name(n) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			return p(i, r, result, st);
 		}
 		string ebnf(unique_defs* defs = nullptr) const {
@@ -1060,8 +1270,8 @@ namespace sn_PC {
 		constexpr explicit parser_log(const string& s, const P& p_)
 			: p(p_), msg(s), rank(p_.rank) {}
 
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			const It x = i;
 			bool const b = p(i, r, result, st);
 #ifdef SN_PC_DEBUG
@@ -1076,6 +1286,10 @@ namespace sn_PC {
 			return b;
 		}
 
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return p.ebnf(defs);
 		}
@@ -1101,15 +1315,21 @@ namespace sn_PC {
 
 		constexpr parser_try(const P& p_)
 			: p(p_), rank(p_.rank) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			const It first = i;
+			const result_assist::mark<Result> mark(result);
 			if (p(i, r, result, st))
 				return true;
 			i = first;
+			mark.restore(result);
 			return false;
 		}
 
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return p.ebnf(defs);
 		}
@@ -1127,20 +1347,26 @@ namespace sn_PC {
 
 		constexpr parser_try_side(const P& p_)
 			: p(p_), rank(p_.rank) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			const It first = i;
+			const result_assist::mark<Result> mark(result);
 			Base inh;
 			if (st != nullptr)
 				inh = *st;
 			if (p(i, r, result, st))
 				return true;
 			i = first;
+			mark.restore(result);
 			if (st != nullptr)
 				*st = inh;
 			return false;
 		}
 
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return p.ebnf(defs);
 		}
@@ -1179,14 +1405,18 @@ namespace sn_PC {
 
 		constexpr parser_strict(const char* s, const P& p_)
 			: p(p_), rank(p_.rank), err(s) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			const It first = i;
 			if (!p(i, r, result, st))
 				throw parse_error(err, p, first, r);
 			return true;
 		}
 
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return p.ebnf(defs);
 		}
@@ -1211,11 +1441,15 @@ namespace sn_PC {
 
 		constexpr parser_name(Name&& m, size_t r, const P& p_)
 			: p(p_), rank(r), n(std::forward<Name>(m)) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			return p(i, r, result, st);
 		}
 
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			return n(defs);
 		}
@@ -1240,11 +1474,15 @@ namespace sn_PC {
 
 		constexpr parser_def(const char* n, const P& p_)
 			: p(p_), rank(p_.rank), name(n) {}
-		template <typename It, typename R, typename Base = default_base>
-		bool operator()(It& i, const R& r, string* result = nullptr, Base* st = nullptr) const {
+		template <typename It, typename R, typename Result = string, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
 			return p(i, r, result, st);
 		}
 
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
 		string ebnf(unique_defs* defs = nullptr) const {
 			const string n = p.ebnf(defs);
 			if (defs != nullptr)
@@ -1272,7 +1510,7 @@ namespace sn_PC {
 	constexpr parser_succ succ;
 	constexpr parser_fail fail;
 
-	template <typename P> constexpr auto option(P const& p)
+	template <typename P> auto option(P const& p)
 		-> decltype(rename(option_name<P>(p), 0, p || succ)) {
 		return rename(option_name<P>(p), 0, p || succ);
 	}
@@ -1325,6 +1563,283 @@ namespace sn_PC {
 		return rename(tok_name<R>(r), 0, r && first_token);
 	}
 
+	// Packrat mode: parse with a packrat_range instead of a stream_range and every memo() rule runs at
+	// most once per input position, the answer is replayed afterwards. With any other range memo() just
+	// forwards, so one grammar serves both modes.
+	// Left recursion (direct or through other rules) grows a seed until the match stops getting longer.
+	// ref: Warth, Douglass, Millstein, Packrat Parsers Can Support Left Recursion
+	namespace packrat {
+
+		inline std::size_t next_rule_id() {
+			static std::atomic<std::size_t> id{0};
+			return id++;
+		}
+
+		// Bump allocator the memo tables live in, released with the parse
+		class memo_arena {
+			std::vector<std::unique_ptr<char[]>> m_blocks;
+			std::size_t m_used = 0;
+			std::size_t m_size = 0;
+		public:
+			constexpr static const std::size_t block_size = 1 << 16;
+
+			void* allocate(std::size_t n, std::size_t align) {
+				std::size_t off = (m_used + align - 1) & ~(align - 1);
+				if (m_blocks.empty() || off + n > m_size) {
+					m_size = std::max(block_size, n);
+					m_blocks.emplace_back(new char[m_size]);
+					off = 0;
+				}
+				m_used = off + n;
+				return m_blocks.back().get() + off;
+			}
+		};
+
+		template <typename T>
+		struct memo_entry {
+			std::size_t pos = static_cast<std::size_t>(-1);
+			std::size_t end = 0;
+			bool ok = false;
+			T value{};
+		};
+
+		struct memo_table_base {
+			virtual ~memo_table_base() {}
+		};
+
+		// Direct-mapped on the input position: an entry is evicted by the one capacity positions
+		// further on, so memory stays bounded however long the input is
+		template <typename T>
+		class memo_table : public memo_table_base {
+			memo_entry<T>* m_entries;
+			std::size_t m_mask;
+		public:
+			memo_table(memo_arena& arena, std::size_t capacity) : m_mask(capacity - 1) {
+				m_entries = static_cast<memo_entry<T>*>(arena.allocate(sizeof(memo_entry<T>) * capacity, alignof(memo_entry<T>)));
+				for (std::size_t k = 0; k < capacity; ++k)
+					new (m_entries + k) memo_entry<T>();
+			}
+			~memo_table() {
+				for (std::size_t k = 0; k <= m_mask; ++k)
+					m_entries[k].~memo_entry<T>();
+			}
+			memo_entry<T>& slot(std::size_t pos) {
+				return m_entries[pos & m_mask];
+			}
+		};
+
+		// A memo rule being evaluated; seed is its current answer to left-recursive calls
+		struct frame {
+			std::size_t rule;
+			std::size_t pos;
+			bool left_recursive;  // called itself at pos
+			bool involved;        // on the path of a left-recursive call, its answer depends on a seed
+			bool ok;
+			std::size_t end;
+			void* seed;
+		};
+
+		class memo_context {
+			memo_arena m_arena;
+			std::vector<memo_table_base*> m_tables;
+			std::size_t m_capacity;
+		public:
+			std::vector<frame> m_stack;
+			std::size_t m_hits = 0;
+			std::size_t m_misses = 0;
+
+			explicit memo_context(std::size_t window) : m_capacity(1) {
+				while (m_capacity < window)
+					m_capacity <<= 1;
+			}
+			~memo_context() {
+				for (auto t : m_tables) {
+					if (t != nullptr)
+						t->~memo_table_base();
+				}
+			}
+			memo_context(const memo_context&) = delete;
+			memo_context& operator=(const memo_context&) = delete;
+
+			template <typename T>
+			memo_table<T>& table(std::size_t rule) {
+				if (rule >= m_tables.size())
+					m_tables.resize(rule + 1, nullptr);
+				if (m_tables[rule] == nullptr)
+					m_tables[rule] = new (m_arena.allocate(sizeof(memo_table<T>), alignof(memo_table<T>))) memo_table<T>(m_arena, m_capacity);
+				return *static_cast<memo_table<T>*>(m_tables[rule]);
+			}
+		};
+
+		template <typename R, typename = void>
+		struct has_memo : std::false_type {};
+		template <typename R>
+		struct has_memo<R, std::void_t<decltype(std::declval<const R&>().memo())>> : std::true_type {};
+
+		// Replayed answers append to string results like the recognisers do, other results are assigned
+		template <typename T, typename V>
+		void store(T& out, const V& v) {
+			out = v;
+		}
+		inline void store(string& out, const string& v) {
+			out.append(v);
+		}
+		// Views are slices of the same input, a replayed one extends the result
+		inline void store(std::string_view& out, const std::string_view& v) {
+			if (v.empty())
+				return;
+			out = out.empty() ? v : std::string_view(out.data(), static_cast<size_t>(v.data() + v.size() - out.data()));
+		}
+	}
+
+	namespace srange {
+		// window: positions each memo() rule remembers behind the furthest one it has seen
+		template <typename Range>
+		class basic_packrat_range : public Range {
+			mutable packrat::memo_context m_memo;
+
+			static std::size_t clamp(std::size_t window, std::size_t size) {
+				return std::min(window, size + 1);
+			}
+		public:
+			template <typename Source>
+			basic_packrat_range(Source&& src, std::size_t window = std::size_t(1) << 16)
+				: Range(std::forward<Source>(src)), m_memo(clamp(window, static_cast<std::size_t>(this->last - this->first))) {}
+			packrat::memo_context& memo() const {
+				return m_memo;
+			}
+		};
+
+		using packrat_range = basic_packrat_range<stream_range>;
+		using packrat_view_range = basic_packrat_range<view_range>;
+	}
+
+	using srange::packrat_range;
+	using srange::packrat_view_range;
+
+	template <typename P>
+	class parser_memo {
+		const P p;
+		const std::size_t id;
+		using value_type = std::conditional_t<std::is_void<typename P::result_type>::value, string, typename P::result_type>;
+	public:
+		using is_parser_type = std::true_type;
+		using is_handle_type = std::false_type;
+		using has_side_effects = typename P::has_side_effects;
+		using result_type = typename P::result_type;
+		const size_t rank;
+
+		constexpr parser_memo(const P& p_)
+			: p(p_), id(packrat::next_rule_id()), rank(p_.rank) {}
+		template <typename It, typename R, typename Result = value_type, typename Base = default_base>
+		bool operator()(It& i, const R& r, Result* result = nullptr, Base* st = nullptr) const {
+			return parse(i, r, result, st, packrat::has_memo<R>{});
+		}
+
+		first_assist::first_set first() const {
+			return first_assist::first_of(p);
+		}
+
+		string ebnf(unique_defs* defs = nullptr) const {
+			return p.ebnf(defs);
+		}
+
+	private:
+		template <typename It, typename R, typename Result, typename Base>
+		bool parse(It& i, const R& r, Result* result, Base* st, std::false_type) const {
+			return p(i, r, result, st);
+		}
+
+		// Slices are memoized apart from copies, a rule reached both ways gets two tables
+		template <typename It, typename R, typename Result, typename Base>
+		bool parse(It& i, const R& r, Result* result, Base* st, std::true_type) const {
+			constexpr bool is_view = std::is_same<Result, std::string_view>::value;
+			using V = std::conditional_t<is_view, std::string_view, value_type>;
+			const std::size_t id = 2 * this->id + (is_view ? 1 : 0);
+			packrat::memo_context& memo = r.memo();
+			std::vector<packrat::frame>& stack = memo.m_stack;
+			const std::size_t pos = static_cast<std::size_t>(i - r.first);
+			// frames above hold positions >= pos, a left-recursive call finds itself among those at pos
+			for (std::size_t k = stack.size(); k-- > 0 && stack[k].pos == pos; ) {
+				if (stack[k].rule == id) {
+					stack[k].left_recursive = true;
+					for (std::size_t j = k + 1; j < stack.size(); ++j)
+						stack[j].involved = true;
+					return replay(i, r, result, stack[k].ok, stack[k].end, *static_cast<const V*>(stack[k].seed));
+				}
+			}
+
+			packrat::memo_entry<V>& e = memo.template table<V>(id).slot(pos);
+			if (e.pos == pos) {
+				++memo.m_hits;
+				return replay(i, r, result, e.ok, e.end, e.value);
+			}
+			++memo.m_misses;
+
+			V seed{};
+			const std::size_t f = stack.size();
+			stack.push_back(packrat::frame{id, pos, false, false, false, pos, &seed});
+			struct pop_guard {
+				std::vector<packrat::frame>& s;
+				const std::size_t n;
+				~pop_guard() {
+					s.resize(n);
+				}
+			} guard{stack, f};
+
+			V ans{};
+			bool ok = p(i, r, &ans, st);
+			std::size_t end = static_cast<std::size_t>(i - r.first);
+			if (ok && stack[f].left_recursive) {
+				for (;;) {
+					seed = ans;
+					stack[f].ok = true;
+					stack[f].end = end;
+					i = r.first + pos;
+					V next{};
+					if (!p(i, r, &next, st) || static_cast<std::size_t>(i - r.first) <= end)
+						break;
+					ans = std::move(next);
+					end = static_cast<std::size_t>(i - r.first);
+				}
+				i = r.first + end;
+			}
+			if (!ok)
+				i = r.first + pos;
+			if (!stack[f].involved) {
+				e.pos = pos;
+				e.end = end;
+				e.ok = ok;
+				e.value = ans;
+			}
+			if constexpr (!std::is_void<Result>::value) {
+				if (ok && result != nullptr)
+					packrat::store(*result, ans);
+			}
+			return ok;
+		}
+
+		template <typename It, typename R, typename Result, typename V>
+		static bool replay(It& i, const R& r, Result* result, bool ok, std::size_t end, const V& v) {
+			if (!ok)
+				return false;
+			i = r.first + end;
+			if constexpr (!std::is_void<Result>::value) {
+				if (result != nullptr)
+					packrat::store(*result, v);
+			}
+			return true;
+		}
+	};
+
+	// A failed memo rule consumes nothing, as under attempt()
+	template <typename P, typename = std::enable_if_t<std::is_same<typename P::is_parser_type, std::true_type>::value
+		|| std::is_same<typename P::is_handle_type, std::true_type>::value>>
+	constexpr parser_memo<P> memo(const P& p) {
+		return parser_memo<P>(p);
+	}
+
+
 }
 
 
@@ -2,198 +2,636 @@
 #define SN_PD_H
 
 #include "sn_CommonHeader.h"
+#include <string_view>
 
 // ref: https://github.com/dented42/derp/blob/master/memoization.rkt
 // ref: https://github.com/dented42/derp/blob/master/fixed-points.rkt
 // ref: https://github.com/dented42/derp/blob/master/lazy-structs.rkt
 // ref: https://github.com/dented42/derp/blob/master/derp-core.rkt
 // ref: https://github.com/tmmcguire/Java-Parser-Derivatives
-// TODO: add hash parser -> add compact ref: https://maniagnosis.crsr.net/2012/05/parsing-with-derivatives-compaction.html
+// ref: https://maniagnosis.crsr.net/2012/05/parsing-with-derivatives-compaction.html
+// ref: Adams, Hollenbeck, Might, On the Complexity and Performance of Parsing with Derivatives
 // TODO: ref: https://github.com/NixOS/nix/blob/b4b1f4525f8dc8f320d666c208bff5cb36777580/src/libstore/derivations.hh
 // TODO: ref: https://github.com/NixOS/nix/blob/b4b1f4525f8dc8f320d666c208bff5cb36777580/src/libstore/derivations.cc
 namespace sn_PD {
-	// Since std::hash<string> is not exists, use set<string>
-
+	// Parse forest: every tree rendered as a string, a pair as "(left, right)"
 	using StrSet = std::set<std::string>;
 
+	// Inherit it and transform deriveNull result
+	template <typename T = std::string, typename U = std::string>
+	struct Reduction {
+		virtual ~Reduction() {}
+		virtual U reduce(T t) const = 0;
+	};
+
+	using ReductionPtr = std::shared_ptr<const Reduction<>>;
+
+	class Parser;
+
+	// What a Reduce node does to each tree of its operand: a user reduction, pairing with the trees
+	// of a node that only matches the empty string (on the left or right), or one wrap after another.
+	// Composing is O(1), the steps run only when the forest is asked for.
+	struct Wrap {
+		enum class Op {
+			Reduce, Left, Right, Then,
+		};
+		Op op;
+		ReductionPtr red;
+		Parser* null;
+		std::shared_ptr<const Wrap> first;
+		std::shared_ptr<const Wrap> second;
+	};
+
+	using WrapPtr = std::shared_ptr<const Wrap>;
+
+	enum class Kind {
+		Empty, Epsilon, Literal, Alt, Concat, Delta, Reduce, Recurrence,
+	};
+
+	class Grammar;
+
+	// A node belongs to the Grammar that built it. Nodes are hash-consed, equal ones are the same
+	// pointer, and immutable except for a Recurrence's target and the memo fields.
 	class Parser {
+		friend class Grammar;
+
+		Kind m_kind;
+		Parser* m_p1 = nullptr;  // Alt / Concat / Delta / Reduce operand, Recurrence target
+		Parser* m_p2 = nullptr;
+		char m_ch = 0;
+		StrSet m_tree;           // Epsilon
+		WrapPtr m_wrap;          // Reduce
+
+		// Derivative by the last character asked for (single entry, a node is mostly derived by one
+		// character during a parse)
+		int m_dchar = -1;
+		Parser* m_deriv = nullptr;
+
+		// Fixed points, valid once known
+		bool m_null_known = false;
+		bool m_nullable = false;
+		std::size_t m_null_pass = 0;
+		bool m_forest_known = false;
+		StrSet m_forest;
+		std::size_t m_forest_pass = 0;
+		bool m_prod_known = false;
+		bool m_productive = false;
+		bool m_prod_tainted = false;  // productive only if a recurrence still being derived is
+		std::size_t m_prod_pass = 0;
+		std::size_t m_prod_round = 0;
+
 	public:
-		virtual std::shared_ptr<Parser> derive(char ch) = 0;
-		virtual StrSet deriveNull() = 0;
+		explicit Parser(Kind k) : m_kind(k) {}
+
+		Kind kind() const {
+			return m_kind;
+		}
 	};
 
-	using ParserPtr = std::shared_ptr<Parser>;
-	
+	using ParserPtr = Parser*;
+
+	// Builds the grammar and its derivatives. The constructors compact as they go (the empty language
+	// absorbs concatenation and vanishes from alternation, a leading or trailing epsilon is folded into
+	// a reduction), so the derivative of a real grammar stays about the size of the grammar.
+	class Grammar {
+		struct Key {
+			Kind kind;
+			const void* a;
+			const void* b;
+			const void* c;
+			bool operator==(const Key& rhs) const {
+				return kind == rhs.kind && a == rhs.a && b == rhs.b && c == rhs.c;
+			}
+		};
+		struct KeyHash {
+			std::size_t operator()(const Key& k) const {
+				std::size_t h = static_cast<std::size_t>(k.kind);
+				for (const void* p : { k.a, k.b, k.c })
+					h = h * 0x9E3779B97F4A7C15ull + (reinterpret_cast<std::uintptr_t>(p) >> 4);
+				return h ^ (h >> 29);
+			}
+		};
+
+		std::vector<std::unique_ptr<Parser>> m_nodes;
+		std::unordered_map<Key, Parser*, KeyHash> m_cons;
+		std::map<StrSet, Parser*> m_epsilons;
+		std::array<Parser*, 256> m_literals{};
+		Parser* m_empty;
+
+		std::size_t m_pass = 0;
+		std::size_t m_round = 0;
+		bool m_changed = false;
+		std::vector<Parser*> m_seen;
 
-	class Empty : public Parser, public std::enable_shared_from_this<Empty> {
 	public:
-		std::shared_ptr<Parser> derive(char ch) override {
-			return std::make_shared<Empty>();
+		// Parse forests larger than this, or still growing after this many passes, are cut off with an
+		// exception (infinitely ambiguous grammars)
+		constexpr static const std::size_t max_forest = 1 << 16;
+		constexpr static const std::size_t max_forest_passes = 64;
+
+		Grammar() {
+			m_empty = make(Kind::Empty);
 		}
-		StrSet deriveNull() override {
-			return {};
+		Grammar(const Grammar&) = delete;
+		Grammar& operator=(const Grammar&) = delete;
+
+		ParserPtr empty() const {
+			return m_empty;
 		}
-	};
 
-	class Epsilon : public Parser, public std::enable_shared_from_this<Epsilon> {
-		StrSet tree;
-	public:
-		Epsilon() { tree.insert(""); }
-		Epsilon(char ch) { tree.insert(std::string(1, ch)); }
-		std::shared_ptr<Parser> derive(char ch) override {
-			return std::make_shared<Empty>();
+		ParserPtr epsilon() {
+			return epsilon(StrSet{ "" });
 		}
-		StrSet deriveNull() override {
-			return tree;
+
+		ParserPtr epsilon(const StrSet& trees) {
+			if (trees.empty())
+				return m_empty;
+			auto it = m_epsilons.find(trees);
+			if (it != m_epsilons.end())
+				return it->second;
+			Parser* p = make(Kind::Epsilon);
+			p->m_tree = trees;
+			p->m_null_known = true;
+			p->m_nullable = true;
+			p->m_forest_known = true;
+			p->m_forest = trees;
+			m_epsilons.emplace(trees, p);
+			return p;
 		}
-	};
 
-	class Literal : public Parser, public std::enable_shared_from_this<Literal> {
-		char ch;
-	public:
-		Literal(char ch_) : ch(ch_) {}
-		std::shared_ptr<Parser> derive(char ch_) override {
-			if (ch == ch_)
-				return std::make_shared<Epsilon>(ch);
-			return std::make_shared<Empty>();
+		ParserPtr literal(char ch) {
+			Parser*& p = m_literals[static_cast<unsigned char>(ch)];
+			if (p == nullptr) {
+				p = make(Kind::Literal);
+				p->m_ch = ch;
+			}
+			return p;
 		}
-		StrSet deriveNull() override {
-			return {};
+
+		// "abc" as 'a' 'b' 'c'
+		ParserPtr literal(std::string_view s) {
+			if (s.empty())
+				return epsilon();
+			ParserPtr p = literal(s.back());
+			for (std::size_t k = s.size() - 1; k-- > 0; )
+				p = concat(literal(s[k]), p);
+			return p;
 		}
-	};
 
-	class Alt : public Parser, public std::enable_shared_from_this<Alt> {
-		ParserPtr p1;
-		ParserPtr p2;
-	public:
-		Alt(ParserPtr p1_, ParserPtr p2_) : p1(p1_), p2(p2_) {}
-		std::shared_ptr<Parser> derive(char ch) override {
-			return std::make_shared<Alt>(p1->derive(ch), p2->derive(ch));
+		// Operands are looked at through defined recurrences but kept as given, a cycle has to be
+		// entered through its recurrence for the derivative memo to close it
+		ParserPtr alt(ParserPtr p1, ParserPtr p2) {
+			Parser* const q1 = resolve(p1);
+			Parser* const q2 = resolve(p2);
+			if (q1 == m_empty)
+				return p2;
+			if (q2 == m_empty || q1 == q2)
+				return p1;
+			if (q1->m_kind == Kind::Epsilon && q2->m_kind == Kind::Epsilon) {
+				StrSet s = q1->m_tree;
+				s.insert(q2->m_tree.begin(), q2->m_tree.end());
+				return epsilon(s);
+			}
+			return cons(Kind::Alt, p1, p2);
 		}
-		StrSet deriveNull() override {
-			StrSet s1 = p1->deriveNull();
-			StrSet s2 = p2->deriveNull();
-			StrSet res;
-			for (const auto& s : s1)
-				res.insert(s);
-			for (const auto& s : s2)
-				res.insert(s);
-			return res;
+
+		ParserPtr concat(ParserPtr p1, ParserPtr p2) {
+			Parser* const q1 = resolve(p1);
+			Parser* const q2 = resolve(p2);
+			if (q1 == m_empty || q2 == m_empty)
+				return m_empty;
+			if (q1->m_kind == Kind::Epsilon && q2->m_kind == Kind::Epsilon)
+				return epsilon(pairs(q1->m_tree, q2->m_tree));
+			// a part that only matches the empty string moves into the trees, so the next derivatives
+			// do not walk a growing chain of them
+			if (null_only(q1))
+				return wrap(p2, Wrap{ Wrap::Op::Left, nullptr, q1, nullptr, nullptr });
+			if (null_only(q2))
+				return wrap(p1, Wrap{ Wrap::Op::Right, nullptr, q2, nullptr, nullptr });
+			return cons(Kind::Concat, p1, p2);
 		}
-	};
 
-	class Delta : public Parser, public std::enable_shared_from_this<Delta> {
-		ParserPtr p;
-	public:
-		Delta(ParserPtr p_) : p(p_) {}
-		std::shared_ptr<Parser> derive(char ch) override {
-			return std::make_shared<Empty>();
+		// The empty parses of p, kept lazy so recognizing never builds a forest
+		ParserPtr delta(ParserPtr p) {
+			p = resolve(p);
+			if (!nullable(p))
+				return m_empty;
+			if (p->m_kind == Kind::Epsilon || p->m_kind == Kind::Delta)
+				return p;
+			return cons(Kind::Delta, p, nullptr);
 		}
-		StrSet deriveNull() override {
-			return p->deriveNull();
+
+		ParserPtr reduce(ParserPtr p, ReductionPtr red) {
+			return wrap(p, Wrap{ Wrap::Op::Reduce, std::move(red), nullptr, nullptr, nullptr });
 		}
-	};
 
-	class Concat : public Parser, public std::enable_shared_from_this<Concat> {
-		ParserPtr p1;
-		ParserPtr p2;
-	public:
-		Concat(ParserPtr p1_, ParserPtr p2_) : p1(p1_), p2(p2_) {}
-		std::shared_ptr<Parser> derive(char ch) override {
-			return std::make_shared<Alt>(
-				std::make_shared<Concat>(p1->derive(ch), p2), 
-				std::make_shared<Concat>(std::make_shared<Delta>(p1), p2->derive(ch))
-				);
-		}
-		StrSet deriveNull() override {
-			StrSet s1 = p1->deriveNull();
-			StrSet s2 = p2->deriveNull();
-			StrSet res;
-			for (auto& s : s1) {
-				for (auto& ss : s2) {
-					res.insert(std::string("(") + s + ", " + ss + ")");
+		// Placeholder for a recursive rule, define() it once the right-hand side is built
+		ParserPtr recurrence() {
+			return make(Kind::Recurrence);
+		}
+
+		// A rule that can derive no string at all (r = r 'x' once its base case is gone) becomes
+		// the empty language, compaction alone never sees through the cycle
+		void define(ParserPtr r, ParserPtr p) {
+			assert(r->m_kind == Kind::Recurrence && r->m_p1 == nullptr && "Recurrence defined twice.");
+			r->m_p1 = resolve(p) == r ? m_empty : p;
+			if (!productive(r))
+				r->m_p1 = m_empty;
+		}
+
+		// Memoized on the node. A recurrence's derivative is registered before its right-hand side is
+		// derived, so a cycle closes on it instead of unfolding forever.
+		ParserPtr derive(ParserPtr p, char ch) {
+			const int c = static_cast<unsigned char>(ch);
+			if (p->m_dchar == c)
+				return p->m_deriv;
+			Parser* d = m_empty;
+			switch (p->m_kind) {
+			case Kind::Empty:
+			case Kind::Epsilon:
+			case Kind::Delta:
+				break;
+			case Kind::Literal:
+				if (p->m_ch == ch)
+					d = epsilon(StrSet{ std::string(1, ch) });
+				break;
+			case Kind::Alt:
+				d = alt(derive(p->m_p1, ch), derive(p->m_p2, ch));
+				break;
+			case Kind::Concat:
+				d = concat(derive(p->m_p1, ch), p->m_p2);
+				if (nullable(p->m_p1))
+					d = alt(d, concat(delta(p->m_p1), derive(p->m_p2, ch)));
+				break;
+			case Kind::Reduce:
+				d = rewrap(derive(p->m_p1, ch), p->m_wrap);
+				break;
+			case Kind::Recurrence:
+				if (p->m_p1 != nullptr) {
+					d = recurrence();
+					p->m_dchar = c;
+					p->m_deriv = d;
+					define(d, derive(p->m_p1, ch));
 				}
+				break;
 			}
-			return res;
+			p->m_dchar = c;
+			p->m_deriv = d;
+			return d;
 		}
-	};
 
-	// Inherit it and transform deriveNull result
-	template <typename T, typename U>
-	struct Reduction {
-		virtual U reduce(T t) = 0;
-	};
+		// Least fixed point over the (possibly cyclic) graph, false values settle as well once
+		// a pass over them changes nothing
+		bool nullable(ParserPtr p) {
+			if (p->m_null_known)
+				return p->m_nullable;
+			do {
+				m_changed = false;
+				++m_pass;
+				m_seen.clear();
+				null_pass(p);
+			} while (m_changed);
+			for (auto q : m_seen)
+				q->m_null_known = true;
+			return p->m_nullable;
+		}
 
-	template <typename T, typename U>
-	class Reduce : public Parser, public std::enable_shared_from_this<Reduce<T, U>> {
-		ParserPtr p;
-		Reduction<T, U> red;
-	public:
-		Reduce(ParserPtr p_, Reduction<T, U> red_) : p(p_), red(red_) {}
-		std::shared_ptr<Parser> derive(char ch) override {
-			return std::make_shared<Reduce>(p->derive(ch), red);
+		// Whether p derives any string at all, recurrences not defined yet are assumed to
+		bool productive(ParserPtr p) {
+			if (p->m_prod_known)
+				return p->m_productive;
+			++m_round;
+			do {
+				m_changed = false;
+				++m_pass;
+				m_seen.clear();
+				prod_pass(p);
+			} while (m_changed);
+			// false is final, so is true that did not lean on an undefined recurrence
+			for (auto q : m_seen) {
+				if (!q->m_productive || !q->m_prod_tainted)
+					q->m_prod_known = true;
+			}
+			return p->m_productive;
 		}
-		StrSet deriveNull() override {
-			StrSet n;
-			for (auto o : p->deriveNull())
-				n.insert(red.reduce(o));
-			return n;
+
+		StrSet deriveNull(ParserPtr p) {
+			if (!nullable(p))
+				return {};
+			if (p->m_forest_known)
+				return p->m_forest;
+			std::size_t passes = 0;
+			do {
+				if (++passes > max_forest_passes)
+					throw std::runtime_error("Parse forest too large.");
+				m_changed = false;
+				++m_pass;
+				m_seen.clear();
+				forest_pass(p);
+			} while (m_changed);
+			for (auto q : m_seen)
+				q->m_forest_known = true;
+			return p->m_forest;
 		}
-	};
-	
-	class Fix : public Parser, public std::enable_shared_from_this<Fix> {
-		StrSet set;
-		class Delay : public Parser, public std::enable_shared_from_this<Delay> {
-			std::shared_ptr<Fix> p;
-			char ch;
-			ParserPtr deriv = nullptr;
-			void force() {
-				if (deriv == nullptr)
-					deriv = p->innerDerive(ch);
-			}
-		public:
-			Delay(std::shared_ptr<Fix> p_, char ch_) : p(p_), ch(ch_) {}
-			ParserPtr derive(char ch) override {
-				force();
-				return deriv->derive(ch);
-			}
-			StrSet deriveNull() override {
-				force();
-				return deriv->deriveNull();
+
+		// Both drop the derivatives they built on return, so a Grammar parsing input after input stays
+		// the size of the grammar itself
+		bool recognize(ParserPtr p, std::string_view s) {
+			const derivative_scope scope(*this);
+			for (char ch : s) {
+				p = derive(p, ch);
+				if (resolve(p) == m_empty)
+					return false;
+			}
+			return nullable(p);
+		}
+
+		StrSet parse(ParserPtr p, std::string_view s) {
+			const derivative_scope scope(*this);
+			for (char ch : s) {
+				p = derive(p, ch);
+				if (resolve(p) == m_empty)
+					return {};
+			}
+			return deriveNull(p);
+		}
+
+		// Nodes built so far
+		std::size_t size() const {
+			return m_nodes.size();
+		}
+
+		// Drops every node built after the first base ones (size() before derive() was called by hand)
+		// along with their hash-cons entries, and forgets the derivatives memoized on the rest.
+		// Pointers to dropped nodes dangle afterwards.
+		void clear_derivatives(std::size_t base) {
+			if (base >= m_nodes.size())
+				return;
+			// the derivative memo of a node about to go doubles as its mark
+			constexpr const int dead = -2;
+			for (std::size_t i = base; i < m_nodes.size(); ++i)
+				m_nodes[i]->m_dchar = dead;
+			for (auto it = m_cons.begin(); it != m_cons.end(); )
+				it = it->second->m_dchar == dead ? m_cons.erase(it) : std::next(it);
+			for (auto it = m_epsilons.begin(); it != m_epsilons.end(); )
+				it = it->second->m_dchar == dead ? m_epsilons.erase(it) : std::next(it);
+			for (auto& l : m_literals) {
+				if (l != nullptr && l->m_dchar == dead)
+					l = nullptr;
+			}
+			for (std::size_t i = 0; i < base; ++i) {
+				m_nodes[i]->m_dchar = -1;
+				m_nodes[i]->m_deriv = nullptr;
+			}
+			m_seen.clear();
+			m_nodes.resize(base);
+		}
+
+	private:
+		// Nodes made inside it (derivatives, not the grammar given) are gone when it ends
+		struct derivative_scope {
+			Grammar& g;
+			std::size_t base;
+			explicit derivative_scope(Grammar& gr) : g(gr), base(gr.size()) {}
+			~derivative_scope() {
+				g.clear_derivatives(base);
 			}
 		};
-		std::map<std::pair<ParserPtr, char>, ParserPtr> derivs;
-	public:
-		virtual ParserPtr innerDerive(char ch);
-		virtual StrSet innerDeriveNull();
-		ParserPtr derive(char ch) override {
-			if (derivs.end() != derivs.find(std::make_pair(shared_from_this(), ch)))
-				derivs.insert(std::make_pair(std::make_pair(shared_from_this(), ch), std::make_shared<Delay>(shared_from_this(), ch)));
-			
-			return derivs.find(std::make_pair(shared_from_this(), ch))->second;
-		}
-		StrSet deriveNull() override {
-			if (!set.empty())
-				return set;
-			StrSet n;
-			do {
-				set = n;
-				n = innerDeriveNull();
-			} while (!(set == n));
+
+		Parser* make(Kind k) {
+			m_nodes.emplace_back(new Parser(k));
+			return m_nodes.back().get();
 		}
-	};
 
-	class Recurrence : public Fix, public std::enable_shared_from_this<Recurrence> {
-		ParserPtr p;
-	public:
-		void setParser(ParserPtr p_) {
-			p = p_;
+		Parser* cons(Kind k, Parser* p1, Parser* p2, const void* extra = nullptr) {
+			Parser*& p = m_cons[Key{ k, p1, p2, extra }];
+			if (p == nullptr) {
+				p = make(k);
+				p->m_p1 = p1;
+				p->m_p2 = p2;
+			}
+			return p;
 		}
-		std::shared_ptr<Parser> innerDerive(char ch) override {
-			return p->derive(ch);
+
+		// A defined recurrence is its target; undefined ones (still being derived) stay opaque
+		static Parser* resolve(Parser* p) {
+			for (int hops = 0; p->m_kind == Kind::Recurrence && p->m_p1 != nullptr && hops < 64; ++hops)
+				p = p->m_p1;
+			return p;
+		}
+
+		static bool null_only(const Parser* p) {
+			if (p->m_kind == Kind::Reduce)
+				p = p->m_p1;
+			return p->m_kind == Kind::Epsilon || p->m_kind == Kind::Delta;
+		}
+
+		// One step on top of those p already has
+		Parser* wrap(Parser* p, Wrap w) {
+			Parser* const q = resolve(p);
+			if (q == m_empty)
+				return m_empty;
+			if (q->m_kind == Kind::Epsilon && (w.op == Wrap::Op::Reduce || w.null->m_kind == Kind::Epsilon))
+				return epsilon(apply(&w, q->m_tree));
+			return rewrap(p, std::make_shared<const Wrap>(std::move(w)));
+		}
+
+		Parser* rewrap(Parser* p, const WrapPtr& w) {
+			Parser* const q = resolve(p);
+			if (q == m_empty)
+				return m_empty;
+			WrapPtr ww = w;
+			if (q->m_kind == Kind::Reduce) {
+				ww = std::make_shared<const Wrap>(Wrap{ Wrap::Op::Then, nullptr, nullptr, q->m_wrap, w });
+				p = q->m_p1;
+			}
+			Parser* r = cons(Kind::Reduce, p, nullptr, ww.get());
+			if (r->m_wrap == nullptr)
+				r->m_wrap = ww;
+			return r;
 		}
-		StrSet innerDeriveNull() override {
-			return p->deriveNull();
+
+		// Steps in order, innermost first; pairing with a delta takes its trees from the current pass
+		StrSet apply(const Wrap* w, StrSet s) {
+			std::vector<const Wrap*> todo{ w };
+			while (!todo.empty()) {
+				const Wrap* k = todo.back();
+				todo.pop_back();
+				if (k->op == Wrap::Op::Then) {
+					todo.push_back(k->second.get());
+					todo.push_back(k->first.get());
+					continue;
+				}
+				StrSet res;
+				switch (k->op) {
+				case Wrap::Op::Reduce:
+					for (const auto& t : s)
+						res.insert(k->red->reduce(t));
+					break;
+				case Wrap::Op::Left:
+					res = pairs(forest_of(k->null), s);
+					break;
+				case Wrap::Op::Right:
+					res = pairs(s, forest_of(k->null));
+					break;
+				default:
+					break;
+				}
+				s = std::move(res);
+			}
+			return s;
+		}
+
+		const StrSet& forest_of(Parser* p) {
+			return p->m_kind == Kind::Epsilon ? p->m_tree : forest_pass(p);
+		}
+
+		static StrSet pairs(const StrSet& s1, const StrSet& s2) {
+			StrSet res;
+			for (const auto& s : s1) {
+				for (const auto& ss : s2) {
+					res.insert(std::string("(") + s + ", " + ss + ")");
+				}
+				if (res.size() > max_forest)
+					throw std::runtime_error("Parse forest too large.");
+			}
+			return res;
+		}
+
+		bool null_pass(Parser* p) {
+			if (p->m_null_known || p->m_null_pass == m_pass)
+				return p->m_nullable;
+			p->m_null_pass = m_pass;
+			m_seen.push_back(p);
+			bool v = false;
+			switch (p->m_kind) {
+			case Kind::Empty:
+			case Kind::Literal:
+				break;
+			case Kind::Epsilon:
+				v = true;
+				break;
+			case Kind::Alt:
+				v = null_pass(p->m_p1);
+				v = null_pass(p->m_p2) || v;
+				break;
+			case Kind::Concat:
+				v = null_pass(p->m_p1);
+				v = null_pass(p->m_p2) && v;
+				break;
+			case Kind::Delta:
+			case Kind::Reduce:
+			case Kind::Recurrence:
+				v = p->m_p1 != nullptr && null_pass(p->m_p1);
+				break;
+			}
+			if (v && !p->m_nullable) {
+				p->m_nullable = true;
+				m_changed = true;
+			}
+			return p->m_nullable;
+		}
+
+		bool prod_pass(Parser* p) {
+			if (p->m_prod_known)
+				return p->m_productive;
+			if (p->m_prod_round != m_round) {
+				p->m_prod_round = m_round;
+				p->m_productive = false;
+				p->m_prod_tainted = false;
+			}
+			if (p->m_prod_pass == m_pass)
+				return p->m_productive;
+			p->m_prod_pass = m_pass;
+			m_seen.push_back(p);
+			bool v = false;
+			bool taint = false;
+			switch (p->m_kind) {
+			case Kind::Empty:
+				break;
+			case Kind::Epsilon:
+			case Kind::Literal:
+			case Kind::Delta:
+				v = true;
+				break;
+			case Kind::Alt: {
+				const bool v1 = prod_pass(p->m_p1);
+				const bool v2 = prod_pass(p->m_p2);
+				v = v1 || v2;
+				taint = !((v1 && !p->m_p1->m_prod_tainted) || (v2 && !p->m_p2->m_prod_tainted));
+				break;
+			}
+			case Kind::Concat:
+				v = prod_pass(p->m_p1);
+				v = prod_pass(p->m_p2) && v;
+				taint = p->m_p1->m_prod_tainted || p->m_p2->m_prod_tainted;
+				break;
+			case Kind::Reduce:
+				v = prod_pass(p->m_p1);
+				taint = p->m_p1->m_prod_tainted;
+				break;
+			case Kind::Recurrence:
+				if (p->m_p1 == nullptr) {
+					v = true;
+					taint = true;
+				}
+				else {
+					v = prod_pass(p->m_p1);
+					taint = p->m_p1->m_prod_tainted;
+				}
+				break;
+			}
+			taint = v && taint;
+			if ((v && !p->m_productive) || (taint && !p->m_prod_tainted)) {
+				p->m_productive = p->m_productive || v;
+				p->m_prod_tainted = p->m_prod_tainted || taint;
+				m_changed = true;
+			}
+			return p->m_productive;
+		}
+
+		const StrSet& forest_pass(Parser* p) {
+			if (p->m_forest_known || p->m_forest_pass == m_pass)
+				return p->m_forest;
+			p->m_forest_pass = m_pass;
+			m_seen.push_back(p);
+			StrSet s;
+			switch (p->m_kind) {
+			case Kind::Empty:
+			case Kind::Literal:
+				break;
+			case Kind::Epsilon:
+				s = p->m_tree;
+				break;
+			case Kind::Alt:
+				s = forest_pass(p->m_p1);
+				for (const auto& t : forest_pass(p->m_p2))
+					s.insert(t);
+				break;
+			case Kind::Concat: {
+				const StrSet s1 = forest_pass(p->m_p1);
+				s = pairs(s1, forest_pass(p->m_p2));
+				break;
+			}
+			case Kind::Delta:
+				s = forest_pass(p->m_p1);
+				break;
+			case Kind::Reduce:
+				s = apply(p->m_wrap.get(), forest_pass(p->m_p1));
+				break;
+			case Kind::Recurrence:
+				if (p->m_p1 != nullptr)
+					s = forest_pass(p->m_p1);
+				break;
+			}
+			// trees only ever get added
+			if (s.size() > p->m_forest.size()) {
+				if (s.size() > max_forest)
+					throw std::runtime_error("Parse forest too large.");
+				p->m_forest = std::move(s);
+				m_changed = true;
+			}
+			return p->m_forest;
 		}
 	};
 
@@ -3,6 +3,7 @@
 
 #include "sn_CommonHeader.h"
 #include "sn_Macro.hpp"
+#include "sn_String/intern.hpp"
 
 namespace sn_Reflection {
 	// ref: http://purecpp.org/?p=1074
@@ -180,6 +181,17 @@ namespace sn_Reflection {
 				return get_impl<N>(t);
 			}
 
+			template <std::size_t N, typename T>
+			constexpr T& get_impl(base_from_member<N, T>& t) noexcept {
+				return t.value;
+			}
+
+			template <std::size_t N, typename ...T>
+			constexpr decltype(auto) get(tuple<T...>& t) noexcept {
+				static_assert(N < tuple<T...>::size_v, "Tuple index out of bounds");
+				return get_impl<N>(t);
+			}
+
 		}
 
 		template <std::size_t ...I>
@@ -207,6 +219,17 @@ namespace sn_Reflection {
 			return get<I>(*t);
 		}
 
+		template <std::size_t I, typename T>
+		decltype(auto) get(T& val) noexcept {
+			auto t = reinterpret_cast<decltype(index_seq_as_tuple<T>())*>(std::addressof(val));
+			return get<I>(*t);
+		}
+
+		template <typename T>
+		constexpr std::size_t fields_count() noexcept {
+			return decltype(array_of_type_ids<T>())::size();
+		}
+
 	}
 #endif
 
@@ -318,8 +341,13 @@ namespace sn_Reflection {
 				return TypeName<Sub>::type_name();
 			}
 
+			// nullptr for a name never registered
 			static Base* create(const std::string& name) {
-				return (*s_creator[name])();
+				const auto sym = sn_String::intern_pool::global().find(name);
+				if (!sym)
+					return nullptr;
+				const auto it = s_creator.find(*sym);
+				return it == s_creator.end() ? nullptr : (*it->second)();
 			}
 
 		private:
@@ -341,14 +369,14 @@ namespace sn_Reflection {
 			class Registery {
 			public:
 				Registery() {
-					s_creator[get_name()] = new Allocator<Sub>();
+					s_creator[sn_String::intern(get_name())] = new Allocator<Sub>();
 				}
 
 				static std::string get_name() {
 					return typeid(Sub).name();
 				}
 				virtual ~Registery() {
-					s_creator.erase(s_creator.find(get_name()));
+					s_creator.erase(sn_String::intern(get_name()));
 				}
 			};
 
@@ -362,11 +390,12 @@ namespace sn_Reflection {
 				static Registery<Sub> s_registery;
 			};
 
-			static std::map<std::string, AllocatorBase* > s_creator;
+			// keyed by the interned typeid name, so each name is stored once library-wide
+			static std::unordered_map<sn_String::symbol, AllocatorBase* > s_creator;
 		};
 
 		template<typename Base>
-		std::map<std::string, typename Reflection<Base>::AllocatorBase*> Reflection<Base>::s_creator;
+		std::unordered_map<sn_String::symbol, typename Reflection<Base>::AllocatorBase*> Reflection<Base>::s_creator;
 
 		template<typename Base>
 		template<typename Sub>
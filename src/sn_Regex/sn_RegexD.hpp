@@ -5,8 +5,7 @@
 
 // ref : Cheukyin/CodeSnippet/blob/master/PL/Regex
 // Brzozowski's derivative
-// TODO: add DFA (ref : https://people.mpi-sws.org/~turon/re-deriv.pdf, derivative can => DFA)
-// TODO: add reduction
+// DFA / lazy DFA compiled from derivatives (ref : https://people.mpi-sws.org/~turon/re-deriv.pdf)
 // Visitor pattern-GADT
 namespace sn_RegexD {
 	namespace AST {
@@ -844,6 +843,486 @@ namespace sn_RegexD {
 
 	}
 
+
+	// Derivatives explored once into an automaton (ref: Owens, Reppy, Turon, Regular-expression derivatives re-examined)
+	// Terms are hash-consed and kept in a canonical form (the similarity rules: Alt is associative, commutative
+	// and idempotent, Empty / Null are units and zeros), so equal derivatives get equal ids and exploration ends.
+	// Captures are not tracked, Group is transparent here.
+	namespace DFA {
+		using namespace AST;
+
+		class DFALimitException : public std::exception {
+		public:
+			const char* what() const noexcept override {
+				return "DFA state limit exceeded.";
+			}
+		};
+
+		enum class TermKind : uint8_t {
+			Empty,
+			Null,
+			Any,
+			Char,
+			Alt,
+			Seq,
+			Rep
+		};
+
+		struct Term {
+			TermKind m_kind;
+			bool m_nullable;
+			unsigned char m_ch;
+			uint32_t m_l, m_r;
+		};
+
+		class TermStore {
+		public:
+			using term_id = uint32_t;
+
+			TermStore() {
+				m_empty = make(TermKind::Empty, false, 0, 0, 0);
+				m_null = make(TermKind::Null, true, 0, 0, 0);
+			}
+
+			const Term& operator[](term_id t) const {
+				return m_terms[t];
+			}
+			std::size_t size() const noexcept {
+				return m_terms.size();
+			}
+			bool nullable(term_id t) const {
+				return m_terms[t].m_nullable;
+			}
+
+			term_id empty() const noexcept {
+				return m_empty;
+			}
+			term_id null() const noexcept {
+				return m_null;
+			}
+			term_id any() {
+				return make(TermKind::Any, false, 0, 0, 0);
+			}
+			term_id chr(unsigned char c) {
+				return make(TermKind::Char, false, c, 0, 0);
+			}
+
+			// Sorted, duplicate-free right spine: the operand set is the canonical form
+			term_id alt(term_id a, term_id b) {
+				if (a == m_empty || a == b)
+					return b;
+				if (b == m_empty)
+					return a;
+				std::vector<term_id> ops;
+				flatten_alt(a, ops);
+				flatten_alt(b, ops);
+				std::sort(ops.begin(), ops.end());
+				ops.erase(std::unique(ops.begin(), ops.end()), ops.end());
+				term_id ret = ops.back();
+				for (std::size_t i = ops.size() - 1; i-- > 0; )
+					ret = make(TermKind::Alt, m_terms[ops[i]].m_nullable || m_terms[ret].m_nullable, 0, ops[i], ret);
+				return ret;
+			}
+			term_id seq(term_id a, term_id b) {
+				if (a == m_empty || b == m_empty)
+					return m_empty;
+				if (a == m_null)
+					return b;
+				if (b == m_null)
+					return a;
+				if (m_terms[a].m_kind == TermKind::Seq) {
+					const Term t = m_terms[a];
+					return seq(t.m_l, seq(t.m_r, b));
+				}
+				return make(TermKind::Seq, m_terms[a].m_nullable && m_terms[b].m_nullable, 0, a, b);
+			}
+			term_id rep(term_id a) {
+				if (a == m_empty || a == m_null)
+					return m_null;
+				if (m_terms[a].m_kind == TermKind::Rep)
+					return a;
+				return make(TermKind::Rep, true, 0, a, 0);
+			}
+
+			// D(t, c), memoized per (term, byte)
+			term_id derive(term_id t, unsigned char c) {
+				const uint64_t key = (static_cast<uint64_t>(t) << 8) | c;
+				auto iter = m_derivs.find(key);
+				if (iter != m_derivs.end())
+					return iter->second;
+				const Term term = m_terms[t];
+				term_id ret;
+				switch (term.m_kind) {
+				case TermKind::Empty:
+				case TermKind::Null:
+					ret = m_empty;
+					break;
+				case TermKind::Any:
+					ret = m_null;
+					break;
+				case TermKind::Char:
+					ret = term.m_ch == c ? m_null : m_empty;
+					break;
+				case TermKind::Alt:
+					ret = alt(derive(term.m_l, c), derive(term.m_r, c));
+					break;
+				case TermKind::Seq:
+					ret = seq(derive(term.m_l, c), term.m_r);
+					if (m_terms[term.m_l].m_nullable)
+						ret = alt(ret, derive(term.m_r, c));
+					break;
+				default:
+					ret = seq(derive(term.m_l, c), t);
+					break;
+				}
+				m_derivs.emplace(key, ret);
+				return ret;
+			}
+
+			// Rebuild t (owned by other) in this store
+			term_id import(const TermStore& other, term_id t) {
+				const Term& term = other[t];
+				switch (term.m_kind) {
+				case TermKind::Empty: return m_empty;
+				case TermKind::Null: return m_null;
+				case TermKind::Any: return any();
+				case TermKind::Char: return chr(term.m_ch);
+				case TermKind::Alt: return alt(import(other, term.m_l), import(other, term.m_r));
+				case TermKind::Seq: return seq(import(other, term.m_l), import(other, term.m_r));
+				default: return rep(import(other, term.m_l));
+				}
+			}
+
+		private:
+			struct TermKey {
+				uint64_t m_lr;
+				uint32_t m_kc;
+				bool operator==(const TermKey& rhs) const noexcept {
+					return m_lr == rhs.m_lr && m_kc == rhs.m_kc;
+				}
+			};
+			struct TermKeyHash {
+				std::size_t operator()(const TermKey& k) const noexcept {
+					return std::hash<uint64_t>()(k.m_lr * 0x9E3779B97F4A7C15ull ^ k.m_kc);
+				}
+			};
+
+			term_id make(TermKind kind, bool nullable, unsigned char ch, term_id l, term_id r) {
+				const TermKey key{(static_cast<uint64_t>(l) << 32) | r, (static_cast<uint32_t>(kind) << 8) | ch};
+				auto iter = m_index.find(key);
+				if (iter != m_index.end())
+					return iter->second;
+				const term_id id = static_cast<term_id>(m_terms.size());
+				m_terms.push_back(Term{kind, nullable, ch, l, r});
+				m_index.emplace(key, id);
+				return id;
+			}
+			void flatten_alt(term_id t, std::vector<term_id>& ops) const {
+				while (m_terms[t].m_kind == TermKind::Alt) {
+					ops.push_back(m_terms[t].m_l);
+					t = m_terms[t].m_r;
+				}
+				ops.push_back(t);
+			}
+
+			std::vector<Term> m_terms;
+			std::unordered_map<TermKey, term_id, TermKeyHash> m_index;
+			std::unordered_map<uint64_t, term_id> m_derivs;
+			term_id m_empty, m_null;
+		};
+
+		// AST -> canonical term, Char('.') is the wildcard as in the derivative engine
+		struct TermBuilder : public Visitor, public std::enable_shared_from_this<TermBuilder> {
+			TermStore* m_store;
+			TermStore::term_id m_term;
+			TermStore::term_id build(TermStore& store, const RegexPtr& re) {
+				m_store = &store;
+				visit(re);
+				return m_term;
+			}
+			void visit(const RegexPtr& re) override {
+				re->accept(shared_from_this());
+			}
+			void visit(const EmptyPtr& re) override {
+				m_term = m_store->empty();
+			}
+			void visit(const NullPtr& re) override {
+				m_term = m_store->null();
+			}
+			void visit(const CharPtr& re) override {
+				m_term = re->m_ch == '.' ? m_store->any() : m_store->chr(static_cast<unsigned char>(re->m_ch));
+			}
+			void visit(const AltPtr& re) override {
+				re->m_expl->accept(shared_from_this());
+				TermStore::term_id l = m_term;
+				re->m_expr->accept(shared_from_this());
+				m_term = m_store->alt(l, m_term);
+			}
+			void visit(const SeqPtr& re) override {
+				re->m_expl->accept(shared_from_this());
+				TermStore::term_id l = m_term;
+				re->m_expr->accept(shared_from_this());
+				m_term = m_store->seq(l, m_term);
+			}
+			void visit(const RepPtr& re) override {
+				re->m_exp->accept(shared_from_this());
+				m_term = m_store->rep(m_term);
+			}
+			void visit(const GroupPtr& re) override {
+				re->m_exp->accept(shared_from_this());
+			}
+		};
+
+		using TermBuilderPtr = std::shared_ptr<TermBuilder>;
+
+		// Bytes no literal tells apart share a class, one column per class in the transition table
+		struct ByteClasses {
+			uint8_t m_map[256];
+			unsigned char m_rep[256];
+			std::size_t m_count;
+
+			void build(const TermStore& store) {
+				bool used[256] = {};
+				for (std::size_t i = 0; i < store.size(); ++i)
+					if (store[static_cast<TermStore::term_id>(i)].m_kind == TermKind::Char)
+						used[store[static_cast<TermStore::term_id>(i)].m_ch] = true;
+				// class 0: every byte no literal mentions
+				m_count = 1;
+				m_rep[0] = 0;
+				bool has_other = false;
+				for (int b = 0; b < 256; ++b) {
+					if (used[b]) {
+						m_map[b] = static_cast<uint8_t>(m_count);
+						m_rep[m_count++] = static_cast<unsigned char>(b);
+					}
+					else {
+						m_map[b] = 0;
+						if (!has_other) {
+							m_rep[0] = static_cast<unsigned char>(b);
+							has_other = true;
+						}
+					}
+				}
+			}
+		};
+
+		// State 0 is the dead state
+		class DFA {
+		public:
+			using state_t = uint32_t;
+			constexpr static const state_t dead = 0;
+
+			explicit DFA(const RegexPtr& re, std::size_t max_states = 10000) {
+				const TermStore::term_id root = TermBuilderPtr(new TermBuilder)->build(m_store, re);
+				m_classes.build(m_store);
+				std::unordered_map<TermStore::term_id, state_t> states;
+				std::vector<TermStore::term_id> terms;
+				auto add = [&](TermStore::term_id t) -> state_t {
+					auto iter = states.find(t);
+					if (iter != states.end())
+						return iter->second;
+					if (terms.size() == max_states)
+						throw DFALimitException();
+					const state_t s = static_cast<state_t>(terms.size());
+					states.emplace(t, s);
+					terms.push_back(t);
+					m_accept.push_back(m_store.nullable(t));
+					return s;
+				};
+				add(m_store.empty());
+				m_start = add(root);
+				// BFS over the states as they are discovered
+				for (std::size_t s = 0; s < terms.size(); ++s) {
+					m_table.resize(terms.size() * m_classes.m_count);
+					for (std::size_t c = 0; c < m_classes.m_count; ++c) {
+						const state_t next = add(m_store.derive(terms[s], m_classes.m_rep[c]));
+						m_table[s * m_classes.m_count + c] = next;
+					}
+				}
+			}
+
+			state_t start() const noexcept {
+				return m_start;
+			}
+			state_t next(state_t s, unsigned char c) const noexcept {
+				return m_table[s * m_classes.m_count + m_classes.m_map[c]];
+			}
+			bool accept(state_t s) const noexcept {
+				return m_accept[s] != 0;
+			}
+			std::size_t state_count() const noexcept {
+				return m_accept.size();
+			}
+			std::size_t class_count() const noexcept {
+				return m_classes.m_count;
+			}
+
+		private:
+			TermStore m_store;
+			ByteClasses m_classes;
+			std::vector<state_t> m_table;
+			std::vector<uint8_t> m_accept;
+			state_t m_start;
+		};
+
+		// Same automaton built on the fly: transitions are filled in as the input needs them and
+		// the whole cache is dropped once it holds max_states states (ref: RE2's lazy DFA)
+		class LazyDFA {
+		public:
+			using state_t = uint32_t;
+			constexpr static const state_t dead = 0;
+			constexpr static const state_t unknown = static_cast<state_t>(-1);
+
+			explicit LazyDFA(const RegexPtr& re, std::size_t max_states = 1024)
+				: m_max_states(max_states < 3 ? 3 : max_states) {
+				m_root = TermBuilderPtr(new TermBuilder)->build(m_store, re);
+				m_classes.build(m_store);
+				reset();
+			}
+
+			state_t start() const noexcept {
+				return m_start;
+			}
+			// May flush the cache, in which case every other state_t held by the caller is stale
+			state_t next(state_t s, unsigned char c) {
+				const std::size_t slot = s * m_classes.m_count + m_classes.m_map[c];
+				const state_t ret = m_table[slot];
+				if (ret != unknown)
+					return ret;
+				return fill(s, slot, c);
+			}
+			bool accept(state_t s) const noexcept {
+				return m_accept[s] != 0;
+			}
+			std::size_t state_count() const noexcept {
+				return m_terms.size();
+			}
+			std::size_t class_count() const noexcept {
+				return m_classes.m_count;
+			}
+			std::size_t flush_count() const noexcept {
+				return m_flushes;
+			}
+
+		private:
+			state_t add(TermStore::term_id t) {
+				auto iter = m_states.find(t);
+				if (iter != m_states.end())
+					return iter->second;
+				const state_t s = static_cast<state_t>(m_terms.size());
+				m_states.emplace(t, s);
+				m_terms.push_back(t);
+				m_accept.push_back(m_store.nullable(t));
+				m_table.resize(m_terms.size() * m_classes.m_count, unknown);
+				return s;
+			}
+			void reset() {
+				m_states.clear();
+				m_terms.clear();
+				m_accept.clear();
+				m_table.clear();
+				add(m_store.empty());
+				m_start = add(m_root);
+			}
+
+			state_t fill(state_t s, std::size_t slot, unsigned char c) {
+				TermStore::term_id t = m_store.derive(m_terms[s], m_classes.m_rep[m_classes.m_map[c]]);
+				if (m_states.find(t) == m_states.end() && m_terms.size() >= m_max_states) {
+					// terms are dropped along with the states, only the root and the target survive
+					TermStore fresh;
+					m_root = fresh.import(m_store, m_root);
+					t = fresh.import(m_store, t);
+					m_store = std::move(fresh);
+					reset();
+					++m_flushes;
+					return add(t);
+				}
+				const state_t ret = add(t);
+				m_table[slot] = ret;
+				return ret;
+			}
+
+			TermStore m_store;
+			ByteClasses m_classes;
+			TermStore::term_id m_root;
+			std::unordered_map<TermStore::term_id, state_t> m_states;
+			std::vector<TermStore::term_id> m_terms;
+			std::vector<state_t> m_table;
+			std::vector<uint8_t> m_accept;
+			state_t m_start;
+			std::size_t m_max_states;
+			std::size_t m_flushes = 0;
+		};
+	}
+
+	namespace DFAEngine {
+		using namespace AST;
+		using Parse::Parser;
+
+		// One table lookup per byte; Automaton is DFA::DFA or DFA::LazyDFA
+		template <typename Automaton>
+		class BasicDFAEngine {
+		public:
+			using str_size_t = std::string::size_type;
+
+			explicit BasicDFAEngine(const std::string& str, std::size_t max_states)
+				: m_dfa(Parser()(str), max_states) {}
+
+			bool match(const std::string& str) {
+				auto s = m_dfa.start();
+				for (str_size_t i = 0; i < str.size() && s != Automaton::dead; ++i)
+					s = m_dfa.next(s, static_cast<unsigned char>(str[i]));
+				return m_dfa.accept(s);
+			}
+
+			// Leftmost-longest match as [first, last), {npos, npos} if none
+			std::pair<str_size_t, str_size_t> find(const std::string& str, str_size_t pos = 0) {
+				for (str_size_t i = pos; i <= str.size(); ++i) {
+					auto s = m_dfa.start();
+					str_size_t last = m_dfa.accept(s) ? i : std::string::npos;
+					for (str_size_t j = i; j < str.size(); ++j) {
+						s = m_dfa.next(s, static_cast<unsigned char>(str[j]));
+						if (s == Automaton::dead)
+							break;
+						if (m_dfa.accept(s))
+							last = j + 1;
+					}
+					if (last != std::string::npos)
+						return {i, last};
+				}
+				return {std::string::npos, std::string::npos};
+			}
+
+			std::string search(const std::string& str) {
+				const auto m = find(str);
+				if (m.first == std::string::npos)
+					return std::string();
+				return str.substr(m.first, m.second - m.first);
+			}
+
+			const Automaton& automaton() const noexcept {
+				return m_dfa;
+			}
+
+		private:
+			Automaton m_dfa;
+		};
+
+		// Whole automaton built up front, throws DFA::DFALimitException past max_states
+		class DFAEngine : public BasicDFAEngine<DFA::DFA> {
+		public:
+			explicit DFAEngine(const std::string& str, std::size_t max_states = 10000)
+				: BasicDFAEngine<DFA::DFA>(str, max_states) {}
+		};
+
+		// For patterns whose automaton explodes: states are built as the input reaches them, at most max_states cached
+		class LazyDFAEngine : public BasicDFAEngine<DFA::LazyDFA> {
+		public:
+			explicit LazyDFAEngine(const std::string& str, std::size_t max_states = 1024)
+				: BasicDFAEngine<DFA::LazyDFA>(str, max_states) {}
+		};
+	}
+
 }
 
 
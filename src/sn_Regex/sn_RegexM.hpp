@@ -2,162 +2,583 @@
 #define SN_REGEX_M_H
 
 #include "../sn_CommonHeader.h"
-#include "../sn_Meta/constexpr_control.hpp"
+#include <array>
+#include <string_view>
 
 // ref: https://zhuanlan.zhihu.com/p/28484185
+// ref: https://github.com/hanickadot/compile-time-regular-expressions
+// Whole pipeline at compile time: pattern -> Glushkov automaton -> subset construction -> Moore
+// minimization -> a constexpr transition table over byte classes. Nothing is built at runtime and
+// everything is usable in constant expressions:
+//     static_assert("[0-9]+-[a-z]*"_regex.match("42-ab"));
+// Syntax: literals, ., [...] / [^...] with ranges, \d \w \s \D \W \S \n \t \r \f \v \xHH and escaped
+// punctuation, ( ), |, *, +, ?, {n}, {n,}, {n,m}. No anchors, captures or backreferences.
 namespace sn_Regex {
 
-    using namespace sn_constexpr::control;
-    
     template <char ...Cs>
     struct char_sequence {
-        template <size_t I>
-        constexpr static auto get() {
-            static_assert(i < sizeof...(Cs), "Access out of bound.");
-            return char_constant<std::get<i>(std::make_tuple(Cs...))>{};
-        }
+        constexpr static std::size_t size = sizeof...(Cs);
+        constexpr static char value[sizeof...(Cs) + 1] = { Cs..., '\0' };
     };
 
-    template <typename Seq, size_t I, typename Res>
-    struct parse_result {
-        constexpr static auto sequence() {
-            return Seq{};
-        }
-        constexpr static auto get() {
-            return Seq::get<I>{};
-        }
-        constexpr static auto peek() {
-            return Seq::get<I + 1>{};
-        }
-        constexpr static auto result() {
-            return Res{};
-        }
-        constexpr static auto next() {
-            return parse_result<Seq, I + 1, Res>{};
-        }
-        template <typename R>
-        constexpr static auto result(R) {
-            return parse_result<Seq, I, R>{};
-        }
-    };
-    
-    template <typename T>
-    struct regex {};
+    namespace detail {
 
-    template <char c>
-    struct match : regex<match<c>> {};
+        constexpr const std::size_t max_positions = 63;  // bit 63 of a state marks the start
+        constexpr const std::size_t max_states = 128;
+        constexpr const std::size_t max_classes = 64;
+        constexpr const std::uint64_t start_bit = std::uint64_t(1) << 63;
 
-    template <char c>
-    constexpr auto make_match(char_constant<c>) {
-        return match<c>{};
-    }
+        struct charset {
+            std::uint64_t w[4] = {};
 
-    template <char c>
-    struct kleene : regex<kleene<c>> {};
+            constexpr void set(unsigned char c) {
+                w[c >> 6] |= std::uint64_t(1) << (c & 63);
+            }
+            constexpr void set_range(unsigned char lo, unsigned char hi) {
+                for (unsigned c = lo; c <= hi; ++c)
+                    set(static_cast<unsigned char>(c));
+            }
+            constexpr void merge(const charset& rhs) {
+                for (int k = 0; k < 4; ++k)
+                    w[k] |= rhs.w[k];
+            }
+            constexpr void invert() {
+                for (int k = 0; k < 4; ++k)
+                    w[k] = ~w[k];
+            }
+            constexpr bool test(unsigned char c) const {
+                return (w[c >> 6] >> (c & 63)) & 1;
+            }
+        };
 
-    template <char c>
-    constexpr auto make_kleene(char_constant<c>) {
-        return kleene<c>{};
-    }
+        // Glushkov sets of a sub-expression
+        struct fragment {
+            std::uint64_t first = 0;
+            std::uint64_t last = 0;
+            bool nullable = true;
+        };
 
-    template <typename ...Rs>
-    struct concat : regex<concat<Rs...>> {};
+        struct glushkov {
+            charset sets[max_positions];
+            std::uint64_t follow[max_positions] = {};
+            std::size_t positions = 0;
+            fragment root;
+        };
 
-    template <typename ...Rs>
-    constexpr auto make_concat(regex<Rs>...) {
-        return concat<Rs...>{};
-    }
+        // Recursive descent straight into Glushkov positions; x{n,m} re-parses x for every copy
+        class parser {
+            const char* m_p;
+            std::size_t m_n;
+            std::size_t m_i = 0;
+            glushkov& m_g;
 
-    template <typename ...Rs, typename ...Ts>
-    constexpr auto make_concat(concat<Rs...>, regex<Ts>...) {
-        return concat<Rs..., Ts...>{};
-    }
+            constexpr bool more() const {
+                return m_i < m_n;
+            }
+            constexpr char peek() const {
+                return m_p[m_i];
+            }
+            constexpr char take() {
+                if (!more())
+                    throw std::invalid_argument("Unexpected end of pattern.");
+                return m_p[m_i++];
+            }
 
-    template <typename ...Rs>
-    struct alter : regex<alter<Rs...>> {};
+            // every position of first may be followed by every position of last
+            constexpr void link(std::uint64_t first, std::uint64_t last) {
+                for (std::size_t k = 0; k < m_g.positions; ++k) {
+                    if ((first >> k) & 1)
+                        m_g.follow[k] |= last;
+                }
+            }
 
-    template <typename ...Rs>
-    constexpr auto make_alter(regex<Rs>...) {
-        return alter<Rs...>{};
-    }
+            constexpr fragment sequence(fragment a, fragment b) {
+                link(a.last, b.first);
+                fragment f;
+                f.first = a.first | (a.nullable ? b.first : 0);
+                f.last = b.last | (b.nullable ? a.last : 0);
+                f.nullable = a.nullable && b.nullable;
+                return f;
+            }
 
-    template <typename ...Rs, typename ...Ts>
-    constexpr auto make_alter(alter<Rs...>, regex<Ts>...) {
-        return alter<Rs..., Ts...>{};
-    }
+            constexpr fragment star(fragment a) {
+                link(a.last, a.first);
+                a.nullable = true;
+                return a;
+            }
 
-    template<typename Res>
-    constexpr static auto parse_kleene(Res r) {
-        auto token = r.get();
-        auto next = r.peek();
-        return cond(
-            next == char_constant<'*'>{},
-            [=] { 
-                return r.forward().forward().result(make_kleene(token)); 
-            },
-            [=] { 
-                return r.forward().result(make_match(token)); 
-            }
-        )();
-    }
+            constexpr fragment position(const charset& s) {
+                if (m_g.positions == max_positions)
+                    throw std::length_error("Pattern has too many positions for the compile-time DFA.");
+                const std::size_t k = m_g.positions++;
+                m_g.sets[k] = s;
+                fragment f;
+                f.first = f.last = std::uint64_t(1) << k;
+                f.nullable = false;
+                return f;
+            }
+
+            static constexpr int hex(char c) {
+                return c >= '0' && c <= '9' ? c - '0'
+                    : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                    : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                    : throw std::invalid_argument("Bad \\x escape.");
+            }
+
+            // after the backslash
+            constexpr charset escape() {
+                charset s;
+                const char c = take();
+                switch (c) {
+                case 'd': case 'D':
+                    s.set_range('0', '9');
+                    break;
+                case 'w': case 'W':
+                    s.set_range('0', '9');
+                    s.set_range('a', 'z');
+                    s.set_range('A', 'Z');
+                    s.set('_');
+                    break;
+                case 's': case 'S':
+                    for (char k : { ' ', '\t', '\n', '\r', '\f', '\v' })
+                        s.set(static_cast<unsigned char>(k));
+                    break;
+                case 'n': s.set('\n'); break;
+                case 't': s.set('\t'); break;
+                case 'r': s.set('\r'); break;
+                case 'f': s.set('\f'); break;
+                case 'v': s.set('\v'); break;
+                case '0': s.set('\0'); break;
+                case 'x': {
+                    const int hi = hex(take());
+                    const int lo = hex(take());
+                    s.set(static_cast<unsigned char>(hi * 16 + lo));
+                    break;
+                }
+                default:
+                    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))
+                        throw std::invalid_argument("Unknown escape.");
+                    s.set(static_cast<unsigned char>(c));
+                }
+                if (c == 'D' || c == 'W' || c == 'S')
+                    s.invert();
+                return s;
+            }
+
+            // after the '['
+            constexpr charset bracket() {
+                charset s;
+                bool negate = false;
+                if (more() && peek() == '^') {
+                    negate = true;
+                    ++m_i;
+                }
+                bool first = true;
+                while (first || peek() != ']') {
+                    if (!more())
+                        throw std::invalid_argument("Missing ].");
+                    first = false;
+                    char c = take();
+                    if (c == '\\') {
+                        const charset e = escape();
+                        const char k = m_p[m_i - 1];
+                        const bool single = !(k == 'd' || k == 'D' || k == 'w' || k == 'W' || k == 's' || k == 'S');
+                        if (!single || !more() || peek() != '-' || m_i + 1 >= m_n || m_p[m_i + 1] == ']') {
+                            s.merge(e);
+                            continue;
+                        }
+                        for (unsigned b = 0; b < 256; ++b) {
+                            if (e.test(static_cast<unsigned char>(b)))
+                                c = static_cast<char>(b);
+                        }
+                    }
+                    if (more() && peek() == '-' && m_i + 1 < m_n && m_p[m_i + 1] != ']') {
+                        ++m_i;
+                        char hi = take();
+                        if (hi == '\\') {
+                            const charset e = escape();
+                            for (unsigned b = 0; b < 256; ++b) {
+                                if (e.test(static_cast<unsigned char>(b)))
+                                    hi = static_cast<char>(b);
+                            }
+                        }
+                        if (static_cast<unsigned char>(hi) < static_cast<unsigned char>(c))
+                            throw std::invalid_argument("Bad range in [].");
+                        s.set_range(static_cast<unsigned char>(c), static_cast<unsigned char>(hi));
+                    }
+                    else {
+                        s.set(static_cast<unsigned char>(c));
+                    }
+                }
+                ++m_i;
+                if (negate)
+                    s.invert();
+                return s;
+            }
+
+            constexpr fragment atom() {
+                const char c = take();
+                switch (c) {
+                case '(': {
+                    if (more() && peek() == '?') {
+                        if (m_i + 1 >= m_n || m_p[m_i + 1] != ':')
+                            throw std::invalid_argument("Only (?:...) groups are supported.");
+                        m_i += 2;
+                    }
+                    const fragment f = alternation();
+                    if (take() != ')')
+                        throw std::invalid_argument("Missing ).");
+                    return f;
+                }
+                case '[':
+                    return position(bracket());
+                case '.': {
+                    charset s;
+                    s.set('\n');
+                    s.invert();
+                    return position(s);
+                }
+                case '\\':
+                    return position(escape());
+                case ')': case '*': case '+': case '?': case '{': case '|':
+                    throw std::invalid_argument("Nothing to repeat or unbalanced ).");
+                case '^': case '$':
+                    throw std::invalid_argument("Anchors are not supported, match() is anchored and search() is not.");
+                default: {
+                    charset s;
+                    s.set(static_cast<unsigned char>(c));
+                    return position(s);
+                }
+                }
+            }
+
+            constexpr std::size_t number() {
+                std::size_t v = 0;
+                if (!more() || peek() < '0' || peek() > '9')
+                    throw std::invalid_argument("Bad {n,m}.");
+                while (more() && peek() >= '0' && peek() <= '9')
+                    v = v * 10 + static_cast<std::size_t>(take() - '0');
+                return v;
+            }
+
+            constexpr fragment repetition() {
+                const std::size_t start = m_i;
+                fragment f = atom();
+                const std::size_t end = m_i;
+                while (more()) {
+                    const char c = peek();
+                    if (c == '*' || c == '+') {
+                        ++m_i;
+                        const bool nullable = f.nullable;
+                        f = star(f);
+                        if (c == '+')
+                            f.nullable = nullable;
+                    }
+                    else if (c == '?') {
+                        ++m_i;
+                        f.nullable = true;
+                    }
+                    else if (c == '{') {
+                        ++m_i;
+                        const std::size_t n = number();
+                        std::size_t m = n;
+                        bool unbounded = false;
+                        if (more() && peek() == ',') {
+                            ++m_i;
+                            if (more() && peek() == '}')
+                                unbounded = true;
+                            else
+                                m = number();
+                        }
+                        if (take() != '}' || m < n)
+                            throw std::invalid_argument("Bad {n,m}.");
+                        const std::size_t after = m_i;
+                        // fresh positions for every copy past the first
+                        fragment res;
+                        for (std::size_t k = 0; k < (unbounded ? n + 1 : m); ++k) {
+                            fragment piece = f;
+                            if (k > 0) {
+                                m_i = start;
+                                piece = atom();
+                                m_i = end;
+                            }
+                            if (unbounded && k == n)
+                                piece = star(piece);
+                            else if (k >= n)
+                                piece.nullable = true;
+                            res = sequence(res, piece);
+                        }
+                        m_i = after;
+                        f = res;
+                    }
+                    else {
+                        break;
+                    }
+                }
+                return f;
+            }
 
-    template<class Res>
-    constexpr static auto parse_concatination(Res r)
-    {
-        return iter(
-            parse_kleene(r),
-            [](auto res) {
-                return (res.get() != char_constant<'\0'>{}) && (res.get() != char_constant<'|'>{});
-            },
-            [](auto res) {
-                auto e = parse_kleene(res);
-                return e.result(make_concat(res.result(), e.result()));
-            }
-        );
-        /* 相当于
-        auto regex = make_concat(parse_kleene(r));
-        static_for (;;) {
-            if (r.get() ！= '\0' && r.get() != '|') {
-                regex = make_concat(regex, parse_kleene(r.forward()));
-            }
-            else {
-                return regex;
+            constexpr fragment concatenation() {
+                fragment f;
+                while (more() && peek() != '|' && peek() != ')')
+                    f = sequence(f, repetition());
+                return f;
             }
+
+        public:
+            constexpr parser(const char* p, std::size_t n, glushkov& g) : m_p(p), m_n(n), m_g(g) {}
+
+            constexpr fragment alternation() {
+                fragment f = concatenation();
+                while (more() && peek() == '|') {
+                    ++m_i;
+                    const fragment g = concatenation();
+                    f.first |= g.first;
+                    f.last |= g.last;
+                    f.nullable = f.nullable || g.nullable;
+                }
+                return f;
+            }
+
+            constexpr void parse() {
+                m_g.root = alternation();
+                if (more())
+                    throw std::invalid_argument("Unbalanced ).");
+            }
+        };
+
+        // Transition table before it is cut to size; state 0 is dead
+        struct dfa_builder {
+            unsigned char cls[256] = {};
+            std::size_t classes = 0;
+            std::uint64_t sets[max_states] = {};
+            std::uint16_t next[max_states][max_classes] = {};
+            bool accept[max_states] = {};
+            std::size_t states = 0;
+            std::size_t start = 0;
+        };
+
+        // floating: the start position stays in every state, so a match may begin anywhere
+        constexpr dfa_builder build(const char* pattern, std::size_t size, bool floating) {
+            glushkov g;
+            parser(pattern, size, g).parse();
+
+            // bytes no position tells apart share a class
+            dfa_builder d;
+            std::uint64_t signature[256] = {};
+            std::uint64_t class_mask[max_classes] = {};
+            for (unsigned b = 0; b < 256; ++b) {
+                std::uint64_t sig = 0;
+                for (std::size_t k = 0; k < g.positions; ++k) {
+                    if (g.sets[k].test(static_cast<unsigned char>(b)))
+                        sig |= std::uint64_t(1) << k;
+                }
+                std::size_t c = 0;
+                while (c < d.classes && signature[c] != sig)
+                    ++c;
+                if (c == d.classes) {
+                    if (d.classes == max_classes)
+                        throw std::length_error("Pattern has too many byte classes for the compile-time DFA.");
+                    signature[d.classes] = sig;
+                    class_mask[d.classes] = sig;
+                    ++d.classes;
+                }
+                d.cls[b] = static_cast<unsigned char>(c);
+            }
+
+            auto accepting = [&g](std::uint64_t s) {
+                return (s & g.root.last) != 0 || ((s & start_bit) && g.root.nullable);
+            };
+            d.sets[0] = 0;
+            d.sets[1] = start_bit;
+            d.accept[1] = accepting(start_bit);
+            d.states = 2;
+            d.start = 1;
+            for (std::size_t q = 1; q < d.states; ++q) {
+                const std::uint64_t s = d.sets[q];
+                for (std::size_t c = 0; c < d.classes; ++c) {
+                    std::uint64_t t = (s & start_bit) ? g.root.first : 0;
+                    for (std::size_t k = 0; k < g.positions; ++k) {
+                        if ((s >> k) & 1)
+                            t |= g.follow[k];
+                    }
+                    t &= class_mask[c];
+                    if (floating)
+                        t |= start_bit;
+                    std::size_t r = 0;
+                    while (r < d.states && d.sets[r] != t)
+                        ++r;
+                    if (r == d.states) {
+                        if (d.states == max_states)
+                            throw std::length_error("Pattern needs too many states for the compile-time DFA.");
+                        d.sets[r] = t;
+                        d.accept[r] = accepting(t);
+                        ++d.states;
+                    }
+                    d.next[q][c] = static_cast<std::uint16_t>(r);
+                }
+            }
+            for (std::size_t c = 0; c < d.classes; ++c)
+                d.next[0][c] = 0;
+
+            // Moore: split blocks until no two states in one block step to different blocks
+            std::size_t block[max_states] = {};
+            std::size_t blocks = 0;
+            for (std::size_t q = 0; q < d.states; ++q)
+                block[q] = d.accept[q] ? 1 : 0;
+            for (;;) {
+                std::size_t refined[max_states] = {};
+                std::size_t count = 0;
+                for (std::size_t q = 0; q < d.states; ++q) {
+                    std::size_t r = 0;
+                    for (; r < q; ++r) {
+                        if (block[r] != block[q])
+                            continue;
+                        bool same = true;
+                        for (std::size_t c = 0; c < d.classes && same; ++c)
+                            same = block[d.next[r][c]] == block[d.next[q][c]];
+                        if (same)
+                            break;
+                    }
+                    refined[q] = r < q ? refined[r] : count++;
+                }
+                const bool stable = count == blocks;
+                blocks = count;
+                for (std::size_t q = 0; q < d.states; ++q)
+                    block[q] = refined[q];
+                if (stable)
+                    break;
+            }
+
+            // dead block first, start next
+            dfa_builder m;
+            m.classes = d.classes;
+            for (unsigned b = 0; b < 256; ++b)
+                m.cls[b] = d.cls[b];
+            std::size_t id[max_states] = {};
+            bool seen[max_states] = {};
+            std::size_t n = 0;
+            auto visit = [&](std::size_t b) {
+                if (!seen[b]) {
+                    seen[b] = true;
+                    id[b] = n++;
+                }
+            };
+            visit(block[0]);
+            visit(block[d.start]);
+            for (std::size_t q = 0; q < d.states; ++q)
+                visit(block[q]);
+            for (std::size_t q = 0; q < d.states; ++q) {
+                const std::size_t s = id[block[q]];
+                m.accept[s] = d.accept[q];
+                for (std::size_t c = 0; c < d.classes; ++c)
+                    m.next[s][c] = static_cast<std::uint16_t>(id[block[d.next[q][c]]]);
+            }
+            m.states = n;
+            m.start = id[block[d.start]];
+            return m;
         }
-        */
     }
 
+    // Minimal DFA cut to size; state 0 is dead
+    template <std::size_t States, std::size_t Classes>
+    struct dfa {
+        using state_type = std::conditional_t<(States <= 256), std::uint8_t, std::uint16_t>;
+
+        std::array<unsigned char, 256> cls = {};
+        std::array<std::array<state_type, Classes>, States> next = {};
+        std::array<bool, States> accept = {};
+        std::size_t start = 0;
 
-    struct regex_parser {
-        template <typename Seq>
-        constexpr static auto parse(Seq s) {
-            return parse_alternative(parse_result<Seq, 0, void>{});
+        constexpr static dfa from(const detail::dfa_builder& b) {
+            dfa d;
+            for (std::size_t k = 0; k < 256; ++k)
+                d.cls[k] = b.cls[k];
+            for (std::size_t q = 0; q < States; ++q) {
+                d.accept[q] = b.accept[q];
+                for (std::size_t c = 0; c < Classes; ++c)
+                    d.next[q][c] = static_cast<state_type>(b.next[q][c]);
+            }
+            d.start = b.start;
+            return d;
         }
-    private:
-        template <typename Res>
-        constexpr static auto parse_alternative(Res r) {
-            return iter(
-                parse_concatination(r),
-                [](auto res) {
-                    return res.get() != char_constant<'\0'>{};
-                },
-                [](auto res) {
-                    static_assert((res.get() == char_constant<'|'>{})::value);
-                    auto e = parse_concatination(res.forward());
-                    return e.result(make_alter(res.result(), e.result()));
-                }
-            );
+
+        constexpr bool match(std::string_view s) const {
+            std::size_t q = start;
+            for (char ch : s) {
+                q = next[q][cls[static_cast<unsigned char>(ch)]];
+                if (q == 0)
+                    return false;
+            }
+            return accept[q];
         }
 
-#if defined(__GNUC__)
-        template<typename TChar, TChar... chars>
-        constexpr decltype(auto) operator"" _regex() {
-            return regex_parser::parse(char_sequence<chars..., '\0'>{}).result();
+        // for a table built floating: stops at the first position some match ends
+        constexpr bool search(std::string_view s) const {
+            std::size_t q = start;
+            if (accept[q])
+                return true;
+            for (char ch : s) {
+                q = next[q][cls[static_cast<unsigned char>(ch)]];
+                if (accept[q])
+                    return true;
+            }
+            return false;
         }
-#endif
+
+        // Longest prefix of s in the language, npos if none (anchored table)
+        constexpr std::size_t prefix(std::string_view s) const {
+            std::size_t q = start;
+            std::size_t best = accept[q] ? 0 : std::string_view::npos;
+            for (std::size_t i = 0; i < s.size(); ++i) {
+                q = next[q][cls[static_cast<unsigned char>(s[i])]];
+                if (q == 0)
+                    break;
+                if (accept[q])
+                    best = i + 1;
+            }
+            return best;
+        }
+    };
+
+    // The tables are static members, built only when the matching function is used
+    template <char ...Cs>
+    struct static_regex {
+        constexpr static std::string_view pattern() {
+            return std::string_view(char_sequence<Cs...>::value, sizeof...(Cs));
+        }
+
+        constexpr static bool match(std::string_view s) {
+            return anchored.match(s);
+        }
+        constexpr static std::size_t prefix(std::string_view s) {
+            return anchored.prefix(s);
+        }
+        constexpr static bool search(std::string_view s) {
+            return floating.search(s);
+        }
+
+        constexpr static std::size_t state_count() {
+            return anchored_builder.states;
+        }
+
+    private:
+        constexpr static detail::dfa_builder anchored_builder = detail::build(char_sequence<Cs...>::value, sizeof...(Cs), false);
+        constexpr static dfa<anchored_builder.states, anchored_builder.classes> anchored = dfa<anchored_builder.states, anchored_builder.classes>::from(anchored_builder);
+        constexpr static detail::dfa_builder floating_builder = detail::build(char_sequence<Cs...>::value, sizeof...(Cs), true);
+        constexpr static dfa<floating_builder.states, floating_builder.classes> floating = dfa<floating_builder.states, floating_builder.classes>::from(floating_builder);
     };
 
+#if defined(__GNUC__)
+    // GNU extension (string literal operator template)
+    template <typename TChar, TChar ...Cs>
+    constexpr auto operator"" _regex() {
+        static_assert(std::is_same<TChar, char>::value, "Only narrow string patterns.");
+        return static_regex<Cs...>{};
+    }
+#endif
+
 }
 
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,16 @@
 #define SN_REGEX_V_H
 
 #include "sn_CommonHeader.h"
+#include <cstring>
+#include <climits>
+#include <bitset>
+#include <array>
+#include <string_view>
+#include <thread>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 // ref: Ninputer/VBF
 // Totally pass-by-value... unlike C#, it's hard to manager reference
@@ -11,7 +21,7 @@ namespace sn_RegexV {
 	namespace REN {
 
 		enum class RegularExpressionType {
-			Empty, Symbol, Alternation, Concatenation, KleeneStar, AlternationCharSet, StringLiteral,
+			Empty, Symbol, Alternation, Concatenation, KleeneStar, AlternationCharSet, StringLiteral, Capture,
 		};
 
 		using RET = RegularExpressionType;
@@ -19,206 +29,231 @@ namespace sn_RegexV {
 		template <typename T>
 		class RegularExpressionConverter;
 
+		// Tag for reading a RegularExpression through one of the typed classes below
+		struct ExpressionView {};
+
+		// Every node keeps its data in the base (sub-expressions shared), so copies through
+		// RegularExpression lose nothing and the derived classes are typed views over it
 		class RegularExpression {
 		public:
 			template <typename T>
-			virtual T Accept(RegularExpressionConverter<T> converter) {}
+			T Accept(RegularExpressionConverter<T>& converter) const {
+				return converter.Convert(*this);
+			}
 
-			RET ExpressionType() {
+			RET ExpressionType() const {
 				return m_expType;
 			}
 
-			static RegularExpression Symbol(char c) {
-				return SymbolExpression(c);
-			}
-			RegularExpression Many() {
-				if (m_expType == RegularExpressionType::KleeneStar)
-					return *this;
-				return KleeneStarExpression(*this);
-			}
-			RegularExpression Concat(RegularExpression follow) {
-				return ConcatenationExpression(*this, follow);
-			}
-			RegularExpression Union(RegularExpression rhs) {
-				if (this == std::addressof(rhs))
-					return *this;
-				return AlternationExpression(*this, rhs);
-			}
-			static RegularExpression Literal(std::string literal) {
-				return StringLiteralExpression(literal);
-			}
-			static RegularExpression CharSet(const char* charSet) {
-				return AlternationCharSetExpression(charSet);
-			}
-			static RegularExpression Empty() {
-				return EmptyExpression();
-			}
+			static RegularExpression Symbol(char c);
+			RegularExpression Many() const;
+			RegularExpression Concat(RegularExpression follow) const;
+			RegularExpression Union(RegularExpression rhs) const;
+			static RegularExpression Literal(std::string literal);
+			static RegularExpression CharSet(const char* charSet);
+			static RegularExpression Empty();
+			// Submatch group, 0 is the whole match and is added by the compiler
+			RegularExpression Capture(std::size_t group) const;
 
-			RegularExpression Many1() {
+			RegularExpression Many1() const {
 				return this->Concat(this->Many());
 			}
-			RegularExpression Optional() {
+			RegularExpression Optional() const {
 				return this->Union(Empty());
 			}
-			static RegularExpression Range(char min, char max) {
-				std::vector<char> rangeCharSet;
-				for (char c = min; c <= max; ++c) {
-					rangeCharSet.push_back(c);
-				}
-				return AlternationCharSetExpression(rangeCharSet);
-			}
-			static RegularExpression CharsOf(std::function<bool(char)> charPredicate) {
-				std::vector<char> rangeCharSet;
-				for (char c = CHAR_MIN; c <= CHAR_MAX; ++c) {
-					if (charPredicate(c))
-						rangeCharSet.push_back(c);
-				}
-				return AlternationCharSetExpression(rangeCharSet);
-			}
-
+			static RegularExpression Range(char min, char max);
+			static RegularExpression CharsOf(std::function<bool(char)> charPredicate);
 
 		protected:
 			RegularExpression(RegularExpressionType expType) {
 				m_expType = expType;
 			}
 
-		private:
 			RegularExpressionType m_expType;
-
+			std::shared_ptr<const RegularExpression> m_exp1, m_exp2;
+			std::shared_ptr<const std::vector<char>> m_charSet;
+			std::shared_ptr<const std::string> m_string;
+			std::size_t m_group = 0;
+			char m_symbol = 0;
 		};
 
-		RegularExpression operator|(RegularExpression l, RegularExpression r) {
-			return AlternationExpression(l, r);
-		}
-		RegularExpression operator+(RegularExpression l, RegularExpression r) {
-			return ConcatenationExpression(l, r);
-		}
-
-
 		class EmptyExpression final : public RegularExpression {
 		public:
 			EmptyExpression() : RegularExpression(RET::Empty) {}
+			EmptyExpression(const RegularExpression& exp, ExpressionView) : RegularExpression(exp) {}
 		};
 
 		class AlternationExpression final : public RegularExpression {
 		public:
 			AlternationExpression(RegularExpression exp1, RegularExpression exp2)
-				: m_exp1(exp1), m_exp2(exp2), RegularExpression(RET::Alternation) {}
-			RegularExpression Expression1() {
-				return m_exp1;
+				: RegularExpression(RET::Alternation) {
+				m_exp1 = std::make_shared<const RegularExpression>(exp1);
+				m_exp2 = std::make_shared<const RegularExpression>(exp2);
 			}
-			RegularExpression Expression2() {
-				return m_exp2;
+			AlternationExpression(const RegularExpression& exp, ExpressionView) : RegularExpression(exp) {}
+			const RegularExpression& Expression1() const {
+				return *m_exp1;
 			}
-			template <typename T>
-			T Accept(RegularExpressionConverter<T> converter) {
-				return converter.ConverterAlternation(*this);
+			const RegularExpression& Expression2() const {
+				return *m_exp2;
 			}
-		private:
-			RegularExpression m_exp1;
-			RegularExpression m_exp2;
 		};
 
 		class ConcatenationExpression final : public RegularExpression {
 		public:
 			ConcatenationExpression(RegularExpression exp1, RegularExpression exp2)
-				: m_expL(exp1), m_expR(exp2), RegularExpression(RET::Concatenation) {}
-			RegularExpression ExpressionL() {
-				return m_expL;
+				: RegularExpression(RET::Concatenation) {
+				m_exp1 = std::make_shared<const RegularExpression>(exp1);
+				m_exp2 = std::make_shared<const RegularExpression>(exp2);
 			}
-			RegularExpression ExpressionR() {
-				return m_expR;
+			ConcatenationExpression(const RegularExpression& exp, ExpressionView) : RegularExpression(exp) {}
+			const RegularExpression& ExpressionL() const {
+				return *m_exp1;
 			}
-			template <typename T>
-			T Accept(RegularExpressionConverter<T> converter) {
-				return converter.ConvertConcatenation(*this);
+			const RegularExpression& ExpressionR() const {
+				return *m_exp2;
 			}
-		private:
-			RegularExpression m_expL;
-			RegularExpression m_expR;
 		};
 
 		class KleeneStarExpression final : public RegularExpression {
 		public:
 			KleeneStarExpression(RegularExpression innerExp)
-				: RegularExpression(RET::KleeneStar), m_exp(innerExp) {}
-			RegularExpression InnerExpression() {
-				return m_exp;
+				: RegularExpression(RET::KleeneStar) {
+				m_exp1 = std::make_shared<const RegularExpression>(innerExp);
 			}
-			template <typename T>
-			T Accept(RegularExpressionConverter<T> converter) {
-				return converter.ConvertKleeneStar(*this);
+			KleeneStarExpression(const RegularExpression& exp, ExpressionView) : RegularExpression(exp) {}
+			const RegularExpression& InnerExpression() const {
+				return *m_exp1;
 			}
-		private:
-			RegularExpression m_exp;
 		};
 
 		class SymbolExpression final : public RegularExpression {
 		public:
-			SymbolExpression(char symbol) : RegularExpression(RegularExpressionType::Symbol), m_symbol(symbol) {}
-
-			char Symbol() {
-				return m_symbol;
+			SymbolExpression(char symbol) : RegularExpression(RegularExpressionType::Symbol) {
+				m_symbol = symbol;
 			}
+			SymbolExpression(const RegularExpression& exp, ExpressionView) : RegularExpression(exp) {}
 
-			template <typename T>
-			T Accept(RegularExpressionConverter<T> converter) {
-				return converter.ConvertSymbol(*this);
+			char Symbol() const {
+				return m_symbol;
 			}
-		private:
-			char m_symbol;
 		};
 
 		class AlternationCharSetExpression final : public RegularExpression {
 		public:
 			AlternationCharSetExpression(std::vector<char> charSet)
-				: RegularExpression(RegularExpressionType::AlternationCharSet), m_charSet(charSet) {}
+				: RegularExpression(RegularExpressionType::AlternationCharSet) {
+				m_charSet = std::make_shared<const std::vector<char>>(std::move(charSet));
+			}
 			AlternationCharSetExpression(const char* charSet)
 				: RegularExpression(RegularExpressionType::AlternationCharSet) {
+				std::vector<char> set;
 				const char* p = charSet;
 				while (*p != '\0') {
-					m_charSet.push_back(*p);
+					set.push_back(*p);
 					++p;
 				}
+				m_charSet = std::make_shared<const std::vector<char>>(std::move(set));
 			}
+			AlternationCharSetExpression(const RegularExpression& exp, ExpressionView) : RegularExpression(exp) {}
 
-
-			std::vector<char> CharSet() {
-				return m_charSet;
+			const std::vector<char>& CharSet() const {
+				return *m_charSet;
 			}
-
-			template <typename T>
-			T Accept(RegularExpressionConverter<T> converter) {
-				return converter.ConvertAlternationCharSet(*this);
-			}
-		private:
-			std::vector<char> m_charSet;
 		};
 
 		class StringLiteralExpression final : public RegularExpression {
 		public:
 			StringLiteralExpression(std::string str)
-				: RegularExpression(RegularExpressionType::StringLiteral), m_string(str) {}
+				: RegularExpression(RegularExpressionType::StringLiteral) {
+				m_string = std::make_shared<const std::string>(std::move(str));
+			}
+			StringLiteralExpression(const RegularExpression& exp, ExpressionView) : RegularExpression(exp) {}
 
-			std::string String() {
-				return m_string;
+			const std::string& String() const {
+				return *m_string;
 			}
+		};
 
-			template <typename T>
-			T Accept(RegularExpressionConverter<T> converter) {
-				return converter.ConvertStringLiteral(*this);
+		class CaptureExpression final : public RegularExpression {
+		public:
+			CaptureExpression(RegularExpression innerExp, std::size_t group)
+				: RegularExpression(RET::Capture) {
+				m_exp1 = std::make_shared<const RegularExpression>(innerExp);
+				m_group = group;
+			}
+			CaptureExpression(const RegularExpression& exp, ExpressionView) : RegularExpression(exp) {}
+			const RegularExpression& InnerExpression() const {
+				return *m_exp1;
+			}
+			std::size_t Group() const {
+				return m_group;
 			}
-		private:
-			std::string m_string;
 		};
 
+		inline RegularExpression RegularExpression::Symbol(char c) {
+			return SymbolExpression(c);
+		}
+		inline RegularExpression RegularExpression::Many() const {
+			if (m_expType == RegularExpressionType::KleeneStar)
+				return *this;
+			return KleeneStarExpression(*this);
+		}
+		inline RegularExpression RegularExpression::Concat(RegularExpression follow) const {
+			return ConcatenationExpression(*this, follow);
+		}
+		inline RegularExpression RegularExpression::Union(RegularExpression rhs) const {
+			return AlternationExpression(*this, rhs);
+		}
+		inline RegularExpression RegularExpression::Literal(std::string literal) {
+			return StringLiteralExpression(literal);
+		}
+		inline RegularExpression RegularExpression::CharSet(const char* charSet) {
+			return AlternationCharSetExpression(charSet);
+		}
+		inline RegularExpression RegularExpression::Empty() {
+			return EmptyExpression();
+		}
+		inline RegularExpression RegularExpression::Capture(std::size_t group) const {
+			return CaptureExpression(*this, group);
+		}
+		inline RegularExpression RegularExpression::Range(char min, char max) {
+			std::vector<char> rangeCharSet;
+			for (int c = min; c <= max; ++c) {
+				rangeCharSet.push_back(static_cast<char>(c));
+			}
+			return AlternationCharSetExpression(rangeCharSet);
+		}
+		inline RegularExpression RegularExpression::CharsOf(std::function<bool(char)> charPredicate) {
+			std::vector<char> rangeCharSet;
+			for (int c = CHAR_MIN; c <= CHAR_MAX; ++c) {
+				if (charPredicate(static_cast<char>(c)))
+					rangeCharSet.push_back(static_cast<char>(c));
+			}
+			return AlternationCharSetExpression(rangeCharSet);
+		}
+
+		inline RegularExpression operator|(RegularExpression l, RegularExpression r) {
+			return AlternationExpression(l, r);
+		}
+		inline RegularExpression operator+(RegularExpression l, RegularExpression r) {
+			return ConcatenationExpression(l, r);
+		}
+
 		template <typename T>
 		class RegularExpressionConverter {
 		public:
-			T Convert(RegularExpression exp) {
-				if (exp == NULL)
-					return T();
-				return exp.Accept(*this);
+			T Convert(const RegularExpression& exp) {
+				switch (exp.ExpressionType()) {
+				case RET::Alternation: return ConvertAlternation(AlternationExpression(exp, ExpressionView()));
+				case RET::Symbol: return ConvertSymbol(SymbolExpression(exp, ExpressionView()));
+				case RET::Concatenation: return ConvertConcatenation(ConcatenationExpression(exp, ExpressionView()));
+				case RET::AlternationCharSet: return ConvertAlternationCharSet(AlternationCharSetExpression(exp, ExpressionView()));
+				case RET::StringLiteral: return ConvertStringLiteral(StringLiteralExpression(exp, ExpressionView()));
+				case RET::KleeneStar: return ConvertKleeneStar(KleeneStarExpression(exp, ExpressionView()));
+				case RET::Capture: return ConvertCapture(CaptureExpression(exp, ExpressionView()));
+				default: return ConvertEmpty(EmptyExpression(exp, ExpressionView()));
+				}
 			}
 			virtual T ConvertAlternation(AlternationExpression) = 0;
 			virtual T ConvertSymbol(SymbolExpression) = 0;
@@ -227,12 +262,20 @@ namespace sn_RegexV {
 			virtual T ConvertAlternationCharSet(AlternationCharSetExpression) = 0;
 			virtual T ConvertStringLiteral(StringLiteralExpression) = 0;
 			virtual T ConvertKleeneStar(KleeneStarExpression) = 0;
+			// Groups only matter to the matcher, other converters see through them
+			virtual T ConvertCapture(CaptureExpression exp) {
+				return Convert(exp.InnerExpression());
+			}
+			virtual ~RegularExpressionConverter() {}
 		protected:
 			RegularExpressionConverter() {}
 		};
 
 	}
 
+	// Unfinished port of VBF's lexer generator: NFAState / NFAEdge and Lexicon / Lexer hold each other
+	// by value and do not compile yet, define SN_REGEX_V_VBF_LEXER to work on them
+#ifdef SN_REGEX_V_VBF_LEXER
 	namespace NFA {
 		using namespace REN;
 
@@ -878,7 +921,1479 @@ namespace sn_RegexV {
 		}*/
 
 	}
+#endif
+
+	// Pattern strings -> RegularExpression
+	// <Regex>  ::= <Seq> ( '|' <Seq> )*
+	// <Seq>    ::= <Factor>*
+	// <Factor> ::= <Atom> ( '*' | '+' | '?' | '{' <Num> ( ',' <Num>? )? '}' )*
+	// <Atom>   ::= '(' '?:'? <Regex> ')' | '[' '^'? <Item>+ ']' | '.' | '\' <Escape> | <Char>
+	namespace Parse {
+		using namespace REN;
+
+		class ParserException : public std::exception {
+		public:
+			const char* what() const noexcept override {
+				return "Invalid regular expression.";
+			}
+		};
+
+		class Parser {
+		public:
+			constexpr static const int max_repeat = 1000;
+
+			RegularExpression operator()(const std::string& str) {
+				m_iter = str.data();
+				m_end = str.data() + str.size();
+				m_group = 0;
+				RegularExpression re = Regex();
+				if (More())
+					throw ParserException();
+				return re;
+			}
+			std::size_t Groups() const {
+				return m_group;
+			}
+
+		private:
+			const char* m_iter;
+			const char* m_end;
+			std::size_t m_group;
+
+			bool More() const {
+				return m_iter != m_end;
+			}
+			char Next() {
+				if (!More())
+					throw ParserException();
+				return *m_iter++;
+			}
+
+			RegularExpression Regex() {
+				RegularExpression re = Seq();
+				while (More() && *m_iter == '|') {
+					++m_iter;
+					re = re.Union(Seq());
+				}
+				return re;
+			}
+
+			RegularExpression Seq() {
+				RegularExpression re = RegularExpression::Empty();
+				bool empty = true;
+				while (More() && *m_iter != '|' && *m_iter != ')') {
+					RegularExpression f = Factor();
+					re = empty ? f : re.Concat(f);
+					empty = false;
+				}
+				return re;
+			}
+
+			RegularExpression Factor() {
+				RegularExpression re = Atom();
+				while (More()) {
+					if (*m_iter == '*') {
+						re = re.Many();
+						++m_iter;
+					}
+					else if (*m_iter == '+') {
+						re = re.Many1();
+						++m_iter;
+					}
+					else if (*m_iter == '?') {
+						re = re.Optional();
+						++m_iter;
+					}
+					else if (*m_iter == '{') {
+						++m_iter;
+						re = Repeat(re);
+					}
+					else
+						break;
+				}
+				return re;
+			}
+
+			// x{n}, x{n,}, x{n,m}
+			RegularExpression Repeat(const RegularExpression& re) {
+				const int n = Num();
+				int m = n;
+				bool unbounded = false;
+				if (More() && *m_iter == ',') {
+					++m_iter;
+					if (More() && *m_iter == '}')
+						unbounded = true;
+					else
+						m = Num();
+				}
+				if (Next() != '}' || m < n)
+					throw ParserException();
+				RegularExpression ret = RegularExpression::Empty();
+				for (int i = 0; i < n; ++i)
+					ret = i == 0 ? re : ret.Concat(re);
+				// x{n,m} = x..x (x(x(x)?)?)?
+				bool empty = !unbounded;
+				RegularExpression tail = unbounded ? re.Many() : RegularExpression::Empty();
+				for (int i = n; i < m; ++i) {
+					tail = (empty ? re : re.Concat(tail)).Optional();
+					empty = false;
+				}
+				if (n == 0)
+					return tail;
+				return empty ? ret : ret.Concat(tail);
+			}
+			int Num() {
+				int ret = 0;
+				if (!More() || *m_iter < '0' || *m_iter > '9')
+					throw ParserException();
+				while (More() && *m_iter >= '0' && *m_iter <= '9') {
+					ret = ret * 10 + (*m_iter++ - '0');
+					if (ret > max_repeat)
+						throw ParserException();
+				}
+				return ret;
+			}
+
+			RegularExpression Atom() {
+				const char c = Next();
+				switch (c) {
+				case '(': {
+					RegularExpression re = RegularExpression::Empty();
+					if (m_end - m_iter >= 2 && m_iter[0] == '?' && m_iter[1] == ':') {
+						m_iter += 2;
+						re = Regex();
+					}
+					else {
+						const std::size_t group = ++m_group;
+						re = Regex().Capture(group);
+					}
+					if (Next() != ')')
+						throw ParserException();
+					return re;
+				}
+				case '[':
+					return Class();
+				case '.':
+					return RegularExpression::CharsOf([](char ch) { return ch != '\n'; });
+				case '\\': {
+					std::bitset<256> set;
+					const char e = Next();
+					if (EscapeSet(e, set))
+						return FromSet(set);
+					return RegularExpression::Symbol(EscapeChar(e));
+				}
+				case '*': case '+': case '?': case '{': case ')':
+					throw ParserException();
+				default:
+					return RegularExpression::Symbol(c);
+				}
+			}
+
+			RegularExpression Class() {
+				std::bitset<256> set;
+				bool negate = false;
+				if (More() && *m_iter == '^') {
+					negate = true;
+					++m_iter;
+				}
+				bool first = true;
+				for (;;) {
+					char c = Next();
+					if (c == ']' && !first)
+						break;
+					first = false;
+					if (c == '\\') {
+						const char e = Next();
+						if (EscapeSet(e, set))
+							continue;
+						c = EscapeChar(e);
+					}
+					unsigned char lo = static_cast<unsigned char>(c), hi = lo;
+					if (m_end - m_iter >= 2 && m_iter[0] == '-' && m_iter[1] != ']') {
+						++m_iter;
+						char h = Next();
+						if (h == '\\')
+							h = EscapeChar(Next());
+						hi = static_cast<unsigned char>(h);
+						if (hi < lo)
+							throw ParserException();
+					}
+					for (unsigned b = lo; b <= hi; ++b)
+						set.set(b);
+				}
+				if (negate)
+					set.flip();
+				if (set.none())
+					throw ParserException();
+				return FromSet(set);
+			}
+
+			static RegularExpression FromSet(const std::bitset<256>& set) {
+				std::vector<char> chars;
+				for (unsigned b = 0; b < 256; ++b)
+					if (set.test(b))
+						chars.push_back(static_cast<char>(b));
+				if (chars.size() == 1)
+					return RegularExpression::Symbol(chars[0]);
+				return AlternationCharSetExpression(chars);
+			}
+
+			static bool EscapeSet(char e, std::bitset<256>& set) {
+				std::bitset<256> s;
+				switch (e | 0x20) {
+				case 'd':
+					for (unsigned b = '0'; b <= '9'; ++b)
+						s.set(b);
+					break;
+				case 'w':
+					for (unsigned b = 0; b < 256; ++b)
+						if ((b >= '0' && b <= '9') || (b >= 'a' && b <= 'z') || (b >= 'A' && b <= 'Z') || b == '_')
+							s.set(b);
+					break;
+				case 's':
+					for (unsigned b : {' ', '\t', '\n', '\r', '\f', '\v'})
+						s.set(b);
+					break;
+				default:
+					return false;
+				}
+				if (e >= 'A' && e <= 'Z')
+					s.flip();
+				set |= s;
+				return true;
+			}
+			char EscapeChar(char e) {
+				switch (e) {
+				case 'n': return '\n';
+				case 't': return '\t';
+				case 'r': return '\r';
+				case 'f': return '\f';
+				case 'v': return '\v';
+				case '0': return '\0';
+				case 'x': {
+					int v = 0;
+					for (int i = 0; i < 2; ++i) {
+						const char h = Next();
+						int d;
+						if (h >= '0' && h <= '9')
+							d = h - '0';
+						else if ((h | 0x20) >= 'a' && (h | 0x20) <= 'f')
+							d = (h | 0x20) - 'a' + 10;
+						else
+							throw ParserException();
+						v = v * 16 + d;
+					}
+					return static_cast<char>(v);
+				}
+				default: return e;
+				}
+			}
+		};
+	}
+
+	// What every match has to contain, so the scan can skip ahead before any automaton runs
+	namespace Literal {
+		using namespace REN;
+
+		struct LiteralInfo {
+			bool m_exact = false;    // the expression matches m_prefix and nothing else
+			std::string m_prefix;    // every match starts with it
+			std::string m_suffix;    // every match ends with it
+			std::string m_required;  // every match contains it
+		};
+
+		class LiteralExtractor : public RegularExpressionConverter<LiteralInfo> {
+		public:
+			LiteralInfo ConvertAlternation(AlternationExpression exp) override {
+				const LiteralInfo a = Convert(exp.Expression1());
+				const LiteralInfo b = Convert(exp.Expression2());
+				if (a.m_exact && b.m_exact && a.m_prefix == b.m_prefix)
+					return a;
+				LiteralInfo ret;
+				std::size_t n = 0;
+				while (n < a.m_prefix.size() && n < b.m_prefix.size() && a.m_prefix[n] == b.m_prefix[n])
+					++n;
+				ret.m_prefix = a.m_prefix.substr(0, n);
+				n = 0;
+				while (n < a.m_suffix.size() && n < b.m_suffix.size() &&
+					a.m_suffix[a.m_suffix.size() - 1 - n] == b.m_suffix[b.m_suffix.size() - 1 - n])
+					++n;
+				ret.m_suffix = a.m_suffix.substr(a.m_suffix.size() - n);
+				return Normalize(ret);
+			}
+			LiteralInfo ConvertSymbol(SymbolExpression exp) override {
+				return Exact(std::string(1, exp.Symbol()));
+			}
+			LiteralInfo ConvertEmpty(EmptyExpression) override {
+				return Exact(std::string());
+			}
+			LiteralInfo ConvertConcatenation(ConcatenationExpression exp) override {
+				const LiteralInfo a = Convert(exp.ExpressionL());
+				const LiteralInfo b = Convert(exp.ExpressionR());
+				if (a.m_exact && b.m_exact)
+					return Exact(a.m_prefix + b.m_prefix);
+				LiteralInfo ret;
+				ret.m_prefix = a.m_exact ? a.m_prefix + b.m_prefix : a.m_prefix;
+				ret.m_suffix = b.m_exact ? a.m_suffix + b.m_suffix : b.m_suffix;
+				ret.m_required = Longest(a.m_required, b.m_required);
+				ret.m_required = Longest(ret.m_required, a.m_suffix + b.m_prefix);
+				return Normalize(ret);
+			}
+			LiteralInfo ConvertAlternationCharSet(AlternationCharSetExpression exp) override {
+				const std::vector<char>& set = exp.CharSet();
+				if (!set.empty() && std::all_of(set.begin(), set.end(), [&](char c) { return c == set[0]; }))
+					return Exact(std::string(1, set[0]));
+				return LiteralInfo();
+			}
+			LiteralInfo ConvertStringLiteral(StringLiteralExpression exp) override {
+				return Exact(exp.String());
+			}
+			LiteralInfo ConvertKleeneStar(KleeneStarExpression exp) override {
+				const LiteralInfo a = Convert(exp.InnerExpression());
+				if (a.m_exact && a.m_prefix.empty())
+					return a;
+				return LiteralInfo();
+			}
+
+		private:
+			static LiteralInfo Exact(std::string s) {
+				LiteralInfo ret;
+				ret.m_exact = true;
+				ret.m_prefix = ret.m_suffix = ret.m_required = std::move(s);
+				return ret;
+			}
+			static const std::string& Longest(const std::string& a, const std::string& b) {
+				return b.size() > a.size() ? b : a;
+			}
+			static LiteralInfo Normalize(LiteralInfo info) {
+				info.m_required = Longest(Longest(info.m_required, info.m_prefix), info.m_suffix);
+				return info;
+			}
+		};
+
+		namespace detail {
+			inline int ctz32(uint32_t x) {
+#if defined(__GNUC__)
+				return __builtin_ctz(x);
+#else
+				unsigned long i;
+				_BitScanForward(&i, x);
+				return static_cast<int>(i);
+#endif
+			}
+		}
+
+		// memmem with a first / last byte filter over 32 (AVX2) or 16 (SSE2) candidates at a time
+		// ref: http://0x80.pl/articles/simd-strfind.html
+		inline const char* Find(const char* p, const char* end, const std::string& lit) {
+			const std::size_t n = lit.size();
+			if (n == 0)
+				return p;
+			if (static_cast<std::size_t>(end - p) < n)
+				return nullptr;
+			if (n == 1)
+				return static_cast<const char*>(std::memchr(p, lit[0], static_cast<std::size_t>(end - p)));
+			// candidate starts are [p, last)
+			const char* const last = end - n + 1;
+#if defined(__AVX2__)
+			const __m256i first_v = _mm256_set1_epi8(lit[0]);
+			const __m256i last_v = _mm256_set1_epi8(lit[n - 1]);
+			for (; last - p >= 32; p += 32) {
+				const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+				const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + n - 1));
+				uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(
+					_mm256_and_si256(_mm256_cmpeq_epi8(a, first_v), _mm256_cmpeq_epi8(b, last_v))));
+				while (mask) {
+					const int i = detail::ctz32(mask);
+					if (std::memcmp(p + i + 1, lit.data() + 1, n - 2) == 0)
+						return p + i;
+					mask &= mask - 1;
+				}
+			}
+#elif defined(__SSE2__)
+			const __m128i first_v = _mm_set1_epi8(lit[0]);
+			const __m128i last_v = _mm_set1_epi8(lit[n - 1]);
+			for (; last - p >= 16; p += 16) {
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n - 1));
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(
+					_mm_and_si128(_mm_cmpeq_epi8(a, first_v), _mm_cmpeq_epi8(b, last_v))));
+				while (mask) {
+					const int i = detail::ctz32(mask);
+					if (std::memcmp(p + i + 1, lit.data() + 1, n - 2) == 0)
+						return p + i;
+					mask &= mask - 1;
+				}
+			}
+#endif
+			while (p < last) {
+				p = static_cast<const char*>(std::memchr(p, lit[0], static_cast<std::size_t>(last - p)));
+				if (!p)
+					return nullptr;
+				if (p[n - 1] == lit[n - 1] && std::memcmp(p + 1, lit.data() + 1, n - 2) == 0)
+					return p;
+				++p;
+			}
+			return nullptr;
+		}
+	}
+
+	// Thompson construction into bytecode run by a Pike VM: every thread advances in lock step,
+	// linear in the input whatever the pattern, with submatch positions carried per thread
+	// ref: https://swtch.com/~rsc/regexp/regexp2.html
+	namespace VM {
+		using namespace REN;
+
+		enum class OpCode : uint8_t {
+			Byte, Set, Split, Jump, Save, Match
+		};
+
+		// m_x is the next pc (Split: preferred branch), m_y the other branch, the set index or the slot
+		struct Instruction {
+			OpCode m_op;
+			uint8_t m_byte;
+			uint32_t m_x, m_y;
+		};
+
+		struct Program {
+			std::vector<Instruction> m_code;
+			std::vector<std::bitset<256>> m_sets;
+			std::size_t m_slots = 2;  // 2 per group, group 0 is the whole match
+			uint32_t m_start = 0;
+		};
+
+		// Entry pc and the targets left dangling, (pc, is m_y)
+		struct Fragment {
+			uint32_t m_start;
+			std::vector<std::pair<uint32_t, bool>> m_holes;
+		};
+
+		class Compiler : public RegularExpressionConverter<Fragment> {
+		public:
+			Program Compile(const RegularExpression& re) {
+				m_program = Program();
+				m_maxGroup = 0;
+				Fragment f = Convert(re.Capture(0));
+				Patch(f, Emit(OpCode::Match));
+				m_program.m_start = f.m_start;
+				m_program.m_slots = 2 * (m_maxGroup + 1);
+				return std::move(m_program);
+			}
+
+			Fragment ConvertAlternation(AlternationExpression exp) override {
+				const uint32_t split = Emit(OpCode::Split);
+				Fragment a = Convert(exp.Expression1());
+				Fragment b = Convert(exp.Expression2());
+				m_program.m_code[split].m_x = a.m_start;
+				m_program.m_code[split].m_y = b.m_start;
+				a.m_holes.insert(a.m_holes.end(), b.m_holes.begin(), b.m_holes.end());
+				return Fragment{split, std::move(a.m_holes)};
+			}
+			Fragment ConvertSymbol(SymbolExpression exp) override {
+				const uint32_t pc = Emit(OpCode::Byte, static_cast<uint8_t>(exp.Symbol()));
+				return Fragment{pc, {{pc, false}}};
+			}
+			Fragment ConvertEmpty(EmptyExpression) override {
+				const uint32_t pc = Emit(OpCode::Jump);
+				return Fragment{pc, {{pc, false}}};
+			}
+			Fragment ConvertConcatenation(ConcatenationExpression exp) override {
+				Fragment a = Convert(exp.ExpressionL());
+				Fragment b = Convert(exp.ExpressionR());
+				Patch(a, b.m_start);
+				return Fragment{a.m_start, std::move(b.m_holes)};
+			}
+			Fragment ConvertAlternationCharSet(AlternationCharSetExpression exp) override {
+				std::bitset<256> set;
+				for (char c : exp.CharSet())
+					set.set(static_cast<unsigned char>(c));
+				uint32_t pc;
+				if (set.count() == 1) {
+					pc = Emit(OpCode::Byte, static_cast<uint8_t>(exp.CharSet()[0]));
+				}
+				else {
+					pc = Emit(OpCode::Set, 0, static_cast<uint32_t>(m_program.m_sets.size()));
+					m_program.m_sets.push_back(set);
+				}
+				return Fragment{pc, {{pc, false}}};
+			}
+			Fragment ConvertStringLiteral(StringLiteralExpression exp) override {
+				const std::string& s = exp.String();
+				if (s.empty())
+					return ConvertEmpty(EmptyExpression());
+				Fragment ret{static_cast<uint32_t>(m_program.m_code.size()), {}};
+				for (std::size_t i = 0; i < s.size(); ++i) {
+					const uint32_t pc = Emit(OpCode::Byte, static_cast<uint8_t>(s[i]));
+					m_program.m_code[pc].m_x = pc + 1;
+				}
+				ret.m_holes.emplace_back(static_cast<uint32_t>(m_program.m_code.size() - 1), false);
+				return ret;
+			}
+			// Greedy: the loop body is preferred over leaving
+			Fragment ConvertKleeneStar(KleeneStarExpression exp) override {
+				const uint32_t split = Emit(OpCode::Split);
+				Fragment a = Convert(exp.InnerExpression());
+				m_program.m_code[split].m_x = a.m_start;
+				Patch(a, split);
+				return Fragment{split, {{split, true}}};
+			}
+			Fragment ConvertCapture(CaptureExpression exp) override {
+				m_maxGroup = std::max(m_maxGroup, exp.Group());
+				const uint32_t open = Emit(OpCode::Save, 0, static_cast<uint32_t>(2 * exp.Group()));
+				Fragment a = Convert(exp.InnerExpression());
+				m_program.m_code[open].m_x = a.m_start;
+				const uint32_t close = Emit(OpCode::Save, 0, static_cast<uint32_t>(2 * exp.Group() + 1));
+				Patch(a, close);
+				return Fragment{open, {{close, false}}};
+			}
+
+		private:
+			uint32_t Emit(OpCode op, uint8_t byte = 0, uint32_t y = 0) {
+				m_program.m_code.push_back(Instruction{op, byte, 0, y});
+				return static_cast<uint32_t>(m_program.m_code.size() - 1);
+			}
+			void Patch(const Fragment& f, uint32_t target) {
+				for (const auto& h : f.m_holes) {
+					if (h.second)
+						m_program.m_code[h.first].m_y = target;
+					else
+						m_program.m_code[h.first].m_x = target;
+				}
+			}
+
+			Program m_program;
+			std::size_t m_maxGroup;
+		};
+
+		// Leftmost-first (Perl) semantics: threads are kept in priority order and a match
+		// drops every thread behind it
+		class PikeVM {
+		public:
+			constexpr static const std::size_t npos = static_cast<std::size_t>(-1);
+
+			explicit PikeVM(const Program& prog)
+				: m_prog(&prog), m_clist(prog), m_nlist(prog), m_scratch(prog.m_slots) {}
+
+			// Match starting at or after from (at from only when anchored), slots gets 2 offsets per group.
+			// Without live threads the scan jumps to the next occurrence of prefix, which every match starts with.
+			bool Run(const char* text, std::size_t len, std::size_t from, bool anchored, std::vector<std::size_t>& slots,
+				const std::string& prefix = std::string()) {
+				const std::size_t n = m_prog->m_slots;
+				slots.assign(n, npos);
+				m_clist.Clear();
+				m_nlist.Clear();
+				bool matched = false;
+				for (std::size_t pos = from; ; ++pos) {
+					if (!matched && (!anchored || pos == from)) {
+						if (m_clist.m_size == 0 && !anchored && !prefix.empty()) {
+							const char* q = Literal::Find(text + pos, text + len, prefix);
+							if (!q)
+								break;
+							pos = static_cast<std::size_t>(q - text);
+						}
+						std::fill(m_scratch.begin(), m_scratch.end(), npos);
+						Add(m_clist, m_prog->m_start, pos, m_scratch.data());
+					}
+					if (m_clist.m_size == 0)
+						break;
+					for (std::size_t i = 0; i < m_clist.m_size; ++i) {
+						const uint32_t pc = m_clist.m_dense[i];
+						const Instruction& in = m_prog->m_code[pc];
+						const std::size_t* caps = m_clist.Caps(i);
+						if (in.m_op == OpCode::Match) {
+							std::copy(caps, caps + n, slots.begin());
+							matched = true;
+							break;
+						}
+						if (pos == len)
+							continue;
+						const unsigned char c = static_cast<unsigned char>(text[pos]);
+						if ((in.m_op == OpCode::Byte && in.m_byte == c) || (in.m_op == OpCode::Set && m_prog->m_sets[in.m_y].test(c))) {
+							std::copy(caps, caps + n, m_scratch.begin());
+							Add(m_nlist, in.m_x, pos + 1, m_scratch.data());
+						}
+					}
+					if (pos == len)
+						break;
+					std::swap(m_clist, m_nlist);
+					m_nlist.Clear();
+				}
+				return matched;
+			}
+
+		private:
+			// Sparse set of pcs in insertion (= priority) order, with the captures of each thread
+			struct ThreadList {
+				std::vector<uint32_t> m_dense, m_sparse;
+				std::vector<std::size_t> m_caps;
+				std::size_t m_size = 0, m_slots;
+
+				explicit ThreadList(const Program& prog)
+					: m_dense(prog.m_code.size()), m_sparse(prog.m_code.size()),
+					m_caps(prog.m_code.size() * prog.m_slots), m_slots(prog.m_slots) {}
+				void Clear() {
+					m_size = 0;
+				}
+				bool Contains(uint32_t pc) const {
+					const uint32_t i = m_sparse[pc];
+					return i < m_size && m_dense[i] == pc;
+				}
+				std::size_t Insert(uint32_t pc) {
+					m_sparse[pc] = static_cast<uint32_t>(m_size);
+					m_dense[m_size] = pc;
+					return m_size++;
+				}
+				std::size_t* Caps(std::size_t i) {
+					return m_caps.data() + i * m_slots;
+				}
+			};
+
+			// pc >= 0: explore pc, otherwise restore caps[slot] = value on the way back
+			struct Frame {
+				uint32_t m_pc;
+				bool m_restore;
+				std::size_t m_slot, m_value;
+			};
+
+			// Follows Jump / Split / Save without consuming input, depth-first in priority order
+			void Add(ThreadList& list, uint32_t pc0, std::size_t pos, std::size_t* caps) {
+				m_stack.clear();
+				m_stack.push_back(Frame{pc0, false, 0, 0});
+				while (!m_stack.empty()) {
+					const Frame f = m_stack.back();
+					m_stack.pop_back();
+					if (f.m_restore) {
+						caps[f.m_slot] = f.m_value;
+						continue;
+					}
+					uint32_t pc = f.m_pc;
+					while (!list.Contains(pc)) {
+						const std::size_t i = list.Insert(pc);
+						const Instruction& in = m_prog->m_code[pc];
+						if (in.m_op == OpCode::Jump) {
+							pc = in.m_x;
+						}
+						else if (in.m_op == OpCode::Split) {
+							m_stack.push_back(Frame{in.m_y, false, 0, 0});
+							pc = in.m_x;
+						}
+						else if (in.m_op == OpCode::Save) {
+							m_stack.push_back(Frame{0, true, in.m_y, caps[in.m_y]});
+							caps[in.m_y] = pos;
+							pc = in.m_x;
+						}
+						else {
+							std::copy(caps, caps + list.m_slots, list.Caps(i));
+							break;
+						}
+					}
+				}
+			}
+
+			const Program* m_prog;
+			ThreadList m_clist, m_nlist;
+			std::vector<std::size_t> m_scratch;
+			std::vector<Frame> m_stack;
+		};
+	}
+
+	// Glushkov automaton in machine words: one bit per symbol position (at most 64), a step is
+	// D = Follow(D) & B[c]; a plain sequence of symbols / sets reduces to Shift-And, Follow(D) = D << 1
+	// ref: Navarro, Raffinot, Flexible Pattern Matching in Strings, 4.3 / 5.4
+	namespace BitParallel {
+		using namespace REN;
+
+		constexpr static const std::size_t max_positions = 64;
+
+		struct Positions {
+			bool m_nullable;
+			uint64_t m_first, m_last;
+		};
+
+		class GlushkovBuilder : public RegularExpressionConverter<Positions> {
+		public:
+			std::vector<std::bitset<256>> m_sets;  // bytes accepted at each position
+			std::vector<uint64_t> m_follow;
+			bool m_overflow = false;
+
+			Positions ConvertAlternation(AlternationExpression exp) override {
+				const Positions a = Convert(exp.Expression1());
+				const Positions b = Convert(exp.Expression2());
+				return Positions{a.m_nullable || b.m_nullable, a.m_first | b.m_first, a.m_last | b.m_last};
+			}
+			Positions ConvertSymbol(SymbolExpression exp) override {
+				std::bitset<256> set;
+				set.set(static_cast<unsigned char>(exp.Symbol()));
+				return Position(set);
+			}
+			Positions ConvertEmpty(EmptyExpression) override {
+				return Positions{true, 0, 0};
+			}
+			Positions ConvertConcatenation(ConcatenationExpression exp) override {
+				const Positions a = Convert(exp.ExpressionL());
+				const Positions b = Convert(exp.ExpressionR());
+				return Concat(a, b);
+			}
+			Positions ConvertAlternationCharSet(AlternationCharSetExpression exp) override {
+				std::bitset<256> set;
+				for (char c : exp.CharSet())
+					set.set(static_cast<unsigned char>(c));
+				return Position(set);
+			}
+			Positions ConvertStringLiteral(StringLiteralExpression exp) override {
+				Positions ret{true, 0, 0};
+				for (char c : exp.String()) {
+					std::bitset<256> set;
+					set.set(static_cast<unsigned char>(c));
+					ret = Concat(ret, Position(set));
+				}
+				return ret;
+			}
+			Positions ConvertKleeneStar(KleeneStarExpression exp) override {
+				const Positions a = Convert(exp.InnerExpression());
+				Link(a.m_last, a.m_first);
+				return Positions{true, a.m_first, a.m_last};
+			}
+
+		private:
+			Positions Position(const std::bitset<256>& set) {
+				if (m_sets.size() == max_positions) {
+					m_overflow = true;
+					return Positions{false, 0, 0};
+				}
+				m_sets.push_back(set);
+				m_follow.push_back(0);
+				const uint64_t bit = uint64_t(1) << (m_sets.size() - 1);
+				return Positions{false, bit, bit};
+			}
+			Positions Concat(const Positions& a, const Positions& b) {
+				Link(a.m_last, b.m_first);
+				return Positions{a.m_nullable && b.m_nullable,
+					a.m_first | (a.m_nullable ? b.m_first : 0),
+					b.m_last | (b.m_nullable ? a.m_last : 0)};
+			}
+			void Link(uint64_t first, uint64_t last) {
+				for (std::size_t p = 0; p < m_follow.size(); ++p)
+					if (first >> p & 1)
+						m_follow[p] |= last;
+			}
+		};
 
+		class Matcher {
+		public:
+			// False when the expression has more than 64 positions
+			bool Build(const RegularExpression& re) {
+				GlushkovBuilder b;
+				const Positions pos = b.Convert(re);
+				if (b.m_overflow)
+					return false;
+				const std::size_t n = b.m_sets.size();
+				m_nullable = pos.m_nullable;
+				m_first = pos.m_first;
+				m_last = pos.m_last;
+				for (unsigned c = 0; c < 256; ++c) {
+					m_bytes[c] = 0;
+					for (std::size_t p = 0; p < n; ++p)
+						if (b.m_sets[p].test(c))
+							m_bytes[c] |= uint64_t(1) << p;
+				}
+				m_linear = n > 0 && !m_nullable && m_first == 1 && m_last == uint64_t(1) << (n - 1);
+				for (std::size_t p = 0; p < n && m_linear; ++p)
+					m_linear = b.m_follow[p] == (p + 1 < n ? uint64_t(1) << (p + 1) : 0);
+				// Follow(D) by table lookups, 8 positions per table
+				m_follow.assign((n + 7) / 8, std::array<uint64_t, 256>());
+				for (std::size_t k = 0; k < m_follow.size(); ++k) {
+					for (unsigned v = 0; v < 256; ++v) {
+						uint64_t f = 0;
+						for (unsigned i = 0; i < 8 && k * 8 + i < n; ++i)
+							if (v >> i & 1)
+								f |= b.m_follow[k * 8 + i];
+						m_follow[k][v] = f;
+					}
+				}
+				return true;
+			}
+
+			// Whole input
+			bool Match(const char* p, const char* end) const {
+				if (p == end)
+					return m_nullable;
+				uint64_t d = m_first & m_bytes[static_cast<unsigned char>(*p++)];
+				for (; p != end && d; ++p)
+					d = Follow(d) & m_bytes[static_cast<unsigned char>(*p)];
+				return p == end && (d & m_last) != 0;
+			}
+
+			// End of the match that ends first, nullptr if there is none
+			const char* Search(const char* p, const char* end) const {
+				if (m_nullable)
+					return p;
+				uint64_t d = 0;
+				if (m_linear) {
+					for (; p != end; ++p) {
+						d = ((d << 1) | 1) & m_bytes[static_cast<unsigned char>(*p)];
+						if (d & m_last)
+							return p + 1;
+					}
+					return nullptr;
+				}
+				for (; p != end; ++p) {
+					d = (Follow(d) | m_first) & m_bytes[static_cast<unsigned char>(*p)];
+					if (d & m_last)
+						return p + 1;
+				}
+				return nullptr;
+			}
+
+		private:
+			uint64_t Follow(uint64_t d) const {
+				if (m_linear)
+					return d << 1;
+				uint64_t ret = 0;
+				for (std::size_t k = 0; d; ++k, d >>= 8)
+					ret |= m_follow[k][d & 0xFF];
+				return ret;
+			}
+
+			uint64_t m_bytes[256];
+			std::vector<std::array<uint64_t, 256>> m_follow;
+			uint64_t m_first = 0, m_last = 0;
+			bool m_nullable = false, m_linear = false;
+		};
+	}
+
+	namespace Engine {
+		using namespace REN;
+
+		struct MatchResult {
+			std::string_view m_text;
+			std::vector<std::size_t> m_slots;
+
+			bool Matched(std::size_t group = 0) const {
+				return 2 * group + 1 < m_slots.size() && m_slots[2 * group] != VM::PikeVM::npos && m_slots[2 * group + 1] != VM::PikeVM::npos;
+			}
+			std::size_t Position(std::size_t group = 0) const {
+				return m_slots[2 * group];
+			}
+			std::size_t Length(std::size_t group = 0) const {
+				return m_slots[2 * group + 1] - m_slots[2 * group];
+			}
+			std::string_view Str(std::size_t group = 0) const {
+				return Matched(group) ? m_text.substr(Position(group), Length(group)) : std::string_view();
+			}
+		};
+
+		// Picks the cheapest way to answer each query: required-literal rejection first, then the
+		// bit-parallel matcher when the pattern fits in 64 positions, the Pike VM for the rest and for submatches
+		class Regex {
+		public:
+			explicit Regex(const std::string& pattern)
+				: Regex(Parse::Parser()(pattern)) {}
+			explicit Regex(const RegularExpression& re)
+				: m_program(VM::Compiler().Compile(re)), m_vm(m_program) {
+				m_literal = Literal::LiteralExtractor().Convert(re);
+				m_hasBits = m_bits.Build(re);
+			}
+			Regex(const Regex&) = delete;
+			Regex& operator=(const Regex&) = delete;
+
+			// The whole input
+			bool Match(std::string_view s) {
+				if (m_literal.m_exact)
+					return s == m_literal.m_prefix;
+				if (m_hasBits)
+					return m_bits.Match(s.data(), s.data() + s.size());
+				return m_vm.Run(s.data(), s.size(), 0, true, m_slots) && m_slots[1] == s.size();
+			}
+
+			// Anywhere in the input
+			bool Search(std::string_view s) {
+				const char* const end = s.data() + s.size();
+				if (!m_literal.m_required.empty() && !Literal::Find(s.data(), end, m_literal.m_required))
+					return false;
+				if (m_literal.m_exact)
+					return true;
+				if (m_hasBits)
+					return m_bits.Search(s.data(), end) != nullptr;
+				return m_vm.Run(s.data(), s.size(), 0, false, m_slots, m_literal.m_prefix);
+			}
+
+			// Leftmost-first match at or after from, with submatches
+			bool Find(std::string_view s, MatchResult& m, std::size_t from = 0) {
+				m.m_text = s;
+				return m_vm.Run(s.data(), s.size(), from, false, m.m_slots, m_literal.m_prefix);
+			}
+
+			// Calls fn(line) for every '\n'-separated line with a match, returns how many.
+			// With a required literal only the lines holding it are looked at.
+			template <typename F>
+			std::size_t Grep(std::string_view text, F&& fn) {
+				std::size_t count = 0;
+				const char* p = text.data();
+				const char* const end = p + text.size();
+				while (p < end) {
+					const char* line = p;
+					if (!m_literal.m_required.empty()) {
+						const char* q = Literal::Find(p, end, m_literal.m_required);
+						if (!q)
+							break;
+						line = q;
+						while (line > p && line[-1] != '\n')
+							--line;
+					}
+					const char* eol = static_cast<const char*>(std::memchr(line, '\n', static_cast<std::size_t>(end - line)));
+					if (!eol)
+						eol = end;
+					const std::string_view l(line, static_cast<std::size_t>(eol - line));
+					if (Search(l)) {
+						fn(l);
+						++count;
+					}
+					p = eol + 1;
+				}
+				return count;
+			}
+
+			// Including group 0
+			std::size_t GroupCount() const {
+				return m_program.m_slots / 2;
+			}
+			const Literal::LiteralInfo& Literals() const {
+				return m_literal;
+			}
+			bool IsBitParallel() const {
+				return m_hasBits;
+			}
+
+		private:
+			VM::Program m_program;
+			VM::PikeVM m_vm;
+			BitParallel::Matcher m_bits;
+			bool m_hasBits;
+			Literal::LiteralInfo m_literal;
+			std::vector<std::size_t> m_slots;
+		};
+	}
+
+	// Many patterns in one pass over the input, every matching pattern id reported.
+	// Literal-only members go into an Aho-Corasick automaton, the others are merged into a single
+	// unanchored lazy DFA built from their VM programs. Both run over byte classes.
+	namespace Multi {
+		using namespace REN;
+
+		// Bytes no pattern tells apart share a class
+		struct ByteClasses {
+			uint8_t m_class[256] = {};
+			std::size_t m_count = 1;
+
+			void Refine(const std::bitset<256>& set) {
+				int16_t remap[256][2];
+				std::fill(&remap[0][0], &remap[0][0] + 512, int16_t(-1));
+				std::size_t count = 0;
+				for (unsigned b = 0; b < 256; ++b) {
+					int16_t& r = remap[m_class[b]][set.test(b)];
+					if (r < 0)
+						r = static_cast<int16_t>(count++);
+					m_class[b] = static_cast<uint8_t>(r);
+				}
+				m_count = count;
+			}
+			// one byte of every class
+			std::vector<unsigned char> Representatives() const {
+				std::vector<unsigned char> ret(m_count);
+				for (unsigned b = 256; b-- > 0; )
+					ret[m_class[b]] = static_cast<unsigned char>(b);
+				return ret;
+			}
+		};
+
+		// ref: Aho, Corasick, Efficient string matching: an aid to bibliographic search
+		// The trie is completed into a DFA (failure links folded into the transitions) and every
+		// state carries the ids of all literals ending there, its suffixes included.
+		class AhoCorasick {
+		public:
+			AhoCorasick() : m_trie(1) {
+				m_trie[0].fill(-1);
+			}
+
+			void Add(const std::string& literal, uint32_t id) {
+				int32_t s = 0;
+				for (char ch : literal) {
+					const unsigned char c = static_cast<unsigned char>(ch);
+					if (m_trie[s][c] < 0) {
+						m_trie[s][c] = static_cast<int32_t>(m_trie.size());
+						m_trie.emplace_back();
+						m_trie.back().fill(-1);
+					}
+					s = m_trie[s][c];
+				}
+				m_outputs.resize(m_trie.size());
+				m_outputs[s].push_back(id);
+			}
+
+			void Build() {
+				const std::size_t n = m_trie.size();
+				m_outputs.resize(n);
+				for (std::size_t s = 0; s < n; ++s) {
+					for (unsigned c = 0; c < 256; ++c) {
+						if (m_trie[s][c] >= 0) {
+							std::bitset<256> one;
+							one.set(c);
+							m_classes.Refine(one);
+						}
+					}
+				}
+				const std::vector<unsigned char> rep = m_classes.Representatives();
+				const std::size_t k = m_classes.m_count;
+				m_delta.assign(n * k, 0);
+				std::vector<int32_t> fail(n, 0);
+				std::vector<int32_t> queue;
+				for (std::size_t c = 0; c < k; ++c) {
+					const int32_t t = m_trie[0][rep[c]];
+					if (t > 0) {
+						m_delta[c] = static_cast<uint32_t>(t);
+						queue.push_back(t);
+					}
+				}
+				for (std::size_t head = 0; head < queue.size(); ++head) {
+					const int32_t s = queue[head];
+					const std::vector<uint32_t>& inherited = m_outputs[fail[s]];
+					m_outputs[s].insert(m_outputs[s].end(), inherited.begin(), inherited.end());
+					for (std::size_t c = 0; c < k; ++c) {
+						const int32_t t = m_trie[s][rep[c]];
+						if (t > 0) {
+							fail[t] = static_cast<int32_t>(m_delta[fail[s] * k + c]);
+							m_delta[s * k + c] = static_cast<uint32_t>(t);
+							queue.push_back(t);
+						}
+						else {
+							m_delta[s * k + c] = m_delta[fail[s] * k + c];
+						}
+					}
+				}
+				// state ids premultiplied by the class count
+				for (uint32_t& t : m_delta)
+					t *= static_cast<uint32_t>(k);
+				m_final.assign(n * k, 0);
+				for (std::size_t s = 0; s < n; ++s)
+					m_final[s * k] = !m_outputs[s].empty();
+				m_trie.clear();
+				m_trie.shrink_to_fit();
+			}
+
+			uint32_t Start() const {
+				return 0;
+			}
+			uint32_t Next(uint32_t s, unsigned char c) const {
+				return m_delta[s + m_classes.m_class[c]];
+			}
+			bool HasOutput(uint32_t s) const {
+				return m_final[s] != 0;
+			}
+			const std::vector<uint32_t>& Outputs(uint32_t s) const {
+				return m_outputs[s / m_classes.m_count];
+			}
+
+		private:
+			std::vector<std::array<int32_t, 256>> m_trie;
+			std::vector<std::vector<uint32_t>> m_outputs;
+			ByteClasses m_classes;
+			std::vector<uint32_t> m_delta;
+			std::vector<uint8_t> m_final;
+		};
+
+		// The VM programs of several patterns in one code vector, Match carries the pattern id in m_y
+		struct CombinedProgram {
+			std::vector<VM::Instruction> m_code;
+			std::vector<std::bitset<256>> m_sets;
+			std::vector<uint32_t> m_starts;
+			ByteClasses m_classes;
+
+			void Add(const VM::Program& prog, uint32_t id) {
+				const uint32_t offset = static_cast<uint32_t>(m_code.size());
+				const uint32_t set_offset = static_cast<uint32_t>(m_sets.size());
+				for (VM::Instruction in : prog.m_code) {
+					in.m_x += offset;
+					if (in.m_op == VM::OpCode::Split)
+						in.m_y += offset;
+					else if (in.m_op == VM::OpCode::Set)
+						in.m_y += set_offset;
+					else if (in.m_op == VM::OpCode::Match)
+						in.m_y = id;
+					m_code.push_back(in);
+				}
+				for (const auto& set : prog.m_sets) {
+					m_sets.push_back(set);
+					m_classes.Refine(set);
+				}
+				for (const VM::Instruction& in : prog.m_code) {
+					if (in.m_op == VM::OpCode::Byte) {
+						std::bitset<256> one;
+						one.set(in.m_byte);
+						m_classes.Refine(one);
+					}
+				}
+				m_starts.push_back(prog.m_start + offset);
+			}
+		};
+
+		// Subset construction on demand over a CombinedProgram, searching anywhere: every state also
+		// holds the start threads. The cache is dropped and rebuilt once it exceeds max_states.
+		// Not thread-safe, one per thread.
+		class LazyDFA {
+		public:
+			constexpr static const int32_t unknown = -1;
+			constexpr static const std::size_t max_states = 4096;
+
+			explicit LazyDFA(const CombinedProgram& prog)
+				: m_prog(prog), m_reps(prog.m_classes.Representatives()),
+				m_mark(prog.m_code.size(), 0) {
+				Reset();
+			}
+
+			uint32_t Start() const {
+				return 0;
+			}
+			// States are numbered premultiplied by the class count
+			uint32_t Next(uint32_t s, unsigned char c) {
+				const std::size_t cls = m_prog.m_classes.m_class[c];
+				const int32_t t = m_delta[s + cls];
+				if (t != unknown)
+					return static_cast<uint32_t>(t);
+				return Compute(s / static_cast<uint32_t>(m_prog.m_classes.m_count), cls);
+			}
+			bool HasOutput(uint32_t s) const {
+				return m_final[s] != 0;
+			}
+			const std::vector<uint32_t>& Outputs(uint32_t s) const {
+				return m_outputs[s / m_prog.m_classes.m_count];
+			}
+			std::size_t StateCount() const {
+				return m_states.size();
+			}
+			std::size_t FlushCount() const {
+				return m_flushes;
+			}
+
+		private:
+			struct Hasher {
+				std::size_t operator()(const std::vector<uint32_t>& v) const {
+					std::size_t h = 1469598103934665603ull;
+					for (uint32_t x : v)
+						h = (h ^ x) * 1099511628211ull;
+					return h;
+				}
+			};
+
+			void Reset() {
+				m_states.clear();
+				m_outputs.clear();
+				m_delta.clear();
+				m_final.clear();
+				m_index.clear();
+				std::vector<uint32_t> start;
+				++m_epoch;
+				for (uint32_t pc : m_prog.m_starts)
+					Closure(pc, start);
+				Insert(std::move(start));
+			}
+
+			// Consuming and Match pcs reachable from pc without input
+			void Closure(uint32_t pc0, std::vector<uint32_t>& out) {
+				m_stack.clear();
+				m_stack.push_back(pc0);
+				while (!m_stack.empty()) {
+					const uint32_t pc = m_stack.back();
+					m_stack.pop_back();
+					if (m_mark[pc] == m_epoch)
+						continue;
+					m_mark[pc] = m_epoch;
+					const VM::Instruction& in = m_prog.m_code[pc];
+					switch (in.m_op) {
+					case VM::OpCode::Split:
+						m_stack.push_back(in.m_y);
+						m_stack.push_back(in.m_x);
+						break;
+					case VM::OpCode::Jump:
+					case VM::OpCode::Save:
+						m_stack.push_back(in.m_x);
+						break;
+					default:
+						out.push_back(pc);
+					}
+				}
+			}
+
+			uint32_t Insert(std::vector<uint32_t> pcs) {
+				std::sort(pcs.begin(), pcs.end());
+				auto it = m_index.find(pcs);
+				if (it != m_index.end())
+					return it->second;
+				const uint32_t id = static_cast<uint32_t>(m_states.size());
+				std::vector<uint32_t> outputs;
+				for (uint32_t pc : pcs)
+					if (m_prog.m_code[pc].m_op == VM::OpCode::Match)
+						outputs.push_back(m_prog.m_code[pc].m_y);
+				std::sort(outputs.begin(), outputs.end());
+				outputs.erase(std::unique(outputs.begin(), outputs.end()), outputs.end());
+				m_final.resize(m_final.size() + m_prog.m_classes.m_count, 0);
+				m_final[id * m_prog.m_classes.m_count] = !outputs.empty();
+				m_outputs.push_back(std::move(outputs));
+				m_delta.resize(m_delta.size() + m_prog.m_classes.m_count, unknown);
+				m_index.emplace(pcs, id);
+				m_states.push_back(std::move(pcs));
+				return id;
+			}
+
+			uint32_t Compute(uint32_t s, std::size_t cls) {
+				const unsigned char c = m_reps[cls];
+				std::vector<uint32_t> next;
+				++m_epoch;
+				for (uint32_t pc : m_states[s]) {
+					const VM::Instruction& in = m_prog.m_code[pc];
+					if ((in.m_op == VM::OpCode::Byte && in.m_byte == c) ||
+						(in.m_op == VM::OpCode::Set && m_prog.m_sets[in.m_y].test(c)))
+						Closure(in.m_x, next);
+				}
+				for (uint32_t pc : m_prog.m_starts)
+					Closure(pc, next);
+				const bool flush = m_states.size() >= max_states;
+				if (flush) {
+					++m_flushes;
+					Reset();
+				}
+				const uint32_t t = Insert(std::move(next)) * static_cast<uint32_t>(m_prog.m_classes.m_count);
+				if (!flush)
+					m_delta[s * m_prog.m_classes.m_count + cls] = static_cast<int32_t>(t);
+				return t;
+			}
+
+			const CombinedProgram& m_prog;
+			std::vector<unsigned char> m_reps;
+			std::vector<std::vector<uint32_t>> m_states;
+			std::vector<std::vector<uint32_t>> m_outputs;
+			std::vector<int32_t> m_delta;
+			std::vector<uint8_t> m_final;
+			std::unordered_map<std::vector<uint32_t>, uint32_t, Hasher> m_index;
+			std::vector<uint32_t> m_mark;
+			uint32_t m_epoch = 0;
+			std::vector<uint32_t> m_stack;
+			std::size_t m_flushes = 0;
+		};
+
+		class RegexSet;
+
+		// Incremental scan, chunks can be cut anywhere (e.g. slices of an sn_FileSystem InputMemoryFile).
+		// Feed / End collect the ids matching anywhere in all input so far; FeedLines / EndLines
+		// treat every '\n'-separated line as its own input and call fn(line number, ids) for each line
+		// that matches, a line may span chunks.
+		class Scanner {
+		public:
+			explicit Scanner(const RegexSet& set);
+
+			void Feed(const char* p, std::size_t n) {
+				Run(p, p + n);
+			}
+			// Sorted ids of the patterns matched by everything fed since the last End / Reset
+			std::vector<uint32_t> End() {
+				std::vector<uint32_t> ret(m_hits);
+				std::sort(ret.begin(), ret.end());
+				Reset();
+				return ret;
+			}
+
+			template <typename F>
+			void FeedLines(const char* p, std::size_t n, F&& fn) {
+				const char* const end = p + n;
+				while (p != end) {
+					const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+					if (!nl) {
+						Run(p, end);
+						return;
+					}
+					Run(p, nl);
+					EndLines(fn);
+					p = nl + 1;
+				}
+			}
+			// Closes the current line
+			template <typename F>
+			void EndLines(F&& fn) {
+				if (!m_hits.empty()) {
+					std::sort(m_hits.begin(), m_hits.end());
+					fn(m_line, static_cast<const std::vector<uint32_t>&>(m_hits));
+				}
+				Reset();
+				++m_line;
+			}
+
+			void Reset() {
+				for (uint32_t id : m_hits)
+					m_seen[id] = false;
+				m_hits.clear();
+				m_ac_state = m_ac ? m_ac->Start() : 0;
+				m_dfa_state = m_dfa.Start();
+				if (m_ac)
+					Collect(m_ac->Outputs(m_ac_state));
+				if (m_hasDFA)
+					Collect(m_dfa.Outputs(m_dfa_state));
+			}
+			void SetLine(std::size_t line) {
+				m_line = line;
+			}
+			const LazyDFA& Automaton() const {
+				return m_dfa;
+			}
+
+		private:
+			void Collect(const std::vector<uint32_t>& ids) {
+				for (std::size_t i = 0, n = ids.size(); i < n; ++i) {
+					const uint32_t id = ids[i];
+					if (!m_seen[id]) {
+						m_seen[id] = true;
+						m_hits.push_back(id);
+					}
+				}
+			}
+
+			void Run(const char* p, const char* end) {
+				if (m_ac) {
+					uint32_t s = m_ac_state;
+					for (const char* q = p; q != end; ++q) {
+						s = m_ac->Next(s, static_cast<unsigned char>(*q));
+						if (m_ac->HasOutput(s))
+							Collect(m_ac->Outputs(s));
+					}
+					m_ac_state = s;
+				}
+				if (m_hasDFA) {
+					uint32_t s = m_dfa_state;
+					for (const char* q = p; q != end; ++q) {
+						s = m_dfa.Next(s, static_cast<unsigned char>(*q));
+						if (m_dfa.HasOutput(s))
+							Collect(m_dfa.Outputs(s));
+					}
+					m_dfa_state = s;
+				}
+			}
+
+			const AhoCorasick* m_ac;
+			bool m_hasDFA;
+			LazyDFA m_dfa;
+			uint32_t m_ac_state = 0, m_dfa_state = 0;
+			std::vector<char> m_seen;
+			std::vector<uint32_t> m_hits;
+			std::size_t m_line = 0;
+		};
+
+		class RegexSet {
+		public:
+			// Pattern i gets id i
+			explicit RegexSet(const std::vector<std::string>& patterns) : m_size(patterns.size()) {
+				for (std::size_t i = 0; i < patterns.size(); ++i) {
+					const RegularExpression re = Parse::Parser()(patterns[i]);
+					const Literal::LiteralInfo info = Literal::LiteralExtractor().Convert(re);
+					const uint32_t id = static_cast<uint32_t>(i);
+					if (info.m_exact) {
+						m_ac.Add(info.m_prefix, id);
+						++m_literals;
+					}
+					else {
+						m_program.Add(VM::Compiler().Compile(re), id);
+					}
+				}
+				if (m_literals)
+					m_ac.Build();
+			}
+			RegexSet(const RegexSet&) = delete;
+			RegexSet& operator=(const RegexSet&) = delete;
+
+			std::size_t Size() const {
+				return m_size;
+			}
+			std::size_t LiteralCount() const {
+				return m_literals;
+			}
+
+			// Sorted ids of the patterns matching somewhere in text
+			std::vector<uint32_t> Matches(std::string_view text) const {
+				Scanner scanner(*this);
+				scanner.Feed(text.data(), text.size());
+				return scanner.End();
+			}
+
+			// fn(line number, sorted ids) for every line with a match
+			template <typename F>
+			void ScanLines(std::string_view text, F&& fn) const {
+				Scanner scanner(*this);
+				scanner.FeedLines(text.data(), text.size(), fn);
+				if (!text.empty() && text.back() != '\n')
+					scanner.EndLines(fn);
+			}
+
+			// fn(line number, sorted ids, worker) for every line with a match, threads == 0 uses every core.
+			// Each worker scans one contiguous range of whole lines with its own lazy DFA.
+			template <typename F>
+			void ParallelScanLines(std::string_view text, F&& fn, unsigned threads = 0) const {
+				if (threads == 0)
+					threads = std::max(1u, std::thread::hardware_concurrency());
+				const char* const buf = text.data();
+				const std::size_t len = text.size();
+				// cut after a '\n' near every len / threads
+				std::vector<std::size_t> cuts{0};
+				for (unsigned i = 1; i <= threads && cuts.back() < len; ++i) {
+					std::size_t stop = i == threads ? len : std::max(cuts.back(), len / threads * i);
+					if (stop < len) {
+						const void* nl = std::memchr(buf + stop, '\n', len - stop);
+						stop = nl ? static_cast<std::size_t>(static_cast<const char*>(nl) - buf) + 1 : len;
+					}
+					cuts.push_back(stop);
+				}
+				const std::size_t parts = cuts.size() - 1;
+				std::vector<std::exception_ptr> errors(parts);
+				auto work = [&](unsigned t) {
+					try {
+						Scanner scanner(*this);
+						scanner.SetLine(static_cast<std::size_t>(std::count(buf, buf + cuts[t], '\n')));
+						auto call = [&](std::size_t line, const std::vector<uint32_t>& ids) {
+							fn(line, ids, t);
+						};
+						scanner.FeedLines(buf + cuts[t], cuts[t + 1] - cuts[t], call);
+						if (cuts[t + 1] == len && len && buf[len - 1] != '\n')
+							scanner.EndLines(call);
+					}
+					catch (...) {
+						errors[t] = std::current_exception();
+					}
+				};
+				std::vector<std::thread> workers;
+				for (unsigned t = 1; t < parts; ++t)
+					workers.emplace_back(work, t);
+				if (parts)
+					work(0);
+				for (auto& w : workers)
+					w.join();
+				for (auto& e : errors) {
+					if (e)
+						std::rethrow_exception(e);
+				}
+			}
+
+		private:
+			friend class Scanner;
+
+			std::size_t m_size;
+			std::size_t m_literals = 0;
+			AhoCorasick m_ac;
+			CombinedProgram m_program;
+		};
+
+		inline Scanner::Scanner(const RegexSet& set)
+			: m_ac(set.m_literals ? &set.m_ac : nullptr), m_hasDFA(!set.m_program.m_starts.empty()),
+			m_dfa(set.m_program), m_seen(set.m_size, false) {
+			Reset();
+		}
+	}
 
 	using RE = REN::RegularExpression;
 }
@@ -3,7 +3,6 @@
 
 #include "sn_CommonHeader.h"
 
-// TODO: add PDA
 namespace sn_SM {
 	// ref: https://github.com/eglimi/cppfsm
 	namespace fsm {
@@ -22,11 +21,34 @@ namespace sn_SM {
 			};
 
 		private:
+			static constexpr std::int32_t npos = -1;
 			S m_initial;
 			S m_currentState;
-			using transition_edge_t = std::vector<Trans>;
-			using transition_t = std::map<S, transition_edge_t>;
-			transition_t m_trans;
+			// flat (state, trigger) -> first transition table, alternatives chained through m_next in insertion order
+			std::vector<Trans> m_trans;
+			std::vector<std::int32_t> m_next;
+			std::vector<std::int32_t> m_first;
+			std::size_t m_states = 0;
+			std::size_t m_triggers = 0;
+
+			void build() {
+				m_states = m_triggers = 0;
+				for (const auto& t : m_trans) {
+					m_states = std::max({ m_states, static_cast<std::size_t>(t.m_from) + 1, static_cast<std::size_t>(t.m_to) + 1 });
+					m_triggers = std::max(m_triggers, static_cast<std::size_t>(t.trigger) + 1);
+				}
+				m_first.assign(m_states * m_triggers, npos);
+				m_next.assign(m_trans.size(), npos);
+				std::vector<std::int32_t> last(m_first.size(), npos);
+				for (std::size_t i = 0; i < m_trans.size(); ++i) {
+					const std::size_t cell = static_cast<std::size_t>(m_trans[i].m_from) * m_triggers + static_cast<std::size_t>(m_trans[i].trigger);
+					if (last[cell] == npos)
+						m_first[cell] = static_cast<std::int32_t>(i);
+					else
+						m_next[last[cell]] = static_cast<std::int32_t>(i);
+					last[cell] = static_cast<std::int32_t>(i);
+				}
+			}
 			
 		public:
 
@@ -38,7 +60,8 @@ namespace sn_SM {
 			template <typename It>
 			void add_transitions(It start, It end) {
 				for (It it = start; it != end; ++it)
-					m_trans[(*it).from_state].push_bach(*it);
+					m_trans.push_back(*it);
+				build();
 			}
 			template <typename C>
 			void add_transitions(C&& c) {
@@ -48,16 +71,16 @@ namespace sn_SM {
 				add_transitions(std::begin(l), std::end(l));
 			}
 			void execute(Tr trigger) {
-				const auto s = m_trans.find(m_currentState);
-				const transition_edge_t sv = s->second;
-				for (const auto& trans : sv) {
-					if (trigger != trans.trigger)
-						continue;
+				const std::size_t s = static_cast<std::size_t>(m_currentState), t = static_cast<std::size_t>(trigger);
+				if (s >= m_states || t >= m_triggers)
+					return;
+				for (std::int32_t i = m_first[s * m_triggers + t]; i != npos; i = m_next[i]) {
+					const Trans& trans = m_trans[i];
 					if (trans.guard && !trans.guard())
 						continue;
 					if (trans.action)
 						trans.action();
-					m_currentState = trans.to_state;
+					m_currentState = trans.m_to;
 					break;
 				}
 			}
@@ -79,10 +102,328 @@ namespace sn_SM {
 			);		
 		*/
 
+		// Compiled machines: transitions are types, so the (state, trigger[, stack top]) table is laid out at
+		// compile time and guards/actions are called directly instead of through std::function.
+		// Guards and actions are default-constructible callables taking the context arguments given to execute.
+		struct None {};
+
+		// Lifts a function (pointer) into a guard/action type
+		template <auto F>
+		struct Fn {
+			template <typename... Args>
+			decltype(auto) operator()(Args&&... args) const {
+				return F(std::forward<Args>(args)...);
+			}
+		};
+
+		enum class StackOp { none, push, pop, replace };
+
+		namespace detail {
+			constexpr const std::size_t any_top = static_cast<std::size_t>(-1);
+
+			// 0 is the empty stack, symbol k is k + 1
+			template <typename T>
+			constexpr std::size_t top_index(T v) {
+				if constexpr (std::is_same<T, std::nullptr_t>::value)
+					return 0;
+				else
+					return static_cast<std::size_t>(v) + 1;
+			}
+			template <typename T>
+			constexpr std::size_t symbol_index(T v) {
+				if constexpr (std::is_same<T, std::nullptr_t>::value)
+					return 0;
+				else
+					return static_cast<std::size_t>(v);
+			}
+
+			template <typename Row, typename... Ctx>
+			bool guard_row(Ctx&... ctx) {
+				if constexpr (!std::is_same<typename Row::guard, None>::value)
+					return static_cast<bool>(typename Row::guard{}(ctx...));
+				else
+					return true;
+			}
+			template <typename Row, typename... Ctx>
+			void action_row(Ctx&... ctx) {
+				if constexpr (!std::is_same<typename Row::action, None>::value)
+					typename Row::action{}(ctx...);
+			}
+
+			template <typename S, typename Tr, std::size_t NS, std::size_t NT, std::size_t NTop, typename... Rows>
+			struct Table {
+				static constexpr std::size_t row_count = sizeof...(Rows);
+				static constexpr std::size_t cell_count = NS * NT * NTop;
+				static_assert(row_count < 0xFFFF, "Too many transitions.");
+				static_assert(((static_cast<std::size_t>(Rows::from) < NS && static_cast<std::size_t>(Rows::to_state) < NS) && ...), "State out of range.");
+				static_assert(((static_cast<std::size_t>(Rows::trigger) < NT) && ...), "Trigger out of range.");
+				static_assert(((Rows::top == any_top || Rows::top < NTop) && ...), "Stack symbol out of range.");
+
+				static constexpr std::size_t from[] = { static_cast<std::size_t>(Rows::from)..., 0 };
+				static constexpr std::size_t trigger[] = { static_cast<std::size_t>(Rows::trigger)..., 0 };
+				static constexpr std::size_t top[] = { Rows::top..., 0 };
+				static constexpr S to_state[] = { Rows::to_state..., S{} };
+				static constexpr StackOp op[] = { Rows::op..., StackOp::none };
+				static constexpr std::size_t symbol[] = { Rows::symbol..., 0 };
+				static constexpr bool has_guard[] = { !std::is_same<typename Rows::guard, None>::value..., false };
+				static constexpr bool has_action[] = { !std::is_same<typename Rows::action, None>::value..., false };
+
+				static constexpr std::size_t cell_of(std::size_t s, std::size_t t, std::size_t k) {
+					return (s * NT + t) * NTop + k;
+				}
+
+				static constexpr std::size_t match_count() {
+					std::size_t n = 0;
+					for (std::size_t r = 0; r < row_count; ++r)
+						n += top[r] == any_top ? NTop : 1;
+					return n;
+				}
+
+				// Rows matching cell c are order[first[c], first[c + 1]), in declaration order
+				struct Layout {
+					std::array<std::uint32_t, cell_count + 1> first{};
+					std::array<std::uint16_t, match_count() + 1> order{};
+				};
+
+				static constexpr Layout build() {
+					Layout l{};
+					for (std::size_t r = 0; r < row_count; ++r) {
+						for (std::size_t k = 0; k < NTop; ++k) {
+							if (top[r] == any_top || top[r] == k)
+								++l.first[cell_of(from[r], trigger[r], k) + 1];
+						}
+					}
+					for (std::size_t c = 0; c < cell_count; ++c)
+						l.first[c + 1] += l.first[c];
+					std::array<std::uint32_t, cell_count + 1> fill = l.first;
+					for (std::size_t r = 0; r < row_count; ++r) {
+						for (std::size_t k = 0; k < NTop; ++k) {
+							if (top[r] == any_top || top[r] == k)
+								l.order[fill[cell_of(from[r], trigger[r], k)]++] = static_cast<std::uint16_t>(r);
+						}
+					}
+					return l;
+				}
+
+				static constexpr Layout layout = build();
+
+				// the folds compile to a jump over inlined guard/action bodies; the caller runs the action
+				// only once the guard accepted and the transition is known to go through
+				template <typename... Ctx>
+				static bool fire_guard(std::size_t r, Ctx&... ctx) {
+					if (!has_guard[r])
+						return true;
+					bool ok = false;
+					std::size_t i = 0;
+					(void)((i++ == r ? (ok = guard_row<Rows>(ctx...), true) : false) || ...);
+					return ok;
+				}
+				template <typename... Ctx>
+				static void fire_action(std::size_t r, Ctx&... ctx) {
+					if (!has_action[r])
+						return;
+					std::size_t i = 0;
+					(void)((i++ == r ? (action_row<Rows>(ctx...), true) : false) || ...);
+				}
+			};
+		}
+
+		// Transition From --Trigger--> To; in a PDA it matches whatever is on the stack and leaves it alone
+		template <auto From, auto Trigger, auto To, typename Action = None, typename Guard = None>
+		struct Row {
+			static constexpr auto from = From;
+			static constexpr auto trigger = Trigger;
+			static constexpr auto to_state = To;
+			static constexpr std::size_t top = detail::any_top;
+			static constexpr StackOp op = StackOp::none;
+			static constexpr std::size_t symbol = 0;
+			using action = Action;
+			using guard = Guard;
+		};
+
+		// PDA transition taken only with Top on the stack (nullptr: the stack is empty), then Op with Symbol
+		template <auto From, auto Trigger, auto Top, auto To, StackOp Op = StackOp::none, auto Symbol = Top,
+			typename Action = None, typename Guard = None>
+		struct PushdownRow {
+			static_assert(!(std::is_same<decltype(Top), std::nullptr_t>::value && (Op == StackOp::pop || Op == StackOp::replace)),
+				"Cannot pop an empty stack.");
+			static_assert(!(std::is_same<decltype(Symbol), std::nullptr_t>::value && (Op == StackOp::push || Op == StackOp::replace)),
+				"Push needs a symbol.");
+			static constexpr auto from = From;
+			static constexpr auto trigger = Trigger;
+			static constexpr auto to_state = To;
+			static constexpr std::size_t top = detail::top_index(Top);
+			static constexpr StackOp op = Op;
+			static constexpr std::size_t symbol = detail::symbol_index(Symbol);
+			using action = Action;
+			using guard = Guard;
+		};
+
+		// NS/NT: number of states/triggers, the enums being dense from 0
+		template <typename S, typename Tr, std::size_t NS, std::size_t NT, typename... Rows>
+		class CompiledFSM {
+			using table = detail::Table<S, Tr, NS, NT, 1, Rows...>;
+			S m_initial;
+			S m_currentState;
+		public:
+			constexpr explicit CompiledFSM(S init)
+				: m_initial(init), m_currentState(init) {}
+
+			// true when a transition was taken
+			template <typename... Ctx>
+			bool execute(Tr trigger, Ctx&... ctx) {
+				const std::size_t t = static_cast<std::size_t>(trigger);
+				if (t >= NT)
+					return false;
+				const std::size_t cell = table::cell_of(static_cast<std::size_t>(m_currentState), t, 0);
+				for (std::uint32_t i = table::layout.first[cell], e = table::layout.first[cell + 1]; i < e; ++i) {
+					const std::size_t r = table::layout.order[i];
+					if (table::fire_guard(r, ctx...)) {
+						table::fire_action(r, ctx...);
+						m_currentState = table::to_state[r];
+						return true;
+					}
+				}
+				return false;
+			}
+
+			// Feeds a contiguous batch of events in order, returns how many were taken
+			template <typename... Ctx>
+			std::size_t execute_all(const Tr* first, const Tr* last, Ctx&... ctx) {
+				std::size_t taken = 0;
+				for (; first != last; ++first)
+					taken += execute(*first, ctx...);
+				return taken;
+			}
+			template <typename Range, typename... Ctx, typename = decltype(std::data(std::declval<const Range&>()))>
+			std::size_t execute_all(const Range& events, Ctx&... ctx) {
+				return execute_all(std::data(events), std::data(events) + std::size(events), ctx...);
+			}
+
+			static constexpr bool has_transition(S s, Tr t) {
+				const std::size_t cell = table::cell_of(static_cast<std::size_t>(s), static_cast<std::size_t>(t), 0);
+				return table::layout.first[cell] != table::layout.first[cell + 1];
+			}
+			void reset() {
+				m_currentState = m_initial;
+			}
+			S state() const {
+				return m_currentState;
+			}
+			bool is_initial() const {
+				return m_currentState == m_initial;
+			}
+		};
+
+		/*
+		Usage:
+			enum class State { Idle, Run, Count };
+			enum class Trigger { Start, Stop, Count };
+			struct OnStart { void operator()(Session& s) const { ... } };
+			using M = CompiledFSM<State, Trigger, 2, 2,
+				Row<State::Idle, Trigger::Start, State::Run, OnStart>,
+				Row<State::Run, Trigger::Stop, State::Idle, None, Fn<&can_stop>>>;
+			M m{State::Idle};
+			m.execute(Trigger::Start, session);
+		*/
+
+		// Pushdown automaton on the same table, indexed by the stack top as well; the stack is a fixed
+		// array of Depth symbols (NSym of them, dense from 0), so nothing allocates.
+		template <typename S, typename Tr, typename Sym, std::size_t NS, std::size_t NT, std::size_t NSym, std::size_t Depth, typename... Rows>
+		class PDA {
+			using table = detail::Table<S, Tr, NS, NT, NSym + 1, Rows...>;
+			S m_initial;
+			S m_currentState;
+			std::array<Sym, Depth> m_stack{};
+			std::size_t m_depth = 0;
+		public:
+			constexpr explicit PDA(S init)
+				: m_initial(init), m_currentState(init) {}
+
+			// true when a transition was taken; taking a push with the stack full throws std::length_error
+			// before its action runs, rows whose guard rejects are passed over as usual
+			template <typename... Ctx>
+			bool execute(Tr trigger, Ctx&... ctx) {
+				const std::size_t t = static_cast<std::size_t>(trigger);
+				if (t >= NT)
+					return false;
+				const std::size_t top = m_depth ? static_cast<std::size_t>(m_stack[m_depth - 1]) + 1 : 0;
+				const std::size_t cell = table::cell_of(static_cast<std::size_t>(m_currentState), t, top);
+				for (std::uint32_t i = table::layout.first[cell], e = table::layout.first[cell + 1]; i < e; ++i) {
+					const std::size_t r = table::layout.order[i];
+					if (!table::fire_guard(r, ctx...))
+						continue;
+					if (table::op[r] == StackOp::push && m_depth == Depth)
+						throw std::length_error("PDA stack overflow.");
+					table::fire_action(r, ctx...);
+					m_currentState = table::to_state[r];
+					switch (table::op[r]) {
+					case StackOp::push:
+						m_stack[m_depth++] = static_cast<Sym>(table::symbol[r]);
+						break;
+					case StackOp::pop:
+						--m_depth;
+						break;
+					case StackOp::replace:
+						m_stack[m_depth - 1] = static_cast<Sym>(table::symbol[r]);
+						break;
+					default:
+						break;
+					}
+					return true;
+				}
+				return false;
+			}
+
+			template <typename... Ctx>
+			std::size_t execute_all(const Tr* first, const Tr* last, Ctx&... ctx) {
+				std::size_t taken = 0;
+				for (; first != last; ++first)
+					taken += execute(*first, ctx...);
+				return taken;
+			}
+			template <typename Range, typename... Ctx, typename = decltype(std::data(std::declval<const Range&>()))>
+			std::size_t execute_all(const Range& events, Ctx&... ctx) {
+				return execute_all(std::data(events), std::data(events) + std::size(events), ctx...);
+			}
+
+			void reset() {
+				m_currentState = m_initial;
+				m_depth = 0;
+			}
+			S state() const {
+				return m_currentState;
+			}
+			bool is_initial() const {
+				return m_currentState == m_initial;
+			}
+			std::size_t depth() const {
+				return m_depth;
+			}
+			bool empty() const {
+				return m_depth == 0;
+			}
+			Sym top() const {
+				return m_stack[m_depth - 1];
+			}
+		};
+
+		/*
+		Usage: balanced brackets
+			enum class State { Scan, Count };
+			enum class Token { Open, Close, Count };
+			enum class Sym { Paren, Count };
+			using P = PDA<State, Token, Sym, 1, 2, 1, 64,
+				PushdownRow<State::Scan, Token::Open, nullptr, State::Scan, StackOp::push, Sym::Paren>,
+				PushdownRow<State::Scan, Token::Open, Sym::Paren, State::Scan, StackOp::push, Sym::Paren>,
+				PushdownRow<State::Scan, Token::Close, Sym::Paren, State::Scan, StackOp::pop>>;
+			P p{State::Scan};
+			bool balanced = p.execute_all(tokens) == tokens.size() && p.empty();
+		*/
 	}
 
 }
 
 
 
-#endif
\ No newline at end of file
+#endif
@@ -395,7 +395,7 @@ namespace sn_Stream {
 
 				guard_t guard(m_mutex);
 				avail_read_len = std::min(length, m_size - m_currentPos);
-				memmove(data + m_currentPos, m_data, static_cast<std::size_t>(avail_read_len));
+				memmove(data, m_data + m_currentPos, static_cast<std::size_t>(avail_read_len));
 				m_currentPos += avail_read_len;
 				return avail_read_len;
 			}
@@ -426,13 +426,16 @@ namespace sn_Stream {
 				guard_t guard(m_mutex);
 				if (length > m_capacity - m_currentPos) {
 					if (m_autoResize) {
-						reserve(length * 2);
+						reserve(std::max(m_capacity * 2, m_currentPos + length));
 						avail_write_len = length;
 					}
 					else {
 						avail_write_len = m_capacity - m_currentPos;
 					}
 				}
+				else {
+					avail_write_len = length;
+				}
 				memmove(m_data + m_currentPos, data, static_cast<std::size_t>(avail_write_len));
 				m_currentPos += avail_write_len;
 				m_size = std::max(m_currentPos, m_size);
@@ -573,7 +576,7 @@ namespace sn_Stream {
 					return avail_read_len;
 
 				avail_read_len = std::min(length, m_size - m_currentPos);
-				memmove(data + m_currentPos, m_data, static_cast<std::size_t>(avail_read_len));
+				memmove(data, m_data + m_currentPos, static_cast<std::size_t>(avail_read_len));
 				m_currentPos += avail_read_len;
 				return avail_read_len;
 			}
@@ -4,7 +4,11 @@
 //TODO: add UTF-8/UTF-16/UCS-2/ANSI/WIDE support
 //TODO: add bytestr
 //TODO: add async support
+#include "sn_String/string_view.hpp"
 #include "sn_String/operation.hpp"
+#include "sn_String/format.hpp"
+#include "sn_String/transcode.hpp"
+#include "sn_String/intern.hpp"
 #include "sn_String/convert.hpp"
 #include "sn_String/cstring.hpp"
 #include "sn_String/repl.hpp"
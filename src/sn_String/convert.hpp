@@ -2,6 +2,7 @@
 #define SN_STRING_CONVERT_H
 
 #include "../sn_CommonHeader.h"
+#include "transcode.hpp"
 
 namespace sn_String {
 	// TODO: add https://www.codeproject.com/Articles/38242/Reading-UTF-with-C-streams
@@ -29,61 +30,48 @@ namespace sn_String {
 
         using std::string;
 		using std::wstring;
-		using std::stringstream;
-		using std::setw;
-		using std::setfill;
 		string wstring_to_utf8(const wstring& str) {
-            using F = deletable_facet<std::codecvt_utf8<wchar_t>>;
-			std::wstring_convert<F> myconv;
-			return myconv.to_bytes(str);
+			return transcode::wide_to_utf8(str);
 		}
 
+		// GBK through the generated table, no ".936" locale needed
 		wstring gbk_to_wstring(const string& gbk_str) {
-			string gbk_locale_name = ".936";
-            using F = deletable_facet<std::codecvt_byname<wchar_t, char, std::mbstate_t>>;
-			std::wstring_convert<F> conv(
-			        new F(gbk_locale_name));
-			return conv.from_bytes(gbk_str);
+			return transcode::gbk_to_wide(gbk_str);
 		}
 
 		//for outputing chinese rows, we use wcout(.imbue(local("chs"))) << utf8_to_wstring(content)
 		wstring utf8_to_wstring(const string& str) {
-            using F = deletable_facet<std::codecvt_utf8<wchar_t>>;
-			std::wstring_convert<F> myconv;
-			return myconv.from_bytes(str);
+			return transcode::utf8_to_wide(str);
+		}
+
+		// UTF-8 is taken as is, anything else is read as GBK
+		string string_to_utf8(const string& str) {
+			if (transcode::validate_utf8(str.data(), str.size()) == transcode::npos)
+				return str;
+			return transcode::gbk_to_utf8(str);
 		}
 
 		wstring string_to_wstring(const string& str) {
-            using F = deletable_facet<std::codecvt_utf8_utf16<wchar_t>>;
-			try {
-				std::wstring_convert<F> conv;
-				wstring wstr = conv.from_bytes(str);
-				return wstr;
-			}
-			catch (std::range_error&)
-			{
-				wstring wstr = gbk_to_wstring(str);
-				return wstr;
-			}
+			if (transcode::validate_utf8(str.data(), str.size()) == transcode::npos)
+				return transcode::utf8_to_wide(str);
+			return transcode::gbk_to_wide(str);
 		}
 
 		string wstring_to_string(const wstring& wstr) {
-            using F = deletable_facet<std::codecvt_utf8_utf16<wchar_t>>;
-			std::wstring_convert<F> conv;
-			string str = conv.to_bytes(wstr);
-			return str;
+			return transcode::wide_to_utf8(wstr);
+		}
+
+		namespace detail {
+			inline string quoted_hex(const string& u8str) {
+				string hexstr(2 * u8str.size() + 2, '\'');
+				transcode::hex_encode(u8str.data(), u8str.size(), &hexstr[1]);
+				return hexstr;
+			}
 		}
 
 		//for chinese fields, we use hex(field_name) = wstring_to_hex(L'example')
 		string wstring_to_hex(const wstring& str) {
-			string u8str = wstring_to_utf8(str);
-			stringstream ss;
-			ss << std::hex;
-			for (unsigned char c : u8str)
-				ss << setw(2) << setfill('0') << static_cast<int>(c);
-			string hexstr = ss.str();
-			hexstr = "\'" + hexstr + "\'";
-			return hexstr;
+			return detail::quoted_hex(wstring_to_utf8(str));
 		}
 
 		string wstring_to_unhex(const wstring& str) {
@@ -92,13 +80,11 @@ namespace sn_String {
 		}
 
 		string string_to_hex(const string& str) {
-			wstring wstr = string_to_wstring(str);
-			return wstring_to_hex(wstr);
+			return detail::quoted_hex(string_to_utf8(str));
 		}
 
 		string string_to_unhex(const string& str) {
-			wstring wstr = string_to_wstring(str);
-			return wstring_to_unhex(wstr);
+			return "unhex(" + string_to_hex(str) + ")";
 		}
 
 		void hex_print(const std::string& s) {
@@ -0,0 +1,579 @@
+#ifndef SN_STRING_FORMAT_H
+#define SN_STRING_FORMAT_H
+
+#include "../sn_CommonHeader.h"
+#include "../sn_Meta/constexpr_string.hpp"
+#include "string_view.hpp"
+#include <charconv>
+#include <string_view>
+
+// ref: https://github.com/fmtlib/fmt
+// Replacement fields: {} / {N} with an optional spec [[fill]align][sign][#][0][width][.precision][type]
+//     align: < > ^    sign: + - space    type: d b B o x X c | e E f F g G | s | p
+// {{ and }} are literal braces. A pattern given as a type (sn_Meta::constexpr_string::string, from
+// "..."_sn or SN_CONSTEXPR_STRING) is parsed and checked against the argument types at compile time,
+// and each field is bound to its argument statically. A runtime pattern takes the same syntax.
+namespace sn_String {
+
+    namespace detail {
+
+        struct format_spec {
+            char fill = ' ';
+            char align = 0;  // 0: right for numbers, left for the rest
+            char sign = '-';
+            bool alt = false;
+            bool zero = false;
+            int width = 0;
+            int precision = -1;
+            char type = 0;
+        };
+
+        // Literal text [begin, begin + size) of the pattern, or a field when arg != npos
+        struct format_segment {
+            std::size_t begin = 0;
+            std::size_t size = 0;
+            std::size_t arg = npos;
+            format_spec spec;
+        };
+
+        class format_parser {
+            std::string_view m_text;
+            std::size_t m_i = 0;
+            std::size_t m_next_arg = 0;
+            bool m_manual = false;
+            bool m_automatic = false;
+
+            constexpr char peek() const {
+                if (m_i >= m_text.size())
+                    throw std::invalid_argument("Unterminated replacement field.");
+                return m_text[m_i];
+            }
+            static constexpr bool is_digit(char c) {
+                return c >= '0' && c <= '9';
+            }
+            static constexpr bool is_align(char c) {
+                return c == '<' || c == '>' || c == '^';
+            }
+            constexpr int number() {
+                int v = 0;
+                while (is_digit(peek())) {
+                    v = v * 10 + (m_text[m_i++] - '0');
+                    if (v > 1000000)
+                        throw std::invalid_argument("Width / precision / index too large.");
+                }
+                return v;
+            }
+            constexpr format_spec spec() {
+                format_spec s;
+                if (m_i + 1 < m_text.size() && is_align(m_text[m_i + 1])) {
+                    s.fill = m_text[m_i];
+                    s.align = m_text[m_i + 1];
+                    m_i += 2;
+                }
+                else if (is_align(peek())) {
+                    s.align = m_text[m_i++];
+                }
+                if (peek() == '+' || peek() == '-' || peek() == ' ')
+                    s.sign = m_text[m_i++];
+                if (peek() == '#') {
+                    s.alt = true;
+                    ++m_i;
+                }
+                if (peek() == '0') {
+                    s.zero = true;
+                    ++m_i;
+                }
+                s.width = number();
+                if (peek() == '.') {
+                    ++m_i;
+                    if (!is_digit(peek()))
+                        throw std::invalid_argument("Missing precision after '.'.");
+                    s.precision = number();
+                }
+                if (peek() != '}') {
+                    s.type = m_text[m_i++];
+                    const std::string_view types = "bBcdoxXeEfFgGsp";
+                    if (types.find(s.type) == std::string_view::npos)
+                        throw std::invalid_argument("Unknown format type.");
+                }
+                return s;
+            }
+        public:
+            constexpr explicit format_parser(std::string_view text) : m_text(text) {}
+
+            constexpr bool next(format_segment& seg) {
+                seg = format_segment{};
+                if (m_i >= m_text.size())
+                    return false;
+                const char c = m_text[m_i];
+                if (c == '{' || c == '}') {
+                    if (m_i + 1 < m_text.size() && m_text[m_i + 1] == c) {
+                        seg.begin = m_i;
+                        seg.size = 1;
+                        m_i += 2;
+                        return true;
+                    }
+                    if (c == '}')
+                        throw std::invalid_argument("Single '}' in format pattern.");
+                    ++m_i;
+                    if (is_digit(peek())) {
+                        seg.arg = static_cast<std::size_t>(number());
+                        m_manual = true;
+                    }
+                    else {
+                        seg.arg = m_next_arg++;
+                        m_automatic = true;
+                    }
+                    if (m_manual && m_automatic)
+                        throw std::invalid_argument("Cannot mix {} and {N} in one pattern.");
+                    if (peek() == ':') {
+                        ++m_i;
+                        seg.spec = spec();
+                    }
+                    if (peek() != '}')
+                        throw std::invalid_argument("Expected '}' in format pattern.");
+                    ++m_i;
+                    return true;
+                }
+                seg.begin = m_i;
+                while (m_i < m_text.size() && m_text[m_i] != '{' && m_text[m_i] != '}')
+                    ++m_i;
+                seg.size = m_i - seg.begin;
+                return true;
+            }
+        };
+
+        enum class format_kind {
+            integer, floating, string, character, boolean, pointer, custom
+        };
+
+        template <typename T>
+        constexpr format_kind kind_of() {
+            using U = std::decay_t<T>;
+            if constexpr (std::is_same<U, bool>::value)
+                return format_kind::boolean;
+            else if constexpr (std::is_same<U, char>::value)
+                return format_kind::character;
+            else if constexpr (std::is_integral<U>::value || std::is_enum<U>::value)
+                return format_kind::integer;
+            else if constexpr (std::is_floating_point<U>::value)
+                return format_kind::floating;
+            // before string: nullptr_t converts to std::string_view too
+            else if constexpr (std::is_null_pointer<U>::value ||
+                               (std::is_pointer<U>::value && !std::is_same<std::remove_cv_t<std::remove_pointer_t<U>>, char>::value))
+                return format_kind::pointer;
+            else if constexpr (std::is_convertible<const U&, std::string_view>::value || std::is_same<U, basic_string_view<char>>::value)
+                return format_kind::string;
+            else
+                return format_kind::custom;
+        }
+
+        constexpr void check_spec(format_kind k, const format_spec& s) {
+            const char t = s.type;
+            bool ok = false;
+            switch (k) {
+            case format_kind::integer:
+                ok = t == 0 || t == 'd' || t == 'b' || t == 'B' || t == 'o' || t == 'x' || t == 'X' || t == 'c';
+                break;
+            case format_kind::character:
+                ok = t == 0 || t == 'c' || t == 'd' || t == 'b' || t == 'B' || t == 'o' || t == 'x' || t == 'X';
+                break;
+            case format_kind::floating:
+                ok = t == 0 || t == 'e' || t == 'E' || t == 'f' || t == 'F' || t == 'g' || t == 'G';
+                break;
+            case format_kind::boolean:
+            case format_kind::custom:
+                ok = t == 0 || t == 's';
+                break;
+            case format_kind::string:
+                ok = t == 0 || t == 's';
+                break;
+            case format_kind::pointer:
+                ok = t == 0 || t == 'p';
+                break;
+            }
+            if (!ok)
+                throw std::invalid_argument("Format type does not fit the argument.");
+            if (s.precision >= 0 && k != format_kind::floating && k != format_kind::string)
+                throw std::invalid_argument("Precision is only for floating points and strings.");
+        }
+
+        // Compile-time pattern: segments parsed once per pattern type
+        template <typename Pattern>
+        struct compiled_format {
+            static constexpr std::string_view text = Pattern::view();
+
+            static constexpr std::size_t count() {
+                format_parser p(text);
+                format_segment seg;
+                std::size_t n = 0;
+                while (p.next(seg))
+                    ++n;
+                return n;
+            }
+            static constexpr std::array<format_segment, count()> parse() {
+                std::array<format_segment, count()> segs{};
+                format_parser p(text);
+                for (std::size_t i = 0; i < segs.size(); ++i)
+                    p.next(segs[i]);
+                return segs;
+            }
+
+            static constexpr std::array<format_segment, count()> segments = parse();
+
+            template <typename ...Args>
+            static constexpr bool check() {
+                const format_kind kinds[sizeof...(Args) + 1] = { kind_of<Args>()..., format_kind::custom };
+                for (const format_segment& seg : segments) {
+                    if (seg.arg == npos)
+                        continue;
+                    if (seg.arg >= sizeof...(Args))
+                        throw std::invalid_argument("Replacement field refers to a missing argument.");
+                    check_spec(kinds[seg.arg], seg.spec);
+                }
+                return true;
+            }
+        };
+
+        struct string_sink {
+            std::string& out;
+            void write(const char* p, std::size_t n) {
+                out.append(p, n);
+            }
+            void fill(char c, std::size_t n) {
+                out.append(n, c);
+            }
+        };
+
+        template <typename OutputIt>
+        struct iterator_sink {
+            OutputIt out;
+            void write(const char* p, std::size_t n) {
+                out = std::copy_n(p, n, out);
+            }
+            void fill(char c, std::size_t n) {
+                out = std::fill_n(out, n, c);
+            }
+        };
+
+        // prefix (sign, 0x) stays in front of zero padding, fill goes around both
+        template <typename Sink>
+        void write_padded(Sink& sink, const format_spec& s, char default_align, const char* prefix, std::size_t prefix_size,
+            const char* body, std::size_t size) {
+            const std::size_t total = prefix_size + size;
+            const std::size_t width = static_cast<std::size_t>(s.width);
+            if (total >= width) {
+                sink.write(prefix, prefix_size);
+                sink.write(body, size);
+                return;
+            }
+            const std::size_t pad = width - total;
+            if (s.zero && s.align == 0) {
+                sink.write(prefix, prefix_size);
+                sink.fill('0', pad);
+                sink.write(body, size);
+                return;
+            }
+            const char align = s.align ? s.align : default_align;
+            const std::size_t before = align == '>' ? pad : align == '^' ? pad / 2 : 0;
+            sink.fill(s.fill, before);
+            sink.write(prefix, prefix_size);
+            sink.write(body, size);
+            sink.fill(s.fill, pad - before);
+        }
+
+        inline std::size_t sign_prefix(char* prefix, bool negative, const format_spec& s) {
+            if (negative)
+                prefix[0] = '-';
+            else if (s.sign == '+' || s.sign == ' ')
+                prefix[0] = s.sign;
+            else
+                return 0;
+            return 1;
+        }
+
+        template <typename Sink, typename T>
+        void write_integer(Sink& sink, T value, const format_spec& s) {
+            using U = std::make_unsigned_t<T>;
+            bool negative = false;
+            if constexpr (std::is_signed<T>::value)
+                negative = value < 0;
+            U v = negative ? static_cast<U>(U(0) - static_cast<U>(value)) : static_cast<U>(value);
+            if (s.type == 'c') {
+                const char c = static_cast<char>(value);
+                write_padded(sink, s, '<', nullptr, 0, &c, 1);
+                return;
+            }
+            char buf[sizeof(U) * 8];
+            char* const end = buf + sizeof(buf);
+            char* p = end;
+            char prefix[3] = {};
+            std::size_t prefix_size = sign_prefix(prefix, negative, s);
+            switch (s.type) {
+            case 'x': case 'X': {
+                const char* digits = s.type == 'x' ? "0123456789abcdef" : "0123456789ABCDEF";
+                do { *--p = digits[v & 15]; v >>= 4; } while (v);
+                if (s.alt) {
+                    prefix[prefix_size++] = '0';
+                    prefix[prefix_size++] = s.type;
+                }
+                break;
+            }
+            case 'o':
+                do { *--p = static_cast<char>('0' + (v & 7)); v >>= 3; } while (v);
+                if (s.alt && *p != '0')
+                    *--p = '0';
+                break;
+            case 'b': case 'B':
+                do { *--p = static_cast<char>('0' + (v & 1)); v >>= 1; } while (v);
+                if (s.alt) {
+                    prefix[prefix_size++] = '0';
+                    prefix[prefix_size++] = s.type;
+                }
+                break;
+            default: {
+                // two digits per division
+                static const char pairs[] =
+                    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                    "8081828384858687888990919293949596979899";
+                while (v >= 100) {
+                    const unsigned r = static_cast<unsigned>(v % 100);
+                    v /= 100;
+                    p -= 2;
+                    p[0] = pairs[r * 2];
+                    p[1] = pairs[r * 2 + 1];
+                }
+                if (v >= 10) {
+                    p -= 2;
+                    p[0] = pairs[v * 2];
+                    p[1] = pairs[v * 2 + 1];
+                }
+                else {
+                    *--p = static_cast<char>('0' + v);
+                }
+            }
+            }
+            write_padded(sink, s, '>', prefix, prefix_size, p, static_cast<std::size_t>(end - p));
+        }
+
+        template <typename Sink, typename T>
+        void write_floating(Sink& sink, T value, const format_spec& s) {
+            char prefix[1] = {};
+            const std::size_t prefix_size = sign_prefix(prefix, std::signbit(value), s);
+            const T magnitude = std::fabs(value);
+            char buf[128];
+            const bool upper = s.type == 'E' || s.type == 'F' || s.type == 'G';
+            std::size_t size = 0;
+            std::string big;
+            if (std::isfinite(magnitude)) {
+#if defined(__cpp_lib_to_chars) || (defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11)
+                std::chars_format fmt = std::chars_format::general;
+                if (s.type == 'e' || s.type == 'E')
+                    fmt = std::chars_format::scientific;
+                else if (s.type == 'f' || s.type == 'F')
+                    fmt = std::chars_format::fixed;
+                std::to_chars_result r;
+                if (s.type == 0 && s.precision < 0)
+                    r = std::to_chars(buf, buf + sizeof(buf), magnitude);
+                else
+                    r = std::to_chars(buf, buf + sizeof(buf), magnitude, fmt, s.precision < 0 ? 6 : s.precision);
+                if (r.ec == std::errc()) {
+                    size = static_cast<std::size_t>(r.ptr - buf);
+                }
+                else {
+                    big.resize(400 + static_cast<std::size_t>(s.precision));
+                    r = std::to_chars(&big[0], &big[0] + big.size(), magnitude, fmt, s.precision < 0 ? 6 : s.precision);
+                    big.resize(static_cast<std::size_t>(r.ptr - big.data()));
+                }
+#else
+                char conv[16] = "%.*";
+                conv[3] = s.type ? static_cast<char>(s.type | 0x20) : 'g';
+                const int precision = s.precision < 0 ? (s.type ? 6 : 17) : s.precision;
+                const int n = std::snprintf(buf, sizeof(buf), conv, precision, static_cast<double>(magnitude));
+                if (n >= 0 && static_cast<std::size_t>(n) < sizeof(buf)) {
+                    size = static_cast<std::size_t>(n);
+                }
+                else {
+                    big.resize(static_cast<std::size_t>(n) + 1);
+                    std::snprintf(&big[0], big.size(), conv, precision, static_cast<double>(magnitude));
+                    big.pop_back();
+                }
+#endif
+            }
+            else {
+                const char* text = std::isnan(magnitude) ? "nan" : "inf";
+                std::copy_n(text, 3, buf);
+                size = 3;
+            }
+            char* body = big.empty() ? buf : &big[0];
+            if (!big.empty())
+                size = big.size();
+            if (upper)
+                std::transform(body, body + size, body, [](char c) { return static_cast<char>(std::toupper(static_cast<unsigned char>(c))); });
+            if (!std::isfinite(magnitude)) {
+                format_spec plain = s;
+                plain.zero = false;
+                write_padded(sink, plain, '>', prefix, prefix_size, body, size);
+                return;
+            }
+            write_padded(sink, s, '>', prefix, prefix_size, body, size);
+        }
+
+        template <typename Sink>
+        void write_string(Sink& sink, const char* p, std::size_t n, const format_spec& s) {
+            if (s.precision >= 0 && static_cast<std::size_t>(s.precision) < n)
+                n = static_cast<std::size_t>(s.precision);
+            format_spec plain = s;
+            plain.zero = false;
+            write_padded(sink, plain, '<', nullptr, 0, p, n);
+        }
+
+        template <typename T, typename = void>
+        struct is_streamable : std::false_type {};
+        template <typename T>
+        struct is_streamable<T, std::void_t<decltype(std::declval<std::ostream&>() << std::declval<const T&>())>> : std::true_type {};
+
+        template <typename Sink, typename T>
+        void write_arg(Sink& sink, const T& value, const format_spec& s) {
+            constexpr format_kind kind = kind_of<T>();
+            if constexpr (kind == format_kind::boolean) {
+                if (s.type == 0 || s.type == 's')
+                    write_string(sink, value ? "true" : "false", value ? 4 : 5, s);
+            }
+            else if constexpr (kind == format_kind::character) {
+                if (s.type == 0 || s.type == 'c')
+                    write_string(sink, &value, 1, s);
+                else
+                    write_integer(sink, static_cast<unsigned char>(value), s);
+            }
+            else if constexpr (kind == format_kind::integer) {
+                if constexpr (std::is_enum<T>::value)
+                    write_integer(sink, static_cast<std::underlying_type_t<T>>(value), s);
+                else
+                    write_integer(sink, value, s);
+            }
+            else if constexpr (kind == format_kind::floating) {
+                write_floating(sink, value, s);
+            }
+            else if constexpr (kind == format_kind::string) {
+                if constexpr (std::is_same<T, basic_string_view<char>>::value) {
+                    write_string(sink, value.data(), value.size(), s);
+                }
+                else {
+                    const std::string_view v(value);
+                    write_string(sink, v.data(), v.size(), s);
+                }
+            }
+            else if constexpr (kind == format_kind::pointer) {
+                format_spec hex = s;
+                hex.type = 'x';
+                hex.alt = true;
+                write_integer(sink, reinterpret_cast<std::uintptr_t>(value), hex);
+            }
+            else {
+                static_assert(is_streamable<T>::value, "Argument is neither a builtin nor printable with operator<<.");
+                std::ostringstream os;
+                os << value;
+                const std::string str = os.str();
+                write_string(sink, str.data(), str.size(), s);
+            }
+        }
+
+        template <std::size_t Arg, typename Sink, typename Tuple>
+        void write_segment(Sink& sink, std::string_view text, const format_segment& seg, const Tuple& args) {
+            if constexpr (Arg == npos)
+                sink.write(text.data() + seg.begin, seg.size);
+            else
+                write_arg(sink, std::get<Arg>(args), seg.spec);
+        }
+
+        template <typename Pattern, typename Sink, typename Tuple, std::size_t ...I>
+        void write_compiled(Sink& sink, const Tuple& args, std::index_sequence<I...>) {
+            using C = compiled_format<Pattern>;
+            (void)args;
+            std::initializer_list<int>{ (write_segment<C::segments[I].arg>(sink, C::text, C::segments[I], args), 0)... };
+        }
+
+        // Runtime pattern: every argument behind one function pointer per type
+        template <typename Sink>
+        struct erased_arg {
+            const void* value;
+            format_kind kind;
+            void (*write)(Sink&, const void*, const format_spec&);
+        };
+
+        template <typename Sink, typename T>
+        void write_erased(Sink& sink, const void* value, const format_spec& s) {
+            write_arg(sink, *static_cast<const T*>(value), s);
+        }
+
+        template <typename Sink>
+        void write_runtime(Sink& sink, std::string_view text, const erased_arg<Sink>* args, std::size_t n) {
+            format_parser p(text);
+            format_segment seg;
+            while (p.next(seg)) {
+                if (seg.arg == npos) {
+                    sink.write(text.data() + seg.begin, seg.size);
+                    continue;
+                }
+                if (seg.arg >= n)
+                    throw std::invalid_argument("Replacement field refers to a missing argument.");
+                check_spec(args[seg.arg].kind, seg.spec);
+                args[seg.arg].write(sink, args[seg.arg].value, seg.spec);
+            }
+        }
+
+        template <typename Sink, typename ...Args>
+        void format_runtime(Sink& sink, std::string_view pattern, const Args&... args) {
+            const erased_arg<Sink> erased[sizeof...(Args) + 1] = {
+                { static_cast<const void*>(std::addressof(args)), kind_of<Args>(), &write_erased<Sink, Args> }..., { nullptr, format_kind::custom, nullptr } };
+            write_runtime(sink, pattern, erased, sizeof...(Args));
+        }
+    }
+
+    // Compile-time pattern: format("{} = {:08.3f}"_sn, name, value)
+    template <char ...Cs, typename ...Args>
+    std::string format(sn_Meta::constexpr_string::string<Cs...>, const Args&... args) {
+        using Pattern = sn_Meta::constexpr_string::string<Cs...>;
+        using C = detail::compiled_format<Pattern>;
+        constexpr bool checked = C::template check<Args...>();
+        static_assert(checked, "");
+        std::string out;
+        out.reserve(sizeof...(Cs) + 16 * sizeof...(Args));
+        detail::string_sink sink{ out };
+        detail::write_compiled<Pattern>(sink, std::forward_as_tuple(args...), std::make_index_sequence<C::segments.size()>{});
+        return out;
+    }
+
+    template <typename OutputIt, char ...Cs, typename ...Args>
+    OutputIt format_to(OutputIt out, sn_Meta::constexpr_string::string<Cs...>, const Args&... args) {
+        using Pattern = sn_Meta::constexpr_string::string<Cs...>;
+        using C = detail::compiled_format<Pattern>;
+        constexpr bool checked = C::template check<Args...>();
+        static_assert(checked, "");
+        detail::iterator_sink<OutputIt> sink{ out };
+        detail::write_compiled<Pattern>(sink, std::forward_as_tuple(args...), std::make_index_sequence<C::segments.size()>{});
+        return sink.out;
+    }
+
+    // Runtime pattern, std::invalid_argument on a malformed pattern or a spec the argument cannot take
+    template <typename ...Args>
+    std::string format(std::string_view pattern, const Args&... args) {
+        std::string out;
+        out.reserve(pattern.size() + 16 * sizeof...(Args));
+        detail::string_sink sink{ out };
+        detail::format_runtime(sink, pattern, args...);
+        return out;
+    }
+
+    template <typename OutputIt, typename ...Args>
+    OutputIt format_to(OutputIt out, std::string_view pattern, const Args&... args) {
+        detail::iterator_sink<OutputIt> sink{ out };
+        detail::format_runtime(sink, pattern, args...);
+        return sink.out;
+    }
+}
+
+
+#endif
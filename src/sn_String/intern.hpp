@@ -0,0 +1,303 @@
+#ifndef SN_STRING_INTERN_H
+#define SN_STRING_INTERN_H
+
+#include "../sn_CommonHeader.h"
+#include "string_view.hpp"
+#include <cstring>
+#include <optional>
+
+namespace sn_String {
+    class string_arena;
+
+    // Immutable string living in a string_arena: a pointer and a length, copied by value. The bytes are
+    // NUL-terminated and stay put as long as the arena does.
+    class arena_string {
+        const char* m_data = "";
+        std::size_t m_size = 0;
+
+        friend class string_arena;
+        arena_string(const char* data, std::size_t size) noexcept : m_data(data), m_size(size) {}
+    public:
+        arena_string() noexcept = default;
+
+        const char* data() const noexcept { return m_data; }
+        const char* c_str() const noexcept { return m_data; }
+        std::size_t size() const noexcept { return m_size; }
+        bool empty() const noexcept { return m_size == 0; }
+        const char* begin() const noexcept { return m_data; }
+        const char* end() const noexcept { return m_data + m_size; }
+        char operator[](std::size_t i) const noexcept { return m_data[i]; }
+
+        string_view view() const noexcept { return string_view(m_data, m_size); }
+        operator string_view() const noexcept { return view(); }
+        std::string str() const { return std::string(m_data, m_size); }
+
+        friend bool operator==(const arena_string& a, const arena_string& b) noexcept {
+            return a.m_size == b.m_size && (a.m_data == b.m_data || std::memcmp(a.m_data, b.m_data, a.m_size) == 0);
+        }
+        friend bool operator!=(const arena_string& a, const arena_string& b) noexcept {
+            return !(a == b);
+        }
+        friend bool operator<(const arena_string& a, const arena_string& b) noexcept {
+            return a.view() < b.view();
+        }
+        friend std::ostream& operator<<(std::ostream& os, const arena_string& s) {
+            return os.write(s.m_data, static_cast<std::streamsize>(s.m_size));
+        }
+    };
+
+    // Bump allocator for string bytes, for data built in bulk and dropped all at once. Chunks are only
+    // released with the arena, so nothing it hands out ever moves. Not thread-safe on its own.
+    class string_arena {
+        std::vector<std::unique_ptr<char[]>> m_chunks;
+        char* m_cur = nullptr;
+        std::size_t m_left = 0;
+        std::size_t m_chunk_size;
+        std::size_t m_used = 0;
+
+        char* allocate(std::size_t n) {
+            if (n > m_left) {
+                // a big string gets a chunk of its own, so the current one keeps its room
+                if (n > m_chunk_size / 4) {
+                    m_chunks.emplace_back(new char[n]);
+                    m_used += n;
+                    return m_chunks.back().get();
+                }
+                m_chunks.emplace_back(new char[m_chunk_size]);
+                m_cur = m_chunks.back().get();
+                m_left = m_chunk_size;
+            }
+            char* p = m_cur;
+            m_cur += n;
+            m_left -= n;
+            m_used += n;
+            return p;
+        }
+    public:
+        explicit string_arena(std::size_t chunk_size = 4096) : m_chunk_size(chunk_size) {}
+        string_arena(const string_arena&) = delete;
+        string_arena& operator=(const string_arena&) = delete;
+        string_arena(string_arena&&) = default;
+        string_arena& operator=(string_arena&&) = default;
+
+        arena_string make(string_view s) {
+            const std::size_t n = s.size();
+            char* p = allocate(n + 1);
+            if (n)
+                std::memcpy(p, s.data(), n);
+            p[n] = '\0';
+            return arena_string(p, n);
+        }
+
+        // Joins the parts straight into the arena, no temporary std::string
+        arena_string concat(std::initializer_list<string_view> parts) {
+            std::size_t n = 0;
+            for (string_view part : parts)
+                n += part.size();
+            char* p = allocate(n + 1);
+            std::size_t at = 0;
+            for (string_view part : parts) {
+                if (part.size())
+                    std::memcpy(p + at, part.data(), part.size());
+                at += part.size();
+            }
+            p[n] = '\0';
+            return arena_string(p, n);
+        }
+
+        std::size_t bytes_used() const noexcept { return m_used; }
+        std::size_t chunk_count() const noexcept { return m_chunks.size(); }
+    };
+
+    // Handle of a string interned in an intern_pool: equal strings get equal symbols, so comparing and
+    // hashing are single 32-bit operations. Symbol 0 is the empty string in every pool.
+    class symbol {
+        std::uint32_t m_id = 0;
+    public:
+        constexpr symbol() noexcept = default;
+        constexpr explicit symbol(std::uint32_t id) noexcept : m_id(id) {}
+        constexpr std::uint32_t id() const noexcept { return m_id; }
+
+        friend constexpr bool operator==(symbol a, symbol b) noexcept { return a.m_id == b.m_id; }
+        friend constexpr bool operator!=(symbol a, symbol b) noexcept { return a.m_id != b.m_id; }
+        friend constexpr bool operator<(symbol a, symbol b) noexcept { return a.m_id < b.m_id; }
+    };
+
+    // Every distinct string is stored once, in the arena of one of 16 shards picked by its hash; interning
+    // locks only that shard. Symbol -> string goes through a table whose slots never move, so it takes no
+    // lock at all. Hand symbols between threads the way you would hand any other value.
+    class intern_pool {
+        static constexpr unsigned shard_bits = 4;
+        static constexpr std::size_t shard_count = std::size_t(1) << shard_bits;
+
+        // Append-only: block k holds 2^(k + base_bits) entries, so growing never relocates one
+        class table {
+            static constexpr unsigned base_bits = 8;
+            static constexpr unsigned block_count = 32 - base_bits + 1;
+            std::atomic<arena_string*> m_blocks[block_count];
+            std::atomic<std::uint32_t> m_size{ 0 };
+
+            static unsigned msb(std::uint64_t x) noexcept {
+#if defined(__GNUC__)
+                return 63 - static_cast<unsigned>(__builtin_clzll(x));
+#else
+                unsigned long i;
+                _BitScanReverse64(&i, x);
+                return static_cast<unsigned>(i);
+#endif
+            }
+            static void locate(std::uint32_t id, unsigned& block, std::size_t& offset) noexcept {
+                const std::uint64_t pos = std::uint64_t(id) + (std::uint64_t(1) << base_bits);
+                const unsigned top = msb(pos);
+                block = top - base_bits;
+                offset = static_cast<std::size_t>(pos - (std::uint64_t(1) << top));
+            }
+        public:
+            table() {
+                for (auto& b : m_blocks)
+                    b.store(nullptr, std::memory_order_relaxed);
+            }
+            ~table() {
+                for (auto& b : m_blocks)
+                    delete[] b.load(std::memory_order_relaxed);
+            }
+
+            std::uint32_t push_back(arena_string s) {
+                const std::uint32_t id = m_size.fetch_add(1, std::memory_order_relaxed);
+                if (id == std::numeric_limits<std::uint32_t>::max())
+                    throw std::length_error("sn_String::intern_pool: out of symbols.");
+                unsigned k;
+                std::size_t off;
+                locate(id, k, off);
+                arena_string* block = m_blocks[k].load(std::memory_order_acquire);
+                if (!block) {
+                    arena_string* fresh = new arena_string[std::size_t(1) << (k + base_bits)];
+                    if (m_blocks[k].compare_exchange_strong(block, fresh, std::memory_order_acq_rel))
+                        block = fresh;
+                    else
+                        delete[] fresh;
+                }
+                block[off] = s;
+                return id;
+            }
+
+            const arena_string& operator[](std::uint32_t id) const noexcept {
+                unsigned k;
+                std::size_t off;
+                locate(id, k, off);
+                return m_blocks[k].load(std::memory_order_acquire)[off];
+            }
+
+            std::uint32_t size() const noexcept { return m_size.load(std::memory_order_relaxed); }
+        };
+
+        // Open addressing over (hash tag << 32 | id + 1), 0 marking an empty slot, kept at most half full
+        struct alignas(64) shard {
+            mutable std::mutex mutex;
+            string_arena arena;
+            std::vector<std::uint64_t> slots = std::vector<std::uint64_t>(64);
+            std::size_t count = 0;
+
+            std::size_t probe(std::uint32_t tag, string_view s, const table& t) const noexcept {
+                const std::size_t mask = slots.size() - 1;
+                for (std::size_t i = tag & mask;; i = (i + 1) & mask) {
+                    const std::uint64_t e = slots[i];
+                    if (!e || (static_cast<std::uint32_t>(e >> 32) == tag && t[static_cast<std::uint32_t>(e) - 1].view() == s))
+                        return i;
+                }
+            }
+
+            void grow() {
+                std::vector<std::uint64_t> old(slots.size() * 2);
+                old.swap(slots);
+                const std::size_t mask = slots.size() - 1;
+                for (std::uint64_t e : old) {
+                    if (!e)
+                        continue;
+                    std::size_t i = static_cast<std::uint32_t>(e >> 32) & mask;
+                    while (slots[i])
+                        i = (i + 1) & mask;
+                    slots[i] = e;
+                }
+            }
+        };
+
+        table m_table;
+        shard m_shards[shard_count];
+
+        static std::size_t hash(string_view s) noexcept {
+            return std::hash<string_view>{}(s);
+        }
+        shard& shard_of(std::size_t h) noexcept {
+            return m_shards[h >> (sizeof(std::size_t) * 8 - shard_bits)];
+        }
+        const shard& shard_of(std::size_t h) const noexcept {
+            return m_shards[h >> (sizeof(std::size_t) * 8 - shard_bits)];
+        }
+    public:
+        intern_pool() {
+            intern(string_view());
+        }
+        intern_pool(const intern_pool&) = delete;
+        intern_pool& operator=(const intern_pool&) = delete;
+
+        symbol intern(string_view s) {
+            const std::size_t h = hash(s);
+            const std::uint32_t tag = static_cast<std::uint32_t>(h);
+            shard& sh = shard_of(h);
+            std::lock_guard<std::mutex> guard(sh.mutex);
+            std::size_t i = sh.probe(tag, s, m_table);
+            if (sh.slots[i])
+                return symbol(static_cast<std::uint32_t>(sh.slots[i]) - 1);
+            const std::uint32_t id = m_table.push_back(sh.arena.make(s));
+            if (2 * (sh.count + 1) > sh.slots.size()) {
+                sh.grow();
+                i = sh.probe(tag, s, m_table);
+            }
+            sh.slots[i] = (std::uint64_t(tag) << 32) | (std::uint64_t(id) + 1);
+            ++sh.count;
+            return symbol(id);
+        }
+
+        // The symbol of s if it has been interned, without adding it
+        std::optional<symbol> find(string_view s) const {
+            const std::size_t h = hash(s);
+            const shard& sh = shard_of(h);
+            std::lock_guard<std::mutex> guard(sh.mutex);
+            const std::size_t i = sh.probe(static_cast<std::uint32_t>(h), s, m_table);
+            if (!sh.slots[i])
+                return std::nullopt;
+            return symbol(static_cast<std::uint32_t>(sh.slots[i]) - 1);
+        }
+
+        const arena_string& str(symbol sym) const noexcept {
+            return m_table[sym.id()];
+        }
+
+        std::size_t size() const noexcept { return m_table.size(); }
+
+        // Shared by the library for names and keys that repeat everywhere
+        static intern_pool& global() {
+            static intern_pool pool;
+            return pool;
+        }
+    };
+
+    inline symbol intern(string_view s) {
+        return intern_pool::global().intern(s);
+    }
+}
+
+namespace std {
+    template <>
+    struct hash<sn_String::symbol> {
+        size_t operator()(sn_String::symbol s) const noexcept {
+            // ids are dense, mixing keeps power-of-two buckets apart
+            return static_cast<size_t>(s.id() * 0x9E3779B97F4A7C15ull);
+        }
+    };
+}
+
+
+
+#endif
@@ -2,6 +2,7 @@
 #define SN_STRING_OPERATION_H
 
 #include "../sn_CommonHeader.h"
+#include "string_view.hpp"
 
 
 namespace sn_String {
@@ -15,91 +16,192 @@ namespace sn_String {
         return str.substr(pos);
     }
 
-    /*
+    // Trimmed window into str instead of a copy
+    inline string_view trim_view(string_view str, char delim = ' ') noexcept {
+        const std::size_t pos = str.find_first_not_of(string_view(&delim, 1));
+        if (pos == string_view::npos)
+            return str;
+        return str.substr(pos, str.find_last_not_of(string_view(&delim, 1)) - pos + 1);
+    }
+
     struct split_option {
         enum empty_t { empty_remain, empty_discard };
     };
-		
-    template<typename T>
-    std::vector<T> split(const T& str, const T& delimiter = "\t", split_option::empty_t empty_option = split_option::empty_remain) {
-        std::vector<T> v;
-        std::size_t current;
-        std::size_t next = -1;
-        do {
-            if (empty_option == split_option::empty_discard) {
-                next = str.find_first_not_of(delimiter, next + 1);
-                if (next == string::npos)
-                    break;
-                next -= 1;
-            }
-            current = next + 1;
-            next = str.find_first_of(delimiter, current);
-            v.push_back(str.substr(current, next - current));
-        } while (next != std::string::npos);
-        return v;
+
+    // Delimiters for split: next(str, pos) gives the position and length of the next delimiter at or
+    // after pos, npos if there is none. Scanning goes through the SIMD finders of basic_string_view.
+    namespace delimiter {
+        struct single {
+            char c;
+            std::pair<std::size_t, std::size_t> next(string_view str, std::size_t pos) const noexcept {
+                return { str.find(c, pos), 1 };
+            }
+        };
+
+        struct sequence {
+            string_view seq;
+            explicit sequence(string_view s) : seq(s) {
+                if (s.empty())
+                    throw std::invalid_argument("Empty split delimiter.");
+            }
+            std::pair<std::size_t, std::size_t> next(string_view str, std::size_t pos) const noexcept {
+                return { str.find(seq, pos), seq.size() };
+            }
+        };
+
+        struct any_of {
+            byte_set set;
+            explicit any_of(string_view chars) : set(chars.data(), chars.size()) {}
+            std::pair<std::size_t, std::size_t> next(string_view str, std::size_t pos) const noexcept {
+                return { str.find_first_of(set, pos), 1 };
+            }
+        };
+
+        template <typename Pr>
+        struct predicate {
+            Pr pred;
+            std::pair<std::size_t, std::size_t> next(string_view str, std::size_t pos) const {
+                return { str.find_if(pred, pos), 1 };
+            }
+        };
     }
-    */
 
-    std::vector<std::string> split_str(const std::string& str, char delim = ' ') {
-        std::istringstream iss{str};
-        std::vector<std::string> v;
-        for(std::string token; std::getline(iss, token, delim);) {
-            v.push_back(token);
+    // Lazy split: the pieces are views into str, nothing is allocated. With empty_remain "a,,b," gives
+    // "a", "", "b", "" and "" gives a single empty piece; empty_discard skips the empty ones.
+    template <typename Delim>
+    class split_range {
+        string_view m_str;
+        Delim m_delim;
+        split_option::empty_t m_option;
+    public:
+        class iterator {
+            const split_range* m_range = nullptr;
+            std::size_t m_begin = 0;
+            std::size_t m_end = 0;
+            std::size_t m_skip = 0;
+            bool m_last = false;
+            bool m_done = true;
+
+            friend class split_range;
+
+            void locate() {
+                const auto d = m_range->m_delim.next(m_range->m_str, m_begin);
+                m_last = d.first == string_view::npos;
+                m_end = m_last ? m_range->m_str.size() : d.first;
+                m_skip = d.second;
+            }
+            void step() {
+                if (m_last) {
+                    m_done = true;
+                    return;
+                }
+                m_begin = m_end + m_skip;
+                locate();
+            }
+            void skip_empty() {
+                if (m_range->m_option == split_option::empty_discard) {
+                    while (!m_done && m_begin == m_end)
+                        step();
+                }
+            }
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = string_view;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const string_view*;
+            using reference = string_view;
+
+            iterator() = default;
+            explicit iterator(const split_range* r) : m_range(r), m_done(false) {
+                locate();
+                skip_empty();
+            }
+
+            string_view operator*() const noexcept {
+                return string_view(m_range->m_str.data() + m_begin, m_end - m_begin);
+            }
+            iterator& operator++() {
+                step();
+                skip_empty();
+                return *this;
+            }
+            iterator operator++(int) {
+                iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+            bool operator==(const iterator& rhs) const noexcept {
+                return m_done == rhs.m_done && (m_done || m_begin == rhs.m_begin);
+            }
+            bool operator!=(const iterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+        };
+
+        split_range(string_view str, Delim delim, split_option::empty_t option)
+            : m_str(str), m_delim(std::move(delim)), m_option(option) {}
+
+        iterator begin() const { return iterator(this); }
+        iterator end() const { return iterator(); }
+
+        // Fills out[0, n) and returns the count. rest is what is left unsplit, a null view once all is consumed
+        // (an empty one still holds a trailing empty piece).
+        std::size_t fill(string_view* out, std::size_t n, string_view* rest = nullptr) const {
+            std::size_t k = 0;
+            iterator it = begin();
+            for (; k < n && !it.m_done; ++it)
+                out[k++] = *it;
+            if (rest)
+                *rest = it.m_done ? string_view() : m_str.substr(it.m_begin);
+            return k;
         }
-        return v;
+
+        // Collects into any container of string_view or of something constructible from it,
+        // e.g. split(s, ',').collect<std::vector<std::string>>()
+        template <typename Container>
+        Container collect() const {
+            Container c;
+            for (string_view piece : *this)
+                c.insert(c.end(), typename Container::value_type(piece.data(), piece.size()));
+            return c;
+        }
+    };
+
+    inline split_range<delimiter::single> split(string_view str, char delim, split_option::empty_t option = split_option::empty_remain) {
+        return { str, delimiter::single{ delim }, option };
+    }
+    inline split_range<delimiter::sequence> split(string_view str, string_view delim, split_option::empty_t option = split_option::empty_remain) {
+        return { str, delimiter::sequence(delim), option };
+    }
+    inline split_range<delimiter::sequence> split(string_view str, const char* delim, split_option::empty_t option = split_option::empty_remain) {
+        return { str, delimiter::sequence(delim), option };
+    }
+    template <typename Pr, typename = std::enable_if_t<std::is_invocable_r<bool, Pr, char>::value>>
+    split_range<delimiter::predicate<Pr>> split(string_view str, Pr pred, split_option::empty_t option = split_option::empty_remain) {
+        return { str, delimiter::predicate<Pr>{ std::move(pred) }, option };
+    }
+    // Any byte of chars is a delimiter
+    inline split_range<delimiter::any_of> split_any(string_view str, string_view chars, split_option::empty_t option = split_option::empty_remain) {
+        return { str, delimiter::any_of(chars), option };
     }
 
-    namespace detail {
-        std::array<int, 4> find_string_token(const std::string& base_string, std::string::size_type& pos, std::string::size_type& prev_len, const std::string& arg) {
-			int pprev_len = prev_len;
-			int first = base_string.find('{', pos);
-			int second = base_string.find('}', first);
-			std::string numeric = base_string.substr(first + 1, second - first - 1);
-			if (numeric.find_first_not_of("0123456789") == numeric.npos) {
-				pos = second;
-				std::array<int, 4> res{ first, second, pprev_len, atoi(numeric.c_str()) };
-				prev_len = arg.length();
-				return res;
-			}
-			else {
-				++pos;
-				return find_string_token(base_string, pos, prev_len, arg);
-			}
-		}
-
-		template <typename T, std::size_t N, std::size_t ...I>
-		void string_formatter_impl(std::string& base_string, const std::vector<std::array<int, 4>>& v, std::index_sequence<I...>, std::array<T, N> arr) {
-			std::initializer_list<int>{ (base_string.replace(std::get<0>(v[I]) + std::get<2>(v[I]) - 3 - static_cast<int>(floor(I == 0 ? 0 : log10(I))), std::get<1>(v[I]) - std::get<0>(v[I]) + 1, arr[I]), 0)...};
-		}
+    // Batch form of split: fills out[0, n), the unsplit tail goes to rest
+    template <typename Delim>
+    std::size_t split_into(string_view str, Delim delim, string_view* out, std::size_t n,
+        string_view* rest = nullptr, split_option::empty_t option = split_option::empty_remain) {
+        return split(str, delim, option).fill(out, n, rest);
     }
 
-    template <typename ...Args>
-    std::string format(std::string base_string, Args... args) {
-        auto format_list = std::make_index_sequence<sizeof...(args)>();
-        std::vector<std::array<int, 4>> token_pos{};
-        std::string::size_type current_pos = 0;
-        std::string::size_type previous_length = 3;
-        std::array<std::string, sizeof...(args)> params{ args... };
-        std::initializer_list<int>{
-            (token_pos.push_back(
-                    detail::find_string_token(base_string, current_pos, previous_length, args)), 0)...};
-        std::array<std::size_t, sizeof...(args)> idx;
-        for (std::size_t i = 0; i < idx.size(); ++i) {
-            idx[i] = i;
+    std::vector<std::string> split_str(const std::string& str, char delim = ' ') {
+        // same pieces as std::getline, which drops a trailing empty one
+        std::vector<std::string> v;
+        for (string_view token : split(str, delim)) {
+            v.emplace_back(token.data(), token.size());
         }
-        std::sort(idx.begin(), idx.end(), [&token_pos](std::size_t a, std::size_t b) {
-            return std::get<3>(token_pos[a]) < std::get<3>(token_pos[b]);
-        });
-        std::array<std::string, sizeof...(args)> params_copy;
-        for (std::size_t i = 0; i < idx.size(); ++i) {
-            params_copy[i] = params[idx[i]];
-            if (i == 0)
-                std::get<2>(token_pos[i]) = 3;
-            else
-                std::get<2>(token_pos[i]) = params_copy[i - 1].length();
+        if (!v.empty() && v.back().empty()) {
+            v.pop_back();
         }
-        detail::string_formatter_impl(base_string, token_pos, format_list, params_copy);
-        return base_string;
+        return v;
     }
 
     // reverse words is just reverse whole + reverse every word
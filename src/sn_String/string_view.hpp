@@ -2,6 +2,11 @@
 #define SN_STRING_STRING_VIEW_H
 
 #include "../sn_CommonHeader.h"
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace sn_String {
     template <typename T>
@@ -20,6 +25,436 @@ namespace sn_String {
         }
     };
 
+    // Search kernels behind basic_string_view: SIMD for plain bytes, Two-Way for everything else
+    namespace detail {
+        constexpr const std::size_t npos = static_cast<std::size_t>(-1);
+
+#if defined(__AVX2__) || defined(__SSE2__)
+        inline int ctz32(std::uint32_t x) {
+#if defined(__GNUC__)
+            return __builtin_ctz(x);
+#else
+            unsigned long i;
+            _BitScanForward(&i, x);
+            return static_cast<int>(i);
+#endif
+        }
+        inline int msb32(std::uint32_t x) {
+#if defined(__GNUC__)
+            return 31 - __builtin_clz(x);
+#else
+            unsigned long i;
+            _BitScanReverse(&i, x);
+            return static_cast<int>(i);
+#endif
+        }
+#endif
+
+        // Crochemore-Perrin Two-Way, linear time and constant space whatever the needle
+        // It is a pointer, or a reverse iterator to search the mirrored text (see two_way_last)
+        // ref: http://www-igm.univ-mlv.fr/~lecroq/string/node26.html
+        // ref: musl src/string/strstr.c
+        template <typename CharT, typename Traits, typename It>
+        std::size_t two_way(It h, std::size_t n, It s, std::size_t m, std::size_t from) {
+            if (m == 0)
+                return from <= n ? from : npos;
+            if (m > n || from > n - m)
+                return npos;
+            using diff_t = std::ptrdiff_t;
+            const diff_t l = static_cast<diff_t>(m);
+
+            // maximal suffix under both orders, the later one gives the critical factorization
+            auto maximal_suffix = [s, l](bool reversed, diff_t& period) {
+                diff_t ip = -1, jp = 0, k = 1, p = 1;
+                while (jp + k < l) {
+                    const CharT a = s[ip + k];
+                    const CharT b = s[jp + k];
+                    if (Traits::eq(a, b)) {
+                        if (k == p) {
+                            jp += p;
+                            k = 1;
+                        }
+                        else {
+                            ++k;
+                        }
+                    }
+                    else if (reversed ? Traits::lt(a, b) : Traits::lt(b, a)) {
+                        jp += k;
+                        k = 1;
+                        p = jp - ip;
+                    }
+                    else {
+                        ip = jp++;
+                        k = p = 1;
+                    }
+                }
+                period = p;
+                return ip;
+            };
+            diff_t p0 = 0, p1 = 0;
+            const diff_t ms0 = maximal_suffix(false, p0);
+            const diff_t ms1 = maximal_suffix(true, p1);
+            const diff_t ms = ms1 > ms0 ? ms1 : ms0;
+            diff_t p = ms1 > ms0 ? p1 : p0;
+
+            // remembering the matched prefix only pays off for a periodic needle
+            diff_t mem0;
+            diff_t same = 0;
+            while (same <= ms && Traits::eq(s[same], s[same + p]))
+                ++same;
+            if (same <= ms) {
+                mem0 = 0;
+                p = std::max(ms, l - ms - 1) + 1;
+            }
+            else {
+                mem0 = l - p;
+            }
+
+            // bad character shift on the last byte of the window
+            constexpr const bool byte_sized = sizeof(CharT) == 1;
+            std::size_t shift[byte_sized ? 256 : 1] = {};
+            if constexpr (byte_sized) {
+                for (diff_t i = 0; i < l; ++i)
+                    shift[static_cast<unsigned char>(s[i])] = static_cast<std::size_t>(i + 1);
+            }
+
+            diff_t mem = 0;
+            const It end = h + n;
+            for (It t = h + from; end - t >= l;) {
+                if constexpr (byte_sized) {
+                    const std::size_t sh = shift[static_cast<unsigned char>(t[l - 1])];
+                    if (sh == 0) {
+                        t += l;
+                        mem = 0;
+                        continue;
+                    }
+                    diff_t k = l - static_cast<diff_t>(sh);
+                    if (k) {
+                        if (k < mem)
+                            k = mem;
+                        t += k;
+                        mem = 0;
+                        continue;
+                    }
+                }
+                diff_t k = std::max(ms + 1, mem);
+                while (k < l && Traits::eq(s[k], t[k]))
+                    ++k;
+                if (k < l) {
+                    t += k - ms;
+                    mem = 0;
+                    continue;
+                }
+                k = ms + 1;
+                while (k > mem && Traits::eq(s[k - 1], t[k - 1]))
+                    --k;
+                if (k <= mem)
+                    return static_cast<std::size_t>(t - h);
+                t += p;
+                mem = mem0;
+            }
+            return npos;
+        }
+
+        // Last match starting at or before last_pos: the first one of the mirrored needle in the mirrored text
+        template <typename CharT, typename Traits>
+        std::size_t two_way_last(const CharT* h, std::size_t n, const CharT* s, std::size_t m, std::size_t last_pos) {
+            if (m > n)
+                return npos;
+            if (last_pos > n - m)
+                last_pos = n - m;
+            using rit = std::reverse_iterator<const CharT*>;
+            const std::size_t r = two_way<CharT, Traits>(rit(h + n), n, rit(s + m), m, n - m - last_pos);
+            return r == npos ? npos : n - m - r;
+        }
+
+        inline bool verify(const char* p, const char* s, std::size_t m) {
+            return m <= 2 || std::memcmp(p + 1, s + 1, m - 2) == 0;
+        }
+
+        // First / last byte filter over 32 (AVX2) or 16 (SSE2) candidates per block. The rest goes to
+        // Two-Way once verifying candidates costs more than the scan, so the worst case stays linear.
+        // ref: http://0x80.pl/articles/simd-strfind.html
+        inline std::size_t find(const char* h, std::size_t n, const char* s, std::size_t m, std::size_t from) {
+            if (m == 0)
+                return from <= n ? from : npos;
+            if (m > n || from > n - m)
+                return npos;
+            if (m == 1) {
+                const void* r = std::memchr(h + from, s[0], n - from);
+                return r ? static_cast<std::size_t>(static_cast<const char*>(r) - h) : npos;
+            }
+            const char* p = h + from;
+            // candidate starts are [p, last)
+            const char* const last = h + n - m + 1;
+#if defined(__AVX2__) || defined(__SSE2__)
+            // libc memchr outruns the filter until the first byte turns out to be common
+            for (std::size_t hits = 0; p < last; ++hits) {
+                if (hits >= 16 && static_cast<std::size_t>(p - (h + from)) < hits * 64)
+                    break;
+                p = static_cast<const char*>(std::memchr(p, s[0], static_cast<std::size_t>(last - p)));
+                if (!p)
+                    return npos;
+                if (p[m - 1] == s[m - 1] && verify(p, s, m))
+                    return static_cast<std::size_t>(p - h);
+                ++p;
+            }
+            const char* const begin = p;
+            std::size_t verified = 0;
+            auto too_costly = [&]() {
+                return m > 16 && verified > 4 * static_cast<std::size_t>(p - begin) + 4096;
+            };
+#if defined(__AVX2__)
+            constexpr const std::ptrdiff_t width = 32;
+            const __m256i first_v = _mm256_set1_epi8(s[0]);
+            const __m256i last_v = _mm256_set1_epi8(s[m - 1]);
+            auto candidates = [&](const char* q) {
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + m - 1));
+                return static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                    _mm256_and_si256(_mm256_cmpeq_epi8(a, first_v), _mm256_cmpeq_epi8(b, last_v))));
+            };
+#else
+            constexpr const std::ptrdiff_t width = 16;
+            const __m128i first_v = _mm_set1_epi8(s[0]);
+            const __m128i last_v = _mm_set1_epi8(s[m - 1]);
+            auto candidates = [&](const char* q) {
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + m - 1));
+                return static_cast<std::uint32_t>(_mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(a, first_v), _mm_cmpeq_epi8(b, last_v))));
+            };
+#endif
+            for (; last - p >= width; p += width) {
+                std::uint32_t mask = candidates(p);
+                while (mask) {
+                    const int i = ctz32(mask);
+                    if (verify(p + i, s, m))
+                        return static_cast<std::size_t>(p + i - h);
+                    verified += m;
+                    mask &= mask - 1;
+                }
+                if (too_costly())
+                    return two_way<char, std::char_traits<char>>(h, n, s, m, static_cast<std::size_t>(p + width - h));
+            }
+#else
+            if (m > 16)
+                return two_way<char, std::char_traits<char>>(h, n, s, m, from);
+#endif
+            while (p < last) {
+                p = static_cast<const char*>(std::memchr(p, s[0], static_cast<std::size_t>(last - p)));
+                if (!p)
+                    return npos;
+                if (p[m - 1] == s[m - 1] && verify(p, s, m))
+                    return static_cast<std::size_t>(p - h);
+                ++p;
+            }
+            return npos;
+        }
+
+        // Last match starting at or before `last_pos`, the same filter walking backwards and the same
+        // hand-over to Two-Way (on the mirrored text) once verifying gets too costly
+        inline std::size_t rfind(const char* h, std::size_t n, const char* s, std::size_t m, std::size_t last_pos) {
+            if (m > n)
+                return npos;
+            if (last_pos > n - m)
+                last_pos = n - m;
+            if (m == 0)
+                return last_pos;
+            // candidate starts are [h, hi)
+            const char* hi = h + last_pos + 1;
+#if defined(__AVX2__) || defined(__SSE2__)
+            const char* const top = hi;
+            std::size_t verified = 0;
+            auto too_costly = [&]() {
+                return m > 16 && verified > 4 * static_cast<std::size_t>(top - hi) + 4096;
+            };
+            // whatever is left below hi
+            auto rest = [&]() {
+                return hi == h ? npos : two_way_last<char, std::char_traits<char>>(h, n, s, m, static_cast<std::size_t>(hi - h) - 1);
+            };
+#endif
+#if defined(__AVX2__)
+            const __m256i first_v = _mm256_set1_epi8(s[0]);
+            const __m256i last_v = _mm256_set1_epi8(s[m - 1]);
+            for (; hi - h >= 32; hi -= 32) {
+                const char* const p = hi - 32;
+                const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + m - 1));
+                std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(
+                    _mm256_and_si256(_mm256_cmpeq_epi8(a, first_v), _mm256_cmpeq_epi8(b, last_v))));
+                while (mask) {
+                    const int i = msb32(mask);
+                    if (verify(p + i, s, m))
+                        return static_cast<std::size_t>(p + i - h);
+                    verified += m;
+                    mask &= ~(std::uint32_t(1) << i);
+                }
+                if (too_costly()) {
+                    hi = p;
+                    return rest();
+                }
+            }
+#elif defined(__SSE2__)
+            const __m128i first_v = _mm_set1_epi8(s[0]);
+            const __m128i last_v = _mm_set1_epi8(s[m - 1]);
+            for (; hi - h >= 16; hi -= 16) {
+                const char* const p = hi - 16;
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + m - 1));
+                std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(
+                    _mm_and_si128(_mm_cmpeq_epi8(a, first_v), _mm_cmpeq_epi8(b, last_v))));
+                while (mask) {
+                    const int i = msb32(mask);
+                    if (verify(p + i, s, m))
+                        return static_cast<std::size_t>(p + i - h);
+                    verified += m;
+                    mask &= ~(std::uint32_t(1) << i);
+                }
+                if (too_costly()) {
+                    hi = p;
+                    return rest();
+                }
+            }
+#else
+            if (m > 16)
+                return two_way_last<char, std::char_traits<char>>(h, n, s, m, last_pos);
+#endif
+            while (hi > h) {
+                --hi;
+                if (hi[0] == s[0] && hi[m - 1] == s[m - 1] && verify(hi, s, m))
+                    return static_cast<std::size_t>(hi - h);
+            }
+            return npos;
+        }
+    }
+
+    // A set of bytes tested 32 (AVX2) or 16 (SSSE3) at a time with nibble lookups: the low nibble
+    // picks a row of the 16x16 membership matrix, the high nibble picks the bit in that row
+    // ref: http://0x80.pl/articles/simd-byte-lookup.html
+    class byte_set {
+        std::uint64_t m_bits[4] = {};
+        alignas(16) std::uint8_t m_rows_lo[16] = {};  // bit h of row l: byte (h << 4 | l), h < 8
+        alignas(16) std::uint8_t m_rows_hi[16] = {};  // the same for h >= 8
+    public:
+        byte_set() = default;
+        byte_set(const char* s, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i)
+                insert(static_cast<unsigned char>(s[i]));
+        }
+        template <typename Pr>
+        static byte_set of(Pr pred) {
+            byte_set r;
+            for (unsigned c = 0; c < 256; ++c) {
+                if (pred(static_cast<char>(c)))
+                    r.insert(static_cast<unsigned char>(c));
+            }
+            return r;
+        }
+
+        void insert(unsigned char c) noexcept {
+            m_bits[c >> 6] |= std::uint64_t(1) << (c & 63);
+            (c < 128 ? m_rows_lo : m_rows_hi)[c & 15] |= static_cast<std::uint8_t>(1u << ((c >> 4) & 7));
+        }
+        bool contains(unsigned char c) const noexcept {
+            return (m_bits[c >> 6] >> (c & 63)) & 1;
+        }
+        byte_set operator~() const noexcept {
+            byte_set r;
+            for (unsigned c = 0; c < 256; ++c) {
+                if (!contains(static_cast<unsigned char>(c)))
+                    r.insert(static_cast<unsigned char>(c));
+            }
+            return r;
+        }
+
+        // First byte of [p + pos, p + n) in the set
+        std::size_t find(const char* p, std::size_t n, std::size_t pos = 0) const noexcept {
+            std::size_t i = pos;
+#if defined(__AVX2__)
+            const __m256i lo_t = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m_rows_lo)));
+            const __m256i hi_t = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m_rows_hi)));
+            for (; i + 32 <= n; i += 32) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+                const std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(member(v, lo_t, hi_t)));
+                if (mask)
+                    return i + static_cast<std::size_t>(detail::ctz32(mask));
+            }
+#elif defined(__SSSE3__)
+            const __m128i lo_t = _mm_load_si128(reinterpret_cast<const __m128i*>(m_rows_lo));
+            const __m128i hi_t = _mm_load_si128(reinterpret_cast<const __m128i*>(m_rows_hi));
+            for (; i + 16 <= n; i += 16) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                const std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(member(v, lo_t, hi_t)));
+                if (mask)
+                    return i + static_cast<std::size_t>(detail::ctz32(mask));
+            }
+#endif
+            for (; i < n; ++i) {
+                if (contains(static_cast<unsigned char>(p[i])))
+                    return i;
+            }
+            return detail::npos;
+        }
+
+        // Last byte of [p, p + min(pos + 1, n)) in the set
+        std::size_t rfind(const char* p, std::size_t n, std::size_t pos = detail::npos) const noexcept {
+            std::size_t i = pos < n ? pos + 1 : n;
+#if defined(__AVX2__)
+            const __m256i lo_t = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m_rows_lo)));
+            const __m256i hi_t = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m_rows_hi)));
+            for (; i >= 32; i -= 32) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i - 32));
+                const std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(member(v, lo_t, hi_t)));
+                if (mask)
+                    return i - 32 + static_cast<std::size_t>(detail::msb32(mask));
+            }
+#elif defined(__SSSE3__)
+            const __m128i lo_t = _mm_load_si128(reinterpret_cast<const __m128i*>(m_rows_lo));
+            const __m128i hi_t = _mm_load_si128(reinterpret_cast<const __m128i*>(m_rows_hi));
+            for (; i >= 16; i -= 16) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i - 16));
+                const std::uint32_t mask = static_cast<std::uint32_t>(_mm_movemask_epi8(member(v, lo_t, hi_t)));
+                if (mask)
+                    return i - 16 + static_cast<std::size_t>(detail::msb32(mask));
+            }
+#endif
+            while (i > 0) {
+                --i;
+                if (contains(static_cast<unsigned char>(p[i])))
+                    return i;
+            }
+            return detail::npos;
+        }
+
+    private:
+#if defined(__AVX2__)
+        static __m256i member(__m256i v, __m256i lo_t, __m256i hi_t) {
+            const __m256i bit_t = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128,
+                1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            const __m256i nib = _mm256_set1_epi8(0x0F);
+            const __m256i lo = _mm256_and_si256(v, nib);
+            const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nib);
+            const __m256i upper = _mm256_cmpgt_epi8(hi, _mm256_set1_epi8(7));
+            const __m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(lo_t, lo), _mm256_shuffle_epi8(hi_t, lo), upper);
+            const __m256i bit = _mm256_shuffle_epi8(bit_t, hi);
+            return _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+        }
+#elif defined(__SSSE3__)
+        static __m128i member(__m128i v, __m128i lo_t, __m128i hi_t) {
+            const __m128i bit_t = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+            const __m128i nib = _mm_set1_epi8(0x0F);
+            const __m128i lo = _mm_and_si128(v, nib);
+            const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), nib);
+            const __m128i upper = _mm_cmpgt_epi8(hi, _mm_set1_epi8(7));
+            const __m128i row = _mm_or_si128(_mm_andnot_si128(upper, _mm_shuffle_epi8(lo_t, lo)),
+                _mm_and_si128(upper, _mm_shuffle_epi8(hi_t, lo)));
+            const __m128i bit = _mm_shuffle_epi8(bit_t, hi);
+            return _mm_cmpeq_epi8(_mm_and_si128(row, bit), bit);
+        }
+#endif
+    };
+
     // God, I really wish I can use C++17
     template <typename CharT, typename Traits = std::char_traits<CharT>>
     class basic_string_view : public less_than<basic_string_view<CharT, Traits>> {
@@ -61,6 +496,7 @@ namespace sn_String {
         basic_string_view& operator=(basic_string_view&&) = default;
 
         pointer data() noexcept { return m_data; }
+        const_pointer data() const noexcept { return m_data; }
 
         // non-standard, modified to const version
         iterator begin() noexcept { return m_data; }
@@ -186,86 +622,129 @@ namespace sn_String {
             }
             return res;
         }
+        // plain chars go to the SIMD kernels, other traits keep the generic loops
+        constexpr static const bool is_byte = std::is_same<CharT, char>::value && std::is_same<Traits, std::char_traits<char>>::value;
+
         size_type find(CharT c, size_type pos = 0) const noexcept {
-            if (pos > m_size) {
+            if (pos >= m_size) {
                 return npos;
             }
-            const_iterator it = std::find(
-                begin() + pos, end(), c
-            );
-            if (it == end()) {
+            const_pointer p = Traits::find(m_data + pos, m_size - pos, c);
+            return p ? static_cast<size_type>(p - m_data) : npos;
+        }
+        size_type find(basic_string_view sv, size_type pos = 0) const noexcept {
+            if constexpr (is_byte) {
+                return detail::find(m_data, m_size, sv.m_data, sv.m_size, pos);
+            }
+            else if (sv.m_size == 1) {
+                return find(sv[0], pos);
+            }
+            else {
+                return detail::two_way<CharT, Traits>(m_data, m_size, sv.m_data, sv.m_size, pos);
+            }
+        }
+        size_type rfind(CharT c, size_type pos = npos) const noexcept {
+            if (m_size == 0) {
                 return npos;
             }
-            return std::distance(begin(), it);
+            for (size_type i = std::min(pos, m_size - 1) + 1; i > 0; --i) {
+                if (Traits::eq(m_data[i - 1], c)) {
+                    return i - 1;
+                }
+            }
+            return npos;
         }
-    /*
+        size_type rfind(basic_string_view sv, size_type pos = npos) const noexcept {
+            if constexpr (is_byte) {
+                return detail::rfind(m_data, m_size, sv.m_data, sv.m_size, pos);
+            }
+            else if (sv.m_size == 1) {
+                return rfind(sv[0], pos);
+            }
+            else {
+                return detail::two_way_last<CharT, Traits>(m_data, m_size, sv.m_data, sv.m_size, pos);
+            }
+        }
+
+        // non-standard, find(Pr) would take string literals away from find(basic_string_view)
         template <typename Pr>
-        size_type find(Pr pred, size_type pos = 0) const noexcept {
+        size_type find_if(Pr pred, size_type pos = 0) const {
             if (pos > m_size) {
                 return npos;
             }
-            const_iterator it = std::find_if(
-                begin() + pos, end(), pred
-            );
+            const_iterator it = std::find_if(begin() + pos, end(), pred);
             if (it == end()) {
                 return npos;
             }
             return std::distance(begin(), it);
         }
-    */
-        size_type find(basic_string_view sv, size_type pos = 0) const noexcept {
-            if (pos > m_size) {
-                return npos;
+        template <typename Pr>
+        size_type rfind_if(Pr pred, size_type pos = npos) const {
+            for (size_type i = std::min(pos, m_size - 1) + 1; m_size != 0 && i > 0; --i) {
+                if (pred(m_data[i - 1])) {
+                    return i - 1;
+                }
             }
-            // Better use boyer-moore search
-            const_iterator it = std::search(
-                begin() + pos, end(), sv.begin(), sv.end()
-            );
-            if (it == end()) {
-                return npos;
+            return npos;
+        }
+
+        // Every match at or after pos, in one pass, non-overlapping unless asked
+        template <typename OutputIt>
+        OutputIt find_all(basic_string_view sv, OutputIt out, bool overlap = false, size_type pos = 0) const {
+            const size_type step = overlap || sv.m_size == 0 ? 1 : sv.m_size;
+            for (size_type i = find(sv, pos); i != npos; i = find(sv, i + step)) {
+                *out++ = i;
+            }
+            return out;
+        }
+        std::vector<size_type> find_all(basic_string_view sv, bool overlap = false, size_type pos = 0) const {
+            std::vector<size_type> v;
+            find_all(sv, std::back_inserter(v), overlap, pos);
+            return v;
+        }
+
+        size_type find_first_of(basic_string_view set, size_type pos = 0) const noexcept {
+            if constexpr (is_byte) {
+                if (set.m_size == 1) {
+                    return find(set[0], pos);
+                }
+                return pos < m_size ? byte_set(set.m_data, set.m_size).find(m_data, m_size, pos) : npos;
+            }
+            else {
+                return find_if([set](CharT c) { return Traits::find(set.m_data, set.m_size, c) != nullptr; }, pos);
             }
-            return std::distance(begin(), it);
         }
-        size_type rfind(CharT c, size_type pos = 0) const noexcept {
-            if (pos > m_size) {
-                return npos;
+        size_type find_first_not_of(basic_string_view set, size_type pos = 0) const noexcept {
+            if constexpr (is_byte) {
+                return pos < m_size ? (~byte_set(set.m_data, set.m_size)).find(m_data, m_size, pos) : npos;
             }
-            const_iterator it = std::find(
-                rbegin() + pos, rend(), c
-            );
-            if (it == rend()) {
-                return npos;
+            else {
+                return find_if([set](CharT c) { return Traits::find(set.m_data, set.m_size, c) == nullptr; }, pos);
             }
-            return std::distance(rbegin(), it);
         }
-        size_type rfind(basic_string_view sv, size_type pos = 0) const noexcept {
-            if (pos > m_size) {
-                return npos;
+        size_type find_last_of(basic_string_view set, size_type pos = npos) const noexcept {
+            if constexpr (is_byte) {
+                return byte_set(set.m_data, set.m_size).rfind(m_data, m_size, pos);
             }
-            const_iterator it = std::search(
-                rbegin() + pos, rend, sv.rbegin(), sv.rend()
-            );
-            if (it == rend()) {
-                return npos;
+            else {
+                return rfind_if([set](CharT c) { return Traits::find(set.m_data, set.m_size, c) != nullptr; }, pos);
             }
-            return std::distance(rbegin(), it);
         }
-    /*
-        template <typename Pr>
-        size_type rfind(Pr pred, size_type pos = 0) const noexcept {
-            if (pos > m_size) {
-                return npos;
+        size_type find_last_not_of(basic_string_view set, size_type pos = npos) const noexcept {
+            if constexpr (is_byte) {
+                return (~byte_set(set.m_data, set.m_size)).rfind(m_data, m_size, pos);
             }
-            const_iterator it = std::find_if(
-                rbegin() + pos, rend(), pred
-            );
-            if (it == rend()) {
-                return npos;
+            else {
+                return rfind_if([set](CharT c) { return Traits::find(set.m_data, set.m_size, c) == nullptr; }, pos);
             }
-            return std::distance(begin(), it);
         }
-    */
-        // find_xxx_of the same.
+        // non-standard, a prebuilt set (byte_set::of(pred) included) skips the table setup per call
+        size_type find_first_of(const byte_set& set, size_type pos = 0) const noexcept {
+            return pos < m_size ? set.find(m_data, m_size, pos) : npos;
+        }
+        size_type find_last_of(const byte_set& set, size_type pos = npos) const noexcept {
+            return set.rfind(m_data, m_size, pos);
+        }
         
         // non-standard, and should be a non-member function
         // Rely on NRVO optimization
@@ -288,9 +767,9 @@ namespace sn_String {
         std::vector<basic_string_view> split(Pr pred, bool keep_empty = false) const noexcept {
             std::vector<basic_string_view> v;
             size_type last_beg = 0;
-            size_type last_end = find(pred);
+            size_type last_end = find_if(pred);
             for (; last_end != npos; 
-                last_beg = last_end + 1, last_end = find(pred, last_beg)) {
+                last_beg = last_end + 1, last_end = find_if(pred, last_beg)) {
                 if (last_beg != last_end || keep_empty) {
                     v.push_back(basic_string_view{m_data + last_beg, last_end - last_beg});
                 }
@@ -414,9 +893,13 @@ namespace sn_String {
 // UB
 namespace std {
     template <typename CharT, typename Traits>
-    struct hash<sn_String::basic_string_view<CharT, Traits>> : public unary_function<sn_String::basic_string_view<CharT, Traits>, size_t> {
+    struct hash<sn_String::basic_string_view<CharT, Traits>> {
         size_t operator()(const sn_String::basic_string_view<CharT, Traits>& sv) const noexcept {
-            return hash<std::basic_string<CharT, Traits, std::allocator<CharT>>>(sv);
+            return hash<std::basic_string_view<CharT, Traits>>{}(std::basic_string_view<CharT, Traits>(sv.data(), sv.size()));
         }
     };
 }
+
+
+#endif
+
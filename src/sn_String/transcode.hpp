@@ -0,0 +1,659 @@
+#ifndef SN_STRING_TRANSCODE_H
+#define SN_STRING_TRANSCODE_H
+
+#include "../sn_CommonHeader.h"
+#include "gbk_table.hpp"
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace sn_String {
+    // Transcoding between UTF-8, UTF-16, UTF-32 and GBK. The span functions read [src, src + n), write at most
+    // cap units to dst and never allocate; only the std::basic_string wrappers at the bottom do, once each.
+    // Any unit type of the right width works (char16_t, char32_t, wchar_t, std::uint16_t...).
+    namespace transcode {
+        constexpr const std::size_t npos = static_cast<std::size_t>(-1);
+
+        enum class error { none, invalid, truncated, output_full };
+
+        // strict stops at the first bad sequence, replace writes U+FFFD for each bad unit and goes on
+        enum class policy { strict, replace };
+
+        struct result {
+            error err;
+            std::size_t read;       // units consumed, or where the failing sequence starts
+            std::size_t written;    // units written
+            explicit operator bool() const noexcept { return err == error::none; }
+        };
+
+        namespace detail {
+            enum status { ok, bad, partial };
+
+            template <typename Unit>
+            inline std::uint32_t unit(Unit c) noexcept {
+                return static_cast<std::uint32_t>(static_cast<std::make_unsigned_t<Unit>>(c));
+            }
+
+            struct utf8 {
+                template <typename In>
+                static status decode(const In* s, std::size_t n, std::size_t& i, char32_t& cp) noexcept {
+                    const std::uint32_t c = unit(s[i]);
+                    if (c < 0x80) {
+                        cp = c;
+                        ++i;
+                        return ok;
+                    }
+                    // the second byte range is where overlongs, surrogates and > U+10FFFF show
+                    if (c < 0xE0) {
+                        if (c < 0xC2)
+                            return bad;
+                        if (i + 1 >= n)
+                            return partial;
+                        const std::uint32_t t1 = unit(s[i + 1]);
+                        if ((t1 & 0xC0) != 0x80)
+                            return bad;
+                        cp = ((c & 0x1F) << 6) | (t1 & 0x3F);
+                        i += 2;
+                        return ok;
+                    }
+                    if (c < 0xF0) {
+                        const std::uint32_t lo = c == 0xE0 ? 0xA0 : 0x80, hi = c == 0xED ? 0x9F : 0xBF;
+                        if (i + 1 >= n)
+                            return partial;
+                        const std::uint32_t t1 = unit(s[i + 1]);
+                        if (t1 < lo || t1 > hi)
+                            return bad;
+                        if (i + 2 >= n)
+                            return partial;
+                        const std::uint32_t t2 = unit(s[i + 2]);
+                        if ((t2 & 0xC0) != 0x80)
+                            return bad;
+                        cp = ((c & 0x0F) << 12) | ((t1 & 0x3F) << 6) | (t2 & 0x3F);
+                        i += 3;
+                        return ok;
+                    }
+                    if (c >= 0xF5)
+                        return bad;
+                    const std::uint32_t lo = c == 0xF0 ? 0x90 : 0x80, hi = c == 0xF4 ? 0x8F : 0xBF;
+                    if (i + 1 >= n)
+                        return partial;
+                    const std::uint32_t t1 = unit(s[i + 1]);
+                    if (t1 < lo || t1 > hi)
+                        return bad;
+                    if (i + 2 >= n)
+                        return partial;
+                    const std::uint32_t t2 = unit(s[i + 2]);
+                    if ((t2 & 0xC0) != 0x80)
+                        return bad;
+                    if (i + 3 >= n)
+                        return partial;
+                    const std::uint32_t t3 = unit(s[i + 3]);
+                    if ((t3 & 0xC0) != 0x80)
+                        return bad;
+                    cp = ((c & 0x07) << 18) | ((t1 & 0x3F) << 12) | ((t2 & 0x3F) << 6) | (t3 & 0x3F);
+                    i += 4;
+                    return ok;
+                }
+
+                template <typename Out>
+                static bool encode(char32_t cp, Out* d, std::size_t cap, std::size_t& w) noexcept {
+                    if (cp < 0x80) {
+                        if (w == cap)
+                            return false;
+                        d[w++] = static_cast<Out>(cp);
+                    } else if (cp < 0x800) {
+                        if (cap - w < 2)
+                            return false;
+                        d[w++] = static_cast<Out>(0xC0 | (cp >> 6));
+                        d[w++] = static_cast<Out>(0x80 | (cp & 0x3F));
+                    } else if (cp < 0x10000) {
+                        if (cap - w < 3)
+                            return false;
+                        d[w++] = static_cast<Out>(0xE0 | (cp >> 12));
+                        d[w++] = static_cast<Out>(0x80 | ((cp >> 6) & 0x3F));
+                        d[w++] = static_cast<Out>(0x80 | (cp & 0x3F));
+                    } else {
+                        if (cap - w < 4)
+                            return false;
+                        d[w++] = static_cast<Out>(0xF0 | (cp >> 18));
+                        d[w++] = static_cast<Out>(0x80 | ((cp >> 12) & 0x3F));
+                        d[w++] = static_cast<Out>(0x80 | ((cp >> 6) & 0x3F));
+                        d[w++] = static_cast<Out>(0x80 | (cp & 0x3F));
+                    }
+                    return true;
+                }
+            };
+
+            struct utf16 {
+                template <typename In>
+                static status decode(const In* s, std::size_t n, std::size_t& i, char32_t& cp) noexcept {
+                    const std::uint32_t c = unit(s[i]);
+                    if (c - 0xD800 >= 0x800) {
+                        cp = c;
+                        ++i;
+                        return ok;
+                    }
+                    if (c >= 0xDC00)
+                        return bad;
+                    if (i + 1 >= n)
+                        return partial;
+                    const std::uint32_t t = unit(s[i + 1]);
+                    if (t - 0xDC00 >= 0x400)
+                        return bad;
+                    cp = 0x10000 + ((c - 0xD800) << 10) + (t - 0xDC00);
+                    i += 2;
+                    return ok;
+                }
+
+                template <typename Out>
+                static bool encode(char32_t cp, Out* d, std::size_t cap, std::size_t& w) noexcept {
+                    if (cp < 0x10000) {
+                        if (w == cap)
+                            return false;
+                        d[w++] = static_cast<Out>(cp);
+                    } else {
+                        if (cap - w < 2)
+                            return false;
+                        d[w++] = static_cast<Out>(0xD800 + ((cp - 0x10000) >> 10));
+                        d[w++] = static_cast<Out>(0xDC00 + ((cp - 0x10000) & 0x3FF));
+                    }
+                    return true;
+                }
+            };
+
+            struct utf32 {
+                template <typename In>
+                static status decode(const In* s, std::size_t, std::size_t& i, char32_t& cp) noexcept {
+                    const std::uint32_t c = unit(s[i]);
+                    if (c > 0x10FFFF || c - 0xD800 < 0x800)
+                        return bad;
+                    cp = c;
+                    ++i;
+                    return ok;
+                }
+
+                template <typename Out>
+                static bool encode(char32_t cp, Out* d, std::size_t cap, std::size_t& w) noexcept {
+                    if (w == cap)
+                        return false;
+                    d[w++] = static_cast<Out>(cp);
+                    return true;
+                }
+            };
+
+            // Decode only: one table lookup per double-byte character
+            struct gbk {
+                template <typename In>
+                static status decode(const In* s, std::size_t n, std::size_t& i, char32_t& cp) noexcept {
+                    const std::uint32_t c = unit(s[i]);
+                    if (c < 0x80) {
+                        cp = c;
+                        ++i;
+                        return ok;
+                    }
+                    if (c == 0x80 || c == 0xFF)
+                        return bad;
+                    if (i + 1 >= n)
+                        return partial;
+                    const std::uint32_t t = unit(s[i + 1]);
+                    if (t < 0x40 || t == 0xFF)
+                        return bad;
+                    const std::uint16_t v = gbk_table[(c - 0x81) * gbk_trail_count + (t - 0x40)];
+                    if (!v)
+                        return bad;
+                    cp = v;
+                    i += 2;
+                    return ok;
+                }
+            };
+
+            // Copies the ASCII run at the head of s, which reads the same in every encoding here, and returns its
+            // length. SSE2 moves 16 units per step, widening or narrowing on the way; the scalar loop finishes the run.
+            template <typename In, typename Out>
+            inline std::size_t copy_ascii(const In* s, std::size_t n, Out* d, std::size_t cap) noexcept {
+                std::size_t k = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+                const __m128i zero = _mm_setzero_si128();
+                if constexpr (sizeof(In) == 1) {
+                    for (; k + 16 <= n && k + 16 <= cap; k += 16) {
+                        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k));
+                        if (_mm_movemask_epi8(v))
+                            break;
+                        if constexpr (sizeof(Out) == 1) {
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k), v);
+                        } else if constexpr (sizeof(Out) == 2) {
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k), _mm_unpacklo_epi8(v, zero));
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k + 8), _mm_unpackhi_epi8(v, zero));
+                        } else if constexpr (sizeof(Out) == 4) {
+                            const __m128i lo = _mm_unpacklo_epi8(v, zero);
+                            const __m128i hi = _mm_unpackhi_epi8(v, zero);
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k), _mm_unpacklo_epi16(lo, zero));
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k + 4), _mm_unpackhi_epi16(lo, zero));
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k + 8), _mm_unpacklo_epi16(hi, zero));
+                            _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k + 12), _mm_unpackhi_epi16(hi, zero));
+                        }
+                    }
+                } else if constexpr (sizeof(In) == 2 && sizeof(Out) == 1) {
+                    const __m128i high = _mm_set1_epi16(static_cast<short>(0xFF80));
+                    for (; k + 16 <= n && k + 16 <= cap; k += 16) {
+                        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k));
+                        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k + 8));
+                        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(a, b), high), zero)) != 0xFFFF)
+                            break;
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k), _mm_packus_epi16(a, b));
+                    }
+                } else if constexpr (sizeof(In) == 4 && sizeof(Out) == 1) {
+                    const __m128i high = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+                    for (; k + 16 <= n && k + 16 <= cap; k += 16) {
+                        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k));
+                        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k + 4));
+                        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k + 8));
+                        const __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + k + 12));
+                        const __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, e));
+                        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(all, high), zero)) != 0xFFFF)
+                            break;
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + k), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, e)));
+                    }
+                }
+#endif
+                for (; k < n && k < cap && unit(s[k]) < 0x80; ++k)
+                    d[k] = static_cast<Out>(s[k]);
+                return k;
+            }
+
+            template <typename Decoder, typename Encoder, typename In, typename Out>
+            result run(const In* s, std::size_t n, Out* d, std::size_t cap, policy p) noexcept {
+                std::size_t i = 0, w = 0;
+                while (i < n) {
+                    if (unit(s[i]) < 0x80) {
+                        const std::size_t k = copy_ascii(s + i, n - i, d + w, cap - w);
+                        i += k;
+                        w += k;
+                        if (i == n)
+                            break;
+                    }
+                    const std::size_t at = i;
+                    char32_t cp;
+                    const status st = Decoder::decode(s, n, i, cp);
+                    if (st != ok) {
+                        if (p == policy::strict)
+                            return { st == bad ? error::invalid : error::truncated, at, w };
+                        cp = 0xFFFD;
+                        i = at + 1;
+                    }
+                    if (!Encoder::encode(cp, d, cap, w))
+                        return { error::output_full, at, w };
+                }
+                return { error::none, i, w };
+            }
+
+            inline std::size_t validate_utf8_scalar(const char* s, std::size_t n, std::size_t i) noexcept {
+                while (i < n) {
+                    for (; i + 8 <= n; i += 8) {
+                        std::uint64_t v;
+                        std::memcpy(&v, s + i, 8);
+                        if (v & 0x8080808080808080ull)
+                            break;
+                    }
+                    if (i == n)
+                        break;
+                    const std::size_t at = i;
+                    char32_t cp;
+                    if (utf8::decode(s, n, i, cp) != ok)
+                        return at;
+                }
+                return npos;
+            }
+
+            // First lead or ASCII byte in [i - 3, i]: everything before it has been checked already, and
+            // a sequence reaching into the block at i cannot start any earlier
+            inline std::size_t resync(const char* s, std::size_t i) noexcept {
+                std::size_t j = i >= 3 ? i - 3 : 0;
+                while (j < i && (unit(s[j]) & 0xC0) == 0x80)
+                    ++j;
+                return j;
+            }
+
+#if defined(__SSSE3__)
+            // Keiser-Lemire: three nibble lookups classify each (previous byte, byte) pair, and a separate check
+            // asks that the 3rd/4th bytes of a sequence be continuation bytes. Nonzero lanes are errors.
+            // ref: https://arxiv.org/abs/2010.03090
+            // ref: simdjson src/generic/stage1/utf8_lookup4_algorithm.h
+            inline __m128i utf8_block_error(__m128i input, __m128i prev_input) noexcept {
+                constexpr char TOO_SHORT = 1 << 0;      // 11______ 0_______ or 11______ 11______
+                constexpr char TOO_LONG = 1 << 1;       // 0_______ 10______
+                constexpr char OVERLONG_3 = 1 << 2;     // 11100000 100_____
+                constexpr char TOO_LARGE = 1 << 3;      // 11110100 1001____ and up
+                constexpr char SURROGATE = 1 << 4;      // 11101101 101_____
+                constexpr char OVERLONG_2 = 1 << 5;     // 1100000_ 10______
+                constexpr char TOO_LARGE_1000 = 1 << 6; // 11110101 1000____ and up
+                constexpr char OVERLONG_4 = 1 << 6;     // 11110000 1000____
+                constexpr char TWO_CONTS = static_cast<char>(1 << 7); // 10______ 10______
+                constexpr char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+                const __m128i byte_1_high_table = _mm_setr_epi8(
+                    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                    TOO_SHORT | OVERLONG_2,
+                    TOO_SHORT,
+                    TOO_SHORT | OVERLONG_3 | SURROGATE,
+                    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+                const __m128i byte_1_low_table = _mm_setr_epi8(
+                    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+                    CARRY | OVERLONG_2,
+                    CARRY,
+                    CARRY,
+                    CARRY | TOO_LARGE,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000);
+                const __m128i byte_2_high_table = _mm_setr_epi8(
+                    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+                    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+                const __m128i nibble = _mm_set1_epi8(0x0F);
+                const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+                const __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+                const __m128i byte_1_low = _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, nibble));
+                const __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table, _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+                const __m128i special = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+                // 111_____ two bytes back or 1111____ three bytes back: bit 7 says a continuation is due
+                const __m128i third = _mm_subs_epu8(_mm_alignr_epi8(input, prev_input, 14), _mm_set1_epi8(0xE0 - 0x80));
+                const __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(input, prev_input, 13), _mm_set1_epi8(0xF0 - 0x80));
+                const __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+                return _mm_xor_si128(must23, special);
+            }
+
+            // Checks whole 16-byte blocks and returns where the scalar pass has to take over: the tail, or
+            // the block holding the first error, so the exact position still comes out of validate_utf8_scalar
+            inline std::size_t validate_utf8_blocks(const char* s, std::size_t n) noexcept {
+                // lanes still waiting for continuation bytes when the block ends
+                const __m128i max_complete = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                    static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+                const __m128i zero = _mm_setzero_si128();
+                __m128i prev = zero, prev_incomplete = zero;
+                std::size_t i = 0;
+                for (; i + 16 <= n; i += 16) {
+                    // ASCII runs go 64 bytes at a time once no sequence is left open
+                    while (i + 64 <= n && _mm_movemask_epi8(_mm_cmpeq_epi8(prev_incomplete, zero)) == 0xFFFF) {
+                        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+                        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 16));
+                        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 32));
+                        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 48));
+                        if (_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d))))
+                            break;
+                        prev = d;
+                        i += 64;
+                    }
+                    if (i + 16 > n)
+                        break;
+                    const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+                    __m128i err;
+                    if (!_mm_movemask_epi8(input)) {
+                        err = prev_incomplete;
+                        prev_incomplete = zero;
+                    } else {
+                        err = utf8_block_error(input, prev);
+                        prev_incomplete = _mm_subs_epu8(input, max_complete);
+                    }
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi8(err, zero)) != 0xFFFF)
+                        break;
+                    prev = input;
+                }
+                return resync(s, i);
+            }
+#endif
+        }
+
+        // npos when [s, s + n) is well-formed UTF-8, else where the first bad or cut-off sequence starts
+        inline std::size_t validate_utf8(const char* s, std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(__SSSE3__)
+            i = detail::validate_utf8_blocks(s, n);
+#endif
+            return detail::validate_utf8_scalar(s, n, i);
+        }
+
+        namespace detail {
+            // UTF-8 that validate_utf8 has passed: only the output capacity is left to check
+            template <typename Encoder, typename Out>
+            bool transcode_valid_utf8(const char* s, std::size_t n, std::size_t& i, Out* d, std::size_t cap, std::size_t& w) noexcept {
+                while (i < n) {
+                    const std::uint32_t c = unit(s[i]);
+                    if (c < 0x80) {
+                        const std::size_t k = copy_ascii(s + i, n - i, d + w, cap - w);
+                        i += k;
+                        w += k;
+                        if (i < n && unit(s[i]) < 0x80)
+                            return false;
+                        continue;
+                    }
+                    char32_t cp;
+                    std::size_t len;
+                    if (c < 0xE0) {
+                        cp = ((c & 0x1F) << 6) | (unit(s[i + 1]) & 0x3F);
+                        len = 2;
+                    } else if (c < 0xF0) {
+                        cp = ((c & 0x0F) << 12) | ((unit(s[i + 1]) & 0x3F) << 6) | (unit(s[i + 2]) & 0x3F);
+                        len = 3;
+                    } else {
+                        cp = ((c & 0x07) << 18) | ((unit(s[i + 1]) & 0x3F) << 12) | ((unit(s[i + 2]) & 0x3F) << 6) | (unit(s[i + 3]) & 0x3F);
+                        len = 4;
+                    }
+                    if (!Encoder::encode(cp, d, cap, w))
+                        return false;
+                    i += len;
+                }
+                return true;
+            }
+
+            // Validate with SIMD first, then decode the good prefix unchecked; the checked loop takes the rest
+            template <typename Encoder, typename Out>
+            result run_utf8(const char* s, std::size_t n, Out* d, std::size_t cap, policy p) noexcept {
+                const std::size_t bad_at = validate_utf8(s, n);
+                const std::size_t end = bad_at == npos ? n : bad_at;
+                std::size_t i = 0, w = 0;
+                if (!transcode_valid_utf8<Encoder>(s, end, i, d, cap, w))
+                    return { error::output_full, i, w };
+                if (end == n)
+                    return { error::none, n, w };
+                if (p == policy::strict) {
+                    char32_t cp;
+                    return { utf8::decode(s, n, i, cp) == partial ? error::truncated : error::invalid, end, w };
+                }
+                const result r = run<utf8, Encoder>(s + end, n - end, d + w, cap - w, p);
+                return { r.err, end + r.read, w + r.written };
+            }
+        }
+
+        inline bool is_ascii(const char* s, std::size_t n) noexcept {
+            std::size_t i = 0;
+#if defined(__AVX2__) || defined(__SSE2__)
+            __m128i acc = _mm_setzero_si128();
+            for (; i + 16 <= n; i += 16)
+                acc = _mm_or_si128(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)));
+            if (_mm_movemask_epi8(acc))
+                return false;
+#endif
+            for (; i < n; ++i) {
+                if (static_cast<unsigned char>(s[i]) >= 0x80)
+                    return false;
+            }
+            return true;
+        }
+
+        // Worst-case output sizes, in units: UTF-8 -> UTF-16/32 and GBK -> UTF-16/32 need n,
+        // UTF-16 -> UTF-8 and GBK -> UTF-8 need 3n, UTF-32 -> UTF-8 needs 4n, UTF-16 <-> UTF-32 need n.
+        template <typename Char16, typename = std::enable_if_t<sizeof(Char16) == 2>>
+        result utf8_to_utf16(const char* src, std::size_t n, Char16* dst, std::size_t cap, policy p = policy::strict) noexcept {
+            return detail::run_utf8<detail::utf16>(src, n, dst, cap, p);
+        }
+        template <typename Char32, typename = std::enable_if_t<sizeof(Char32) == 4>>
+        result utf8_to_utf32(const char* src, std::size_t n, Char32* dst, std::size_t cap, policy p = policy::strict) noexcept {
+            return detail::run_utf8<detail::utf32>(src, n, dst, cap, p);
+        }
+        template <typename Char16, typename = std::enable_if_t<sizeof(Char16) == 2>>
+        result utf16_to_utf8(const Char16* src, std::size_t n, char* dst, std::size_t cap, policy p = policy::strict) noexcept {
+            return detail::run<detail::utf16, detail::utf8>(src, n, dst, cap, p);
+        }
+        template <typename Char32, typename = std::enable_if_t<sizeof(Char32) == 4>>
+        result utf32_to_utf8(const Char32* src, std::size_t n, char* dst, std::size_t cap, policy p = policy::strict) noexcept {
+            return detail::run<detail::utf32, detail::utf8>(src, n, dst, cap, p);
+        }
+        template <typename Char16, typename Char32, typename = std::enable_if_t<sizeof(Char16) == 2 && sizeof(Char32) == 4>>
+        result utf16_to_utf32(const Char16* src, std::size_t n, Char32* dst, std::size_t cap, policy p = policy::strict) noexcept {
+            return detail::run<detail::utf16, detail::utf32>(src, n, dst, cap, p);
+        }
+        template <typename Char32, typename Char16, typename = std::enable_if_t<sizeof(Char16) == 2 && sizeof(Char32) == 4>>
+        result utf32_to_utf16(const Char32* src, std::size_t n, Char16* dst, std::size_t cap, policy p = policy::strict) noexcept {
+            return detail::run<detail::utf32, detail::utf16>(src, n, dst, cap, p);
+        }
+        template <typename Char16, typename = std::enable_if_t<sizeof(Char16) == 2>>
+        result gbk_to_utf16(const char* src, std::size_t n, Char16* dst, std::size_t cap, policy p = policy::strict) noexcept {
+            return detail::run<detail::gbk, detail::utf16>(src, n, dst, cap, p);
+        }
+        template <typename Char32, typename = std::enable_if_t<sizeof(Char32) == 4>>
+        result gbk_to_utf32(const char* src, std::size_t n, Char32* dst, std::size_t cap, policy p = policy::strict) noexcept {
+            return detail::run<detail::gbk, detail::utf32>(src, n, dst, cap, p);
+        }
+        inline result gbk_to_utf8(const char* src, std::size_t n, char* dst, std::size_t cap, policy p = policy::strict) noexcept {
+            return detail::run<detail::gbk, detail::utf8>(src, n, dst, cap, p);
+        }
+
+        // Writes 2n hex digits to dst and returns 2n
+        inline std::size_t hex_encode(const void* src, std::size_t n, char* dst, bool upper = false) noexcept {
+            const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+            const unsigned char* p = static_cast<const unsigned char*>(src);
+            std::size_t i = 0;
+#if defined(__SSSE3__)
+            const __m128i lut = _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits));
+            const __m128i nibble = _mm_set1_epi8(0x0F);
+            for (; i + 16 <= n; i += 16) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                const __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+                const __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, nibble));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+            }
+#endif
+            for (; i < n; ++i) {
+                dst[2 * i] = digits[p[i] >> 4];
+                dst[2 * i + 1] = digits[p[i] & 0x0F];
+            }
+            return 2 * n;
+        }
+
+        // Reads n hex digits of either case into n / 2 bytes and returns n / 2; npos on an odd n or a non hex digit
+        inline std::size_t hex_decode(const char* src, std::size_t n, unsigned char* dst) noexcept {
+            if (n % 2)
+                return npos;
+            std::size_t i = 0;
+#if defined(__SSSE3__)
+            const __m128i nine = _mm_set1_epi8(9);
+            const __m128i five = _mm_set1_epi8(5);
+            for (; i + 16 <= n; i += 16) {
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+                const __m128i digit = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+                const __m128i alpha = _mm_sub_epi8(_mm_or_si128(v, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+                const __m128i is_digit = _mm_cmpeq_epi8(_mm_max_epu8(digit, nine), nine);
+                const __m128i is_alpha = _mm_cmpeq_epi8(_mm_max_epu8(alpha, five), five);
+                if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xFFFF)
+                    return npos;
+                const __m128i value = _mm_or_si128(_mm_and_si128(is_digit, digit),
+                    _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+                // 16 * high + low for each digit pair
+                const __m128i bytes = _mm_maddubs_epi16(value, _mm_set1_epi16(0x0110));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i / 2), _mm_packus_epi16(bytes, bytes));
+            }
+#endif
+            auto value = [](char c) -> int {
+                if (c >= '0' && c <= '9')
+                    return c - '0';
+                c = static_cast<char>(c | 0x20);
+                if (c >= 'a' && c <= 'f')
+                    return c - 'a' + 10;
+                return -1;
+            };
+            for (; i < n; i += 2) {
+                const int hi = value(src[i]), lo = value(src[i + 1]);
+                if (hi < 0 || lo < 0)
+                    return npos;
+                dst[i / 2] = static_cast<unsigned char>(hi * 16 + lo);
+            }
+            return n / 2;
+        }
+
+        namespace detail {
+            template <typename Decoder, typename Encoder, typename In, typename Out>
+            result dispatch(const In* s, std::size_t n, Out* d, std::size_t cap, policy p) noexcept {
+                if constexpr (std::is_same<Decoder, utf8>::value)
+                    return run_utf8<Encoder>(s, n, d, cap, p);
+                else
+                    return run<Decoder, Encoder>(s, n, d, cap, p);
+            }
+
+            template <typename Decoder, typename Encoder, typename Out, typename In>
+            Out convert_string(const In* s, std::size_t n, std::size_t bound, policy p) {
+                Out out(bound, typename Out::value_type());
+                const result r = dispatch<Decoder, Encoder>(s, n, &out[0], out.size(), p);
+                if (!r)
+                    throw std::range_error("sn_String::transcode: bad input sequence at " + std::to_string(r.read));
+                out.resize(r.written);
+                return out;
+            }
+
+            // wchar_t is UTF-16 on Windows and UTF-32 elsewhere
+            using wide = std::conditional_t<sizeof(wchar_t) == 2, utf16, utf32>;
+        }
+
+        // Allocating wrappers; strict input errors throw std::range_error like std::wstring_convert
+        inline std::u16string utf8_to_u16string(const std::string& s, policy p = policy::strict) {
+            return detail::convert_string<detail::utf8, detail::utf16, std::u16string>(s.data(), s.size(), s.size(), p);
+        }
+        inline std::u32string utf8_to_u32string(const std::string& s, policy p = policy::strict) {
+            return detail::convert_string<detail::utf8, detail::utf32, std::u32string>(s.data(), s.size(), s.size(), p);
+        }
+        inline std::wstring utf8_to_wide(const std::string& s, policy p = policy::strict) {
+            return detail::convert_string<detail::utf8, detail::wide, std::wstring>(s.data(), s.size(), s.size(), p);
+        }
+        inline std::string u16string_to_utf8(const std::u16string& s, policy p = policy::strict) {
+            return detail::convert_string<detail::utf16, detail::utf8, std::string>(s.data(), s.size(), 3 * s.size(), p);
+        }
+        inline std::string u32string_to_utf8(const std::u32string& s, policy p = policy::strict) {
+            return detail::convert_string<detail::utf32, detail::utf8, std::string>(s.data(), s.size(), 4 * s.size(), p);
+        }
+        inline std::string wide_to_utf8(const std::wstring& s, policy p = policy::strict) {
+            return detail::convert_string<detail::wide, detail::utf8, std::string>(s.data(), s.size(), 4 * s.size(), p);
+        }
+        inline std::wstring gbk_to_wide(const std::string& s, policy p = policy::strict) {
+            return detail::convert_string<detail::gbk, detail::wide, std::wstring>(s.data(), s.size(), s.size(), p);
+        }
+        inline std::string gbk_to_utf8(const std::string& s, policy p = policy::strict) {
+            return detail::convert_string<detail::gbk, detail::utf8, std::string>(s.data(), s.size(), 3 * s.size(), p);
+        }
+        inline std::string hex(const std::string& s, bool upper = false) {
+            std::string out(2 * s.size(), '\0');
+            hex_encode(s.data(), s.size(), &out[0], upper);
+            return out;
+        }
+    }
+}
+
+
+
+#endif
@@ -40,6 +40,7 @@ namespace sn_Alg_test {
 	void sn_alg_test() {
 		//graph_test();
 		//cout << sn_Alg::number_theory::prime::linear_prime_sieve(100);
+		//small_sort_compare();
 		
 	}
 	
@@ -76,5 +77,27 @@ namespace sn_Alg_test {
 		cout << t2 - t1 << endl;
 		cout << t3 - t2 << endl;
 	}
+
+	// small partitions: insertion_sort vs sorting network
+	void small_sort_compare() {
+		const size_t s = 100000;
+		for (size_t n : { 8, 16, 32 }) {
+			vector<int> a(s * n);
+			for (auto& v : a)
+				v = rand();
+			vector<int> b = a;
+			clock_t t1, t2, t3;
+			t1 = clock();
+			for (size_t i = 0; i < s; ++i) {
+				sort::insertion_sort(a.data() + i * n, 0, n);
+			}
+			t2 = clock();
+			for (size_t i = 0; i < s; ++i) {
+				sort::small_sort(b.data() + i * n, 0, n);
+			}
+			t3 = clock();
+			cout << n << ": " << t2 - t1 << " " << t3 - t2 << (a == b ? "" : " mismatch") << endl;
+		}
+	}
 }
 #endif
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include <utility>
 #include <typeindex>
 #include <iterator>
+#include <regex>
 
 #if !defined(_WIN32) || !defined(__GNUC__)
 // #include "../src/sn_Alg.hpp" // due to mingw64 + windows byte type conflict
@@ -20,6 +21,7 @@
 #include "../src/sn_Assist.hpp"
 #include "../src/sn_Reflection.hpp"
 #include "../src/sn_String.hpp"
+#include "../src/sn_Regex/sn_RegexM.hpp"
 #include "../src/sn_Log.hpp"
 #include "../src/sn_Builtin.hpp"
 #include "../src/sn_Thread.hpp"
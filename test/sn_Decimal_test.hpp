@@ -9,6 +9,13 @@ namespace sn_Decimal_test {
 		sn_Decimal::sn_unsigned_decimal<sn_Decimal::sn_decimal_bit> e(1);
 		auto f = d + e;
 		std::cout << f;
+
+		sn_Decimal::sn_big_unsigned x("123456789012345678901234567890"), y(987654321u);
+		std::cout << '\n' << x * y << ' ' << x / y << ' ' << x % y << '\n';
+
+		using price = sn_Decimal::decimal64<4>;
+		std::vector<price> prices{price("19.99"), price("0.0005"), price("-3.25")};
+		std::cout << price("10") / price("3") << ' ' << sn_Decimal::fixed_batch::sum(prices) << '\n';
 	}
 }
 
@@ -0,0 +1,122 @@
+#ifndef SN_TEST_JSON_H
+#define SN_TEST_JSON_H
+
+#include "sn_CommonHeader_test.h"
+
+namespace sn_JSON_test {
+	using namespace std;
+	using namespace sn_JSON;
+
+	// Two-stage parser through basic_json: escapes, surrogate pairs and number edges survive a
+	// parse -> dump -> parse round trip, malformed input throws parse_error
+	void parse_test() {
+		const string s = R"({"esc":"q\"b\\s\/n\nt\tu\u00e9","pair":"\ud83d\ude00",)"
+			R"("i":[-9223372036854775808,9223372036854775807,0,-0],)"
+			R"("u":18446744073709551615,"d":[1.7976931348623157e308,5e-324,-2.5E-3,1e2]})";
+		const json j = json::parse(s);
+		const json k = json::parse(j.dump());
+		const bool same = j.dump() == k.dump()
+			&& j["esc"].get_string() == "q\"b\\s/n\nt\tu\xc3\xa9"
+			&& j["pair"].get_string() == "\xf0\x9f\x98\x80"
+			&& j["i"][0].get_integer() == numeric_limits<int64_t>::min()
+			&& j["i"][1].get_integer() == numeric_limits<int64_t>::max()
+			&& j["u"].get_double() == 18446744073709551615.0
+			&& j["d"][0].get_double() == numeric_limits<double>::max()
+			&& j["d"][1].get_double() == numeric_limits<double>::denorm_min()
+			&& k["d"][2].get_double() == -2.5e-3;
+		cout << same << " " << k["i"].dump() << endl;
+
+		size_t rejected = 0;
+		for (const char* bad : { "[1,]", R"(["\ud800"])", "1e400", R"(["abc)", "{\"a\" 1}", "01", "" }) {
+			try {
+				json::parse(bad);
+			}
+			catch (const parser::parse_error&) {
+				++rejected;
+			}
+		}
+		cout << "rejected " << rejected << " of 7" << endl;
+	}
+
+	// Rewinding an object re-reads escaped strings, they must land where they did the first time
+	void ondemand_rewind_test() {
+		const string s = R"({"a":"x\ny\nz\nw","b":1})";
+		ondemand::document doc(s);
+		ondemand::object o = doc.root().get_object();
+		string_view first;
+		for (int i = 0; i < 1000; ++i) {
+			const string_view a = o["a"].get_string();
+			if (i == 0)
+				first = a;
+			o["b"];
+			if (a != "x\ny\nz\nw" || a.data() != first.data())
+				cout << "ondemand rewind: bad string at pass " << i << endl;
+		}
+		cout << o["b"].get_int64() << " " << (first == "x\ny\nz\nw") << endl;
+	}
+
+	struct json_person {
+		int id;
+		std::string name;
+		std::optional<double> score;
+		std::vector<int> tags;
+	};
+
+	struct json_label {
+		int id;
+		std::string_view text;
+	};
+
+	struct json_pair {
+		int a;
+		long long b;
+	};
+
+	struct json_float_pair {
+		float a;
+		int b;
+	};
+}
+
+namespace sn_Reflection {
+	namespace named_pod_reflect {
+		using sn_JSON_test::json_person;
+		using sn_JSON_test::json_label;
+		SN_REFLECTION(json_person, id, name, score, tags)
+		SN_REFLECTION(json_label, id, text)
+	}
+}
+
+namespace sn_JSON_test {
+	void reflect_test() {
+		using namespace sn_JSON::reflect;
+		static_assert(detail::is_unnamed<json_pair>(), "registered fields map to arrays");
+		static_assert(!detail::is_unnamed<json_float_pair>(), "float has no unamed_pod_reflect id");
+		static_assert(detail::holds_view<json_label>::value && !detail::holds_view<json_person>::value, "");
+
+		const json_person p{ 7, "ann \"a\"", 1.5, { 1, 2 } };
+		const string s = to_json(p);
+		json_person q{};
+		from_json(s, q);
+		cout << s << " " << (q.name == p.name && q.score == p.score && q.tags == p.tags) << endl;
+
+		json_pair pr{};
+		from_json(to_json(json_pair{ 1, -2 }), pr);
+		cout << pr.a << " " << pr.b << endl;
+
+		// the escaped text is unescaped into doc, which outlives the label
+		const string l = R"({"id":3,"text":"tab\there"})";
+		ondemand::document doc;
+		json_label label{};
+		from_json(doc, l, label);
+		cout << label.id << " " << (label.text == "tab\there") << endl;
+	}
+
+	void sn_json_test() {
+		parse_test();
+		ondemand_rewind_test();
+		reflect_test();
+	}
+}
+
+#endif
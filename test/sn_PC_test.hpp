@@ -0,0 +1,126 @@
+#ifndef SN_TEST_PC_H
+#define SN_TEST_PC_H
+
+#include "sn_CommonHeader_test.h"
+
+namespace sn_PC_test {
+	using namespace std;
+	using namespace sn_PC;
+	using It = stream_range::iterator;
+
+	// Shared prefixes between alternatives, backtracking re-parses them 9 times per nesting level
+	template <typename R>
+	struct arith_grammar {
+		parser_handle<It, R, string> expr, term, factor;
+		arith_grammar() {
+			auto number = some(accept(is_digit));
+			auto e = reference("expr", &expr);
+			auto t = reference("term", &term);
+			auto f = reference("factor", &factor);
+			factor = memo(number || (accept(is_assist::is_char('(')) && e && accept(is_assist::is_char(')'))));
+			term = memo(attempt(f && accept(is_assist::is_char('*')) && t) || attempt(f && accept(is_assist::is_char('/')) && t) || f);
+			expr = memo(attempt(t && accept(is_assist::is_char('+')) && e) || attempt(t && accept(is_assist::is_char('-')) && e) || t);
+		}
+	};
+
+	// Written the naive way: members / elements try "x , rest" before "x"
+	template <typename R>
+	struct json_grammar {
+		parser_handle<It, R, string> value, members, elements;
+		json_grammar() {
+			auto ws = discard(many(accept(is_space)));
+			auto ch = [](char c) { return accept(is_assist::is_char(c)); };
+			auto str = ch('"') && many(attempt(ch('\\') && accept(is_any)) || accept(is_any - is_assist::is_char('"') - is_assist::is_char('\\'))) && ch('"');
+			auto number = option(ch('-')) && some(accept(is_digit)) && option(ch('.') && some(accept(is_digit)));
+			auto v = reference("value", &value);
+			auto ms = reference("members", &members);
+			auto es = reference("elements", &elements);
+			auto member = ws && str && ws && ch(':') && v;
+			members = memo(attempt(member && ch(',') && ms) || member);
+			elements = memo(attempt(v && ch(',') && es) || v);
+			auto object = attempt(ch('{') && members && ch('}')) || (ch('{') && ws && ch('}'));
+			auto array = attempt(ch('[') && elements && ch(']')) || (ch('[') && ws && ch(']'));
+			value = memo(ws && (object || array || str || number || attempt(accept_str("true")) || attempt(accept_str("false")) || accept_str("null")) && ws);
+		}
+	};
+
+	string nested_arith(int depth) {
+		return depth == 0 ? "1*2+3" : "2*(" + nested_arith(depth - 1) + ")-1";
+	}
+
+	string nested_json(int depth) {
+		if (depth == 0)
+			return "{\"id\": 42, \"tags\": [\"a\", \"b\"], \"ok\": true}";
+		return "{\"name\": \"n" + to_string(depth) + "\", \"list\": [1, 2.5, null], \"child\": " + nested_json(depth - 1) + "}";
+	}
+
+	template <typename R, typename P>
+	bool parse_all(const P& p, const string& s) {
+		R r(s);
+		auto i = r.first;
+		string result;
+		return p(i, r, &result) && i == r.last;
+	}
+
+	void packrat_compare() {
+		arith_grammar<stream_range> a1;
+		arith_grammar<packrat_range> a2;
+		for (int depth : { 2, 4, 6, 7 }) {
+			const string s = nested_arith(depth);
+			clock_t t1, t2, t3;
+			t1 = clock();
+			const bool b1 = parse_all<stream_range>(a1.expr, s);
+			t2 = clock();
+			const bool b2 = parse_all<packrat_range>(a2.expr, s);
+			t3 = clock();
+			cout << "arith " << depth << ": " << t2 - t1 << " " << t3 - t2 << (b1 && b2 ? "" : " mismatch") << endl;
+		}
+		json_grammar<stream_range> j1;
+		json_grammar<packrat_range> j2;
+		for (int depth : { 4, 8, 12, 14 }) {
+			const string s = nested_json(depth);
+			clock_t t1, t2, t3;
+			t1 = clock();
+			const bool b1 = parse_all<stream_range>(j1.value, s);
+			t2 = clock();
+			const bool b2 = parse_all<packrat_range>(j2.value, s);
+			t3 = clock();
+			cout << "json " << depth << ": " << t2 - t1 << " " << t3 - t2 << (b1 && b2 ? "" : " mismatch") << endl;
+		}
+	}
+
+	void left_recursion_test() {
+		// expr = expr '+' term | expr '-' term | term; term = term '*' number | number
+		parser_handle<It, packrat_range, string> expr, term;
+		auto number = some(accept(is_digit));
+		auto e = reference("expr", &expr);
+		auto t = reference("term", &term);
+		term = memo(attempt(t && accept(is_assist::is_char('*')) && number) || number);
+		expr = memo(attempt(e && accept(is_assist::is_char('+')) && t) || attempt(e && accept(is_assist::is_char('-')) && t) || t);
+		packrat_range r("1+2*3*4-5+6");
+		auto i = r.first;
+		string result;
+		cout << expr(i, r, &result) << " " << result << endl;
+	}
+
+	// Slices of the input instead of copies, the choices dispatch on the next byte
+	void view_range_test() {
+		parser_handle<const char*, packrat_view_range, string_view> expr;
+		auto number = span(some(accept(is_digit)));
+		auto e = reference("expr", &expr);
+		expr = memo(attempt(e && accept(is_assist::is_char('+')) && number) || number);
+		const string s = "12+345+6 rest";
+		packrat_view_range r{string_view(s)};
+		auto i = r.first;
+		string_view result;
+		cout << expr(i, r, &result) << " " << result << " |" << string_view(i, static_cast<size_t>(r.last - i)) << endl;
+	}
+
+	void sn_pc_test() {
+		left_recursion_test();
+		view_range_test();
+		//packrat_compare();
+	}
+}
+
+#endif
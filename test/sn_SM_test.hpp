@@ -0,0 +1,83 @@
+#ifndef SN_TEST_SM_H
+#define SN_TEST_SM_H
+
+#include "sn_CommonHeader_test.h"
+
+namespace sn_SM_test {
+	using namespace std;
+	using namespace sn_SM::fsm;
+
+	enum class conn_state { idle, connecting, open, closed };
+	enum class conn_event { dial, ack, data, hang, err };
+
+	struct session {
+		long bytes = 0;
+		int retries = 0;
+		size_t depth = 0;
+	};
+	struct on_data {
+		void operator()(session& s) const { ++s.bytes; }
+	};
+	struct can_retry {
+		bool operator()(session& s) const { return s.retries++ < 3; }
+	};
+
+	using conn_fsm = CompiledFSM<conn_state, conn_event, 4, 5,
+		Row<conn_state::idle, conn_event::dial, conn_state::connecting>,
+		Row<conn_state::connecting, conn_event::ack, conn_state::open>,
+		Row<conn_state::connecting, conn_event::err, conn_state::connecting, None, can_retry>,
+		Row<conn_state::connecting, conn_event::err, conn_state::closed>,
+		Row<conn_state::open, conn_event::data, conn_state::open, on_data>,
+		Row<conn_state::open, conn_event::hang, conn_state::closed>>;
+
+	void compiled_fsm_test() {
+		session s;
+		conn_fsm m{ conn_state::idle };
+		const conn_event retries[] = { conn_event::dial, conn_event::err, conn_event::err, conn_event::err, conn_event::err };
+		cout << m.execute_all(retries, s) << " " << (m.state() == conn_state::closed) << endl;
+		m.reset();
+		const vector<conn_event> seq = { conn_event::dial, conn_event::ack, conn_event::data, conn_event::data, conn_event::dial, conn_event::hang };
+		cout << m.execute_all(seq, s) << " " << s.bytes << " " << (m.state() == conn_state::closed) << endl;
+	}
+
+	enum class scan_state { scan, too_deep };
+	enum class token { open, close, other };
+	enum class paren { round };
+
+	// Nesting past depth 3 is sent to too_deep by the guarded rows instead of overflowing the stack
+	struct has_room {
+		bool operator()(session& s) const { return s.depth < 3; }
+	};
+	struct enter {
+		void operator()(session& s) const { ++s.depth; }
+	};
+	struct leave {
+		void operator()(session& s) const { --s.depth; }
+	};
+
+	using bracket_pda = PDA<scan_state, token, paren, 2, 3, 1, 3,
+		Row<scan_state::scan, token::other, scan_state::scan>,
+		PushdownRow<scan_state::scan, token::open, nullptr, scan_state::scan, StackOp::push, paren::round, enter>,
+		PushdownRow<scan_state::scan, token::open, paren::round, scan_state::scan, StackOp::push, paren::round, enter, has_room>,
+		PushdownRow<scan_state::scan, token::open, paren::round, scan_state::too_deep>,
+		PushdownRow<scan_state::scan, token::close, paren::round, scan_state::scan, StackOp::pop, paren::round, leave>>;
+
+	void pda_test() {
+		for (const string text : { "(a(b)c)", "(()", "())", "((()))", "(((())))" }) {
+			vector<token> tokens;
+			for (char c : text)
+				tokens.push_back(c == '(' ? token::open : c == ')' ? token::close : token::other);
+			session s;
+			bracket_pda p{ scan_state::scan };
+			const bool balanced = p.execute_all(tokens, s) == tokens.size() && p.empty();
+			cout << text << " " << balanced << " " << (p.state() == scan_state::too_deep) << endl;
+		}
+	}
+
+	void sn_sm_test() {
+		compiled_fsm_test();
+		pda_test();
+	}
+}
+
+#endif
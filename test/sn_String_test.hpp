@@ -4,8 +4,84 @@
 #include "sn_CommonHeader_test.h"
 
 namespace sn_String_test {
+	// ns per call: pattern parsed at compile time / at runtime / snprintf
+	void format_benchmark() {
+		const int n = 300000;
+		auto run = [n](auto f) {
+			std::size_t total = 0;
+			clock_t t = clock();
+			for (int i = 0; i < n; ++i)
+				total += f(i);
+			std::cout << (clock() - t) * 1e9 / CLOCKS_PER_SEC / n << (total ? " " : "");
+		};
+		run([](int i) { return sn_String::format(SN_CONSTEXPR_STRING("id={} name={} score={:.2f} hex={:#x}"), i, "alice", i * 0.5, i).size(); });
+		run([](int i) { return sn_String::format("id={} name={} score={:.2f} hex={:#x}", i, "alice", i * 0.5, i).size(); });
+		run([](int i) { char buf[128]; return static_cast<std::size_t>(snprintf(buf, sizeof(buf), "id=%d name=%s score=%.2f hex=%#x", i, "alice", i * 0.5, i)); });
+		std::cout << std::endl;
+	}
+
+	// ns per call: compile-time DFA against std::regex, anchored match and unanchored search
+	void regex_benchmark() {
+		const int n = 20000;
+		const std::vector<std::string> inputs = { "2024-abc", "42-", "x-12", "123456789-zzzzzz", "id 7-ab in text" };
+		const std::regex re("[0-9]+-[a-z]*");
+		auto run = [&](auto f) {
+			std::size_t total = 0;
+			clock_t t = clock();
+			for (int i = 0; i < n; ++i)
+				total += f(inputs[i % inputs.size()]);
+			std::cout << (clock() - t) * 1e9 / CLOCKS_PER_SEC / n << (total ? " " : "");
+		};
+		using digits_dash = sn_Regex::static_regex<'[', '0', '-', '9', ']', '+', '-', '[', 'a', '-', 'z', ']', '*'>;
+		run([](const std::string& s) { return digits_dash::match(s); });
+		run([&](const std::string& s) { return std::regex_match(s, re); });
+		run([](const std::string& s) { return digits_dash::search(s); });
+		run([&](const std::string& s) { return std::regex_search(s, re); });
+		std::cout << std::endl;
+	}
+
+	void regex_test() {
+		using ident = sn_Regex::static_regex<'[', 'a', '-', 'z', '_', ']', '\\', 'w', '*'>;
+		static_assert(ident::match("snake_case1") && !ident::match("1abc"), "identifier");
+		std::cout << ident::match("abc") << ident::search("12 x") << ident::prefix("ab-c") << std::endl;
+#if defined(__GNUC__)
+		using sn_Regex::operator""_regex;
+		static_assert("(ab|cd){2,3}x?"_regex.match("abcdab") && !"(ab|cd){2,3}x?"_regex.match("ab"), "repeat");
+		std::cout << "[0-9]+-[a-z]*"_regex.match("42-ab") << "[0-9]+-[a-z]*"_regex.search("id 7-x") << "a+"_regex.match("b") << std::endl;
+#endif
+	}
+
+	// Periodic needle over periodic text: every window passes the first/last byte filter, so this
+	// goes through the Two-Way fallback; checked against std::string::rfind
+	void rfind_test() {
+		std::string text;
+		for (int i = 0; i < 2000; ++i)
+			text += "abaabaab";
+		const std::string needle = std::string(40, 'a') + "ab" + "abaabaab" + "abaab";
+		const std::string periodic = "abaabaababaabaab" "abaabaababaabaab" "aba";
+		const std::string adversarial(1 << 16, 'a');
+		const std::string spike = std::string(500, 'a') + "b" + std::string(500, 'a');
+		std::size_t mismatches = 0;
+		for (std::size_t pos : { std::size_t(0), std::size_t(7), std::size_t(5000), std::size_t(15990), text.size(), std::string::npos }) {
+			mismatches += sn_String::string_view(text).rfind(periodic, pos) != text.rfind(periodic, pos);
+			mismatches += sn_String::string_view(text).rfind(needle, pos) != text.rfind(needle, pos);
+			mismatches += sn_String::string_view(adversarial).rfind(spike, pos) != adversarial.rfind(spike, pos);
+		}
+		std::cout << "rfind mismatches: " << mismatches << std::endl;
+	}
+
 	void sn_string_test() {
 		std::cout << sn_String::format("{1}, {0}", "abbb", "b") << std::endl;
+		std::cout << sn_String::format(SN_CONSTEXPR_STRING("[{:>6}] {:08.3f} {:#x}"), "ab", 3.14159, 255) << std::endl;
+		std::cout << sn_String::format("{} {}", nullptr, static_cast<const char*>("p")) << std::endl;
+		for (sn_String::string_view field : sn_String::split("id,,name, tag ", ','))
+			std::cout << '[' << sn_String::trim_view(field) << ']';
+		std::cout << std::endl;
+		// GBK "\u4f60\u597d" comes out as the hex of its UTF-8 form
+		std::cout << sn_String::convert::string_to_hex("\xc4\xe3\xba\xc3") << std::endl;
+		std::cout << (sn_String::intern("name") == sn_String::intern(std::string("na") + "me")) << std::endl;
+		regex_test();
+		rfind_test();
 	}
 }
 
@@ -7,6 +7,9 @@
 #include "sn_Log_test.hpp"
 #include "sn_Thread_test.hpp"
 #include "sn_LC_test.hpp"
+#include "sn_PC_test.hpp"
+#include "sn_JSON_test.hpp"
+#include "sn_SM_test.hpp"
 
 
 #ifdef SN_TEST_DB
@@ -112,6 +115,9 @@ int main() {
 	sn_Log_test::sn_log_test();
 	sn_Thread_test::sn_thread_test();
 	sn_LC_test::sn_lc_test();
+	sn_PC_test::sn_pc_test();
+	sn_JSON_test::sn_json_test();
+	sn_SM_test::sn_sm_test();
 #endif
 	//getchar();
 	return 0;